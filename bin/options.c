@@ -36,14 +36,14 @@ static char default_heur[] = "lm-cut";
 static char default_search[] = "astar";
 
 static const char *opt_search_ehc[] = {
-    "pref", "pref_only", NULL
+    "pref", "pref_only", "stubborn", NULL
 };
 static const char *opt_search_lazy[] = {
     "pref", "pref_only", "list-bucket", "list-heap", "list-rb",
-    "list-splay", NULL
+    "list-splay", "inc-app", "stubborn", NULL
 };
 static const char *opt_search_astar[] = {
-    "pathmax", NULL
+    "pathmax", "stubborn", "symmetry", NULL
 };
 static const char *opt_empty[] = { NULL };
 static const char *opt_heur_all[] = {
@@ -54,11 +54,19 @@ static const char *opt_heur_flow[] = {
     "ilp", "lm-cut", "lm-cut-inc-local",
     "lm-cut-inc-cache", NULL
 };
+static const char *opt_heur_op_count[] = {
+    "proj", "loc", "glob", "op-cost1", "op-cost+1",
+    "ilp", "seq", "lm-cut", "pho", NULL
+};
+static const char *opt_heur_dtg[] = {
+    "proj", "loc", "glob", "op-cost1", "op-cost+1", "table", NULL
+};
 static const char *opt_heur_lm_cut_inc_cache[] = {
     "proj", "loc", "glob", "op-cost1", "op-cost+1", "prune", NULL
 };
 static const char *opt_heur_pot[] = {
-    "proj", "loc", "glob", "op-cost1", "op-cost+1", "all-synt-states", NULL
+    "proj", "loc", "glob", "op-cost1", "op-cost+1", "all-synt-states",
+    "ensemble", NULL
 };
 static const char *opt_heur_ma_pot[] = {
     "op-cost1", "op-cost+1", "all-synt-states", "encrypt-off",
@@ -80,11 +88,14 @@ static optdef_t opt_heur[] = {
     { "add", opt_heur_all },
     { "max", opt_heur_all },
     { "ff", opt_heur_all },
-    { "dtg", opt_heur_all },
+    { "dtg", opt_heur_dtg },
     { "lm-cut", opt_heur_all },
     { "lm-cut-inc-local", opt_heur_all },
     { "lm-cut-inc-cache", opt_heur_lm_cut_inc_cache },
     { "flow", opt_heur_flow },
+    { "op-count", opt_heur_op_count },
+    { "pdb", opt_heur_all },
+    { "ms", opt_heur_all },
     { "pot", opt_heur_pot },
     { "ma-max", opt_empty },
     { "ma-ff", opt_empty },
@@ -114,6 +125,14 @@ static int readOpts(int argc, char *argv[])
                 "Path to a problem definition in .proto format.");
     optsAddDesc("fd-problem", 0x0, OPTS_STR, &o->fd, NULL,
                 "Path to a problem definition in Fast Downward's format.");
+    optsAddDesc("bin-problem", 0x0, OPTS_STR, &o->bin, NULL,
+                "Path to a problem definition in binary format.");
+    optsAddDesc("write-bin", 0x0, OPTS_STR, &o->write_bin, NULL,
+                "Store the loaded problem in binary format (that can be"
+                " loaded by --bin-problem) to the specified file.");
+    optsAddDesc("prune-h2", 0x0, OPTS_NONE, &o->prune_h2, NULL,
+                "Remove unreachable facts and useless operators of .proto"
+                " problems using h^2 mutexes. (default: Off)");
     optsAddDesc("search", 's', OPTS_STR, &o->search, NULL,
                 "Define search algorithm. See below for options. (default: astar)");
     optsAddDesc("heur", 'H', OPTS_STR, &o->heur, NULL,
@@ -130,6 +149,29 @@ static int readOpts(int argc, char *argv[])
                 "Switch to the factored multi-agent (threaded) mode. This"
                 " option implies that as -p must be specified path do a"
                 " directory with .proto files containing factors.");
+    optsAddDesc("ma-heur-pipeline", 0x0, OPTS_INT, &o->ma_heur_pipeline, NULL,
+                "Maximal number of states whose heuristic is computed by"
+                " other agents at the same time. Only ma-ff and ma-dtg"
+                " heuristics support it, values <= 1 disable it."
+                " (default: 0)");
+    optsAddDesc("ma-pin-cpu", 0x0, OPTS_NONE, &o->ma_pin_cpu, NULL,
+                "Pin each agent thread to its own CPU core (agent i runs"
+                " on the i-th CPU allowed by the process affinity mask"
+                " modulo number of such CPUs). Works only in threaded"
+                " multi-agent modes on Linux.");
+    optsAddDesc("ma-checkpoint", 0x0, OPTS_STR, &o->ma_checkpoint, NULL,
+                "Path prefix of checkpoint files. Each agent periodically"
+                " writes its part of a consistent global checkpoint of the"
+                " search to the file <prefix>.<token>.<agent-id>; agent 0"
+                " commits complete checkpoints in <prefix>.manifest."
+                " All agents must share the filesystem.");
+    optsAddDesc("ma-checkpoint-interval", 0x0, OPTS_INT,
+                &o->ma_checkpoint_interval, NULL,
+                "Number of seconds between two checkpoints."
+                " (default: 600)");
+    optsAddDesc("ma-restore", 0x0, OPTS_STR, &o->ma_restore, NULL,
+                "Path prefix of checkpoint files (see --ma-checkpoint)"
+                " from which the search is resumed.");
     optsAddDesc("tcp", 0x0, OPTS_STR, NULL, OPTS_CB(tcpAdd),
                 "Defines tcp ip-address:port for an agent. This options"
                 " should be used as many times as is number of agents in"
@@ -155,6 +197,22 @@ static int readOpts(int argc, char *argv[])
     optsAddDesc("hard-limit-sleeptime", 0x0, OPTS_INT, &o->hard_limit_sleeptime,
                 NULL, "Sleeptime in seconds for hard limit monitor."
                 " Set to -1 to disable hard limit monitor. (default: 5)");
+    optsAddDesc("lm-cache-mem", 0x0, OPTS_INT, &o->lm_cache_mem, NULL,
+                "Maximal memory in MB used by the landmark cache of"
+                " lm-cut-inc-cache heuristic. The least recently used"
+                " landmark sets are evicted when the limit is reached."
+                " Set to 0 for no limit. (default: 0)");
+    optsAddDesc("pdb-mem", 0x0, OPTS_INT, &o->pdb_mem, NULL,
+                "Maximal memory in MB used by the pattern databases of"
+                " pdb heuristic. Set to 0 for the default limit."
+                " (default: 0, i.e., 64 MB)");
+    optsAddDesc("ms-size", 0x0, OPTS_INT, &o->ms_size, NULL,
+                "Maximal number of abstract states of transition systems"
+                " of ms heuristic. Set to 0 for the default limit."
+                " (default: 0, i.e., 50000)");
+    optsAddDesc("pot-seed", 0x0, OPTS_INT, &o->pot_seed, NULL,
+                "Seed of the random walks sampling states for the"
+                " ensemble of pot heuristic. (default: 0)");
 
     if (opts(&argc, argv) != 0){
         return -1;
@@ -198,6 +256,7 @@ static void usage(const char *progname)
 "    Options allowed for *ehc*:\n"
 "           pref      -- preferred operators are used\n"
 "           pref_only -- only the preferred operators are used\n"
+"           stubborn  -- strong stubborn sets pruning\n"
 "\n"
 "    Options allowed for *lazy*:\n"
 "           pref        -- preferred operators are used\n"
@@ -206,9 +265,14 @@ static void usage(const char *progname)
 "           list-heap   -- pairing heap based open-list\n"
 "           list-rb     -- rb-tree based open-list\n"
 "           list-splay  -- splay-tree based open-list (default)\n"
+"           inc-app     -- applicable operators are derived from the\n"
+"                          parent state (ignored with stubborn)\n"
+"           stubborn    -- strong stubborn sets pruning\n"
 "\n"
 "    Options allowed for *astar*:\n"
-"           pathmax -- pathmax variant of A*\n"
+"           pathmax  -- pathmax variant of A*\n"
+"           stubborn -- strong stubborn sets pruning\n"
+"           symmetry -- pruning of symmetric states\n"
 "\n"
 "    EXAMPLES:\n"
 "           ehc:pref -- EHC algorithm with preferred operators\n"
@@ -221,13 +285,30 @@ static void usage(const char *progname)
 "  HEUR OPTIONS:\n"
 "    The available heur algorithms are:\n"
 "        goalcount, add, max, ff, dtg, lm-cut, lm-cut-inc-local,\n"
-"        lm-cut-inc-cache, flow, potential.\n"
+"        lm-cut-inc-cache, flow, op-count, pdb, ms, potential.\n"
 "    Additionally for the multi-agent mode: ma-max, ma-ff, ma-lm-cut, ma-dtg, ma-pot\n"
 "\n"
 "    Options allowed for flow heuristic:\n"
 "           ilp    -- Integer linear programming instead of LP is used\n"
 "           lm-cut -- Landmarks from lm-cut heuristic are used\n"
 "\n"
+"    Options allowed for op-count heuristic:\n"
+"           ilp    -- Integer linear programming instead of LP is used\n"
+"           seq    -- Net change constraints (default if no other\n"
+"                     constraints are selected)\n"
+"           lm-cut -- Landmarks from lm-cut heuristic\n"
+"           pho    -- Post-hoc optimization constraints from atomic\n"
+"                     projections to goal variables\n"
+"\n"
+"    Options allowed for dtg heuristic:\n"
+"           table -- Distances in DTGs are precomputed at start-up\n"
+"\n"
+"    Options allowed for pot heuristic:\n"
+"           all-synt-states -- Potentials are optimized for all\n"
+"                              syntactic states\n"
+"           ensemble -- Maximum over 16 potential functions optimized\n"
+"                       for states sampled by random walks\n"
+"\n"
 "    Options allowed for lm-cut-inc-cache heuristic:\n"
 "           prune -- Pruning of cache is enabled\n"
 "\n"
@@ -333,6 +414,15 @@ static void printOpts(void)
     }else{
         printf("Multi-agent: no\n");
     }
+    if (o->ma_unfactor || o->ma_factor || o->ma_factor_dir)
+        printf("MA heur pipeline: %d\n", o->ma_heur_pipeline);
+    if (o->ma_unfactor || o->ma_factor_dir)
+        printf("MA pin CPU: %d\n", o->ma_pin_cpu);
+    if (o->ma_unfactor || o->ma_factor || o->ma_factor_dir){
+        printf("MA checkpoint: %s\n", o->ma_checkpoint);
+        printf("MA checkpoint interval: %d s\n", o->ma_checkpoint_interval);
+        printf("MA restore: %s\n", o->ma_restore);
+    }
     printf("Proto: %s\n", o->proto);
     printf("Output: %s\n", o->output);
     printf("Max time: %d s\n", o->max_time);
@@ -340,6 +430,10 @@ static void printOpts(void)
     printf("Progress freq: %d\n", o->progress_freq);
     printf("Print heur init: %d\n", o->print_heur_init);
     printf("Dot graph: %s\n", o->dot_graph);
+    printf("LM cache mem: %d MB\n", o->lm_cache_mem);
+    printf("PDB mem: %d MB\n", o->pdb_mem);
+    printf("M&S size: %d\n", o->ms_size);
+    printf("Pot seed: %d\n", o->pot_seed);
     printf("Heur: %s [", o->heur);
     for (i = 0; i < o->heur_opts_len; ++i){
         if (i > 0)
@@ -366,6 +460,7 @@ options_t *options(int argc, char *argv[])
     o->max_time = 30 * 60;
     o->max_mem = 1024;
     o->progress_freq = 10000;
+    o->ma_checkpoint_interval = 600;
     o->heur = default_heur;
     o->heur_opts = NULL;
     o->heur_opts_len = 0;
@@ -379,7 +474,7 @@ options_t *options(int argc, char *argv[])
         return NULL;
     }
 
-    if (o->proto == NULL && o->fd == NULL){
+    if (o->proto == NULL && o->fd == NULL && o->bin == NULL){
         fprintf(stderr, "Error: Problem file not specified! (see -p"
                         " option)\n\n");
         usage(argv[0]);
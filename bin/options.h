@@ -25,8 +25,16 @@ struct _options_t {
     int ma_unfactor;
     int ma_factor;
     int ma_factor_dir;
+    int ma_heur_pipeline;
+    int ma_pin_cpu;
+    char *ma_checkpoint;
+    int ma_checkpoint_interval;
+    char *ma_restore;
     char *proto;
     char *fd;
+    char *bin;
+    char *write_bin;
+    int prune_h2;
     char *output;
     char **tcp;
     int tcp_size;
@@ -37,6 +45,10 @@ struct _options_t {
     int print_heur_init;
     char *dot_graph;
     int hard_limit_sleeptime;
+    int lm_cache_mem;
+    int pdb_mem;
+    int ms_size;
+    int pot_seed;
 
     char *heur;
     char **heur_opts;
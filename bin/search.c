@@ -17,7 +17,14 @@
  * See the License for more information.
  */
 
+#ifdef __linux__
+# define _GNU_SOURCE
+# include <sched.h>
+# include <pthread.h>
+#endif /* __linux__ */
+
 #include <sys/resource.h>
+#include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <dirent.h>
@@ -46,11 +53,13 @@ typedef struct _progress_t progress_t;
 struct _ma_t {
     int agent_id;
     const options_t *opts;
+    const plan_problem_t *prob;
     plan_search_t *search;
     plan_ma_comm_t *comm;
     plan_path_t path;
     progress_t progress_data;
     int res;
+    double cpu_time; /*!< CPU time consumed by the agent's search */
 };
 typedef struct _ma_t ma_t;
 
@@ -222,6 +231,10 @@ static void printProblem(const plan_problem_t *prob)
            planStatePackerBufSize(prob->state_pool->packer));
     printf("Size of state id: %d\n", (int)sizeof(plan_state_id_t));
     printf("Duplicate operators removed: %d\n", prob->duplicate_ops_removed);
+    if (prob->h2_ops_removed > 0 || prob->h2_facts_removed > 0){
+        printf("h^2 operators removed: %d\n", prob->h2_ops_removed);
+        printf("h^2 facts removed: %d\n", prob->h2_facts_removed);
+    }
     if (prob->agent_name != NULL){
         printf("Agent name: %s\n", prob->agent_name);
         printf("Agent ID: %d\n", prob->agent_id);
@@ -230,6 +243,18 @@ static void printProblem(const plan_problem_t *prob)
     if (prob->proj_op != NULL){
         printf("Num projected operators: %d\n", prob->proj_op_size);
     }
+    if (prob->load_time.total > 0.f){
+        printf("Load Time Parse: %f\n", prob->load_time.parse);
+        printf("Load Time Causal Graph: %f\n", prob->load_time.causal_graph);
+        printf("Load Time Prune Vars: %f\n", prob->load_time.prune_vars);
+        printf("Load Time Prune h^2: %f\n", prob->load_time.prune_h2);
+        printf("Load Time Prune Duplicates: %f\n",
+               prob->load_time.prune_duplicates);
+        printf("Load Time Succ Gen: %f\n", prob->load_time.succ_gen);
+        printf("Load Time Agents: %f\n", prob->load_time.agents);
+        printf("Load Time Pack: %f\n", prob->load_time.pack);
+        printf("Load Time Total: %f\n", prob->load_time.total);
+    }
     fflush(stdout);
 }
 
@@ -256,6 +281,17 @@ static void printStat(const plan_search_stat_t *stat, const char *prefix)
     printf("%sExpanded States: %ld\n", prefix, stat->expanded_states);
     printf("%sGenerated States: %ld\n", prefix, stat->generated_states);
     printf("%sPeak Memory: %ld kb\n", prefix, stat->peak_memory);
+    if (stat->ma_private_mem > 0){
+        printf("%sMA Private Parts: %ld\n", prefix, stat->ma_private_parts);
+        printf("%sMA Private Memory: %ld kb\n", prefix,
+               stat->ma_private_mem / 1024);
+    }
+    if (stat->symmetry_generators > 0){
+        printf("%sSymmetry Generators: %ld\n", prefix,
+               stat->symmetry_generators);
+        printf("%sSymmetry Pruned States: %ld\n", prefix,
+               stat->symmetry_pruned);
+    }
     fflush(stdout);
 }
 
@@ -395,6 +431,8 @@ static int loadProblemAgents(const options_t *o)
     int flags;
 
     flags = PLAN_PROBLEM_USE_CG;
+    if (o->prune_h2)
+        flags |= PLAN_PROBLEM_PRUNE_H2;
     agent_problem = planProblemAgentsFromProto(o->proto, flags);
     if (agent_problem->agent_size <= 1){
         // TODO: Maybe only warning and switch to single-agent mode.
@@ -414,17 +452,30 @@ static int loadProblemAgents(const options_t *o)
 
 static int loadProblemSeq(const options_t *o)
 {
+    const char *fn = NULL;
     int flags;
 
     flags = PLAN_PROBLEM_USE_CG;
+    if (o->prune_h2)
+        flags |= PLAN_PROBLEM_PRUNE_H2;
     problem = NULL;
     if (o->proto != NULL){
+        fn = o->proto;
         problem = planProblemFromProto(o->proto, flags);
     }else if (o->fd != NULL){
+        fn = o->fd;
         problem = planProblemFromFD(o->fd);
+    }else if (o->bin != NULL){
+        fn = o->bin;
+        problem = planProblemFromBin(o->bin);
     }
     if (problem == NULL){
-        fprintf(stderr, "Error: Could not load file `%s'\n", o->proto);
+        fprintf(stderr, "Error: Could not load file `%s'\n", fn);
+        return -1;
+    }
+
+    if (o->write_bin != NULL && planProblemToBin(problem, o->write_bin) != 0){
+        fprintf(stderr, "Error: Could not write `%s'\n", o->write_bin);
         return -1;
     }
 
@@ -539,6 +590,31 @@ static plan_list_lazy_t *listLazyCreate(const options_t *o)
     return list;
 }
 
+static void printDTGTableStat(const plan_heur_t *heur)
+{
+    long size;
+    int var_size;
+    double build_time;
+
+    if (planHeurDTGTableStat(heur, &size, &var_size, &build_time) != 0)
+        return;
+    printf("DTG Table Vars: %d\n", var_size);
+    printf("DTG Table Size: %ld B\n", size);
+    printf("DTG Table Build Time: %f\n", build_time);
+    fflush(stdout);
+}
+
+static void printLMCacheStat(const plan_heur_t *heur)
+{
+    const plan_landmark_cache_t *ldmc;
+
+    ldmc = planHeurLMCutIncCache(heur);
+    if (ldmc == NULL)
+        return;
+    planLandmarkCacheStatsPrint(ldmc, stdout);
+    fflush(stdout);
+}
+
 static plan_heur_t *_heurNew(const options_t *o,
                              const char *name,
                              const plan_problem_t *prob,
@@ -566,8 +642,12 @@ static plan_heur_t *_heurNew(const options_t *o,
         heur = planHeurRelaxFFNew(prob->var, prob->var_size,
                                   prob->goal, op, op_size, flags);
     }else if (strcmp(name, "dtg") == 0){
+        if (optionsHeurOpt(o, "table"))
+            flags |= PLAN_HEUR_DTG_TABLE;
         heur = planHeurDTGNew(prob->var, prob->var_size,
-                              prob->goal, op, op_size);
+                              prob->goal, op, op_size, flags);
+        if (flags & PLAN_HEUR_DTG_TABLE)
+            printDTGTableStat(heur);
     }else if (strcmp(name, "lm-cut") == 0){
         heur = planHeurLMCutNew(prob->var, prob->var_size,
                                 prob->goal, op, op_size, flags);
@@ -577,6 +657,8 @@ static plan_heur_t *_heurNew(const options_t *o,
     }else if (strcmp(name, "lm-cut-inc-cache") == 0){
         if (optionsHeurOpt(o, "prune"))
             flags2 |= PLAN_LANDMARK_CACHE_PRUNE;
+        if (o->lm_cache_mem > 0)
+            flags2 |= PLAN_LANDMARK_CACHE_MAX_MEM_MB(o->lm_cache_mem);
         heur = planHeurLMCutIncCacheNew(prob->var, prob->var_size,
                                         prob->goal, op, op_size, flags, flags2);
     }else if (strcmp(name, "flow") == 0){
@@ -586,13 +668,34 @@ static plan_heur_t *_heurNew(const options_t *o,
             flags |= PLAN_HEUR_FLOW_LANDMARKS_LM_CUT;
         heur = planHeurFlowNew(prob->var, prob->var_size,
                                prob->goal, op, op_size, flags);
+    }else if (strcmp(name, "op-count") == 0){
+        if (optionsHeurOpt(o, "ilp"))
+            flags |= PLAN_HEUR_OP_COUNT_ILP;
+        if (optionsHeurOpt(o, "seq"))
+            flags |= PLAN_HEUR_OP_COUNT_SEQ;
+        if (optionsHeurOpt(o, "lm-cut"))
+            flags |= PLAN_HEUR_OP_COUNT_LM_CUT;
+        if (optionsHeurOpt(o, "pho"))
+            flags |= PLAN_HEUR_OP_COUNT_PHO;
+        heur = planHeurOpCountNew(prob->var, prob->var_size,
+                                  prob->goal, op, op_size, flags);
+    }else if (strcmp(name, "pdb") == 0){
+        heur = planHeurPDBNew(prob->var, prob->var_size,
+                              prob->goal, op, op_size, flags,
+                              o->pdb_mem * 1024L * 1024L);
+    }else if (strcmp(name, "ms") == 0){
+        heur = planHeurMSNew(prob->var, prob->var_size,
+                             prob->goal, op, op_size, flags, o->ms_size);
     }else if (strcmp(name, "pot") == 0){
         if (optionsHeurOpt(o, "all-synt-states"))
             flags |= PLAN_HEUR_POT_ALL_SYNTACTIC_STATES;
+        if (optionsHeurOpt(o, "ensemble"))
+            flags |= PLAN_HEUR_POT_ENSEMBLE(16);
         state = planStateNew(prob->state_pool->num_vars);
         planStatePoolGetState(prob->state_pool, prob->initial_state, state);
         heur = planHeurPotentialNew(prob->var, prob->var_size,
-                                    prob->goal, op, op_size, state, flags);
+                                    prob->goal, op, op_size, state, flags,
+                                    o->pot_seed);
         planStateDel(state);
     }else if (strcmp(name, "ma-max") == 0){
         heur = planHeurMARelaxMaxNew(prob, flags);
@@ -693,11 +796,13 @@ static plan_search_t *searchNew(const options_t *o,
         lazy_params.use_preferred_ops = use_preferred_ops;
         lazy_params.list = listLazyCreate(o);
         lazy_params.list_del = 1;
+        lazy_params.inc_app_ops = optionsSearchOpt(o, "inc-app");
         params = &lazy_params.search;
 
     }else if (strcmp(o->search, "astar") == 0){
         planSearchAStarParamsInit(&astar_params);
         astar_params.pathmax = use_pathmax;
+        astar_params.symmetry = optionsSearchOpt(o, "symmetry");
         params = &astar_params.search;
 
     }else{
@@ -710,6 +815,7 @@ static plan_search_t *searchNew(const options_t *o,
     params->progress.freq = o->progress_freq;
     params->progress.data = progress_data;
     params->prob = prob;
+    params->stubborn_sets = optionsSearchOpt(o, "stubborn");
 
     if (strcmp(o->search, "ehc") == 0){
         search = planSearchEHCNew(&ehc_params);
@@ -749,6 +855,7 @@ static int singleThread(const options_t *o)
     printInitHeur(o, search);
     printf("\n");
     printStat(&search->stat, "");
+    printLMCacheStat(heur);
     fflush(stdout);
 
     planPathFree(&path);
@@ -763,6 +870,7 @@ static void maRun(int agent_id, ma_t *ma)
 {
     plan_ma_search_params_t params;
     plan_ma_search_t *ma_search;
+    struct timespec start, end;
 
     planMASearchParamsInit(&params);
     params.comm = ma->comm;
@@ -772,11 +880,23 @@ static void maRun(int agent_id, ma_t *ma)
     }else{
         params.verify_solution = 0;
     }
+    params.heur_pipeline = ma->opts->ma_heur_pipeline;
+    params.prob = ma->prob;
+    if (ma->opts->ma_checkpoint != NULL){
+        params.checkpoint = ma->opts->ma_checkpoint;
+        params.checkpoint_interval = ma->opts->ma_checkpoint_interval;
+    }
+    params.restore = ma->opts->ma_restore;
 
     ma_search = planMASearchNew(&params);
     limitMonitorAddMASearch(ma_search);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
     ma->res = planMASearchRun(ma_search, &ma->path);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
     planMASearchDel(ma_search);
+
+    ma->cpu_time  = end.tv_sec - start.tv_sec;
+    ma->cpu_time += (end.tv_nsec - start.tv_nsec) / 1E9;
 }
 
 static int maInit(ma_t *ma, int agent_id, const options_t *o,
@@ -786,9 +906,11 @@ static int maInit(ma_t *ma, int agent_id, const options_t *o,
 
     ma->agent_id = agent_id;
     ma->opts = o;
+    ma->prob = prob;
     ma->progress_data.max_time = o->max_time;
     ma->progress_data.max_mem = o->max_mem;
     ma->progress_data.agent_id = agent_id;
+    ma->cpu_time = 0.;
 
     heur = heurNewMA(o, prob, globprob);
     if (heur == NULL)
@@ -855,14 +977,65 @@ static void maPrintResults(ma_t *ma, int size, const options_t *o)
     for (i = 0; i < size; ++i){
         printf("Agent[%d] stats:\n", ma[i].agent_id);
         printStat(&ma[i].search->stat, "    ");
+        printf("    CPU Time: %f\n", ma[i].cpu_time);
+        printf("    Idle Time: %f\n", ma[i].comm->recv_block_time);
+        printf("    Sent Messages: %ld\n", ma[i].comm->msg_sent);
+        printf("    Received Messages: %ld\n", ma[i].comm->msg_recv);
     }
+    fflush(stdout);
 }
 
 
 
+static void maPinCPU(int agent_id)
+{
+#ifdef __linux__
+    cpu_set_t allowed, cpuset;
+    int cpu, cpu_size, i, ret;
+
+    // Choose only from CPUs the process is allowed to run on (taskset,
+    // cpusets of containers, ...)
+    ret = sched_getaffinity(0, sizeof(allowed), &allowed);
+    if (ret != 0){
+        fprintf(stderr, "Warning: Could not read CPU affinity of agent %d:"
+                        " %s\n", agent_id, strerror(errno));
+        return;
+    }
+
+    cpu_size = CPU_COUNT(&allowed);
+    if (cpu_size <= 0)
+        return;
+
+    // Find (agent_id mod cpu_size)-th allowed CPU
+    i = agent_id % cpu_size;
+    for (cpu = 0; cpu < CPU_SETSIZE; ++cpu){
+        if (CPU_ISSET(cpu, &allowed) && i-- == 0)
+            break;
+    }
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (ret != 0){
+        fprintf(stderr, "Warning: Could not pin agent %d to CPU %d: %s\n",
+                agent_id, cpu, strerror(ret));
+    }
+#else /* __linux__ */
+    fprintf(stderr, "Warning: Pinning agents to CPUs is not supported on"
+                    " this system.\n");
+#endif /* __linux__ */
+}
+
 static void maThRun(int id, void *data, const bor_tasks_thinfo_t *_)
 {
-    maRun(id, (ma_t *)data);
+    ma_t *ma = data;
+
+    // Pin the thread before the search starts. The problem and the
+    // search structures are created by the main thread, only memory
+    // allocated during the search is first touched from the agent's core.
+    if (ma->opts->ma_pin_cpu)
+        maPinCPU(ma->agent_id);
+    maRun(id, ma);
 }
 
 static int maUnfactoredThread(const options_t *o)
@@ -5,6 +5,7 @@ ifdef(`DEBUG', `#define PLAN_DEBUG')
 ifdef(`USE_NANOMSG', `#define PLAN_NANOMSG')
 ifdef(`USE_CPLEX', `#define PLAN_USE_CPLEX')
 ifdef(`USE_LP_SOLVE', `#define PLAN_USE_LP_SOLVE')
+ifdef(`USE_LP_INTERNAL', `#define PLAN_USE_LP_INTERNAL')
 ifdef(`LP', `#define PLAN_LP')
 
 #endif /* __PLAN_CONFIG_H__ */
@@ -82,6 +82,56 @@ struct _plan_search_t;
  */
 #define PLAN_HEUR_POT_PRINT_INIT_TIME 0x100u
 
+/**
+ * Sets the number of potential functions of the potential heuristic.
+ * The first function is optimized for the initial state (or all syntactic
+ * states), the others for states sampled by random walks from the initial
+ * state, and the heuristic value is the maximum over all functions.
+ * By default (zero) only one function is used.
+ */
+#define PLAN_HEUR_POT_ENSEMBLE(num) ((((unsigned)(num)) & 0xffu) << 16u)
+#define PLAN_HEUR_POT_ENSEMBLE_SIZE(flags) (((flags) >> 16u) & 0xffu)
+
+/**
+ * Precompute all-pairs distance tables of DTGs of all variables (up to
+ * PLAN_HEUR_DTG_TABLE_MAX_MEM bytes) when DTG heuristic is created.
+ */
+#define PLAN_HEUR_DTG_TABLE 0x4000u
+
+/**
+ * Memory limit of the tables precomputed with PLAN_HEUR_DTG_TABLE.
+ */
+#define PLAN_HEUR_DTG_TABLE_MAX_MEM (256L * 1024L * 1024L)
+
+/**
+ * Constraint generators of the operator-counting heuristic:
+ *  - net change constraints of all facts (state equation),
+ *  - disjunctive action landmarks found by LM-Cut,
+ *  - post-hoc optimization constraints from atomic projections to the
+ *    goal variables.
+ * If no generator is selected, the state equation is used.
+ */
+#define PLAN_HEUR_OP_COUNT_SEQ 0x01000000u
+#define PLAN_HEUR_OP_COUNT_LM_CUT 0x02000000u
+#define PLAN_HEUR_OP_COUNT_PHO 0x04000000u
+
+/**
+ * Use integer linear programming instead of LP in the operator-counting
+ * heuristic.
+ */
+#define PLAN_HEUR_OP_COUNT_ILP 0x08000000u
+
+/**
+ * Default memory limit of the tables of the PDB heuristic.
+ */
+#define PLAN_HEUR_PDB_MAX_MEM (64L * 1024L * 1024L)
+
+/**
+ * Default limit on the number of abstract states of the merge-and-shrink
+ * heuristic.
+ */
+#define PLAN_HEUR_MS_MAX_STATES 50000
+
 /** Forward declaration */
 typedef struct _plan_heur_t plan_heur_t;
 
@@ -190,6 +240,9 @@ struct _plan_heur_t {
 
     int ma; /*!< Set to true if planHeurMA*() functions should be used
                  instead of planHeur() */
+    int ma_pipeline; /*!< Set to true if the heuristic can keep more
+                          evaluations in flight at the same time (see
+                          planHeurMANode()) */
     int ma_agent_size;
     int ma_agent_id;
     plan_ma_state_t *ma_state;
@@ -259,12 +312,29 @@ plan_heur_t *planHeurLMCutIncCacheNew(const plan_var_t *var, int var_size,
                                       unsigned flags,
                                       unsigned cache_flags);
 
+/**
+ * Returns the landmark cache of the heuristic created by
+ * planHeurLMCutIncCacheNew() or NULL if heur is a different heuristic.
+ */
+const plan_landmark_cache_t *planHeurLMCutIncCache(const plan_heur_t *heur);
+
 /**
  * Domain transition graph based heuristic.
+ * For flags see PLAN_HEUR_DTG_* macros above.
  */
 plan_heur_t *planHeurDTGNew(const plan_var_t *var, int var_size,
                             const plan_part_state_t *goal,
-                            const plan_op_t *op, int op_size);
+                            const plan_op_t *op, int op_size,
+                            unsigned flags);
+
+/**
+ * Returns statistics of the distance tables precomputed with
+ * PLAN_HEUR_DTG_TABLE: their size in bytes, the number of variables
+ * covered by them and the time of building in seconds (all zero if no
+ * table was built). Returns -1 if heur is not a DTG heuristic.
+ */
+int planHeurDTGTableStat(const plan_heur_t *heur, long *size,
+                         int *var_size, double *build_time);
 
 /**
  * Flow based heuristics.
@@ -275,14 +345,54 @@ plan_heur_t *planHeurFlowNew(const plan_var_t *var, int var_size,
                              const plan_op_t *op, int op_size,
                              unsigned flags);
 
+/**
+ * Operator-counting heuristic.
+ * The heuristic value is the optimal cost of operator counts satisfying
+ * constraints of all selected generators (see PLAN_HEUR_OP_COUNT_*
+ * macros above), which are all solved in one LP.
+ * PLAN_HEUR_FLOW_CPLEX_NUM_THREADS() can be used also here.
+ */
+plan_heur_t *planHeurOpCountNew(const plan_var_t *var, int var_size,
+                                const plan_part_state_t *goal,
+                                const plan_op_t *op, int op_size,
+                                unsigned flags);
+
+/**
+ * Pattern database heuristic.
+ * One pattern is grown from each goal variable along the causal graph,
+ * the pattern databases are combined using the canonical heuristic
+ * (maximum over sums of additive subsets).
+ * max_mem is a memory limit of all tables in bytes including the
+ * transient array of distances used while a table is built, if it is
+ * zero, PLAN_HEUR_PDB_MAX_MEM is used.
+ */
+plan_heur_t *planHeurPDBNew(const plan_var_t *var, int var_size,
+                            const plan_part_state_t *goal,
+                            const plan_op_t *op, int op_size,
+                            unsigned flags, long max_mem);
+
+/**
+ * Merge-and-shrink heuristic.
+ * Atomic transition systems of variables are merged pairwise along the
+ * causal graph ordering of variables and shrunk by greedy bisimulation
+ * so that no transition system has more than max_states states (if
+ * zero, PLAN_HEUR_MS_MAX_STATES is used).
+ */
+plan_heur_t *planHeurMSNew(const plan_var_t *var, int var_size,
+                           const plan_part_state_t *goal,
+                           const plan_op_t *op, int op_size,
+                           unsigned flags, int max_states);
+
 /**
  * Potential based heuristics.
+ * The seed initializes the random walks sampling states for
+ * PLAN_HEUR_POT_ENSEMBLE(), so the same seed gives the same functions.
  */
 plan_heur_t *planHeurPotentialNew(const plan_var_t *var, int var_size,
                                   const plan_part_state_t *goal,
                                   const plan_op_t *op, int op_size,
                                   const plan_state_t *init_state,
-                                  unsigned flags);
+                                  unsigned flags, unsigned seed);
 
 /**
  * Creates an multi-agent version of max heuristic.
@@ -350,6 +460,13 @@ void planHeurMAInit(plan_heur_t *heur, int agent_size, int agent_id,
  * to other peers. Returns 0 if heuristic value was found or -1 if
  * planHeurMAUpdate() should be consecutively called on all heur-response
  * messages.
+ *
+ * If heur->ma_pipeline is set, planHeurMANode() can be called again before
+ * the previous evaluation is finished. In that case, each heur-response
+ * message carries ID of the evaluated state (see planMAMsgHeurStateId())
+ * and the caller is responsible for passing the message to
+ * planHeurMAUpdate() together with the result structure belonging to that
+ * state.
  */
 int planHeurMANode(plan_heur_t *heur,
                    plan_ma_comm_t *comm,
@@ -0,0 +1,107 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2015 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_INTERN_TABLE_H__
+#define __PLAN_INTERN_TABLE_H__
+
+#include <stdint.h>
+#include <plan/common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Interning table of fixed-size elements.
+ * Each unique element is stored only once and it is identified by a
+ * 32-bit ID assigned sequentially from zero. Elements are stored in one
+ * contiguous array indexed by their IDs and they are looked up through an
+ * open-addressing (linear probing) hash table storing only the IDs.
+ * Elements cannot be removed, so the memory is not bounded: it grows
+ * linearly with the number of unique elements (see
+ * planInternTableMemUsage()).
+ */
+struct _plan_intern_table_t {
+    size_t el_size;     /*!< Size of one element in bytes */
+    char *data;         /*!< Elements indexed by their IDs */
+    uint32_t *hash;     /*!< Hash value of each element */
+    uint32_t size;      /*!< Number of stored elements */
+    uint32_t alloc;     /*!< Number of elements .data can hold */
+    uint32_t *slot;     /*!< Hash table: ID + 1 or 0 for empty slot */
+    uint32_t slot_size; /*!< Number of slots, always power of two */
+};
+typedef struct _plan_intern_table_t plan_intern_table_t;
+
+/**
+ * Initializes an empty table of elements of the given size.
+ */
+void planInternTableInit(plan_intern_table_t *t, size_t el_size);
+
+/**
+ * Frees allocated resources.
+ */
+void planInternTableFree(plan_intern_table_t *t);
+
+/**
+ * Inserts a copy of the element if not already there and returns its ID.
+ */
+int planInternTableInsert(plan_intern_table_t *t, const void *el);
+
+/**
+ * Returns ID of the element or -1 if it is not in the table.
+ */
+int planInternTableFind(const plan_intern_table_t *t, const void *el);
+
+/**
+ * Returns the element with the specified ID or NULL if there is no such
+ * element. The returned pointer is valid only until the next insert.
+ */
+_bor_inline const void *planInternTableGet(const plan_intern_table_t *t,
+                                           int id);
+
+/**
+ * Returns number of stored elements.
+ */
+_bor_inline int planInternTableSize(const plan_intern_table_t *t);
+
+/**
+ * Returns number of bytes allocated by the table.
+ */
+size_t planInternTableMemUsage(const plan_intern_table_t *t);
+
+
+/**** INLINES: ****/
+_bor_inline const void *planInternTableGet(const plan_intern_table_t *t,
+                                           int id)
+{
+    if (id < 0 || (uint32_t)id >= t->size)
+        return NULL;
+    return t->data + t->el_size * id;
+}
+
+_bor_inline int planInternTableSize(const plan_intern_table_t *t)
+{
+    return t->size;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_INTERN_TABLE_H__ */
@@ -20,8 +20,7 @@
 #ifndef __PLAN_LANDMARK_H__
 #define __PLAN_LANDMARK_H__
 
-#include <boruvka/htable.h>
-#include <boruvka/splaytree_int.h>
+#include <stdio.h>
 #include <plan/common.h>
 
 #ifdef __cplusplus
@@ -78,17 +77,60 @@ void planLandmarkSetFree(plan_landmark_set_t *ldms);
  */
 void planLandmarkSetAdd(plan_landmark_set_t *ldms, int size, int *op_id);
 
+/**
+ * Statistics of landmark cache.
+ */
+struct _plan_landmark_cache_stats_t {
+    long hits;      /*!< Number of successful lookups */
+    long misses;    /*!< Number of lookups of sets not in the cache */
+    long inserts;   /*!< Number of inserted sets */
+    long evictions; /*!< Number of sets evicted due to the memory limit */
+    long rejected;  /*!< Number of sets not stored because they alone do
+                         not fit into the memory limit */
+    long pruned;    /*!< Number of pruned sets */
+    long sets;      /*!< Number of sets currently in the cache */
+    long bytes;     /*!< Memory occupied by the cached sets and by the
+                         index of their IDs */
+    long max_bytes; /*!< Peak of .bytes */
+};
+typedef struct _plan_landmark_cache_stats_t plan_landmark_cache_stats_t;
+
 /**
  * Cache for landmark sets.
+ * Landmark sets are stored as compact arrays of sorted operator IDs in a
+ * ring buffer and found by a hash map from IDs to offsets in the buffer.
+ * If the memory is limited, the buffer and the hash map together never
+ * exceed the limit: the oldest sets are evicted whenever a new set does
+ * not fit into the buffer, but sets that were accessed since they were
+ * stored (or since they were visited by the eviction last time) are moved
+ * to the head of the buffer instead (CLOCK algorithm).
  */
 struct _plan_landmark_cache_t {
-    bor_htable_t *ldm_table; /*!< Hash table of landmarks */
-    bor_splaytree_int_t *ldms; /*!< Landmark sets */
-    bor_list_t prune; /*!< List of landmarks ready to be pruned */
+    int *buf;       /*!< Ring buffer with landmark sets */
+    long buf_size;  /*!< Number of ints in .buf */
+    long head;      /*!< Offset where next set will be written */
+    long tail;      /*!< Offset of the oldest set */
+    long wrap;      /*!< Offset where the data before wrapping to the
+                         beginning of .buf ends, or -1 */
+    long used;      /*!< Number of used ints between .tail and .head */
+    long live;      /*!< Number of ints of sets that were not removed */
+    long max_bytes; /*!< Limit on the memory of .buf and index, or 0 */
+
+    int *idx_id;    /*!< Open addressing hash map from IDs of sets (-1 in
+                         empty slots) ... */
+    long *idx_off;  /*!< ... to offsets of the sets in .buf */
+    long idx_size;  /*!< Number of slots, a power of two */
+    long idx_num;   /*!< Number of stored IDs */
+
     int prune_enable; /*!< True if cache should be pruned */
+    int *prune;       /*!< IDs of sets ready to be pruned */
+    int prune_size;
+    int prune_alloc;
 
     plan_landmark_set_t ldms_out; /*!< Set used for *Get() method */
     int ldms_alloc; /*!< Size of allocated space in .ldms_out */
+
+    plan_landmark_cache_stats_t stats;
 };
 typedef struct _plan_landmark_cache_t plan_landmark_cache_t;
 
@@ -97,6 +139,13 @@ typedef struct _plan_landmark_cache_t plan_landmark_cache_t;
  */
 #define PLAN_LANDMARK_CACHE_PRUNE 0x1
 
+/**
+ * Limits memory occupied by the cached landmark sets to the given number
+ * of megabytes (up to 2^24 - 1). Zero means no limit.
+ */
+#define PLAN_LANDMARK_CACHE_MAX_MEM_MB(mb) \
+    ((((unsigned)(mb)) & 0xffffffu) << 8u)
+
 /**
  * Creates an empty landmark cache.
  */
@@ -113,6 +162,8 @@ void planLandmarkCacheDel(plan_landmark_cache_t *);
  * caller should not use the landmark set again (it is zeroized anyway).
  * Returns 0 on success, -1 if ID is already in cache and in that case
  * {ldms} is not touched.
+ * Note that a set larger than the memory limit is consumed but not
+ * stored.
  */
 int planLandmarkCacheAdd(plan_landmark_cache_t *ldmc,
                          int id, plan_landmark_set_t *ldms);
@@ -121,7 +172,8 @@ int planLandmarkCacheAdd(plan_landmark_cache_t *ldmc,
  * Returns a landmark set that corresponds to the given ID or NULL of not
  * such landmark set is stored in the cache.
  * The returned landmark set points to an internal structure of the cache
- * so it should not be changed in any way.
+ * so it should not be changed in any way and it is valid only until the
+ * next call of planLandmarkCacheAdd().
  */
 const plan_landmark_set_t *planLandmarkCacheGet(plan_landmark_cache_t *ldmc,
                                                 int ldmid);
@@ -135,6 +187,12 @@ const plan_landmark_set_t *planLandmarkCacheGet(plan_landmark_cache_t *ldmc,
  */
 int planLandmarkPrune(plan_landmark_cache_t *ldmc);
 
+/**
+ * Prints statistics of the cache.
+ */
+void planLandmarkCacheStatsPrint(const plan_landmark_cache_t *ldmc,
+                                 FILE *fout);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
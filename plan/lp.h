@@ -51,6 +51,14 @@ typedef struct _plan_lp_t plan_lp_t;
  */
 #define PLAN_LP_MAX 0x1
 
+/**
+ * Statuses of the last solve returned by planLPStatus().
+ */
+#define PLAN_LP_OPTIMAL    0
+#define PLAN_LP_INFEASIBLE 1
+#define PLAN_LP_UNBOUNDED  2
+/** The solver gave up, e.g., on an iteration or node limit */
+#define PLAN_LP_FAILED     3
 
 /**
  * Creates a new LP problem with specified number of rows and columns.
@@ -113,11 +121,47 @@ void planLPDelRows(plan_lp_t *lp, int begin, int end);
  */
 int planLPNumRows(const plan_lp_t *lp);
 
+/**
+ * Returns number of columns in model.
+ */
+int planLPNumCols(const plan_lp_t *lp);
+
+/**
+ * Returns number of elements of an array needed for storing the current
+ * basis (see planLPGetBasis()). The size changes whenever rows or columns
+ * are added or deleted.
+ */
+int planLPBasisSize(const plan_lp_t *lp);
+
+/**
+ * Stores the basis of the last solved problem into the given array of
+ * planLPBasisSize() elements.
+ * Returns 0 on success, -1 if no basis is available.
+ */
+int planLPGetBasis(plan_lp_t *lp, int *basis);
+
+/**
+ * Sets the starting basis of the next solve. The basis must be obtained
+ * by planLPGetBasis() from a model of the same dimensions.
+ */
+void planLPSetBasis(plan_lp_t *lp, const int *basis);
+
 /**
  * Solves problem and returns objective value.
+ * If no optimal solution was found DBL_MAX is returned and the reason can
+ * be obtained by planLPStatus().
  */
 double planLPSolveObjVal(plan_lp_t *lp);
 
+/**
+ * Same as planLPSolveObjVal() but the problem is re-optimized by the dual
+ * simplex starting from the current (or set) basis. This is the fastest
+ * way to solve a problem that differs from the previously solved one only
+ * in right hand sides, because the previous optimal basis stays dual
+ * feasible.
+ */
+double planLPSolveDualObjVal(plan_lp_t *lp);
+
 /**
  * Solves Integer Linear Program and returns objective value.
  */
@@ -129,6 +173,12 @@ double planLPSolveILPObjVal(plan_lp_t *lp);
  */
 double planLPSolve(plan_lp_t *lp, double *obj);
 
+/**
+ * Returns status of the last solve, one of PLAN_LP_{OPTIMAL,INFEASIBLE,
+ * UNBOUNDED,FAILED}. Only PLAN_LP_INFEASIBLE proves that the problem has
+ * no solution.
+ */
+int planLPStatus(const plan_lp_t *lp);
 
 void planLPWrite(plan_lp_t *lp, const char *fn);
 
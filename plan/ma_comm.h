@@ -31,6 +31,10 @@ struct _plan_ma_comm_t {
     int node_size;
     int recv_sock;
     int *send_sock;
+    long msg_sent; /*!< Number of sent messages */
+    long msg_recv; /*!< Number of received messages */
+    double recv_block_time; /*!< Time (in seconds) spent waiting in
+                                 planMACommRecvBlock() */
 };
 typedef struct _plan_ma_comm_t plan_ma_comm_t;
 
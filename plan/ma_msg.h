@@ -38,6 +38,7 @@ extern "C" {
 #define PLAN_MA_MSG_PUBLIC_STATE 0x2
 #define PLAN_MA_MSG_SNAPSHOT     0x3
 #define PLAN_MA_MSG_HEUR         0x4
+#define PLAN_MA_MSG_DEAD_END     0x5
 
 
 /**
@@ -59,7 +60,7 @@ extern "C" {
  * Snapshot specific types (see planMAMsgSnapshotSetType()).
  */
 #define PLAN_MA_MSG_SOLUTION_VERIFICATION 0x0
-#define PLAN_MA_MSG_DEAD_END_VERIFICATION 0x1
+#define PLAN_MA_MSG_CHECKPOINT            0x1
 
 
 /**
@@ -208,9 +209,36 @@ void planMAMsgAddHeurRequestedAgent(plan_ma_msg_t *msg, int agent_id);
 int planMAMsgHeurCost(const plan_ma_msg_t *msg);
 void planMAMsgSetHeurCost(plan_ma_msg_t *msg, int cost);
 
+/**
+ * ID of the state (in the requester's state pool) the heur request or
+ * response belongs to. Used for pairing responses with evaluations when
+ * more heuristic evaluations are in flight at the same time.
+ */
+plan_state_id_t planMAMsgHeurStateId(const plan_ma_msg_t *msg);
+void planMAMsgSetHeurStateId(plan_ma_msg_t *msg, plan_state_id_t state_id);
+
+/**
+ * ID of the agent owning the state given by planMAMsgHeurStateId(), i.e.,
+ * the agent that started the evaluation. Requests relayed by other agents
+ * keep the ID of the original requester, so together with the state ID it
+ * identifies the evaluation.
+ */
+int planMAMsgHeurStateAgent(const plan_ma_msg_t *msg);
+void planMAMsgSetHeurStateAgent(plan_ma_msg_t *msg, int agent_id);
+
 int planMAMsgSearchRes(const plan_ma_msg_t *msg);
 void planMAMsgSetSearchRes(plan_ma_msg_t *msg, int res);
 
+/**
+ * Token of the termination detection (PLAN_MA_MSG_DEAD_END): sum of
+ * message counters of the visited agents and the flag whether some of
+ * them received a message since the last round.
+ */
+long planMAMsgTermCounter(const plan_ma_msg_t *msg);
+void planMAMsgSetTermCounter(plan_ma_msg_t *msg, long counter);
+int planMAMsgTermBlack(const plan_ma_msg_t *msg);
+void planMAMsgSetTermBlack(plan_ma_msg_t *msg, int black);
+
 
 /**
  * Sets request for DTG heuristic.
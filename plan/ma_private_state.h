@@ -20,10 +20,7 @@
 #ifndef __PLAN_MA_PRIVATE_STATE_H__
 #define __PLAN_MA_PRIVATE_STATE_H__
 
-#include <boruvka/htable.h>
-#include <boruvka/extarr.h>
-
-#include <plan/common.h>
+#include <plan/intern_table.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,10 +29,9 @@ extern "C" {
 struct _plan_ma_private_state_t {
     int num_agents;
     int agent_id;
-    bor_extarr_t *states;
-    int num_states;
-    size_t state_size;
-    bor_htable_t *htable;
+    int *state;                /*!< Pre-allocated array of IDs without
+                                    the current agent */
+    plan_intern_table_t table; /*!< Unique arrays of IDs */
 };
 typedef struct _plan_ma_private_state_t plan_ma_private_state_t;
 
@@ -67,6 +63,11 @@ int planMAPrivateStateInsert(plan_ma_private_state_t *aps, int *state_ids);
 void planMAPrivateStateGet(const plan_ma_private_state_t *aps, int id,
                            int *state_ids);
 
+/**
+ * Returns number of bytes allocated by the registry.
+ */
+size_t planMAPrivateStateMemUsage(const plan_ma_private_state_t *aps);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -38,6 +38,32 @@ struct _plan_ma_search_params_t {
     plan_ma_comm_t *comm;  /*!< Communication channel between agents */
     int verify_solution;   /*!< Set to true if a solution should be
                                 verified by all agents. Default: 0 */
+    int heur_pipeline;     /*!< Maximal number of heuristic evaluations
+                                waiting for other agents at the same time.
+                                It has effect only if the heuristic
+                                supports it (see plan_heur_t.ma_pipeline),
+                                values <= 1 disable pipelining.
+                                Default: 0 */
+    const plan_problem_t *prob; /*!< Problem definition the search runs
+                                     on. It is needed only for checkpoints
+                                     and restoring. Default: NULL */
+    const char *checkpoint; /*!< Path prefix of checkpoint files, each
+                                 agent writes its part of a checkpoint to
+                                 the file "<checkpoint>.<token>.<agent-id>"
+                                 and agent 0 commits the checkpoint by
+                                 writing its token to
+                                 "<checkpoint>.manifest". All agents must
+                                 see the same files (shared filesystem).
+                                 Default: NULL (disabled) */
+    float checkpoint_interval; /*!< Number of seconds between two
+                                    consecutive checkpoints. Checkpoints
+                                    are initiated by agent 0.
+                                    Default: 0 (disabled) */
+    const char *restore;     /*!< Path prefix of checkpoint files from
+                                  which the search should be resumed, see
+                                  .checkpoint. Only the checkpoint named
+                                  by the manifest is used.
+                                  Default: NULL */
 };
 typedef struct _plan_ma_search_params_t plan_ma_search_params_t;
 
@@ -59,6 +85,9 @@ void planMASearchDel(plan_ma_search_t *ma_search);
 
 /**
  * Runs underlying search algorithm in a multi-agent mode.
+ * If params.restore was set, the search is first restored from the
+ * checkpoint. All agents of the cluster must be restored from the same
+ * checkpoint.
  * Returns the same values as the underlying search algorithm.
  */
 int planMASearchRun(plan_ma_search_t *search, plan_path_t *path);
@@ -20,9 +20,8 @@
 #ifndef __PLAN_MA_STATE_H__
 #define __PLAN_MA_STATE_H__
 
-#include <boruvka/htable.h>
-#include <boruvka/extarr.h>
-
+#include <stdio.h>
+#include <plan/intern_table.h>
 #include <plan/state_pool.h>
 #include <plan/ma_private_state.h>
 #include <plan/ma_msg.h>
@@ -47,9 +46,8 @@ struct _plan_ma_state_t {
     int pub_bufsize; /*!< Size of the buffer for public part of packed state */
 
     int priv_bufsize; /*!< Size of the private part of the packed state. */
-    bor_extarr_t *priv_data; /*!< Array of elements in .priv_table */
-    bor_htable_t *priv_table; /*!< Hash table of unique private parts */
-    int priv_size; /*!< Number of private parts stored in table */
+    void *priv_buf; /*!< Pre-allocated buffer for private part */
+    plan_intern_table_t priv_table; /*!< Table of unique private parts */
 };
 typedef struct _plan_ma_state_t plan_ma_state_t;
 
@@ -97,6 +95,34 @@ void planMAStateGetFromMAMsg(plan_ma_state_t *ma_state,
                              const plan_ma_msg_t *ma_msg,
                              plan_state_t *state);
 
+/**
+ * Returns number of unique private parts of states stored in ma-privacy
+ * mode.
+ */
+int planMAStatePrivatePartSize(const plan_ma_state_t *ma_state);
+
+/**
+ * Returns number of bytes allocated for private parts of states and for
+ * the table of private state IDs.
+ */
+size_t planMAStatePrivateMemUsage(const plan_ma_state_t *ma_state);
+
+/**
+ * Writes tables of private parts of states to the file so that they can
+ * be restored by planMAStateLoad().
+ * Returns 0 on success, -1 on I/O error.
+ */
+int planMAStateSave(const plan_ma_state_t *ma_state, FILE *fout);
+
+/**
+ * Restores tables of private parts of states written by planMAStateSave()
+ * so that the IDs of private parts are the same as in the saved object.
+ * It must be called before any state is sent or received.
+ * Returns 0 on success, -1 on error or if the data are not consistent
+ * with the ma-state object.
+ */
+int planMAStateLoad(plan_ma_state_t *ma_state, FILE *fin);
+
 /**
  * Returns true if the state is properly set in the ma message.
  */
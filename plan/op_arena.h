@@ -0,0 +1,66 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_OP_ARENA_H__
+#define __PLAN_OP_ARENA_H__
+
+#include <plan/op.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Arena holding the content of an array of operators, i.e., part-states
+ * including their packed buffers, conditional effects and names, in one
+ * contiguous block. Data of each operator are stored next to each other.
+ */
+struct _plan_op_arena_t {
+    char *buf;   /*!< The contiguous block */
+    size_t size; /*!< Size of .buf in bytes */
+};
+typedef struct _plan_op_arena_t plan_op_arena_t;
+
+/**
+ * Moves the content of the operators into a new arena.
+ * The operators must not be modified afterwards and they must not be
+ * freed by planOpFree(), only the array itself is freed after
+ * planOpArenaDel() is called.
+ */
+plan_op_arena_t *planOpArenaNew(plan_op_t *op, int op_size);
+
+/**
+ * Frees the arena.
+ */
+void planOpArenaDel(plan_op_arena_t *arena);
+
+/**
+ * Copies the arena with its operators op[] as a whole and returns the
+ * new arena. The new array of operators pointing to the new arena is
+ * returned via op_out.
+ */
+plan_op_arena_t *planOpArenaClone(const plan_op_arena_t *arena,
+                                  const plan_op_t *op, int op_size,
+                                  plan_op_t **op_out);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_OP_ARENA_H__ */
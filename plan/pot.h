@@ -33,6 +33,19 @@ extern "C" {
  */
 #define PLAN_POT_MA 0x1u
 
+/**
+ * Upper bound on the scale of fixed-point potentials, i.e., the number of
+ * fixed-point units per one unit of cost.
+ */
+#define PLAN_POT_FIXED_SCALE (1L << 20)
+
+/**
+ * Tolerance added to the sum of fixed-point potentials before it is
+ * rounded down to a cost, so that round-off errors of the LP solver do
+ * not lose a whole unit of the heuristic value.
+ */
+#define PLAN_POT_FIXED_EPS 1E-3
+
 
 struct _plan_pot_submatrix_t {
     int cols;   /*!< Number of columns in submatrix */
@@ -100,6 +113,14 @@ struct _plan_pot_t {
     plan_pot_prob_t prob; /*!< Saved problem in sparse format */
 
     double *pot;         /*!< Potential for each lp-variable */
+
+    int64_t *fpot;       /*!< Fixed-point potentials rounded to the nearest
+                              value and flattened per (var, val) pair */
+    int *fpot_off;       /*!< Offset of each variable in .fpot */
+    int64_t fpot_scale;  /*!< Scale of .fpot */
+
+    plan_lp_t *lp;       /*!< LP problem kept between calls of
+                              planPotCompute() */
 };
 typedef struct _plan_pot_t plan_pot_t;
 
@@ -121,10 +142,19 @@ void planPotFree(plan_pot_t *pot);
 
 /**
  * Compute potentials.
+ * The fixed-point table (.fpot) is computed from the potentials too.
+ * The LP problem is created by the first call and the following calls
+ * only change its objective according to .prob.state_coef, so any other
+ * change of .prob is ignored until planPotFreeLP() is called.
  */
 void planPotCompute(plan_pot_t *pot);
 void planPotCompute2(const plan_pot_prob_t *prob, double *pot);
 
+/**
+ * Deletes the LP problem kept by planPotCompute().
+ */
+void planPotFreeLP(plan_pot_t *pot);
+
 /**
  * Convers state to the list of LP variable IDs.
  * Returns number of facts stored in var_ids array.
@@ -132,6 +162,12 @@ void planPotCompute2(const plan_pot_prob_t *prob, double *pot);
 int planPotToVarIds(const plan_pot_t *pot, const plan_state_t *state,
                     int *var_ids);
 
+/**
+ * Set pot->prob.state_coef so that the potentials are optimized for the
+ * given state.
+ */
+void planPotSetState(plan_pot_t *pot, const plan_state_t *state);
+
 /**
  * Set pot->prob.state_coef from all-syntactic-states version of potential.
  */
@@ -149,6 +185,25 @@ _bor_inline double planPotStatePot(const plan_pot_t *pot,
                                    const plan_state_t *state);
 
 
+/**
+ * Returns fixed-point potential of the variable-value pair.
+ */
+_bor_inline int64_t planPotPotFixed(const plan_pot_t *pot, int var, int val);
+
+/**
+ * Returns fixed-point potential of the state. The sum is exact, so it can
+ * be also computed incrementally using planPotPotFixed().
+ */
+_bor_inline int64_t planPotStatePotFixed(const plan_pot_t *pot,
+                                         const plan_state_t *state);
+
+/**
+ * Converts fixed-point potential with the given scale to an admissible
+ * heuristic value, i.e., rounds it down with the tolerance
+ * PLAN_POT_FIXED_EPS.
+ */
+_bor_inline plan_cost_t planPotFixedToCost(int64_t fpot, int64_t scale);
+
 /**
  * Initializes agent potential structure.
  */
@@ -184,6 +239,35 @@ _bor_inline double planPotStatePot(const plan_pot_t *pot,
     return p;
 }
 
+_bor_inline int64_t planPotPotFixed(const plan_pot_t *pot, int var, int val)
+{
+    return pot->fpot[pot->fpot_off[var] + val];
+}
+
+_bor_inline int64_t planPotStatePotFixed(const plan_pot_t *pot,
+                                         const plan_state_t *state)
+{
+    const int64_t *fpot = pot->fpot;
+    const int *off = pot->fpot_off;
+    const plan_val_t *val = state->val;
+    int64_t p = 0;
+    int i;
+
+    for (i = 0; i < pot->var_size; ++i)
+        p += fpot[off[i] + val[i]];
+    return p;
+}
+
+_bor_inline plan_cost_t planPotFixedToCost(int64_t fpot, int64_t scale)
+{
+    if (fpot <= 0)
+        return 0;
+    fpot = (fpot + (int64_t)(PLAN_POT_FIXED_EPS * scale)) / scale;
+    if (fpot >= PLAN_COST_MAX)
+        return PLAN_COST_MAX - 1;
+    return fpot;
+}
+
 #else /* PLAN_LP */
 
 void planNOPot(void);
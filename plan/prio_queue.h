@@ -95,6 +95,12 @@ void planPrioQueueInit(plan_prio_queue_t *q);
  */
 void planPrioQueueFree(plan_prio_queue_t *q);
 
+/**
+ * Removes all elements from the queue but keeps the allocated memory so
+ * that the queue can be cheaply reused.
+ */
+void planPrioQueueClear(plan_prio_queue_t *q);
+
 /**
  * Inserts an element into queue.
  */
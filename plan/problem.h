@@ -23,6 +23,7 @@
 #include <plan/var.h>
 #include <plan/state.h>
 #include <plan/op.h>
+#include <plan/op_arena.h>
 #include <plan/succ_gen.h>
 
 #ifdef __cplusplus
@@ -49,6 +50,13 @@ extern "C" {
  */
 #define PLAN_PROBLEM_MA_STATE_PRIVACY 0x8u
 
+/**
+ * Turns on pruning of unreachable facts and useless operators using
+ * forward and backward h^2 analysis. Preconditions of the operators are
+ * also extended with values implied by h^2 mutexes.
+ */
+#define PLAN_PROBLEM_PRUNE_H2 0x1000u
+
 /**
  * Prepare problem on cluster of a specified number of agents.
  */
@@ -61,6 +69,23 @@ struct _plan_problem_private_val_t {
 };
 typedef struct _plan_problem_private_val_t plan_problem_private_val_t;
 
+/**
+ * Wall-clock time (in seconds) spent in the individual stages of loading
+ * the problem. Stages that were not run are left zero.
+ */
+struct _plan_problem_load_time_t {
+    float parse;            /*!< Parsing of the input file */
+    float causal_graph;     /*!< Causal graph construction */
+    float prune_vars;       /*!< Pruning of unimportant variables */
+    float prune_h2;         /*!< h^2 analysis and pruning */
+    float prune_duplicates; /*!< Sorting and removal of duplicate ops */
+    float succ_gen;         /*!< Successor generator construction */
+    float agents;           /*!< Construction of agents' problems */
+    float pack;             /*!< Packing of goal and operators */
+    float total;            /*!< Whole loading including all above */
+};
+typedef struct _plan_problem_load_time_t plan_problem_load_time_t;
+
 struct _plan_problem_t {
     plan_var_t *var;               /*!< Definitions of variables */
     int var_size;                  /*!< Number of variables */
@@ -72,9 +97,16 @@ struct _plan_problem_t {
     plan_part_state_t *goal;       /*!< Partial state representing goal */
     plan_op_t *op;                 /*!< Array of operators */
     int op_size;                   /*!< Number of operators */
+    plan_op_arena_t *op_arena;     /*!< Arena holding content of .op[]
+                                        once the problem is packed */
     plan_succ_gen_t *succ_gen;     /*!< Successor generator */
     int duplicate_ops_removed;     /*!< Number of duplicate operators that
                                         were removed */
+    int h2_ops_removed;            /*!< Number of operators removed by h^2
+                                        analysis */
+    int h2_facts_removed;          /*!< Number of facts (values of
+                                        variables) removed by h^2 analysis */
+    plan_problem_load_time_t load_time; /*!< Timings of loading stages */
 
     /** Fllowing data are available only in case of agent problem defintion: */
     char *agent_name;   /*!< Name of the corresponding agent */
@@ -82,8 +114,12 @@ struct _plan_problem_t {
     int num_agents;     /*!< Number of agents in cluster */
     plan_op_t *proj_op; /*!< Projected operators */
     int proj_op_size;   /*!< Number of projected operators */
+    plan_op_arena_t *proj_op_arena; /*!< Arena of .proj_op[] */
     plan_problem_private_val_t *private_val; /*!< List of private values */
     int private_val_size;
+
+    void *bin_map;       /*!< Mapped file if loaded by planProblemFromBin() */
+    size_t bin_map_size;
 };
 typedef struct _plan_problem_t plan_problem_t;
 
@@ -105,6 +141,29 @@ plan_problem_t *planProblemFromFD(const char *fn);
  */
 plan_problem_t *planProblemFromProto(const char *fn, unsigned flags);
 
+/**
+ * Loads problem from the binary format created by planProblemToBin().
+ * The file is mapped into memory and operators, goal and the successor
+ * generator point directly into the mapping, so the problem must be
+ * treated as read-only (e.g., planProblemPack() must not be called on
+ * it). Returns NULL if the file is not in the current version of the
+ * format.
+ */
+plan_problem_t *planProblemFromBin(const char *fn);
+
+/**
+ * Stores the problem including its packed operators and the successor
+ * generator in the binary format. Agent problems are not supported.
+ * Returns 0 on success.
+ */
+int planProblemToBin(const plan_problem_t *p, const char *fn);
+
+/**
+ * Frees the parts of the problem that point into the mapped file.
+ * Called from planProblemFree().
+ */
+void _planProblemBinFree(plan_problem_t *p);
+
 /**
  * Creates an exact copy of the problem object.
  */
@@ -160,6 +219,9 @@ _bor_inline int planProblemCheckGoal(plan_problem_t *p,
 
 /**
  * Pack part-states and operators.
+ * Large sets of operators are packed by several threads.
+ * Packed operators are then moved to an arena (see plan/op_arena.h), so
+ * they must not be modified afterwards.
  */
 void planProblemPack(plan_problem_t *p);
 
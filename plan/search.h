@@ -31,6 +31,8 @@
 #include <plan/ma_comm.h>
 #include <plan/search_stat.h>
 #include <plan/search_applicable_ops.h>
+#include <plan/search_stubborn.h>
+#include <plan/symmetry.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,6 +74,9 @@ struct _plan_search_params_t {
                             planSearchDel() */
 
     plan_problem_t *prob; /*!< Problem definition */
+
+    int stubborn_sets; /*!< True if applicable operators should be pruned
+                            using strong stubborn sets */
 };
 typedef struct _plan_search_params_t plan_search_params_t;
 
@@ -108,6 +113,10 @@ struct _plan_search_lazy_params_t {
     plan_list_lazy_t *list; /*!< Lazy list that will be used. */
     int list_del;           /*!< True if .list should be deleted in
                                  planSearchDel() */
+    int inc_app_ops;        /*!< True if applicable operators should be
+                                 derived from the parent's applicable
+                                 operators instead of computing them from
+                                 scratch */
 };
 typedef struct _plan_search_lazy_params_t plan_search_lazy_params_t;
 
@@ -130,6 +139,10 @@ struct _plan_search_astar_params_t {
     plan_search_params_t search; /*!< Common parameters */
 
     int pathmax; /*!< Use pathmax correction */
+    int symmetry; /*!< Prune states symmetric to already generated ones.
+                       Ignored for agents' problems. Heuristics are
+                       evaluated on the canonical states via
+                       planHeurState() */
 };
 typedef struct _plan_search_astar_params_t plan_search_astar_params_t;
 
@@ -350,6 +363,13 @@ struct _plan_search_t {
     plan_state_id_t state_id;        /*!< ID of .state -- used for caching*/
     plan_search_stat_t stat;
     plan_search_applicable_ops_t app_ops;
+    plan_search_stubborn_t *stubborn; /*!< Stubborn sets pruning or NULL */
+    plan_symmetry_t *symmetry;  /*!< Symmetries used for canonicalization
+                                     of states or NULL */
+    int reinsert_closed;        /*!< True if the open-list refers also to
+                                     closed nodes (lazy searches), so they
+                                     must be re-inserted when the search is
+                                     restored */
 
     plan_state_id_t goal_state; /*!< The found state satisfying the goal */
 };
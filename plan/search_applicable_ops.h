@@ -22,6 +22,7 @@
 
 #include <plan/op.h>
 #include <plan/succ_gen.h>
+#include <plan/problem.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +40,29 @@ struct _plan_search_applicable_ops_t {
 };
 typedef struct _plan_search_applicable_ops_t plan_search_applicable_ops_t;
 
+/**
+ * Data for incremental computation of applicable operators from the
+ * applicable operators of the parent state.
+ */
+struct _plan_search_applicable_ops_inc_t {
+    plan_op_t *op;         /*!< Operators of the problem */
+    int *var_fact;         /*!< ID of the first fact of each variable or
+                                -1 for private variables */
+    int *fact_op;          /*!< IDs of operators having the fact as
+                                precondition, stored fact by fact */
+    int *fact_op_begin;    /*!< Start of each fact in .fact_op[] */
+    int *var_mark;         /*!< Variables changed by the applied operator */
+    int *op_mark;          /*!< Operators already in the child's set */
+    int mark;              /*!< Current value of marks */
+
+    plan_op_t **base;      /*!< Applicable operators of .base_state */
+    int base_size;
+    plan_state_id_t base_state;
+    plan_state_t *state;   /*!< Preallocated state */
+};
+typedef struct _plan_search_applicable_ops_inc_t
+    plan_search_applicable_ops_inc_t;
+
 /**
  * Initializes structure.
  */
@@ -60,6 +84,48 @@ int planSearchApplicableOpsFind(plan_search_applicable_ops_t *app_ops,
                                 plan_state_id_t state_id,
                                 const plan_succ_gen_t *succ_gen);
 
+/**
+ * Same as planSearchApplicableOpsFind() but the state is given in its
+ * packed form.
+ */
+int planSearchApplicableOpsFindPacked(plan_search_applicable_ops_t *app_ops,
+                                      const plan_state_packer_t *packer,
+                                      const void *bufstate,
+                                      plan_state_id_t state_id,
+                                      const plan_succ_gen_t *succ_gen);
+
+/**
+ * Initializes structure for incremental computation of applicable
+ * operators in the given problem.
+ */
+void planSearchApplicableOpsIncInit(plan_search_applicable_ops_inc_t *inc,
+                                    const plan_problem_t *prob);
+
+/**
+ * Frees resources.
+ */
+void planSearchApplicableOpsIncFree(plan_search_applicable_ops_inc_t *inc);
+
+/**
+ * Same as planSearchApplicableOpsFind() but the state is known to be
+ * reached from parent_state_id by parent_op. The applicable operators are
+ * derived from the operators applicable in the parent state: operators
+ * with preconditions on variables changed by parent_op are removed and
+ * operators enabled by the new values are added.
+ * The parent's operators are taken either from app_ops (if it still holds
+ * the parent state) or from the copy kept in inc; otherwise they are
+ * computed from scratch using succ_gen. The operators of the child state
+ * are not found in the order given by succ_gen.
+ */
+int planSearchApplicableOpsFindInc(plan_search_applicable_ops_t *app_ops,
+                                   plan_search_applicable_ops_inc_t *inc,
+                                   const plan_state_t *state,
+                                   plan_state_id_t state_id,
+                                   plan_state_id_t parent_state_id,
+                                   const plan_op_t *parent_op,
+                                   plan_state_pool_t *state_pool,
+                                   const plan_succ_gen_t *succ_gen);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -38,6 +38,13 @@ struct _plan_search_stat_t {
     long expanded_states;
     long generated_states;
     long peak_memory;
+    long ma_private_parts; /*!< Number of unique private parts of states
+                                stored in ma-privacy mode */
+    long ma_private_mem;   /*!< Memory (in bytes) used for the private
+                                parts and private state IDs */
+    long symmetry_generators; /*!< Number of generators of symmetries */
+    long symmetry_pruned;  /*!< Number of generated states replaced by an
+                                already known symmetric state */
     int found;
 };
 typedef struct _plan_search_stat_t plan_search_stat_t;
@@ -0,0 +1,97 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_SEARCH_STUBBORN_H__
+#define __PLAN_SEARCH_STUBBORN_H__
+
+#include <plan/problem.h>
+#include <plan/search_applicable_ops.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Number of pruned states after which the pruning ratio is checked.
+ */
+#define PLAN_SEARCH_STUBBORN_CHECK_AFTER 1000
+
+/**
+ * Minimal ratio of pruned applicable operators. If less operators were
+ * pruned during the first PLAN_SEARCH_STUBBORN_CHECK_AFTER states the
+ * pruning is switched off.
+ */
+#define PLAN_SEARCH_STUBBORN_MIN_RATIO 0.2
+
+/**
+ * Pruning of applicable operators using strong stubborn sets.
+ * Only the operators from the stubborn set of the state are expanded,
+ * which preserves completeness and optimality of the search.
+ * Problems with conditional effects, ma-privacy variable and agents'
+ * problems are not supported and the pruning is disabled for them.
+ */
+struct _plan_search_stubborn_t {
+    const plan_op_t *op;     /*!< Operators of the problem */
+    int op_size;
+    const plan_part_state_t *goal;
+    int *var_fact;           /*!< ID of the first fact of each variable */
+    int *fact_pre;           /*!< Operators with the fact as precondition,
+                                  stored fact by fact */
+    int *fact_pre_begin;     /*!< Start of each fact in .fact_pre[] */
+    int *fact_eff;           /*!< Operators with the fact as effect */
+    int *fact_eff_begin;     /*!< Start of each fact in .fact_eff[] */
+    int **interfere;         /*!< Interfering operators of each operator,
+                                  computed on demand */
+    int *interfere_size;
+    int *op_mark;            /*!< Operators in the current stubborn set */
+    int mark;                /*!< Current value of the mark */
+    int *queue;              /*!< Operators waiting for processing */
+
+    int enabled;             /*!< True if the pruning is active */
+    long pruned_states;      /*!< Number of calls of the pruning */
+    long ops_before;         /*!< Applicable operators before pruning */
+    long ops_after;          /*!< Applicable operators after pruning */
+};
+typedef struct _plan_search_stubborn_t plan_search_stubborn_t;
+
+/**
+ * Initializes the structure for the given problem.
+ */
+void planSearchStubbornInit(plan_search_stubborn_t *ss,
+                            const plan_problem_t *prob);
+
+/**
+ * Frees allocated resources.
+ */
+void planSearchStubbornFree(plan_search_stubborn_t *ss);
+
+/**
+ * Restricts the applicable operators app->op[] in the given state to its
+ * strong stubborn set. The kept operators are moved to the beginning of
+ * app->op[] and app->op_found is set accordingly.
+ */
+void planSearchStubbornPrune(plan_search_stubborn_t *ss,
+                             const plan_state_t *state,
+                             plan_search_applicable_ops_t *app);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_SEARCH_STUBBORN_H__ */
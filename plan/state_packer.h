@@ -144,6 +144,13 @@ void planStatePackerSetPrivatePart(const plan_state_packer_t *p,
                                    const void *private_buffer,
                                    void *bufstate);
 
+/**
+ * Returns value of the variable directly from the packed state.
+ */
+plan_val_t planStatePackerGetVar(const plan_state_packer_t *p,
+                                 plan_var_id_t var,
+                                 const void *buf);
+
 /**
  * Sets value of the ma-privacy variable directly into packed state.
  */
@@ -21,18 +21,55 @@
 #define __PLAN_SUCCGEN_H__
 
 #include <plan/op.h>
+#include <plan/state_packer.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
-struct _plan_succ_gen_tree_t;
+struct _plan_succ_gen_node_t;
+
+/**
+ * Flags for planSuccGenPack():
+ * Force testing of packed preconditions of all operators (_MASK) or
+ * force use of the decision tree (_TREE). If none is set, the cheaper
+ * method is chosen by a cost model.
+ */
+#define PLAN_SUCC_GEN_MASK 0x1u
+#define PLAN_SUCC_GEN_TREE 0x2u
+
+/**
+ * Number of operators whose packed preconditions are tested at once.
+ */
+#define PLAN_SUCC_GEN_MASK_BLOCK 8
 
 /**
  * Successor generator.
+ * The decision tree is stored in one contiguous buffer: an array of
+ * nodes (the root is the first one), an array of immediate operators of
+ * all nodes and an array of indexes of subtrees of all nodes. Nodes
+ * refer to each other by indexes instead of pointers.
  */
 struct _plan_succ_gen_t {
-    struct _plan_succ_gen_tree_t *root; /*!< Root of decision tree */
+    struct _plan_succ_gen_node_t *node; /*!< Nodes of decision tree */
+    int node_size;
+    plan_op_t **ops;                    /*!< Immediate operators */
+    int *child;                         /*!< Subtrees indexed by values */
+    int max_depth;                      /*!< Depth of decision tree */
+    void *buf;                          /*!< Buffer holding all above, or
+                                             only .ops if the generator was
+                                             loaded by planSuccGenFromBin() */
+
+    plan_op_t *mask_op;                 /*!< Operators tested by packed
+                                             preconditions, NULL if the
+                                             decision tree is used */
+    int mask_op_size;
+    int mask_words;                     /*!< Words of packed state */
+    plan_packer_word_t *mask;           /*!< Masks of preconditions of
+                                             blocks of operators interleaved
+                                             word by word */
+    plan_packer_word_t *mask_val;       /*!< Values of preconditions, same
+                                             layout as .mask */
     int num_operators;
     plan_var_id_t *var_order;           /*!< Copied order of variables to
                                              enable cloning of the object */
@@ -51,11 +88,61 @@ plan_succ_gen_t *planSuccGenNew(const plan_op_t *op, int opsize,
 
 /**
  * Loads successor generator from FD definition.
+ * The rest of the stream is read into memory and parsed by
+ * planSuccGenFromFDBuf(), then the stream is moved right behind the
+ * definition (if the stream is seekable).
  */
 plan_succ_gen_t *planSuccGenFromFD(FILE *fin,
                                    const plan_var_t *vars,
                                    plan_op_t *op);
 
+/**
+ * Loads successor generator from FD definition stored in the buffer
+ * [*buf, end). On return, *buf points right behind the definition.
+ */
+plan_succ_gen_t *planSuccGenFromFDBuf(const char **buf, const char *end,
+                                      const plan_var_t *vars,
+                                      plan_op_t *op);
+
+/**
+ * Returns number of bytes needed for planSuccGenToBin().
+ */
+size_t planSuccGenBinSize(const plan_succ_gen_t *sg);
+
+/**
+ * Serializes the decision tree into buf which must be at least
+ * planSuccGenBinSize() bytes long and aligned to 8 bytes. Operators are
+ * stored as indexes into the array op the generator was created from.
+ */
+void planSuccGenToBin(const plan_succ_gen_t *sg, const plan_op_t *op,
+                      void *buf);
+
+/**
+ * Creates successor generator from the buffer filled by
+ * planSuccGenToBin(). The nodes of the decision tree are not copied, so
+ * buf must stay valid until the generator is deleted.
+ * Returns NULL if buf does not contain a valid successor generator.
+ */
+plan_succ_gen_t *planSuccGenFromBin(const void *buf, size_t size,
+                                    plan_op_t *op, int op_size,
+                                    int var_size);
+
+/**
+ * Prepares the successor generator for testing of packed preconditions
+ * of operators. It is expected that the operators were already packed
+ * (see planOpPack()) and that op is the same array the generator was
+ * created from. Whether the packed preconditions will be used by
+ * planSuccGenFindPacked() instead of the decision tree is decided by a
+ * cost model unless forced by flags (see PLAN_SUCC_GEN_* above).
+ */
+void planSuccGenPack(plan_succ_gen_t *sg, plan_op_t *op, int op_size,
+                     unsigned flags);
+
+/**
+ * Returns true if planSuccGenFindPacked() tests packed preconditions.
+ */
+_bor_inline int planSuccGenUseMask(const plan_succ_gen_t *sg);
+
 /**
  * Deletes successor generator.
  */
@@ -82,6 +169,17 @@ int planSuccGenFindPart(const plan_succ_gen_t *sg,
                         const plan_part_state_t *part_state,
                         plan_op_t **op, int op_size);
 
+/**
+ * Same as planSuccGenFind() but the values are read directly from the
+ * packed state without unpacking it first. If planSuccGenPack() selected
+ * testing of packed preconditions, the operators are found in the order
+ * of the op array.
+ */
+int planSuccGenFindPacked(const plan_succ_gen_t *sg,
+                          const plan_state_packer_t *packer,
+                          const void *bufstate,
+                          plan_op_t **op, int op_size);
+
 
 /**** INLINES ****/
 _bor_inline int planSuccGenNumOperators(const plan_succ_gen_t *sg)
@@ -89,6 +187,11 @@ _bor_inline int planSuccGenNumOperators(const plan_succ_gen_t *sg)
     return sg->num_operators;
 }
 
+_bor_inline int planSuccGenUseMask(const plan_succ_gen_t *sg)
+{
+    return sg->mask_op != NULL;
+}
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */
@@ -0,0 +1,138 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_SYMMETRY_H__
+#define __PLAN_SYMMETRY_H__
+
+#include <plan/problem.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Maximal number of search nodes explored for a single candidate vertex
+ * when looking for an automorphism.
+ */
+#define PLAN_SYMMETRY_BRANCH_LIMIT 64
+
+/**
+ * Maximal number of integers used for storing partitions during the
+ * search for automorphisms. The search is skipped if the limit is
+ * exceeded.
+ */
+#define PLAN_SYMMETRY_MAX_PART_MEM (1 << 25)
+
+/**
+ * One generator of the symmetry group.
+ */
+struct _plan_symmetry_gen_t {
+    int *var;    /*!< Mapping of variables */
+    int *fact;   /*!< Mapping of facts (see plan_symmetry_t.var_fact) */
+    int *op;     /*!< Mapping of operators */
+    int *op_inv; /*!< Inverse mapping of operators */
+};
+typedef struct _plan_symmetry_gen_t plan_symmetry_gen_t;
+
+/**
+ * Structural symmetries of the planning problem.
+ * The generators are automorphisms of the problem description graph
+ * consisting of variables, facts and operators, where goal facts and
+ * operators of different costs are distinguished by colors. States are
+ * reduced to a canonical representative of their orbit by greedy
+ * lexicographic minimization over the generators.
+ * Problems with conditional effects or ma-privacy variable are not
+ * supported -- no generators are computed for them.
+ */
+struct _plan_symmetry_t {
+    int var_size;
+    int *var_fact;             /*!< ID of the first fact of each variable */
+    int fact_size;
+    plan_op_t *op;             /*!< Operators of the problem */
+    int op_size;
+
+    plan_symmetry_gen_t *gen;  /*!< Generators */
+    int gen_size;
+
+    plan_state_t *state;       /*!< Preallocated states */
+    plan_state_t *state2;
+    int *trace;                /*!< Indexes of generators applied during
+                                    the last canonicalization */
+    int trace_size;
+    int trace_alloc;
+    int record_trace;          /*!< True if .trace should be filled */
+};
+typedef struct _plan_symmetry_t plan_symmetry_t;
+
+/**
+ * Initializes the structure and computes generators of the problem.
+ */
+void planSymmetryInit(plan_symmetry_t *sym, const plan_problem_t *prob);
+
+/**
+ * Frees allocated resources.
+ */
+void planSymmetryFree(plan_symmetry_t *sym);
+
+/**
+ * Transforms the state into the canonical representative of its orbit.
+ * Returns true if the state was changed.
+ */
+int planSymmetryCanonicalize(plan_symmetry_t *sym, plan_state_t *state);
+
+/**
+ * Returns ID of the canonical representative of the given state.
+ * If pruned is non-NULL, it is set to true if the representative
+ * differs from the state and it was already in the pool.
+ */
+plan_state_id_t planSymmetryCanonicalStateId(plan_symmetry_t *sym,
+                                             plan_state_pool_t *pool,
+                                             plan_state_id_t state_id,
+                                             int *pruned);
+
+/**
+ * Applies the operator on the state and returns ID of the canonical
+ * representative of the resulting state. The state is not modified.
+ * The pruned flag is set in the same way as in
+ * planSymmetryCanonicalStateId().
+ */
+plan_state_id_t planSymmetryApplyOp(plan_symmetry_t *sym,
+                                    plan_state_pool_t *pool,
+                                    const plan_state_t *state,
+                                    const plan_op_t *op,
+                                    int *pruned);
+
+/**
+ * Transforms a path found among canonical states into a path applicable
+ * in the initial state init_state. The path starts in the canonical
+ * representative of init_state and op[i] leads from the state to a state
+ * symmetric to the next one. On output, op[] contains operators of the
+ * real plan and state[0..op_size] the states it traverses.
+ */
+void planSymmetryRepairPath(plan_symmetry_t *sym,
+                            plan_state_pool_t *pool,
+                            plan_state_id_t init_state,
+                            plan_op_t **op, int op_size,
+                            plan_state_id_t *state);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_SYMMETRY_H__ */
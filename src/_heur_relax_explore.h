@@ -26,18 +26,17 @@
 #endif
 
 {
-    plan_prio_queue_t queue;
+    plan_prio_queue_t *queue = &relax->queue;
     int i, size, *op, op_id;
     int fact_id;
     plan_cost_t value;
     plan_heur_relax_fact_t *fact;
 
     relaxInit(relax);
-    planPrioQueueInit(&queue);
 
-    relaxAddInitState(relax, &queue, state);
-    while (!planPrioQueueEmpty(&queue)){
-        fact_id = planPrioQueuePop(&queue, &value);
+    relaxAddInitState(relax, queue, state);
+    while (!planPrioQueueEmpty(queue)){
+        fact_id = planPrioQueuePop(queue, &value);
         fact = relax->fact + fact_id;
         if (fact->value != value)
             continue;
@@ -52,7 +51,7 @@
         }
     }
 
-    planPrioQueueFree(&queue);
+    planPrioQueueClear(queue);
 }
 
 #undef PLAN_HEUR_RELAX_EXPLORE_CHECK_GOAL
@@ -0,0 +1,171 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_FD_READER_H__
+#define __PLAN_FD_READER_H__
+
+#include <string.h>
+#include <limits.h>
+#include <boruvka/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Tokenizer of Fast-Downward's SAS+ files held in memory.
+ * Tokens are separated by white space; the buffer does not need to be
+ * zero terminated.
+ */
+struct _plan_fd_reader_t {
+    const char *cur; /*!< Next character to read */
+    const char *end; /*!< End of the buffer */
+};
+typedef struct _plan_fd_reader_t plan_fd_reader_t;
+
+/**
+ * Initializes reader over the buffer [buf, buf + size).
+ */
+_bor_inline void planFDReaderInit(plan_fd_reader_t *r,
+                                  const char *buf, size_t size);
+
+/**
+ * Reads next token. The token is not zero terminated, its length is
+ * returned in len.
+ * Returns 0 on success, -1 if there is no more token.
+ */
+_bor_inline int planFDReaderWord(plan_fd_reader_t *r,
+                                 const char **word, int *len);
+
+/**
+ * Reads next token and checks that it equals to str.
+ * Returns 0 on success, -1 otherwise.
+ */
+_bor_inline int planFDReaderAssert(plan_fd_reader_t *r, const char *str);
+
+/**
+ * Reads next token as a decimal integer, the token must not contain
+ * anything after the digits.
+ * Returns 0 on success, -1 otherwise.
+ */
+_bor_inline int planFDReaderInt(plan_fd_reader_t *r, int *val);
+
+/**
+ * Reads the rest of the current line without the terminating '\n' and
+ * moves to the beginning of the next line.
+ * Returns 0 on success, -1 at the end of the buffer.
+ */
+_bor_inline int planFDReaderLine(plan_fd_reader_t *r,
+                                 const char **line, int *len);
+
+
+/**** INLINES: ****/
+_bor_inline int _planFDReaderIsSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r'
+            || c == '\v' || c == '\f';
+}
+
+_bor_inline void planFDReaderInit(plan_fd_reader_t *r,
+                                  const char *buf, size_t size)
+{
+    r->cur = buf;
+    r->end = buf + size;
+}
+
+_bor_inline int planFDReaderWord(plan_fd_reader_t *r,
+                                 const char **word, int *len)
+{
+    const char *c = r->cur;
+
+    while (c < r->end && _planFDReaderIsSpace(*c))
+        ++c;
+    *word = c;
+    while (c < r->end && !_planFDReaderIsSpace(*c))
+        ++c;
+    *len = c - *word;
+    r->cur = c;
+    return (*len > 0 ? 0 : -1);
+}
+
+_bor_inline int planFDReaderAssert(plan_fd_reader_t *r, const char *str)
+{
+    const char *word;
+    int len;
+
+    if (planFDReaderWord(r, &word, &len) != 0)
+        return -1;
+    if (strncmp(word, str, len) != 0 || str[len] != 0x0)
+        return -1;
+    return 0;
+}
+
+_bor_inline int planFDReaderInt(plan_fd_reader_t *r, int *val)
+{
+    const char *c = r->cur;
+    long v = 0;
+    int neg = 0;
+
+    while (c < r->end && _planFDReaderIsSpace(*c))
+        ++c;
+    if (c < r->end && (*c == '-' || *c == '+')){
+        neg = (*c == '-');
+        ++c;
+    }
+    if (c == r->end || *c < '0' || *c > '9')
+        return -1;
+
+    for (; c < r->end && *c >= '0' && *c <= '9'; ++c){
+        v = v * 10 + (*c - '0');
+        if (v > INT_MAX)
+            return -1;
+    }
+    // The number must be a whole word, e.g., "12abc" is not a number
+    if (c < r->end && !_planFDReaderIsSpace(*c))
+        return -1;
+    r->cur = c;
+    *val = (neg ? -v : v);
+    return 0;
+}
+
+_bor_inline int planFDReaderLine(plan_fd_reader_t *r,
+                                 const char **line, int *len)
+{
+    const char *nl;
+
+    if (r->cur >= r->end)
+        return -1;
+
+    *line = r->cur;
+    nl = memchr(r->cur, '\n', r->end - r->cur);
+    if (nl == NULL){
+        *len = r->end - r->cur;
+        r->cur = r->end;
+    }else{
+        *len = nl - r->cur;
+        r->cur = nl + 1;
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_FD_READER_H__ */
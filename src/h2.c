@@ -0,0 +1,707 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <boruvka/alloc.h>
+
+#include "h2.h"
+
+/**
+ * Operator (or regression of an operator) prepared for the fixpoint
+ * computation.
+ */
+struct _h2_op_t {
+    int *pre;     /*!< Precondition facts */
+    int pre_size;
+    int *eff;     /*!< Effect facts, more facts of the same variable mean
+                       that any of them can be achieved */
+    int eff_size;
+    int *eff_var; /*!< Variables changed by the operator */
+    int eff_var_size;
+};
+typedef struct _h2_op_t h2_op_t;
+
+/**
+ * Newly reached pair of facts, a fact paired with itself means the fact
+ * was newly reached.
+ */
+struct _h2_pair_t {
+    int f1;
+    int f2;
+};
+typedef struct _h2_pair_t h2_pair_t;
+
+/**
+ * Reachable facts and pairs of facts of one direction of the analysis.
+ * Facts of the same variable are never paired.
+ */
+struct _h2_run_t {
+    const plan_h2_t *h2;
+    char *fact;          /*!< Reached facts */
+    uint8_t *pair;       /*!< Reached pairs of facts */
+    const char *mask_fact; /*!< If set, only these facts can be reached */
+    const uint8_t *mask_pair; /*!< If set, only these pairs can be reached */
+    char *op_app;        /*!< Operators found applicable */
+
+    int *reached;        /*!< List of reached facts */
+    int reached_size;
+    int *fact_pairs;     /*!< Number of reached pairs of each fact */
+    size_t pair_size;    /*!< Number of reached pairs */
+    h2_pair_t *agenda;   /*!< Reached pairs that were not propagated to
+                              the operators yet */
+    size_t agenda_size;
+    size_t agenda_alloc;
+};
+typedef struct _h2_run_t h2_run_t;
+
+/** Creates operators for the forward analysis */
+static h2_op_t *opsForward(const plan_h2_t *h2, const plan_op_t *op);
+/** Creates regression operators for the backward analysis, variables
+ *  changed by an operator without a precondition can have any value (the
+ *  backward run is masked by the forward run) */
+static h2_op_t *opsBackward(const plan_h2_t *h2, const plan_op_t *op);
+static void opsFree(h2_op_t *op, int op_size);
+
+static void runInit(h2_run_t *r, const plan_h2_t *h2,
+                    char *fact, uint8_t *pair);
+static void runFree(h2_run_t *r);
+/** Computes fixpoint of reachable facts and pairs starting from the facts
+ *  and pairs on the agenda */
+static void runFixpoint(h2_run_t *r, const h2_op_t *op, const char *alive);
+static int runSetFact(h2_run_t *r, int f);
+static int runSetPair(h2_run_t *r, int f1, int f2);
+static int runHasPair(const h2_run_t *r, int f1, int f2);
+
+/** Marks operators that were not applicable in the run as not alive and
+ *  returns their number */
+static int removeOps(plan_h2_t *h2, const h2_run_t *r);
+/** Computes the forward run from the initial state */
+static void forward(plan_h2_t *h2, h2_run_t *r, const h2_op_t *op,
+                    const plan_state_t *init);
+/** Computes the backward run from the goal */
+static void backward(plan_h2_t *h2, h2_run_t *r, const h2_op_t *op,
+                     const plan_part_state_t *goal);
+/** Returns true if the partial state is reachable in the run */
+static int partStateReached(const plan_h2_t *h2, const h2_run_t *r,
+                            const plan_part_state_t *ps);
+
+int planH2Init(plan_h2_t *h2, const plan_var_t *var, int var_size,
+               const plan_state_t *init, const plan_part_state_t *goal,
+               const plan_op_t *op, int op_size)
+{
+    h2_run_t fw, bw;
+    h2_op_t *fw_op, *bw_op;
+    char *bw_fact;
+    uint8_t *bw_pair;
+    size_t pair_size, fw_pair_size;
+    int i, j, fact_size, fw_fact_size, removed;
+
+    for (fact_size = 0, i = 0; i < var_size; ++i){
+        if (var[i].ma_privacy)
+            return -1;
+        fact_size += var[i].range;
+    }
+    for (i = 0; i < op_size; ++i){
+        if (op[i].cond_eff_size > 0)
+            return -1;
+    }
+    if (fact_size > PLAN_H2_MAX_FACTS)
+        return -1;
+
+    bzero(h2, sizeof(*h2));
+    h2->var_size = var_size;
+    h2->fact_size = fact_size;
+    h2->op_size = op_size;
+    h2->var_fact = BOR_ALLOC_ARR(int, var_size + 1);
+    h2->fact_var = BOR_ALLOC_ARR(int, BOR_MAX(fact_size, 1));
+    for (fact_size = 0, i = 0; i < var_size; ++i){
+        h2->var_fact[i] = fact_size;
+        for (j = 0; j < (int)var[i].range; ++j)
+            h2->fact_var[fact_size++] = i;
+    }
+    h2->var_fact[var_size] = fact_size;
+
+    pair_size = ((size_t)fact_size * fact_size + 7) / 8;
+    h2->fact = BOR_ALLOC_ARR(char, BOR_MAX(fact_size, 1));
+    h2->pair = BOR_ALLOC_ARR(uint8_t, BOR_MAX(pair_size, 1));
+    bw_fact = BOR_ALLOC_ARR(char, BOR_MAX(fact_size, 1));
+    bw_pair = BOR_ALLOC_ARR(uint8_t, BOR_MAX(pair_size, 1));
+    h2->op_alive = BOR_ALLOC_ARR(char, BOR_MAX(op_size, 1));
+    memset(h2->op_alive, 1, op_size);
+    h2->solvable = 1;
+
+    runInit(&fw, h2, h2->fact, h2->pair);
+    runInit(&bw, h2, bw_fact, bw_pair);
+    bw.mask_fact = h2->fact;
+    bw.mask_pair = h2->pair;
+
+    // Facts of the backward operators that are not reachable in the
+    // forward direction are masked out, so both sets of operators stay
+    // the same for all iterations
+    fw_op = opsForward(h2, op);
+    bw_op = opsBackward(h2, op);
+
+    // Removing an operator that was not applicable in a run does not
+    // change the run, and all operators that remain after a run are
+    // applicable in it. So the forward run is recomputed only if the
+    // backward run removed some operators, and the backward run only if
+    // the forward run removed some operators or lost some facts or pairs
+    // (they mask the backward run). Reached sets can only shrink, so
+    // comparing their sizes is enough.
+    forward(h2, &fw, fw_op, init);
+    removeOps(h2, &fw);
+    while (h2->solvable){
+        if (!partStateReached(h2, &fw, goal)){
+            h2->solvable = 0;
+            break;
+        }
+
+        backward(h2, &bw, bw_op, goal);
+        for (i = 0; i < var_size; ++i){
+            if (!bw_fact[h2->var_fact[i] + planStateGet(init, i)])
+                h2->solvable = 0;
+        }
+        if (removeOps(h2, &bw) == 0 || !h2->solvable)
+            break;
+
+        fw_fact_size = fw.reached_size;
+        fw_pair_size = fw.pair_size;
+        forward(h2, &fw, fw_op, init);
+        removed = removeOps(h2, &fw);
+        if (removed == 0
+                && fw.reached_size == fw_fact_size
+                && fw.pair_size == fw_pair_size)
+            break;
+    }
+
+    if (!h2->solvable)
+        bzero(h2->op_alive, op_size);
+
+    opsFree(fw_op, op_size);
+    opsFree(bw_op, op_size);
+    runFree(&fw);
+    runFree(&bw);
+    BOR_FREE(bw_fact);
+    BOR_FREE(bw_pair);
+    return 0;
+}
+
+void planH2Free(plan_h2_t *h2)
+{
+    BOR_FREE(h2->var_fact);
+    BOR_FREE(h2->fact_var);
+    BOR_FREE(h2->fact);
+    BOR_FREE(h2->pair);
+    BOR_FREE(h2->op_alive);
+}
+
+int planH2TightenPre(const plan_h2_t *h2, plan_op_t *op)
+{
+    plan_var_id_t pvar;
+    plan_val_t pval;
+    int var, fact, cand, cand_size, reachable, ok, i, added = 0;
+
+    for (var = 0; var < h2->var_size; ++var){
+        if (planPartStateIsSet(op->pre, var))
+            continue;
+
+        cand = -1;
+        cand_size = reachable = 0;
+        for (fact = h2->var_fact[var]; fact < h2->var_fact[var + 1]; ++fact){
+            if (!h2->fact[fact])
+                continue;
+            ++reachable;
+
+            ok = 1;
+            PLAN_PART_STATE_FOR_EACH(op->pre, i, pvar, pval){
+                if (planH2IsMutex(h2, fact, planH2Fact(h2, pvar, pval))){
+                    ok = 0;
+                    break;
+                }
+            }
+            if (ok){
+                cand = fact;
+                ++cand_size;
+            }
+        }
+
+        if (cand_size == 0)
+            return -1;
+
+        // Constant variables would only make the operator longer
+        if (cand_size == 1 && reachable > 1){
+            planPartStateSet(op->pre, var, cand - h2->var_fact[var]);
+            ++added;
+        }
+    }
+
+    return added;
+}
+
+static h2_op_t *opsForward(const plan_h2_t *h2, const plan_op_t *op)
+{
+    h2_op_t *hop;
+    plan_var_id_t var;
+    plan_val_t val;
+    int i, j;
+
+    hop = BOR_CALLOC_ARR(h2_op_t, BOR_MAX(h2->op_size, 1));
+    for (i = 0; i < h2->op_size; ++i){
+        hop[i].pre = BOR_ALLOC_ARR(int, BOR_MAX(op[i].pre->vals_size, 1));
+        PLAN_PART_STATE_FOR_EACH(op[i].pre, j, var, val)
+            hop[i].pre[hop[i].pre_size++] = planH2Fact(h2, var, val);
+
+        hop[i].eff = BOR_ALLOC_ARR(int, BOR_MAX(op[i].eff->vals_size, 1));
+        hop[i].eff_var = BOR_ALLOC_ARR(int, BOR_MAX(op[i].eff->vals_size, 1));
+        PLAN_PART_STATE_FOR_EACH(op[i].eff, j, var, val){
+            hop[i].eff[hop[i].eff_size++] = planH2Fact(h2, var, val);
+            hop[i].eff_var[hop[i].eff_var_size++] = var;
+        }
+    }
+    return hop;
+}
+
+static h2_op_t *opsBackward(const plan_h2_t *h2, const plan_op_t *op)
+{
+    h2_op_t *hop;
+    plan_var_id_t var;
+    plan_val_t val;
+    int i, j, fact, size;
+
+    hop = BOR_CALLOC_ARR(h2_op_t, BOR_MAX(h2->op_size, 1));
+    for (i = 0; i < h2->op_size; ++i){
+        // Regression requires the effects and the prevail conditions
+        size = op[i].pre->vals_size + op[i].eff->vals_size;
+        hop[i].pre = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+        PLAN_PART_STATE_FOR_EACH(op[i].eff, j, var, val)
+            hop[i].pre[hop[i].pre_size++] = planH2Fact(h2, var, val);
+        PLAN_PART_STATE_FOR_EACH(op[i].pre, j, var, val){
+            if (!planPartStateIsSet(op[i].eff, var))
+                hop[i].pre[hop[i].pre_size++] = planH2Fact(h2, var, val);
+        }
+
+        // ...and achieves preconditions of the changed variables
+        size = 0;
+        PLAN_PART_STATE_FOR_EACH(op[i].eff, j, var, val){
+            if (planPartStateIsSet(op[i].pre, var)){
+                ++size;
+            }else{
+                size += h2->var_fact[var + 1] - h2->var_fact[var];
+            }
+        }
+        hop[i].eff = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+        hop[i].eff_var = BOR_ALLOC_ARR(int, BOR_MAX(op[i].eff->vals_size, 1));
+        PLAN_PART_STATE_FOR_EACH(op[i].eff, j, var, val){
+            hop[i].eff_var[hop[i].eff_var_size++] = var;
+            if (planPartStateIsSet(op[i].pre, var)){
+                fact = planH2Fact(h2, var, planPartStateGet(op[i].pre, var));
+                hop[i].eff[hop[i].eff_size++] = fact;
+                continue;
+            }
+
+            for (fact = h2->var_fact[var];
+                    fact < h2->var_fact[var + 1]; ++fact){
+                hop[i].eff[hop[i].eff_size++] = fact;
+            }
+        }
+    }
+    return hop;
+}
+
+static void opsFree(h2_op_t *op, int op_size)
+{
+    int i;
+
+    for (i = 0; i < op_size; ++i){
+        if (op[i].pre)
+            BOR_FREE(op[i].pre);
+        if (op[i].eff)
+            BOR_FREE(op[i].eff);
+        if (op[i].eff_var)
+            BOR_FREE(op[i].eff_var);
+    }
+    BOR_FREE(op);
+}
+
+static void runInit(h2_run_t *r, const plan_h2_t *h2,
+                    char *fact, uint8_t *pair)
+{
+    r->h2 = h2;
+    r->fact = fact;
+    r->pair = pair;
+    r->mask_fact = NULL;
+    r->mask_pair = NULL;
+    r->op_app = BOR_ALLOC_ARR(char, BOR_MAX(h2->op_size, 1));
+    r->reached = BOR_ALLOC_ARR(int, BOR_MAX(h2->fact_size, 1));
+    r->fact_pairs = BOR_ALLOC_ARR(int, BOR_MAX(h2->fact_size, 1));
+    r->agenda_alloc = BOR_MAX(h2->fact_size, 1);
+    r->agenda = BOR_ALLOC_ARR(h2_pair_t, r->agenda_alloc);
+    r->agenda_size = 0;
+}
+
+static void runFree(h2_run_t *r)
+{
+    BOR_FREE(r->op_app);
+    BOR_FREE(r->reached);
+    BOR_FREE(r->fact_pairs);
+    BOR_FREE(r->agenda);
+}
+
+/** Resets the run to the empty set of facts */
+static void runReset(h2_run_t *r)
+{
+    const plan_h2_t *h2 = r->h2;
+    size_t size = ((size_t)h2->fact_size * h2->fact_size + 7) / 8;
+
+    bzero(r->fact, h2->fact_size);
+    bzero(r->pair, size);
+    bzero(r->op_app, h2->op_size);
+    bzero(r->fact_pairs, sizeof(int) * h2->fact_size);
+    r->reached_size = 0;
+    r->pair_size = 0;
+    r->agenda_size = 0;
+}
+
+_bor_inline int pairBit(const uint8_t *pair, size_t fact_size,
+                        int f1, int f2)
+{
+    size_t bit = (size_t)f1 * fact_size + f2;
+    return pair[bit >> 3] & (1u << (bit & 7u));
+}
+
+_bor_inline void pairBitSet(uint8_t *pair, size_t fact_size, int f1, int f2)
+{
+    size_t bit = (size_t)f1 * fact_size + f2;
+    pair[bit >> 3] |= (1u << (bit & 7u));
+}
+
+static void runAgendaPush(h2_run_t *r, int f1, int f2)
+{
+    if (r->agenda_size == r->agenda_alloc){
+        r->agenda_alloc *= 2;
+        r->agenda = BOR_REALLOC_ARR(r->agenda, h2_pair_t, r->agenda_alloc);
+    }
+    r->agenda[r->agenda_size].f1 = f1;
+    r->agenda[r->agenda_size].f2 = f2;
+    ++r->agenda_size;
+}
+
+static int runSetFact(h2_run_t *r, int f)
+{
+    if (r->fact[f] || (r->mask_fact && !r->mask_fact[f]))
+        return 0;
+    r->fact[f] = 1;
+    pairBitSet(r->pair, r->h2->fact_size, f, f);
+    r->reached[r->reached_size++] = f;
+    ++r->fact_pairs[f];
+    ++r->pair_size;
+    runAgendaPush(r, f, f);
+    return 1;
+}
+
+static int runSetPair(h2_run_t *r, int f1, int f2)
+{
+    size_t fact_size = r->h2->fact_size;
+
+    if (pairBit(r->pair, fact_size, f1, f2))
+        return 0;
+    if (r->mask_pair && !pairBit(r->mask_pair, fact_size, f1, f2))
+        return 0;
+    pairBitSet(r->pair, fact_size, f1, f2);
+    pairBitSet(r->pair, fact_size, f2, f1);
+    ++r->fact_pairs[f1];
+    ++r->fact_pairs[f2];
+    ++r->pair_size;
+    runAgendaPush(r, f1, f2);
+    return 1;
+}
+
+static int runHasPair(const h2_run_t *r, int f1, int f2)
+{
+    return pairBit(r->pair, r->h2->fact_size, f1, f2);
+}
+
+/** Returns the number of preconditions and pairs of preconditions of the
+ *  operator */
+static int opPreSize(const h2_op_t *op)
+{
+    return op->pre_size + op->pre_size * (op->pre_size - 1) / 2;
+}
+
+/** Returns true if the precondition of the operator contains the fact */
+static int opHasPre(const h2_op_t *op, int f)
+{
+    int i;
+
+    for (i = 0; i < op->pre_size; ++i){
+        if (op->pre[i] == f)
+            return 1;
+    }
+    return 0;
+}
+
+/** Adds pairs of the effects with the fact if it may be preserved from a
+ *  state where the operator is applicable, i.e., the fact is not changed
+ *  by the operator and it is paired with all preconditions. Facts of the
+ *  same variable are never paired, so this also excludes facts
+ *  contradicting the preconditions. */
+static void runApplyOpPreserved(h2_run_t *r, const h2_op_t *op, int f)
+{
+    const plan_h2_t *h2 = r->h2;
+    int i;
+
+    if (!r->fact[f])
+        return;
+    for (i = 0; i < op->eff_var_size; ++i){
+        if (h2->fact_var[f] == op->eff_var[i])
+            return;
+    }
+    for (i = 0; i < op->pre_size; ++i){
+        if (!runHasPair(r, f, op->pre[i]))
+            return;
+    }
+
+    for (i = 0; i < op->eff_size; ++i)
+        runSetPair(r, op->eff[i], f);
+}
+
+/** Adds effects of the operator with their pairs, and pairs of effects
+ *  with all facts that may be preserved from a state where the operator
+ *  is applicable. Such facts must be paired with all preconditions, so
+ *  only the facts paired with the precondition having the least pairs
+ *  are scanned. Facts that can be preserved later are found from the
+ *  agenda. */
+static void runApplyOp(h2_run_t *r, const h2_op_t *op)
+{
+    const plan_h2_t *h2 = r->h2;
+    const uint8_t *row = r->pair;
+    size_t bit;
+    int i, j, f, pre;
+
+    for (i = 0; i < op->eff_size; ++i){
+        runSetFact(r, op->eff[i]);
+        for (j = i + 1; j < op->eff_size; ++j){
+            if (h2->fact_var[op->eff[i]] != h2->fact_var[op->eff[j]])
+                runSetPair(r, op->eff[i], op->eff[j]);
+        }
+    }
+
+    if (op->pre_size == 0){
+        // New facts are appended to the list while it is scanned
+        for (i = 0; i < r->reached_size; ++i)
+            runApplyOpPreserved(r, op, r->reached[i]);
+        return;
+    }
+
+    pre = op->pre[0];
+    for (i = 1; i < op->pre_size; ++i){
+        if (r->fact_pairs[op->pre[i]] < r->fact_pairs[pre])
+            pre = op->pre[i];
+    }
+
+    // Scan the row of the pair matrix skipping empty bytes
+    bit = (size_t)pre * h2->fact_size;
+    for (f = 0; f < h2->fact_size; ++f, ++bit){
+        if ((bit & 7u) == 0 && f + 8 <= h2->fact_size
+                && row[bit >> 3] == 0){
+            f += 7;
+            bit += 7;
+            continue;
+        }
+        if (row[bit >> 3] & (1u << (bit & 7u)))
+            runApplyOpPreserved(r, op, f);
+    }
+}
+
+/** Builds the lists of alive operators having each fact as a
+ *  precondition */
+static void runIndexOps(const h2_run_t *r, const h2_op_t *op,
+                        const char *alive, int *fact_op_begin, int *fact_op)
+{
+    const plan_h2_t *h2 = r->h2;
+    int i, j;
+
+    bzero(fact_op_begin, sizeof(int) * (h2->fact_size + 1));
+    for (i = 0; i < h2->op_size; ++i){
+        if (!alive[i])
+            continue;
+        for (j = 0; j < op[i].pre_size; ++j)
+            ++fact_op_begin[op[i].pre[j] + 1];
+    }
+    for (i = 0; i < h2->fact_size; ++i)
+        fact_op_begin[i + 1] += fact_op_begin[i];
+
+    for (i = 0; i < h2->op_size; ++i){
+        if (!alive[i])
+            continue;
+        for (j = 0; j < op[i].pre_size; ++j)
+            fact_op[fact_op_begin[op[i].pre[j]]++] = i;
+    }
+    for (i = h2->fact_size; i > 0; --i)
+        fact_op_begin[i] = fact_op_begin[i - 1];
+    fact_op_begin[0] = 0;
+}
+
+static void runFixpoint(h2_run_t *r, const h2_op_t *op, const char *alive)
+{
+    const plan_h2_t *h2 = r->h2;
+    int *fact_op_begin, *fact_op, *op_nopre, *unreached;
+    h2_pair_t p;
+    int i, o, size, op_nopre_size;
+
+    // Each reached fact and pair is on the agenda exactly once. Operators
+    // count their preconditions and pairs of preconditions that were not
+    // reached yet, and an operator is applied once the count drops to
+    // zero. Applied operators then only check the facts from the newly
+    // reached pairs with their preconditions (or all newly reached facts
+    // if they have no preconditions).
+    for (size = 0, op_nopre_size = 0, i = 0; i < h2->op_size; ++i){
+        if (!alive[i])
+            continue;
+        size += op[i].pre_size;
+        if (op[i].pre_size == 0)
+            ++op_nopre_size;
+    }
+    fact_op_begin = BOR_ALLOC_ARR(int, h2->fact_size + 1);
+    fact_op = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+    op_nopre = BOR_ALLOC_ARR(int, BOR_MAX(op_nopre_size, 1));
+    unreached = BOR_ALLOC_ARR(int, BOR_MAX(h2->op_size, 1));
+    runIndexOps(r, op, alive, fact_op_begin, fact_op);
+    for (op_nopre_size = 0, i = 0; i < h2->op_size; ++i){
+        unreached[i] = opPreSize(op + i);
+        if (alive[i] && op[i].pre_size == 0)
+            op_nopre[op_nopre_size++] = i;
+    }
+
+    for (i = 0; i < op_nopre_size; ++i){
+        r->op_app[op_nopre[i]] = 1;
+        runApplyOp(r, op + op_nopre[i]);
+    }
+
+    while (r->agenda_size > 0){
+        p = r->agenda[--r->agenda_size];
+
+        for (i = fact_op_begin[p.f1]; i < fact_op_begin[p.f1 + 1]; ++i){
+            o = fact_op[i];
+            if (r->op_app[o]){
+                runApplyOpPreserved(r, op + o, p.f2);
+            }else if ((p.f1 == p.f2 || opHasPre(op + o, p.f2))
+                        && --unreached[o] == 0){
+                r->op_app[o] = 1;
+                runApplyOp(r, op + o);
+            }
+        }
+
+        if (p.f1 == p.f2){
+            for (i = 0; i < op_nopre_size; ++i)
+                runApplyOpPreserved(r, op + op_nopre[i], p.f1);
+            continue;
+        }
+
+        for (i = fact_op_begin[p.f2]; i < fact_op_begin[p.f2 + 1]; ++i){
+            o = fact_op[i];
+            if (r->op_app[o])
+                runApplyOpPreserved(r, op + o, p.f1);
+        }
+    }
+
+    BOR_FREE(fact_op_begin);
+    BOR_FREE(fact_op);
+    BOR_FREE(op_nopre);
+    BOR_FREE(unreached);
+}
+
+static void forward(plan_h2_t *h2, h2_run_t *r, const h2_op_t *op,
+                    const plan_state_t *init)
+{
+    int i, j, f1, f2;
+
+    runReset(r);
+    for (i = 0; i < h2->var_size; ++i){
+        f1 = planH2Fact(h2, i, planStateGet(init, i));
+        runSetFact(r, f1);
+        for (j = i + 1; j < h2->var_size; ++j){
+            f2 = planH2Fact(h2, j, planStateGet(init, j));
+            runSetPair(r, f1, f2);
+        }
+    }
+    runFixpoint(r, op, h2->op_alive);
+}
+
+static void backward(plan_h2_t *h2, h2_run_t *r, const h2_op_t *op,
+                     const plan_part_state_t *goal)
+{
+    char *start;
+    int f1, f2, var;
+
+    // The regression starts in all facts consistent with the goal
+    start = BOR_ALLOC_ARR(char, BOR_MAX(h2->fact_size, 1));
+    for (f1 = 0; f1 < h2->fact_size; ++f1){
+        var = h2->fact_var[f1];
+        start[f1] = !planPartStateIsSet(goal, var)
+                        || planPartStateGet(goal, var)
+                                == (plan_val_t)(f1 - h2->var_fact[var]);
+    }
+
+    runReset(r);
+    for (f1 = 0; f1 < h2->fact_size; ++f1){
+        if (!start[f1])
+            continue;
+        runSetFact(r, f1);
+        for (f2 = h2->var_fact[h2->fact_var[f1] + 1];
+                f2 < h2->fact_size; ++f2){
+            if (start[f2] && r->fact[f1])
+                runSetPair(r, f1, f2);
+        }
+    }
+    BOR_FREE(start);
+
+    runFixpoint(r, op, h2->op_alive);
+}
+
+static int removeOps(plan_h2_t *h2, const h2_run_t *r)
+{
+    int i, removed = 0;
+
+    for (i = 0; i < h2->op_size; ++i){
+        if (h2->op_alive[i] && !r->op_app[i]){
+            h2->op_alive[i] = 0;
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+static int partStateReached(const plan_h2_t *h2, const h2_run_t *r,
+                            const plan_part_state_t *ps)
+{
+    plan_var_id_t var, var2;
+    plan_val_t val, val2;
+    int i, j;
+
+    PLAN_PART_STATE_FOR_EACH(ps, i, var, val){
+        if (!r->fact[planH2Fact(h2, var, val)])
+            return 0;
+        PLAN_PART_STATE_FOR_EACH(ps, j, var2, val2){
+            if (!runHasPair(r, planH2Fact(h2, var, val),
+                            planH2Fact(h2, var2, val2)))
+                return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,112 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_H2_H__
+#define __PLAN_H2_H__
+
+#include <stdint.h>
+#include "plan/problem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Maximal number of facts for which the h^2 analysis is run. The table
+ * of pairs of facts grows quadratically.
+ */
+#define PLAN_H2_MAX_FACTS 20000
+
+/**
+ * Forward and backward h^2 reachability analysis.
+ * Forward h^2 computes pairs of facts that can be reached from the
+ * initial state. Backward h^2 computes pairs of facts from which the goal
+ * can be reached by regression. The two analyses are alternated, each
+ * restricted to the operators that survived the previous one, until no
+ * more operators are removed.
+ */
+struct _plan_h2_t {
+    int var_size;
+    int *var_fact;     /*!< ID of the first fact of each variable */
+    int *fact_var;     /*!< Variable of each fact */
+    int fact_size;
+    int op_size;
+
+    char *fact;        /*!< Facts reachable from the initial state */
+    uint8_t *pair;     /*!< Bit matrix of pairs of facts reachable from
+                            the initial state */
+    char *op_alive;    /*!< Operators that can be part of a plan */
+    int solvable;      /*!< False if the analysis proved that the problem
+                            has no solution */
+};
+typedef struct _plan_h2_t plan_h2_t;
+
+/**
+ * Runs the analysis. Returns 0 on success or -1 if the problem is not
+ * supported (conditional effects, ma-privacy variable or too many facts)
+ * in which case nothing is allocated.
+ */
+int planH2Init(plan_h2_t *h2, const plan_var_t *var, int var_size,
+               const plan_state_t *init, const plan_part_state_t *goal,
+               const plan_op_t *op, int op_size);
+
+/**
+ * Frees allocated resources.
+ */
+void planH2Free(plan_h2_t *h2);
+
+/**
+ * Returns fact ID of the var-val pair.
+ */
+_bor_inline int planH2Fact(const plan_h2_t *h2, plan_var_id_t var,
+                           plan_val_t val);
+
+/**
+ * Returns true if the facts are (h^2) mutex, i.e., they cannot be both
+ * true in any state reachable from the initial state.
+ */
+_bor_inline int planH2IsMutex(const plan_h2_t *h2, int f1, int f2);
+
+/**
+ * Adds preconditions implied by h^2 mutexes to the operator: if all but
+ * one value of a variable are mutex with the preconditions, the
+ * remaining value becomes a precondition.
+ * Returns the number of added preconditions or -1 if the operator can
+ * never be applied.
+ */
+int planH2TightenPre(const plan_h2_t *h2, plan_op_t *op);
+
+/**** INLINES ****/
+_bor_inline int planH2Fact(const plan_h2_t *h2, plan_var_id_t var,
+                           plan_val_t val)
+{
+    return h2->var_fact[var] + val;
+}
+
+_bor_inline int planH2IsMutex(const plan_h2_t *h2, int f1, int f2)
+{
+    size_t bit = (size_t)f1 * h2->fact_size + f2;
+    return !(h2->pair[bit >> 3] & (1u << (bit & 7u)));
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_H2_H__ */
@@ -0,0 +1,50 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_HEUR_COMMON_H__
+#define __PLAN_HEUR_COMMON_H__
+
+#include <plan/heur.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Returns cost of an operator modified according to the
+ * PLAN_HEUR_OP_UNIT_COST and PLAN_HEUR_OP_COST_PLUS_ONE flags.
+ */
+_bor_inline plan_cost_t planHeurOpCost(plan_cost_t cost, unsigned flags);
+
+
+/**** INLINES: ****/
+_bor_inline plan_cost_t planHeurOpCost(plan_cost_t cost, unsigned flags)
+{
+    if (flags & PLAN_HEUR_OP_UNIT_COST)
+        return 1;
+    if (flags & PLAN_HEUR_OP_COST_PLUS_ONE)
+        return cost + 1;
+    return cost;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_HEUR_COMMON_H__ */
@@ -17,8 +17,11 @@
  * See the License for more information.
  */
 
+#include <pthread.h>
+#include <unistd.h>
 #include <boruvka/alloc.h>
 #include <boruvka/fifo.h>
+#include <boruvka/timer.h>
 #include <plan/heur.h>
 #include <plan/dtg.h>
 
@@ -44,15 +47,23 @@ static void heurDTG(plan_heur_t *_heur, const plan_state_t *state,
 
 plan_heur_t *planHeurDTGNew(const plan_var_t *var, int var_size,
                             const plan_part_state_t *goal,
-                            const plan_op_t *op, int op_size)
+                            const plan_op_t *op, int op_size,
+                            unsigned flags)
 {
     plan_heur_dtg_t *hdtg;
+    int num_threads;
 
     hdtg = BOR_ALLOC(plan_heur_dtg_t);
     _planHeurInit(&hdtg->heur, heurDTGDel, heurDTG, NULL);
     planHeurDTGDataInit(&hdtg->data, var, var_size, op, op_size);
     planHeurDTGCtxInit(&hdtg->ctx, &hdtg->data);
 
+    if (flags & PLAN_HEUR_DTG_TABLE){
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+        planHeurDTGDataPrecompute(&hdtg->data, PLAN_HEUR_DTG_TABLE_MAX_MEM,
+                                  BOR_MAX(num_threads, 1));
+    }
+
     // Save goal values
     hdtg->goal = BOR_ALLOC_ARR(plan_part_state_pair_t, goal->vals_size);
     hdtg->goal_size = goal->vals_size;
@@ -62,6 +73,21 @@ plan_heur_t *planHeurDTGNew(const plan_var_t *var, int var_size,
     return &hdtg->heur;
 }
 
+int planHeurDTGTableStat(const plan_heur_t *heur, long *size,
+                         int *var_size, double *build_time)
+{
+    const plan_heur_dtg_path_cache_t *pc;
+
+    if (heur->del_fn != heurDTGDel)
+        return -1;
+
+    pc = &HEUR(heur)->data.dtg_path;
+    *size = pc->table_size;
+    *var_size = pc->table_var_size;
+    *build_time = pc->table_build_time;
+    return 0;
+}
+
 static void heurDTGDel(plan_heur_t *_heur)
 {
     plan_heur_dtg_t *hdtg = HEUR(_heur);
@@ -92,6 +118,10 @@ static void heurDTG(plan_heur_t *_heur, const plan_state_t *state,
  *  path argument. */
 static void dtgPathExplore(const plan_dtg_t *dtg, plan_var_id_t var,
                            plan_val_t val, plan_heur_dtg_path_t *path);
+/** Same as dtgPathExplore() but stores paths into the pre-allocated
+ *  array pre */
+static void dtgPathExplorePre(const plan_dtg_var_t *dtg, plan_val_t val,
+                              plan_heur_dtg_path_pre_t *pre);
 /** Frees allocated memory */
 static void dtgPathFree(plan_heur_dtg_path_t *path);
 
@@ -189,6 +219,111 @@ void planHeurDTGDataFree(plan_heur_dtg_data_t *dtg_data)
     planDTGFree(&dtg_data->dtg);
 }
 
+/** Thread precomputing paths of every num_threads-th variable of the
+ *  table */
+struct _precompute_th_t {
+    pthread_t th;
+    plan_heur_dtg_data_t *dtg_data;
+    const long *offset;
+    int id;
+    int num_threads;
+};
+typedef struct _precompute_th_t precompute_th_t;
+
+static void *precomputeTh(void *_th)
+{
+    precompute_th_t *th = _th;
+    plan_heur_dtg_path_cache_t *pc = &th->dtg_data->dtg_path;
+    const plan_dtg_var_t *dtg;
+    plan_heur_dtg_path_pre_t *pre;
+    int var, val;
+
+    for (var = th->id; var < pc->var_size; var += th->num_threads){
+        if (!pc->in_table[var])
+            continue;
+
+        dtg = th->dtg_data->dtg.dtg + var;
+        pre = pc->table + th->offset[var];
+        for (val = 0; val < pc->range[var]; ++val){
+            dtgPathExplorePre(dtg, val, pre);
+            pc->path[var][val].pre = pre;
+            pre += pc->range[var];
+        }
+    }
+
+    return NULL;
+}
+
+void planHeurDTGDataPrecompute(plan_heur_dtg_data_t *dtg_data,
+                               long max_mem, int num_threads)
+{
+    plan_heur_dtg_path_cache_t *pc = &dtg_data->dtg_path;
+    precompute_th_t *th;
+    bor_timer_t timer;
+    long *offset, size, var_size;
+    int var, val, i;
+
+    if (pc->table != NULL)
+        return;
+
+    borTimerStart(&timer);
+
+    // Assign a part of the table to each variable as long as the table
+    // fits into the memory limit. Already computed paths are dropped.
+    offset = BOR_ALLOC_ARR(long, pc->var_size);
+    size = 0;
+    for (var = 0; var < pc->var_size; ++var){
+        var_size = (long)pc->range[var] * pc->range[var];
+        if (dtg_data->dtg.dtg[var].trans == NULL
+                || (size + var_size) * sizeof(plan_heur_dtg_path_pre_t)
+                        > (unsigned long)max_mem)
+            continue;
+
+        for (val = 0; val < pc->range[var]; ++val){
+            if (pc->path[var][val].pre != NULL)
+                dtgPathFree(&pc->path[var][val]);
+            pc->path[var][val].pre = NULL;
+        }
+
+        pc->in_table[var] = 1;
+        offset[var] = size;
+        size += var_size;
+        ++pc->table_var_size;
+    }
+
+    if (size == 0){
+        BOR_FREE(offset);
+        return;
+    }
+
+    pc->table = BOR_ALLOC_ARR(plan_heur_dtg_path_pre_t, size);
+    pc->table_size = size * sizeof(plan_heur_dtg_path_pre_t);
+
+    num_threads = BOR_MAX(1, BOR_MIN(num_threads, pc->table_var_size));
+    th = BOR_ALLOC_ARR(precompute_th_t, num_threads);
+    for (i = 0; i < num_threads; ++i){
+        th[i].dtg_data = dtg_data;
+        th[i].offset = offset;
+        th[i].id = i;
+        th[i].num_threads = num_threads;
+    }
+
+    if (num_threads == 1){
+        precomputeTh(th);
+    }else{
+        for (i = 0; i < num_threads; ++i)
+            pthread_create(&th[i].th, NULL, precomputeTh, th + i);
+        for (i = 0; i < num_threads; ++i)
+            pthread_join(th[i].th, NULL);
+    }
+
+    BOR_FREE(th);
+    BOR_FREE(offset);
+
+    borTimerStop(&timer);
+    pc->table_build_time = borTimerElapsedInSF(&timer);
+}
+
 plan_heur_dtg_path_t *planHeurDTGDataPath(plan_heur_dtg_data_t *dtg_data,
                                           plan_var_id_t var,
                                           plan_val_t val)
@@ -253,39 +388,47 @@ static void dtgPathExplore(const plan_dtg_t *_dtg, plan_var_id_t var,
                            plan_val_t val, plan_heur_dtg_path_t *path)
 {
     const plan_dtg_var_t *dtg = _dtg->dtg + var;
+
+    if (dtg->trans == NULL)
+        return;
+
+    path->pre = BOR_ALLOC_ARR(plan_heur_dtg_path_pre_t, dtg->val_size);
+    dtgPathExplorePre(dtg, val, path->pre);
+}
+
+static void dtgPathExplorePre(const plan_dtg_var_t *dtg, plan_val_t val,
+                              plan_heur_dtg_path_pre_t *pre)
+{
     const plan_dtg_trans_t *trans;
     bor_fifo_t fifo;
     plan_cost_t len;
     plan_val_t v;
     int i;
 
-    if (dtg->trans == NULL)
-        return;
-
-    path->pre = BOR_ALLOC_ARR(plan_heur_dtg_path_pre_t, dtg->val_size);
     for (i = 0; i < dtg->val_size; ++i){
-        path->pre[i].val = -1;
-        path->pre[i].len = INT_MAX;
+        pre[i].val = -1;
+        pre[i].len = INT_MAX;
     }
 
     borFifoInit(&fifo, sizeof(plan_val_t));
-    path->pre[val].val = val;
-    path->pre[val].len = 0;
+    pre[val].val = val;
+    pre[val].len = 0;
     borFifoPush(&fifo, &val);
     while (!borFifoEmpty(&fifo)){
         v = *(plan_val_t *)borFifoFront(&fifo);
         borFifoPop(&fifo);
-        len = path->pre[v].len;
+        len = pre[v].len;
 
         trans = dtg->trans + v;
         for (i = 0; i < dtg->val_size; ++i, trans += dtg->val_size){
-            if (i == v || path->pre[i].val != -1 || trans->ops_size == 0)
+            if (i == v || pre[i].val != -1 || trans->ops_size == 0)
                 continue;
-            path->pre[i].val = v;
-            path->pre[i].len = len + 1;
+            pre[i].val = v;
+            pre[i].len = len + 1;
             borFifoPush(&fifo, &i);
         }
     }
+    borFifoFree(&fifo);
 }
 
 static void dtgPathFree(plan_heur_dtg_path_t *path)
@@ -306,6 +449,12 @@ static void dtgPathCacheInit(plan_heur_dtg_path_cache_t *pc,
         pc->range[i] = dtg->dtg[i].val_size;
     }
     pc->var_size = dtg->var_size;
+
+    pc->table = NULL;
+    pc->in_table = BOR_CALLOC_ARR(int, dtg->var_size);
+    pc->table_size = 0;
+    pc->table_var_size = 0;
+    pc->table_build_time = 0.;
 }
 
 static void dtgPathCacheFree(plan_heur_dtg_path_cache_t *pc)
@@ -313,7 +462,7 @@ static void dtgPathCacheFree(plan_heur_dtg_path_cache_t *pc)
     int i, j;
 
     for (i = 0; i < pc->var_size; ++i){
-        for (j = 0; j < pc->range[i]; ++j){
+        for (j = 0; !pc->in_table[i] && j < pc->range[i]; ++j){
             if (pc->path[i][j].pre != NULL)
                 dtgPathFree(&pc->path[i][j]);
         }
@@ -321,6 +470,9 @@ static void dtgPathCacheFree(plan_heur_dtg_path_cache_t *pc)
     }
     BOR_FREE(pc->path);
     BOR_FREE(pc->range);
+    BOR_FREE(pc->in_table);
+    if (pc->table != NULL)
+        BOR_FREE(pc->table);
 }
 
 static plan_heur_dtg_path_t *dtgPathCache(plan_heur_dtg_path_cache_t *pc,
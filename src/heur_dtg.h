@@ -45,6 +45,16 @@ struct _plan_heur_dtg_path_cache_t {
     plan_heur_dtg_path_t **path; /*!< Array of arrays for each variable and
                                       value */
     int *range;                  /*!< Range of values for each variable */
+
+    plan_heur_dtg_path_pre_t *table; /*!< Precomputed paths of all values
+                                          of the variables in table, i.e.,
+                                          range x range matrix per variable
+                                          stored contiguously */
+    int *in_table;               /*!< True for variables whose paths are
+                                      stored in .table */
+    long table_size;             /*!< Size of .table in bytes */
+    int table_var_size;          /*!< Number of variables in .table */
+    double table_build_time;     /*!< Time of building .table in seconds */
 };
 typedef struct _plan_heur_dtg_path_cache_t plan_heur_dtg_path_cache_t;
 
@@ -119,6 +129,15 @@ void planHeurDTGDataInitUnknown(plan_heur_dtg_data_t *dtg_data,
                                 const plan_var_t *var, int var_size,
                                 const plan_op_t *op, int op_size);
 
+/**
+ * Precomputes paths between all pairs of values of each variable into one
+ * contiguous table using num_threads threads. Variables are added to the
+ * table as long as the table fits into max_mem bytes, paths of the
+ * remaining variables are still computed lazily.
+ */
+void planHeurDTGDataPrecompute(plan_heur_dtg_data_t *dtg_data,
+                               long max_mem, int num_threads);
+
 /**
  * Fress allocated resources.
  */
@@ -20,6 +20,7 @@
 #include <boruvka/alloc.h>
 #include <plan/config.h>
 #include <plan/heur.h>
+#include <plan/search.h>
 
 #include "plan/lp.h"
 #include "fact_id.h"
@@ -29,6 +30,9 @@
 #define BOUND_INF 1E30
 #define ROUND_EPS 1E-6
 
+/** Number of slots in the cache of LP bases */
+#define BASIS_CACHE_SIZE 1024
+
 /** Upper bound table:
  * [is_goal_var][is_mutex_with_goal][is_init][cause_incomplete_op] */
 static double upper_bound_table[2][2][2][2] = {
@@ -91,6 +95,16 @@ struct _fact_t {
 };
 typedef struct _fact_t fact_t;
 
+/**
+ * Optimal LP basis of an evaluated state
+ */
+struct _basis_t {
+    plan_state_id_t state_id; /*!< ID of the state or PLAN_NO_STATE */
+    int size;                 /*!< Number of elements in .basis */
+    int *basis;
+};
+typedef struct _basis_t basis_t;
+
 /**
  * Main structure for Flow heuristic
  */
@@ -101,6 +115,14 @@ struct _plan_heur_flow_t {
     fact_t *facts;          /*!< Array of fact related structures */
     plan_lp_t *lp;          /*!< (I)LP solver */
     plan_heur_t *lm_cut;    /*!< LM-Cut heuristic used for landmarks */
+
+    int ldm_row_begin;        /*!< First row of the pool of landmark rows */
+    plan_landmark_t *ldm_row; /*!< Landmark currently set in each row of
+                                   the pool */
+    int ldm_row_size;         /*!< Number of rows in the pool */
+    basis_t *basis;           /*!< Direct-mapped cache of optimal bases
+                                   indexed by state ID, used for
+                                   warm-starting LP of child states */
 };
 typedef struct _plan_heur_flow_t plan_heur_flow_t;
 #define HEUR(parent) \
@@ -109,6 +131,8 @@ typedef struct _plan_heur_flow_t plan_heur_flow_t;
 static void heurFlowDel(plan_heur_t *_heur);
 static void heurFlow(plan_heur_t *_heur, const plan_state_t *state,
                      plan_heur_res_t *res);
+static void heurFlowNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                         plan_search_t *search, plan_heur_res_t *res);
 
 /** Initialize array of facts */
 static void factsInit(fact_t *facts, const plan_fact_id_t *fact_id,
@@ -123,9 +147,20 @@ static void factsSetState(fact_t *facts, const plan_fact_id_t *fact_id,
 static plan_lp_t *lpInit(const fact_t *facts, int facts_size,
                          const plan_op_t *op, int op_size, int use_ilp,
                          unsigned flags);
-static plan_cost_t lpSolve(plan_lp_t *lp, const fact_t *facts,
-                           int facts_size, int use_ilp,
+/** Rounds LP objective value up to the heuristic value */
+static plan_cost_t roundOff(double z);
+/** Sets the landmark rows of the pool according to the landmarks */
+static void lpSetLandmarks(plan_heur_flow_t *hflow,
                            const plan_landmark_set_t *ldms);
+/** Sets fact rows according to facts' bounds */
+static void lpSetFacts(plan_lp_t *lp, const fact_t *facts, int facts_size);
+/** Computes heuristic value for the state. If parent_state_id is set,
+ *  the LP is warm-started from the parent's basis if it is cached and
+ *  if state_id is set the optimal basis is cached. */
+static void flowCompute(plan_heur_flow_t *hflow, const plan_state_t *state,
+                        plan_state_id_t parent_state_id,
+                        plan_state_id_t state_id,
+                        plan_heur_res_t *res);
 
 plan_heur_t *planHeurFlowNew(const plan_var_t *var, int var_size,
                              const plan_part_state_t *goal,
@@ -133,9 +168,10 @@ plan_heur_t *planHeurFlowNew(const plan_var_t *var, int var_size,
                              unsigned flags)
 {
     plan_heur_flow_t *hflow;
+    int i;
 
     hflow = BOR_ALLOC(plan_heur_flow_t);
-    _planHeurInit(&hflow->heur, heurFlowDel, heurFlow, NULL);
+    _planHeurInit(&hflow->heur, heurFlowDel, heurFlow, heurFlowNode);
     hflow->use_ilp = (flags & PLAN_HEUR_FLOW_ILP);
 
     planFactIdInit(&hflow->fact_id, var, var_size);
@@ -151,6 +187,17 @@ plan_heur_t *planHeurFlowNew(const plan_var_t *var, int var_size,
         hflow->lm_cut = planHeurLMCutNew(var, var_size, goal, op, op_size,
                                          flags);
 
+    hflow->ldm_row_begin = planLPNumRows(hflow->lp);
+    hflow->ldm_row = NULL;
+    hflow->ldm_row_size = 0;
+
+    hflow->basis = NULL;
+    if (!hflow->use_ilp){
+        hflow->basis = BOR_CALLOC_ARR(basis_t, BASIS_CACHE_SIZE);
+        for (i = 0; i < BASIS_CACHE_SIZE; ++i)
+            hflow->basis[i].state_id = PLAN_NO_STATE;
+    }
+
     return &hflow->heur;
 }
 
@@ -163,6 +210,18 @@ static void heurFlowDel(plan_heur_t *_heur)
         planHeurDel(hflow->lm_cut);
     planLPDel(hflow->lp);
 
+    for (i = 0; i < hflow->ldm_row_size; ++i)
+        planLandmarkFree(hflow->ldm_row + i);
+    if (hflow->ldm_row)
+        BOR_FREE(hflow->ldm_row);
+
+    for (i = 0; hflow->basis && i < BASIS_CACHE_SIZE; ++i){
+        if (hflow->basis[i].basis)
+            BOR_FREE(hflow->basis[i].basis);
+    }
+    if (hflow->basis)
+        BOR_FREE(hflow->basis);
+
     for (i = 0; hflow->facts && i < hflow->fact_id.fact_size; ++i){
         if (hflow->facts[i].constr_idx)
             BOR_FREE(hflow->facts[i].constr_idx);
@@ -180,6 +239,51 @@ static void heurFlow(plan_heur_t *_heur, const plan_state_t *state,
                      plan_heur_res_t *res)
 {
     plan_heur_flow_t *hflow = HEUR(_heur);
+    flowCompute(hflow, state, PLAN_NO_STATE, PLAN_NO_STATE, res);
+}
+
+static void heurFlowNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                         plan_search_t *search, plan_heur_res_t *res)
+{
+    plan_heur_flow_t *hflow = HEUR(_heur);
+    const plan_state_space_node_t *node;
+
+    node = planSearchLoadNode(search, state_id);
+    flowCompute(hflow, planSearchLoadState(search, state_id),
+                node->parent_state_id, state_id, res);
+}
+
+static void basisStore(plan_heur_flow_t *hflow, plan_state_id_t state_id)
+{
+    basis_t *b = hflow->basis + (state_id % BASIS_CACHE_SIZE);
+    int size;
+
+    size = planLPBasisSize(hflow->lp);
+    if (b->size != size){
+        b->basis = BOR_REALLOC_ARR(b->basis, int, size);
+        b->size = size;
+    }
+
+    b->state_id = state_id;
+    if (planLPGetBasis(hflow->lp, b->basis) != 0)
+        b->state_id = PLAN_NO_STATE;
+}
+
+static void basisRestore(plan_heur_flow_t *hflow, plan_state_id_t state_id)
+{
+    const basis_t *b = hflow->basis + (state_id % BASIS_CACHE_SIZE);
+
+    // The basis is usable only if the landmark pool did not grow since it
+    // was stored. Otherwise the LP just continues from the last basis.
+    if (b->state_id == state_id && b->size == planLPBasisSize(hflow->lp))
+        planLPSetBasis(hflow->lp, b->basis);
+}
+
+static void flowCompute(plan_heur_flow_t *hflow, const plan_state_t *state,
+                        plan_state_id_t parent_state_id,
+                        plan_state_id_t state_id,
+                        plan_heur_res_t *res)
+{
     plan_heur_res_t ldms_res;
     plan_landmark_set_t *ldms = NULL;
 
@@ -192,8 +296,21 @@ static void heurFlow(plan_heur_t *_heur, const plan_state_t *state,
     }
 
     factsSetState(hflow->facts, &hflow->fact_id, state);
-    res->heur = lpSolve(hflow->lp, hflow->facts, hflow->fact_id.fact_size,
-                        hflow->use_ilp, ldms);
+    lpSetFacts(hflow->lp, hflow->facts, hflow->fact_id.fact_size);
+    lpSetLandmarks(hflow, ldms);
+
+    if (hflow->use_ilp){
+        res->heur = roundOff(planLPSolveILPObjVal(hflow->lp));
+    }else{
+        // The LP differs from the parent's LP only in right hand sides
+        // and landmark rows, so the parent's optimal basis is usually
+        // close to the optimal one.
+        if (parent_state_id >= 0)
+            basisRestore(hflow, parent_state_id);
+        res->heur = roundOff(planLPSolveDualObjVal(hflow->lp));
+        if (state_id >= 0)
+            basisStore(hflow, state_id);
+    }
 
     // Free allocated landmarks
     if (hflow->lm_cut)
@@ -424,46 +541,56 @@ static plan_lp_t *lpInit(const fact_t *facts, int facts_size,
     return lp;
 }
 
-static void lpAddLandmarks(plan_lp_t *lp, const plan_landmark_set_t *ldms)
+static void lpSetLandmarks(plan_heur_flow_t *hflow,
+                           const plan_landmark_set_t *ldms)
 {
-    plan_landmark_t *ldm;
-    int i, j, row_id;
-
-    if (ldms == NULL || ldms->size == 0)
-        return;
-
-
-    row_id = planLPNumRows(lp);
-    planLPAddRows(lp, ldms->size, NULL, NULL);
-    for (i = 0; i < ldms->size; ++i, ++row_id){
-        ldm = ldms->landmark + i;
-        planLPSetRHS(lp, row_id, 1., 'G');
-        for (j = 0; j < ldm->size; ++j)
-            planLPSetCoef(lp, row_id, ldm->op_id[j], 1.);
+    const plan_landmark_t *ldm;
+    plan_landmark_t *row_ldm;
+    int i, j, row, size = 0;
+
+    if (ldms != NULL)
+        size = ldms->size;
+
+    // Grow the pool if needed, new rows are empty: 0 >= 0
+    if (size > hflow->ldm_row_size){
+        planLPAddRows(hflow->lp, size - hflow->ldm_row_size, NULL, NULL);
+        hflow->ldm_row = BOR_REALLOC_ARR(hflow->ldm_row, plan_landmark_t, size);
+        for (i = hflow->ldm_row_size; i < size; ++i){
+            bzero(hflow->ldm_row + i, sizeof(plan_landmark_t));
+            planLPSetRHS(hflow->lp, hflow->ldm_row_begin + i, 0., 'G');
+        }
+        hflow->ldm_row_size = size;
     }
-}
 
-static void lpDelLandmarks(plan_lp_t *lp, const plan_landmark_set_t *ldms)
-{
-    int from, to;
+    // Rows are only rewritten instead of being added and deleted so that
+    // the dimensions of the LP (and thus its basis) stay the same.
+    for (i = 0; i < hflow->ldm_row_size; ++i){
+        row = hflow->ldm_row_begin + i;
+        row_ldm = hflow->ldm_row + i;
+        if (i >= size && row_ldm->size == 0)
+            continue;
 
-    if (ldms == NULL || ldms->size == 0)
-        return;
+        for (j = 0; j < row_ldm->size; ++j)
+            planLPSetCoef(hflow->lp, row, row_ldm->op_id[j], 0.);
+        planLandmarkFree(row_ldm);
 
-    to = planLPNumRows(lp) - 1;
-    from = planLPNumRows(lp) - ldms->size;
-    planLPDelRows(lp, from, to);
+        if (i < size){
+            ldm = ldms->landmark + i;
+            planLandmarkInit(row_ldm, ldm->size, ldm->op_id);
+            for (j = 0; j < ldm->size; ++j)
+                planLPSetCoef(hflow->lp, row, ldm->op_id[j], 1.);
+            planLPSetRHS(hflow->lp, row, 1., 'G');
+        }else{
+            planLPSetRHS(hflow->lp, row, 0., 'G');
+        }
+    }
 }
 
-static plan_cost_t lpSolve(plan_lp_t *lp, const fact_t *facts,
-                           int facts_size, int use_ilp,
-                           const plan_landmark_set_t *ldms)
+static void lpSetFacts(plan_lp_t *lp, const fact_t *facts, int facts_size)
 {
-    plan_cost_t h = PLAN_HEUR_DEAD_END;
     int i;
-    double z;
 
-    // Add row for each fact
+    // Set row for each fact
     for (i = 0; i < facts_size; ++i){
         double upper, lower;
         lower = facts[i].lower_bound;
@@ -478,19 +605,6 @@ static plan_cost_t lpSolve(plan_lp_t *lp, const fact_t *facts,
             planLPSetRHS(lp, 2 * i + 1, upper, 'L');
         }
     }
-
-    // Add landmarks if provided
-    lpAddLandmarks(lp, ldms);
-
-    if (use_ilp){
-        z = planLPSolveILPObjVal(lp);
-    }else{
-        z = planLPSolveObjVal(lp);
-    }
-    h = roundOff(z);
-
-    lpDelLandmarks(lp, ldms);
-    return h;
 }
 
 #else /* PLAN_LP */
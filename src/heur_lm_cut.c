@@ -18,7 +18,6 @@
  */
 
 #include <boruvka/alloc.h>
-#include <boruvka/lifo.h>
 #include "plan/heur.h"
 #include "plan/search.h"
 
@@ -45,8 +44,18 @@ struct _plan_heur_lm_cut_t {
     plan_heur_t heur;
     plan_heur_relax_t relax;
 
-    int *fact_goal_zone; /*!< Flag for each fact whether it is in goal zone */
-    int *fact_in_queue;
+    int *fact_goal_zone; /*!< Fact is in goal zone if its value equals
+                              to .goal_zone_mark */
+    int goal_zone_mark;
+    int *fact_in_queue;  /*!< Fact was already in the queue if its value
+                              equals to .in_queue_mark */
+    int in_queue_mark;
+    int *queue;          /*!< Stack of facts used during the search for
+                              cut and goal zone */
+    int *op_changed;     /*!< Operator was already recorded as changed if
+                              its value equals to .op_changed_mark, see
+                              applyInitLandmarks() */
+    int op_changed_mark;
     plan_oparr_t cut;    /*!< Array of cut operators */
 
     inc_local_t inc_local; /*!< Struct for local incremental LM-Cut */
@@ -96,8 +105,13 @@ static plan_heur_t *lmCutNew(const plan_var_t *var, int var_size,
     planHeurRelaxInit(&heur->relax, PLAN_HEUR_RELAX_TYPE_MAX,
                       var, var_size, goal, op, op_size, flags);
 
-    heur->fact_goal_zone = BOR_ALLOC_ARR(int, heur->relax.cref.fact_size);
-    heur->fact_in_queue  = BOR_ALLOC_ARR(int, heur->relax.cref.fact_size);
+    heur->fact_goal_zone = BOR_CALLOC_ARR(int, heur->relax.cref.fact_size);
+    heur->goal_zone_mark = 0;
+    heur->fact_in_queue  = BOR_CALLOC_ARR(int, heur->relax.cref.fact_size);
+    heur->in_queue_mark = 0;
+    heur->queue = BOR_ALLOC_ARR(int, heur->relax.cref.fact_size);
+    heur->op_changed = BOR_CALLOC_ARR(int, heur->relax.cref.op_size);
+    heur->op_changed_mark = 0;
     heur->cut.op = BOR_ALLOC_ARR(int, heur->relax.cref.op_size);
     heur->cut.size = 0;
 
@@ -141,6 +155,19 @@ plan_heur_t *planHeurLMCutIncCacheNew(const plan_var_t *var, int var_size,
     return lmCutNew(var, var_size, goal, op, op_size, 2, flags, cache_flags);
 }
 
+const plan_landmark_cache_t *planHeurLMCutIncCache(const plan_heur_t *heur)
+{
+    const plan_heur_lm_cut_t *lm_cut;
+
+    if (heur->del_fn != planHeurLMCutDel)
+        return NULL;
+
+    lm_cut = HEUR(heur);
+    if (!lm_cut->inc_cache.enabled)
+        return NULL;
+    return lm_cut->inc_cache.ldm_cache;
+}
+
 static void planHeurLMCutDel(plan_heur_t *_heur)
 {
     plan_heur_lm_cut_t *heur = HEUR(_heur);
@@ -148,6 +175,8 @@ static void planHeurLMCutDel(plan_heur_t *_heur)
     BOR_FREE(heur->cut.op);
     BOR_FREE(heur->fact_goal_zone);
     BOR_FREE(heur->fact_in_queue);
+    BOR_FREE(heur->queue);
+    BOR_FREE(heur->op_changed);
     if (heur->inc_local.enabled){
         planLandmarkSetFree(&heur->inc_local.ldms);
         planOpIdTrFree(&heur->inc_local.op_id_tr);
@@ -163,61 +192,79 @@ static void planHeurLMCutDel(plan_heur_t *_heur)
 
 
 
-static void markGoalZoneRecursive(plan_heur_lm_cut_t *heur, int fact_id)
+/** Returns a fresh mark for the given array of marks. The array is
+ *  zeroized only if the counter overflows. */
+static int nextMark(int *mark, int *arr, int size)
 {
-    int i, len, *op_ids, op_id;
-    plan_heur_relax_op_t *op;
-
-    if (heur->fact_goal_zone[fact_id])
-        return;
-
-    heur->fact_goal_zone[fact_id] = 1;
-
-    len    = heur->relax.cref.fact_eff[fact_id].size;
-    op_ids = heur->relax.cref.fact_eff[fact_id].op;
-    for (i = 0; i < len; ++i){
-        op_id = op_ids[i];
-        op = heur->relax.op + op_id;
-        if (op->cost == 0 && op->supp != -1)
-            markGoalZoneRecursive(heur, op->supp);
+    if (*mark == INT_MAX){
+        bzero(arr, sizeof(int) * size);
+        *mark = 0;
     }
+    return ++(*mark);
 }
 
 static void markGoalZone(plan_heur_lm_cut_t *heur)
 {
-    // Zeroize goal-zone flags and recursively mark facts in the goal-zone
-    bzero(heur->fact_goal_zone, sizeof(int) * heur->relax.cref.fact_size);
-    markGoalZoneRecursive(heur, heur->relax.cref.goal_id);
+    int i, len, *op_ids, fact_id, mark, queue_size;
+    int *goal_zone = heur->fact_goal_zone;
+    int *queue = heur->queue;
+    const plan_heur_relax_op_t *op;
+
+    // Instead of zeroizing goal-zone flags, just switch to a new mark
+    mark = nextMark(&heur->goal_zone_mark, goal_zone,
+                    heur->relax.cref.fact_size);
+
+    // Mark facts in the goal-zone, each fact is pushed into the stack at
+    // most once because it is marked before it is pushed.
+    fact_id = heur->relax.cref.goal_id;
+    goal_zone[fact_id] = mark;
+    queue[0] = fact_id;
+    queue_size = 1;
+    while (queue_size > 0){
+        fact_id = queue[--queue_size];
+
+        len    = heur->relax.cref.fact_eff[fact_id].size;
+        op_ids = heur->relax.cref.fact_eff[fact_id].op;
+        for (i = 0; i < len; ++i){
+            op = heur->relax.op + op_ids[i];
+            if (op->cost == 0 && op->supp != -1
+                    && goal_zone[op->supp] != mark){
+                goal_zone[op->supp] = mark;
+                queue[queue_size++] = op->supp;
+            }
+        }
+    }
 }
 
 
 
-static void findCutAddInit(plan_heur_lm_cut_t *heur,
-                           const plan_state_t *state,
-                           bor_lifo_t *queue)
+static int findCutAddInit(plan_heur_lm_cut_t *heur,
+                          const plan_state_t *state, int mark)
 {
     plan_var_id_t var, len;
     plan_val_t val;
-    int id;
+    int id, queue_size = 0;
 
     len = planStateSize(state);
     for (var = 0; var < len; ++var){
         val = planStateGet(state, var);
         id = planFactId(&heur->relax.cref.fact_id, var, val);
         if (id >= 0){
-            heur->fact_in_queue[id] = 1;
-            borLifoPush(queue, &id);
+            heur->fact_in_queue[id] = mark;
+            heur->queue[queue_size++] = id;
         }
     }
     id = heur->relax.cref.fake_pre[0].fact_id;
-    heur->fact_in_queue[id] = 1;
-    borLifoPush(queue, &id);
+    heur->fact_in_queue[id] = mark;
+    heur->queue[queue_size++] = id;
+    return queue_size;
 }
 
-static void findCutEnqueueEffects(plan_heur_lm_cut_t *heur,
-                                  int op_id, bor_lifo_t *queue)
+static int findCutEnqueueEffects(plan_heur_lm_cut_t *heur,
+                                 int op_id, int queue_size, int mark)
 {
     int i, len, *facts, fact_id;
+    int goal_zone_mark = heur->goal_zone_mark;
     int in_cut = 0;
 
     len   = heur->relax.cref.op_eff[op_id].size;
@@ -225,52 +272,54 @@ static void findCutEnqueueEffects(plan_heur_lm_cut_t *heur,
     for (i = 0; i < len; ++i){
         fact_id = facts[i];
 
-        // Determine whether the operator belongs to cut
-        if (!in_cut && heur->fact_goal_zone[fact_id]){
-            heur->cut.op[heur->cut.size++] = op_id;
-            in_cut = 1;
-        }
+        if (heur->fact_goal_zone[fact_id] == goal_zone_mark){
+            // Determine whether the operator belongs to cut
+            if (!in_cut){
+                heur->cut.op[heur->cut.size++] = op_id;
+                in_cut = 1;
+            }
 
-        if (!heur->fact_in_queue[fact_id]
-                && !heur->fact_goal_zone[fact_id]){
-            heur->fact_in_queue[fact_id] = 1;
-            borLifoPush(queue, &fact_id);
+        }else if (heur->fact_in_queue[fact_id] != mark){
+            heur->fact_in_queue[fact_id] = mark;
+            heur->queue[queue_size++] = fact_id;
         }
     }
+
+    return queue_size;
 }
 
 static void findCut(plan_heur_lm_cut_t *heur, const plan_state_t *state)
 {
-    int i, len, *ops, fact_id, op_id;
-    bor_lifo_t queue;
+    int i, len, *ops, fact_id, op_id, mark, queue_size;
+    const plan_heur_relax_op_t *op = heur->relax.op;
 
-    // Zeroize in-queue flags
-    bzero(heur->fact_in_queue, sizeof(int) * heur->relax.cref.fact_size);
+    // Switch to a new in-queue mark instead of zeroizing the flags
+    mark = nextMark(&heur->in_queue_mark, heur->fact_in_queue,
+                    heur->relax.cref.fact_size);
 
     // Reset output structure
     heur->cut.size = 0;
 
-    // Initialize queue and adds initial state
-    borLifoInit(&queue, sizeof(int));
-    findCutAddInit(heur, state, &queue);
+    // Initialize queue and adds initial state.
+    // Every fact is pushed at most once, so the queue never holds more
+    // than fact_size elements.
+    queue_size = findCutAddInit(heur, state, mark);
 
-    while (!borLifoEmpty(&queue)){
+    while (queue_size > 0){
         // Pop next fact from queue
-        fact_id = *(int *)borLifoBack(&queue);
-        borLifoPop(&queue);
+        fact_id = heur->queue[--queue_size];
 
         len = heur->relax.cref.fact_pre[fact_id].size;
         ops = heur->relax.cref.fact_pre[fact_id].op;
         for (i = 0; i < len; ++i){
             op_id = ops[i];
 
-            if (heur->relax.op[op_id].supp == fact_id){
-                findCutEnqueueEffects(heur, op_id, &queue);
+            if (op[op_id].supp == fact_id){
+                queue_size = findCutEnqueueEffects(heur, op_id,
+                                                   queue_size, mark);
             }
         }
     }
-
-    borLifoFree(&queue);
 }
 
 static plan_cost_t updateCutCost(const plan_oparr_t *cut, plan_heur_relax_op_t *op)
@@ -314,6 +363,13 @@ static void storeLandmarks(plan_heur_lm_cut_t *heur, int *op_ids, int size,
     BOR_FREE(ops);
 }
 
+static int intCmp(const void *a, const void *b)
+{
+    int i = *(const int *)a;
+    int j = *(const int *)b;
+    return i - j;
+}
+
 static int landmarkCost(const plan_heur_relax_op_t *op, int *ldm,
                         int ldm_size, int used_op_id)
 {
@@ -339,11 +395,13 @@ static plan_cost_t applyInitLandmarks(plan_heur_lm_cut_t *heur,
 {
     plan_cost_t h = 0;
     const plan_landmark_t *ldm;
-    int cost, *op_changed, i, j, size, op_id;
+    int cost, *changed, i, j, size, op_id, mark;
 
-    // Reuse structure for cut
-    op_changed = heur->cut.op;
-    bzero(op_changed, sizeof(*heur->cut.op) * heur->relax.cref.op_size);
+    // Reuse structure for cut for the list of changed operators
+    changed = heur->cut.op;
+    size = 0;
+    mark = nextMark(&heur->op_changed_mark, heur->op_changed,
+                    heur->relax.cref.op_size);
 
     // Record operators that should be changed as well as value that should
     // be substracted from their cost.
@@ -364,7 +422,10 @@ static plan_cost_t applyInitLandmarks(plan_heur_lm_cut_t *heur,
         // cost of the landmark.
         for (j = 0; j < ldm->size; ++j){
             op_id = ldm->op_id[j];
-            op_changed[op_id] = 1;
+            if (heur->op_changed[op_id] != mark){
+                heur->op_changed[op_id] = mark;
+                changed[size++] = op_id;
+            }
             heur->relax.op[op_id].value -= cost;
             heur->relax.op[op_id].cost  -= cost;
         }
@@ -373,14 +434,12 @@ static plan_cost_t applyInitLandmarks(plan_heur_lm_cut_t *heur,
             storeLandmarks(heur, ldm->op_id, ldm->size, res);
     }
 
-    // Reorganize array of changed operators
-    for (size = 0, i = 0; i < heur->relax.cref.op_size; ++i){
-        if (op_changed[i])
-            op_changed[size++] = i;
-    }
+    // Keep the changed operators sorted so that the h^max update breaks
+    // ties the same way regardless of the order of landmarks
+    qsort(changed, size, sizeof(int), intCmp);
 
     // Update relaxation heuristic
-    planHeurRelaxIncMaxFull(&heur->relax, op_changed, size);
+    planHeurRelaxIncMaxFull(&heur->relax, changed, size);
 
     return h;
 }
@@ -543,7 +602,7 @@ static void planHeurLMCutStateInc(plan_heur_t *_heur,
                                   const plan_state_t *state,
                                   plan_heur_res_t *res)
 {
-    fprintf(stderr, "Error: Incremental LM-Cut cannot be called via"
-                    " planHeurState() function!\n");
-    exit(-1);
+    // Without the parent state there is nothing to start from, so the
+    // heuristic is computed from scratch
+    planHeurLMCutState(_heur, state, res);
 }
@@ -29,6 +29,13 @@ typedef struct _pending_req_t pending_req_t;
 
 struct _pending_reqs_t {
     pending_req_t *pending; /*!< List of pending requests */
+    int eval;               /*!< Local evaluation the requests belong to or
+                                 -1 if they were sent on behalf of other
+                                 agent */
+    plan_state_id_t response_state_id; /*!< State ID sent back with the
+                                            response */
+    int response_state_agent; /*!< Owner of the state sent back with the
+                                   response */
     int response_agent;     /*!< ID of agent to which send response */
     int response_token;     /*!< Token expected as response */
     int response_depth;     /*!< Depth of a distributed recursion */
@@ -38,13 +45,26 @@ struct _pending_reqs_t {
 };
 typedef struct _pending_reqs_t pending_reqs_t;
 
+/** Context of one evaluation of the heuristic. More evaluations can be in
+ *  flight at the same time (see plan_heur_t.ma_pipeline). */
+struct _hdtg_eval_t {
+    int active;               /*!< True if the evaluation is in progress */
+    plan_state_id_t state_id; /*!< ID of the evaluated state */
+    plan_heur_dtg_ctx_t ctx;
+    plan_state_t state;
+};
+typedef struct _hdtg_eval_t hdtg_eval_t;
+
 struct _plan_heur_ma_dtg_t {
     plan_heur_t heur;
     plan_heur_dtg_data_t data;
-    plan_heur_dtg_ctx_t ctx;
 
+    hdtg_eval_t *eval;  /*!< Evaluation contexts */
+    int eval_size;      /*!< Number of allocated evaluation contexts */
+    hdtg_eval_t *cur;   /*!< Currently processed evaluation */
+
+    int var_size;
     plan_part_state_t goal;
-    plan_state_t state;
     plan_op_t *fake_op;
     int fake_op_size;
 
@@ -71,6 +91,10 @@ static void initDTGData(plan_heur_ma_dtg_t *hdtg,
 static void pendingReqsInit(plan_heur_ma_dtg_t *hdtg, pending_reqs_t *r);
 static void pendingReqsFree(plan_heur_ma_dtg_t *hdtg, pending_reqs_t *r);
 
+/** Returns index of a free evaluation context, a new one is allocated if
+ *  all are in use. */
+static int hdtgEvalNew(plan_heur_ma_dtg_t *hdtg);
+
 /** Returns next available token, i.e., slot for pending requests.
  *  If not available a new one is allocated. */
 static int hdtgNextToken(plan_heur_ma_dtg_t *hdtg);
@@ -83,7 +107,8 @@ static int hdtgFindOwners(plan_heur_ma_dtg_t *hdtg,
 static void hdtgSendResponse(plan_heur_ma_dtg_t *hdtg,
                              plan_ma_comm_t *comm,
                              int agent, int token, int cost,
-                             int depth);
+                             int depth, int state_agent,
+                             plan_state_id_t state_id);
 /** Sends request to the agents on transition from-to.
  *  If it is request from request (recursion), base request message req_msg
  *  is provided. */
@@ -103,7 +128,9 @@ static int hdtgCheckPath(plan_heur_ma_dtg_t *hdtg,
                          int *token_out);
 /** Performs one step in dtg heuristic */
 static int hdtgStep(plan_heur_ma_dtg_t *hdtg, plan_ma_comm_t *comm);
-/** Process response or req-response */
+/** Process response or req-response. Returns 0 if the local evaluation
+ *  was finished, -1 otherwise (including responses that were only passed
+ *  on to the agent that relayed the request). */
 static int update(plan_heur_ma_dtg_t *hdtg, plan_ma_comm_t *comm,
                   const plan_ma_msg_t *msg);
 
@@ -116,11 +143,17 @@ plan_heur_t *planHeurMADTGNew(const plan_problem_t *agent_def)
     _planHeurMAInit(&hdtg->heur, hdtgHeur, NULL, hdtgUpdate, hdtgRequest);
     initFakeOp(hdtg, agent_def);
     initDTGData(hdtg, agent_def);
-    planHeurDTGCtxInit(&hdtg->ctx, &hdtg->data);
+    // Requests are tagged with the state ID, so more states can be
+    // evaluated at once.
+    hdtg->heur.ma_pipeline = 1;
+
+    hdtg->eval = NULL;
+    hdtg->eval_size = 0;
+    hdtg->cur = NULL;
 
+    hdtg->var_size = agent_def->var_size;
     planPartStateInit(&hdtg->goal, agent_def->var_size);
     planPartStateCopy(&hdtg->goal, agent_def->goal);
-    planStateInit(&hdtg->state, agent_def->var_size);
 
     hdtg->waitlist = NULL;
     hdtg->waitlist_size = 0;
@@ -137,14 +170,18 @@ static void hdtgDel(plan_heur_t *heur)
         pendingReqsFree(hdtg, hdtg->waitlist + i);
     if (hdtg->waitlist)
         BOR_FREE(hdtg->waitlist);
+    for (i = 0; i < hdtg->eval_size; ++i){
+        planHeurDTGCtxFree(&hdtg->eval[i].ctx);
+        planStateFree(&hdtg->eval[i].state);
+    }
+    if (hdtg->eval)
+        BOR_FREE(hdtg->eval);
     planPartStateFree(&hdtg->goal);
-    planStateFree(&hdtg->state);
     for (i = 0; i < hdtg->fake_op_size; ++i)
         planOpFree(hdtg->fake_op + i);
     if (hdtg->fake_op)
         BOR_FREE(hdtg->fake_op);
     planHeurDTGDataFree(&hdtg->data);
-    planHeurDTGCtxFree(&hdtg->ctx);
 
     _planHeurFree(&hdtg->heur);
     BOR_FREE(hdtg);
@@ -154,16 +191,22 @@ static int hdtgHeur(plan_heur_t *heur, plan_ma_comm_t *comm,
                     const plan_state_t *state, plan_heur_res_t *res)
 {
     plan_heur_ma_dtg_t *hdtg = HEUR(heur);
+    hdtg_eval_t *ev;
     int ret;
 
+    ev = hdtg->eval + hdtgEvalNew(hdtg);
+    ev->active = 1;
+    ev->state_id = state->state_id;
+    hdtg->cur = ev;
+
     // Remember initial state
-    planStateCopy(&hdtg->state, state);
+    planStateCopy(&ev->state, state);
     // Private values are copied too, because these values are not in DTG
     // graph anyway, so the agent ignores these values.
 
     // Start computing dtg heuristic
-    planHeurDTGCtxInitStep(&hdtg->ctx, &hdtg->data,
-                           hdtg->state.val, hdtg->state.size,
+    planHeurDTGCtxInitStep(&ev->ctx, &hdtg->data,
+                           ev->state.val, ev->state.size,
                            hdtg->goal.vals, hdtg->goal.vals_size);
 
     // Run dtg heuristic
@@ -171,7 +214,8 @@ static int hdtgHeur(plan_heur_t *heur, plan_ma_comm_t *comm,
     if (ret == 1)
         return -1;
 
-    res->heur = hdtg->ctx.heur;
+    res->heur = ev->ctx.heur;
+    ev->active = 0;
     return 0;
 }
 
@@ -181,7 +225,8 @@ static int hdtgUpdate(plan_heur_t *heur, plan_ma_comm_t *comm,
     plan_heur_ma_dtg_t *hdtg = HEUR(heur);
 
     if (update(hdtg, comm, msg) == 0){
-        res->heur = hdtg->ctx.heur;
+        res->heur = hdtg->cur->ctx.heur;
+        hdtg->cur->active = 0;
         return 0;
     }
     return -1;
@@ -230,6 +275,8 @@ static void hdtgRequest(plan_heur_t *heur, plan_ma_comm_t *comm,
     int subtype;
     int agent_id, token, depth, req_token;
     int var, val_from, val_to, cost;
+    int state_agent;
+    plan_state_id_t state_id;
     int ret;
 
     subtype = planMAMsgSubType(msg);
@@ -250,6 +297,8 @@ static void hdtgRequest(plan_heur_t *heur, plan_ma_comm_t *comm,
     agent_id = planMAMsgAgent(msg);
     token = planMAMsgHeurToken(msg);
     depth = planMAMsgHeurRequestedAgentSize(msg);
+    state_agent = planMAMsgHeurStateAgent(msg);
+    state_id = planMAMsgHeurStateId(msg);
 
     // Determine variable ID and pair of values
     _reqDTG(hdtg, msg, &var, &val_from, &val_to);
@@ -260,7 +309,8 @@ static void hdtgRequest(plan_heur_t *heur, plan_ma_comm_t *comm,
     // If val_to is still unreachable report it back as zero (we don't know
     // whether it is dead end or not)
     if (path->pre[val_to].val == -1){
-        hdtgSendResponse(hdtg, comm, agent_id, token, 0, depth);
+        hdtgSendResponse(hdtg, comm, agent_id, token, 0, depth,
+                         state_agent, state_id);
         return;
     }
 
@@ -273,7 +323,8 @@ static void hdtgRequest(plan_heur_t *heur, plan_ma_comm_t *comm,
     if (ret < 0){
         // Could not send request (either there is no path or we reached
         // limit for distributed recursion) -- report back zero.
-        hdtgSendResponse(hdtg, comm, agent_id, token, 0, depth);
+        hdtgSendResponse(hdtg, comm, agent_id, token, 0, depth,
+                         state_agent, state_id);
 
     }else if (ret > 0){
         // Save cost as a base cost for updates
@@ -281,7 +332,8 @@ static void hdtgRequest(plan_heur_t *heur, plan_ma_comm_t *comm,
 
     }else{
         // Just send response
-        hdtgSendResponse(hdtg, comm, agent_id, token, cost, depth);
+        hdtgSendResponse(hdtg, comm, agent_id, token, cost, depth,
+                         state_agent, state_id);
     }
 }
 
@@ -359,6 +411,24 @@ static void pendingReqsFree(plan_heur_ma_dtg_t *hdtg, pending_reqs_t *r)
 }
 
 
+static int hdtgEvalNew(plan_heur_ma_dtg_t *hdtg)
+{
+    int i;
+
+    for (i = 0; i < hdtg->eval_size; ++i){
+        if (!hdtg->eval[i].active)
+            return i;
+    }
+
+    ++hdtg->eval_size;
+    hdtg->eval = BOR_REALLOC_ARR(hdtg->eval, hdtg_eval_t, hdtg->eval_size);
+    hdtg->eval[i].active = 0;
+    hdtg->eval[i].state_id = PLAN_NO_STATE;
+    planHeurDTGCtxInit(&hdtg->eval[i].ctx, &hdtg->data);
+    planStateInit(&hdtg->eval[i].state, hdtg->var_size);
+    return i;
+}
+
 static int hdtgNextToken(plan_heur_ma_dtg_t *hdtg)
 {
     int i;
@@ -404,7 +474,8 @@ static int hdtgFindOwners(plan_heur_ma_dtg_t *hdtg,
 static void hdtgSendResponse(plan_heur_ma_dtg_t *hdtg,
                              plan_ma_comm_t *comm,
                              int agent, int token, int cost,
-                             int depth)
+                             int depth, int state_agent,
+                             plan_state_id_t state_id)
 {
     plan_ma_msg_t *msg;
     int subtype;
@@ -416,6 +487,8 @@ static void hdtgSendResponse(plan_heur_ma_dtg_t *hdtg,
     msg = planMAMsgNew(PLAN_MA_MSG_HEUR, subtype, comm->node_id);
     planMAMsgSetHeurToken(msg, token);
     planMAMsgSetHeurCost(msg, cost);
+    planMAMsgSetHeurStateAgent(msg, state_agent);
+    planMAMsgSetHeurStateId(msg, state_id);
     planMACommSendToNode(comm, agent, msg);
     planMAMsgDel(msg);
 }
@@ -471,8 +544,8 @@ static plan_ma_msg_t *_sendReqMsgNew(plan_heur_ma_dtg_t *hdtg,
         }
 
     }else{
-        vals = hdtg->ctx.values.val[var];
-        range = hdtg->ctx.values.val_range[var] - 1;
+        vals = hdtg->cur->ctx.values.val[var];
+        range = hdtg->cur->ctx.values.val_range[var] - 1;
         for (i = 0; i < range; ++i){
             if (vals[i])
                 planMAMsgAddDTGReqReachable(msg, i);
@@ -480,6 +553,13 @@ static plan_ma_msg_t *_sendReqMsgNew(plan_heur_ma_dtg_t *hdtg,
     }
 
     planMAMsgSetHeurToken(msg, token);
+    if (req_msg){
+        planMAMsgSetHeurStateAgent(msg, planMAMsgHeurStateAgent(req_msg));
+        planMAMsgSetHeurStateId(msg, planMAMsgHeurStateId(req_msg));
+    }else{
+        planMAMsgSetHeurStateAgent(msg, comm->node_id);
+        planMAMsgSetHeurStateId(msg, hdtg->cur->state_id);
+    }
     planMAMsgAddHeurRequestedAgent(msg, comm->node_id);
     planMAMsgSetDTGReq(msg, var, from, to);
 
@@ -514,10 +594,17 @@ static int hdtgSendRequest(plan_heur_ma_dtg_t *hdtg,
     wait->response_agent = -1;
     wait->response_token = -1;
     wait->response_depth = 0;
+    wait->response_state_id = PLAN_NO_STATE;
+    wait->response_state_agent = -1;
+    wait->eval = -1;
     if (req_msg){
         wait->response_agent = planMAMsgAgent(req_msg);
         wait->response_token = planMAMsgHeurToken(req_msg);
         wait->response_depth = planMAMsgHeurRequestedAgentSize(req_msg);
+        wait->response_state_id = planMAMsgHeurStateId(req_msg);
+        wait->response_state_agent = planMAMsgHeurStateAgent(req_msg);
+    }else{
+        wait->eval = hdtg->cur - hdtg->eval;
     }
 
     // Send message to agents and update corresponding items in waitlist
@@ -626,7 +713,7 @@ static int hdtgStepNoPath(plan_heur_ma_dtg_t *hdtg,
         // At least '?' value is reachable so try other agents and ask them
         // for cost of path.
         // But first we must 'invent' the local cost of path.
-        hdtg->ctx.heur += open_goal.path->pre[fake_val].len;
+        hdtg->cur->ctx.heur += open_goal.path->pre[fake_val].len;
         return hdtgStepRequest(hdtg, comm, open_goal.path, open_goal.var,
                                open_goal.val, fake_val);
     }else{
@@ -641,11 +728,11 @@ static int hdtgStep(plan_heur_ma_dtg_t *hdtg, plan_ma_comm_t *comm)
     plan_heur_dtg_open_goal_t open_goal;
     int ret;
 
-    ret = planHeurDTGCtxStep(&hdtg->ctx, &hdtg->data);
+    ret = planHeurDTGCtxStep(&hdtg->cur->ctx, &hdtg->data);
     if (ret == -1)
         return -1;
 
-    open_goal = hdtg->ctx.cur_open_goal;
+    open_goal = hdtg->cur->ctx.cur_open_goal;
     if (open_goal.min_val == -1){
         // We haven't found any path in DTG -- find out whether the '?'
         // value is reachable.
@@ -694,19 +781,23 @@ static int update(plan_heur_ma_dtg_t *hdtg, plan_ma_comm_t *comm,
     cost += req->base_cost;
 
     if (req->response_agent == -1){
+        // Switch to the evaluation the request was sent from
+        hdtg->cur = hdtg->eval + req->eval;
+
         // Update heuristic value
-        hdtg->ctx.heur += cost;
+        hdtg->cur->ctx.heur += cost;
 
         // Proceed with dtg heuristic
         while ((ret = hdtgStep(hdtg, comm)) == 0);
         if (ret == 1)
             return -1;
 
-    }else{
-        // Send response to the parent caller
-        hdtgSendResponse(hdtg, comm, req->response_agent,
-                         req->response_token, cost, req->response_depth);
+        return 0;
     }
 
-    return 0;
+    // Send response to the parent caller
+    hdtgSendResponse(hdtg, comm, req->response_agent,
+                     req->response_token, cost, req->response_depth,
+                     req->response_state_agent, req->response_state_id);
+    return -1;
 }
@@ -24,10 +24,11 @@
 #include "heur_relax.h"
 #include "op_id_tr.h"
 
-struct _plan_heur_ma_ff_t {
-    plan_heur_t heur;
-    plan_heur_relax_t relax;
-
+/** Context of one evaluation of the heuristic. More evaluations can be in
+ *  flight at the same time (see plan_heur_t.ma_pipeline). */
+struct _ma_ff_eval_t {
+    int active;                /*!< True if the evaluation is in progress */
+    plan_state_id_t state_id;  /*!< ID of the evaluated state */
     plan_state_t *state;       /*!< State for which the heuristic is computed */
     plan_oparr_t relaxed_plan; /*!< Relaxed plan computed on all operators.
                                     It means that the operators are
@@ -35,9 +36,19 @@ struct _plan_heur_ma_ff_t {
 
     bor_rbtree_int_t *peer_op;          /*!< Set of operators that are
                                              requested from other peers */
+    int peer_op_size;                   /*!< Number of peer ops in .peer_op */
+};
+typedef struct _ma_ff_eval_t ma_ff_eval_t;
+
+struct _plan_heur_ma_ff_t {
+    plan_heur_t heur;
+    plan_heur_relax_t relax;
+    int var_size;
+
+    ma_ff_eval_t *eval; /*!< Evaluations in progress */
+    int eval_size;      /*!< Number of allocated evaluation contexts */
     bor_rbtree_int_node_t *pre_peer_op; /*!< Pre-allocated node to
                                              remote_op set */
-    int peer_op_size;                   /*!< Number of peer ops in .peer_op */
 
     const plan_op_t *base_op;
     int base_op_size;
@@ -51,33 +62,43 @@ typedef struct _plan_heur_ma_ff_t plan_heur_ma_ff_t;
 #define HEUR(parent) bor_container_of(parent, plan_heur_ma_ff_t, heur)
 
 
+/** Returns a free evaluation context for the specified state. A new one
+ *  is allocated if all are in use. */
+static ma_ff_eval_t *evalNew(plan_heur_ma_ff_t *ma, plan_state_id_t state_id);
+/** Returns evaluation context of the specified state or NULL */
+static ma_ff_eval_t *evalFind(plan_heur_ma_ff_t *ma,
+                              plan_state_id_t state_id);
+/** Frees resources of the evaluation context */
+static void evalFree(ma_ff_eval_t *ev);
+
 /** Adds operator to the MA relaxed plan if not already there.
  *  Returns 0 if the operator was inserted, -1 otherwise */
-static int maAddOpToRelaxedPlan(plan_heur_ma_ff_t *ma, int id, int cost);
+static int maAddOpToRelaxedPlan(ma_ff_eval_t *ev, int id, int cost);
 /** Adds peer-operator to the register. Returns 0 if the operator was
  *  inserted or -1 if operator was already there or already in relaxed plan. */
-static int maAddPeerOp(plan_heur_ma_ff_t *ma, int id);
+static int maAddPeerOp(plan_heur_ma_ff_t *ma, ma_ff_eval_t *ev, int id);
 /** Removes peer-operator from the registry */
-static void maDelPeerOp(plan_heur_ma_ff_t *ma, int id);
+static void maDelPeerOp(ma_ff_eval_t *ev, int id);
 /** Sends HEUR_REQUEST message to the peer */
 static void maSendHeurRequest(const plan_heur_ma_ff_t *ff,
                               plan_ma_comm_t *comm, int peer_id,
-                              const plan_state_t *state, int op_id);
+                              const ma_ff_eval_t *ev, int op_id);
 /** Computes heuristic value from the relaxed plan */
-static void maHeur(plan_heur_ma_ff_t *heur,
-                   plan_heur_res_t *res);
+static void maHeur(const ma_ff_eval_t *ev, plan_heur_res_t *res);
 /** Returns operator corresponding to its global ID or NULL if this node
  *  does not know this operator */
 static const plan_op_t *maOpFromId(plan_heur_ma_ff_t *heur, int op_id);
 static const plan_op_t *maPrivateOpFromId(plan_heur_ma_ff_t *heur, int op_id);
-/** Performs local exploration from the initial state stored in .ma.state
+/** Performs local exploration from the initial state stored in ev->state
  *  to the specified goal. */
 static void maExploreLocal(plan_heur_ma_ff_t *heur,
+                           ma_ff_eval_t *ev,
                            plan_ma_comm_t *comm,
                            const plan_part_state_t *goal,
                            plan_heur_res_t *res);
 /** Update relaxed plan by received local operator */
 static void maUpdateLocalOp(plan_heur_ma_ff_t *heur,
+                            ma_ff_eval_t *ev,
                             plan_ma_comm_t *comm,
                             int op_id);
 
@@ -103,20 +124,19 @@ plan_heur_t *planHeurMARelaxFFNew(const plan_problem_t *prob)
     _planHeurInit(&heur->heur, heurDel, NULL, NULL);
     _planHeurMAInit(&heur->heur, planHeurRelaxFFMA, NULL,
                     planHeurRelaxFFMAUpdate, planHeurRelaxFFMARequest);
+    // Requests are tagged with the state ID, so more states can be
+    // evaluated at once.
+    heur->heur.ma_pipeline = 1;
 
     planHeurRelaxInit(&heur->relax, PLAN_HEUR_RELAX_TYPE_ADD,
                       prob->var, prob->var_size,
                       prob->goal,
                       prob->proj_op, prob->proj_op_size, 0);
 
-    heur->state = planStateNew(prob->var_size);
-
-    heur->relaxed_plan.op = NULL;
-    heur->relaxed_plan.size = 0;
-
-    heur->peer_op = borRBTreeIntNew();
+    heur->var_size = prob->var_size;
+    heur->eval = NULL;
+    heur->eval_size = 0;
     heur->pre_peer_op = BOR_ALLOC(bor_rbtree_int_node_t);
-    heur->peer_op_size = 0;
 
     heur->base_op = prob->proj_op;
     heur->base_op_size = prob->proj_op_size;
@@ -135,19 +155,16 @@ plan_heur_t *planHeurMARelaxFFNew(const plan_problem_t *prob)
 static void heurDel(plan_heur_t *_heur)
 {
     plan_heur_ma_ff_t *heur = HEUR(_heur);
-    bor_rbtree_int_node_t *n;
+    int i;
 
     _planHeurFree(&heur->heur);
     planHeurRelaxFree(&heur->relax);
 
-    planStateDel(heur->state);
-    if (heur->relaxed_plan.op)
-        BOR_FREE(heur->relaxed_plan.op);
+    for (i = 0; i < heur->eval_size; ++i)
+        evalFree(heur->eval + i);
+    if (heur->eval)
+        BOR_FREE(heur->eval);
 
-    while ((n = borRBTreeIntExtractMin(heur->peer_op)) != NULL){
-        BOR_FREE(n);
-    }
-    borRBTreeIntDel(heur->peer_op);
     BOR_FREE(heur->pre_peer_op);
     planOpIdTrFree(&heur->op_id_tr);
     planProblemDestroyOps(heur->private_op, heur->private_op_size);
@@ -156,83 +173,145 @@ static void heurDel(plan_heur_t *_heur)
 }
 
 
-static int maAddOpToRelaxedPlan(plan_heur_ma_ff_t *ma, int id, int cost)
+static ma_ff_eval_t *evalNew(plan_heur_ma_ff_t *ma, plan_state_id_t state_id)
+{
+    ma_ff_eval_t *ev;
+    bor_rbtree_int_node_t *n;
+    int i;
+
+    for (i = 0; i < ma->eval_size && ma->eval[i].active; ++i);
+    if (i == ma->eval_size){
+        ++ma->eval_size;
+        ma->eval = BOR_REALLOC_ARR(ma->eval, ma_ff_eval_t, ma->eval_size);
+        ev = ma->eval + i;
+        ev->state = planStateNew(ma->var_size);
+        ev->relaxed_plan.op = NULL;
+        ev->relaxed_plan.size = 0;
+        ev->peer_op = borRBTreeIntNew();
+        ev->peer_op_size = 0;
+    }
+
+    ev = ma->eval + i;
+    ev->active = 1;
+    ev->state_id = state_id;
+
+    // Reset relaxed plan
+    for (i = 0; i < ev->relaxed_plan.size; ++i)
+        ev->relaxed_plan.op[i] = -1;
+
+    // Forget peer operators of the previous (dead-end) evaluation
+    while ((n = borRBTreeIntExtractMin(ev->peer_op)) != NULL){
+        BOR_FREE(n);
+    }
+    ev->peer_op_size = 0;
+
+    return ev;
+}
+
+static ma_ff_eval_t *evalFind(plan_heur_ma_ff_t *ma,
+                              plan_state_id_t state_id)
+{
+    int i;
+
+    for (i = 0; i < ma->eval_size; ++i){
+        if (ma->eval[i].active && ma->eval[i].state_id == state_id)
+            return ma->eval + i;
+    }
+    return NULL;
+}
+
+static void evalFree(ma_ff_eval_t *ev)
+{
+    bor_rbtree_int_node_t *n;
+
+    planStateDel(ev->state);
+    if (ev->relaxed_plan.op)
+        BOR_FREE(ev->relaxed_plan.op);
+
+    while ((n = borRBTreeIntExtractMin(ev->peer_op)) != NULL){
+        BOR_FREE(n);
+    }
+    borRBTreeIntDel(ev->peer_op);
+}
+
+static int maAddOpToRelaxedPlan(ma_ff_eval_t *ev, int id, int cost)
 {
     int i;
 
-    if (ma->relaxed_plan.size <= id){
-        i = ma->relaxed_plan.size;
-        ma->relaxed_plan.size = id + 1;
-        ma->relaxed_plan.op = BOR_REALLOC_ARR(ma->relaxed_plan.op, int,
-                                              ma->relaxed_plan.size);
+    if (ev->relaxed_plan.size <= id){
+        i = ev->relaxed_plan.size;
+        ev->relaxed_plan.size = id + 1;
+        ev->relaxed_plan.op = BOR_REALLOC_ARR(ev->relaxed_plan.op, int,
+                                              ev->relaxed_plan.size);
         // Initialize the newly allocated memory
-        for (; i < ma->relaxed_plan.size; ++i){
-            ma->relaxed_plan.op[i] = -1;
+        for (; i < ev->relaxed_plan.size; ++i){
+            ev->relaxed_plan.op[i] = -1;
         }
     }
 
-    if (ma->relaxed_plan.op[id] == -1){
-        ma->relaxed_plan.op[id] = cost;
+    if (ev->relaxed_plan.op[id] == -1){
+        ev->relaxed_plan.op[id] = cost;
         return 0;
     }
 
     return -1;
 }
 
-static int maAddPeerOp(plan_heur_ma_ff_t *ma, int id)
+static int maAddPeerOp(plan_heur_ma_ff_t *ma, ma_ff_eval_t *ev, int id)
 {
     bor_rbtree_int_node_t *n;
 
-    if (id < ma->relaxed_plan.size && ma->relaxed_plan.op[id] >= 0)
+    if (id < ev->relaxed_plan.size && ev->relaxed_plan.op[id] >= 0)
         return -1;
 
-    n = borRBTreeIntInsert(ma->peer_op, id, ma->pre_peer_op);
+    n = borRBTreeIntInsert(ev->peer_op, id, ma->pre_peer_op);
     if (n == NULL){
         // The ID was inserted, preallocate next peer_op
         ma->pre_peer_op = BOR_ALLOC(bor_rbtree_int_node_t);
         // Increase the counter
-        ++ma->peer_op_size;
+        ++ev->peer_op_size;
         return 0;
     }
 
     return -1;
 }
 
-static void maDelPeerOp(plan_heur_ma_ff_t *ma, int id)
+static void maDelPeerOp(ma_ff_eval_t *ev, int id)
 {
     bor_rbtree_int_node_t *n;
 
-    n = borRBTreeIntFind(ma->peer_op, id);
+    n = borRBTreeIntFind(ev->peer_op, id);
     if (n != NULL){
-        borRBTreeIntRemove(ma->peer_op, n);
-        --ma->peer_op_size;
+        borRBTreeIntRemove(ev->peer_op, n);
+        --ev->peer_op_size;
         BOR_FREE(n);
     }
 }
 
 static void maSendHeurRequest(const plan_heur_ma_ff_t *heur,
                               plan_ma_comm_t *comm, int peer_id,
-                              const plan_state_t *state, int op_id)
+                              const ma_ff_eval_t *ev, int op_id)
 {
     plan_ma_msg_t *msg;
 
     msg = planMAMsgNew(PLAN_MA_MSG_HEUR, PLAN_MA_MSG_HEUR_FF_REQUEST,
                        comm->node_id);
-    planMAStateSetMAMsg2(heur->heur.ma_state, state, msg);
+    planMAStateSetMAMsg2(heur->heur.ma_state, ev->state, msg);
     planMAMsgSetGoalOpId(msg, op_id);
+    planMAMsgSetHeurStateAgent(msg, comm->node_id);
+    planMAMsgSetHeurStateId(msg, ev->state_id);
     planMACommSendToNode(comm, peer_id, msg);
     planMAMsgDel(msg);
 }
 
-static void maHeur(plan_heur_ma_ff_t *heur,
-                   plan_heur_res_t *res)
+static void maHeur(const ma_ff_eval_t *ev, plan_heur_res_t *res)
 {
     int i;
     plan_cost_t hval = 0;
 
-    for (i = 0; i < heur->relaxed_plan.size; ++i){
-        if (heur->relaxed_plan.op[i] > 0)
-            hval += heur->relaxed_plan.op[i];
+    for (i = 0; i < ev->relaxed_plan.size; ++i){
+        if (ev->relaxed_plan.op[i] > 0)
+            hval += ev->relaxed_plan.op[i];
     }
 
     res->heur = hval;
@@ -260,6 +339,7 @@ static const plan_op_t *maPrivateOpFromId(plan_heur_ma_ff_t *heur, int op_id)
 }
 
 static void maExploreLocal(plan_heur_ma_ff_t *heur,
+                           ma_ff_eval_t *ev,
                            plan_ma_comm_t *comm,
                            const plan_part_state_t *goal,
                            plan_heur_res_t *res)
@@ -269,7 +349,7 @@ static void maExploreLocal(plan_heur_ma_ff_t *heur,
     int i, global_id, owner;
 
     // Initialize initial state
-    planStateCopy(&state, heur->state);
+    planStateCopy(&state, ev->state);
 
     // Compute heuristic from the initial state to the specified goal
     if (!goal){
@@ -301,18 +381,19 @@ static void maExploreLocal(plan_heur_ma_ff_t *heur,
             // The operator is owned by remote peer.
             // Add it to the set of operators we are waiting for from
             // other peers
-            if (maAddPeerOp(heur, global_id) == 0){
+            if (maAddPeerOp(heur, ev, global_id) == 0){
                 // Send a request to the owner
-                maSendHeurRequest(heur, comm, owner, heur->state, global_id);
+                maSendHeurRequest(heur, comm, owner, ev, global_id);
             }
         }
 
         // Add the operator to the relaxed plan
-        maAddOpToRelaxedPlan(heur, global_id, op->cost);
+        maAddOpToRelaxedPlan(ev, global_id, op->cost);
     }
 }
 
 static void maUpdateLocalOp(plan_heur_ma_ff_t *heur,
+                            ma_ff_eval_t *ev,
                             plan_ma_comm_t *comm,
                             int op_id)
 {
@@ -323,9 +404,9 @@ static void maUpdateLocalOp(plan_heur_ma_ff_t *heur,
     if (op == NULL)
         return;
 
-    if (maAddOpToRelaxedPlan(heur, op_id, op->cost) == 0){
+    if (maAddOpToRelaxedPlan(ev, op_id, op->cost) == 0){
         planHeurResInit(&res);
-        maExploreLocal(heur, comm, op->pre, &res);
+        maExploreLocal(heur, ev, comm, op->pre, &res);
     }
 }
 
@@ -335,28 +416,30 @@ static int planHeurRelaxFFMA(plan_heur_t *_heur,
                              plan_heur_res_t *res)
 {
     plan_heur_ma_ff_t *heur = HEUR(_heur);
-    int i;
+    ma_ff_eval_t *ev;
 
     // Remember the state for which we want to compute heuristic
-    planStateCopy(heur->state, state);
-
-    // Reset relaxed plan
-    for (i = 0; i < heur->relaxed_plan.size; ++i)
-        heur->relaxed_plan.op[i] = -1;
+    ev = evalNew(heur, state->state_id);
+    planStateCopy(ev->state, state);
 
     // Explore projected state space
-    maExploreLocal(heur, comm, NULL, res);
-    if (res->heur == PLAN_HEUR_DEAD_END)
+    maExploreLocal(heur, ev, comm, NULL, res);
+    if (res->heur == PLAN_HEUR_DEAD_END){
+        // Responses to the requests that were already sent will be
+        // ignored because the evaluation is not active anymore.
+        ev->active = 0;
         return 0;
+    }
 
     // If we are waiting for responses from other peers, postpone actual
     // computation of the heuristic value.
-    if (heur->peer_op_size > 0){
+    if (ev->peer_op_size > 0){
         return -1;
     }
 
     // Compute heuristic value
-    maHeur(heur, res);
+    maHeur(ev, res);
+    ev->active = 0;
     return 0;
 }
 
@@ -366,12 +449,19 @@ static int planHeurRelaxFFMAUpdate(plan_heur_t *_heur,
                                    plan_heur_res_t *res)
 {
     plan_heur_ma_ff_t *heur = HEUR(_heur);
+    ma_ff_eval_t *ev;
     const plan_ma_msg_op_t *op;
     int i, len, op_id, cost, owner, from_agent;
 
+    ev = evalFind(heur, planMAMsgHeurStateId(msg));
+    if (ev == NULL){
+        // Late response to an evaluation that was already finished
+        return -1;
+    }
+
     from_agent = planMAMsgAgent(msg);
 
-    maDelPeerOp(heur, planMAMsgGoalOpId(msg));
+    maDelPeerOp(ev, planMAMsgGoalOpId(msg));
 
     // Then explore all other peer-operators
     len = planMAMsgOpSize(msg);
@@ -382,31 +472,35 @@ static int planHeurRelaxFFMAUpdate(plan_heur_t *_heur,
         owner = planMAMsgOpOwner(op);
 
         if (owner == comm->node_id){
-            maUpdateLocalOp(heur, comm, op_id);
+            maUpdateLocalOp(heur, ev, comm, op_id);
 
         }else{
-            if (owner != from_agent && maAddPeerOp(heur, op_id) == 0){
-                maSendHeurRequest(heur, comm, owner, heur->state, op_id);
+            if (owner != from_agent && maAddPeerOp(heur, ev, op_id) == 0){
+                maSendHeurRequest(heur, comm, owner, ev, op_id);
             }
-            maAddOpToRelaxedPlan(heur, op_id, cost);
+            maAddOpToRelaxedPlan(ev, op_id, cost);
         }
     }
 
-    if (heur->peer_op_size > 0)
+    if (ev->peer_op_size > 0)
         return -1;
 
-    maHeur(heur, res);
+    maHeur(ev, res);
+    ev->active = 0;
     return 0;
 }
 
 static void maSendEmptyResponse(plan_ma_comm_t *comm,
-                                int peer_id, int op_id)
+                                int peer_id, int op_id,
+                                plan_state_id_t state_id)
 {
     plan_ma_msg_t *resp;
 
     resp = planMAMsgNew(PLAN_MA_MSG_HEUR, PLAN_MA_MSG_HEUR_FF_RESPONSE,
                         comm->node_id);
     planMAMsgSetGoalOpId(resp, op_id);
+    planMAMsgSetHeurStateAgent(resp, peer_id);
+    planMAMsgSetHeurStateId(resp, state_id);
     planMACommSendToNode(comm, peer_id, resp);
     planMAMsgDel(resp);
 }
@@ -423,9 +517,11 @@ static void planHeurRelaxFFMARequest(plan_heur_t *_heur,
     int i, op_id, agent_id;
     int global_id, owner;
     plan_cost_t h, cost;
+    plan_state_id_t state_id;
 
     op_id = planMAMsgGoalOpId(msg);
     agent_id = planMAMsgAgent(msg);
+    state_id = planMAMsgHeurStateId(msg);
 
     // Initialize initial state
     planMAStateGetFromMAMsg(heur->heur.ma_state, msg, &state);
@@ -433,7 +529,7 @@ static void planHeurRelaxFFMARequest(plan_heur_t *_heur,
     // Find target operator
     op = maPrivateOpFromId(heur, op_id);
     if (op == NULL){
-        maSendEmptyResponse(comm, agent_id, op_id);
+        maSendEmptyResponse(comm, agent_id, op_id, state_id);
         return;
     }
 
@@ -441,7 +537,7 @@ static void planHeurRelaxFFMARequest(plan_heur_t *_heur,
     // requested operator.
     h = planHeurRelax2(&heur->relax, &state, op->pre);
     if (h == PLAN_HEUR_DEAD_END){
-        maSendEmptyResponse(comm, agent_id, op_id);
+        maSendEmptyResponse(comm, agent_id, op_id, state_id);
         return;
     }
     planHeurRelaxMarkPlan2(&heur->relax, op->pre);
@@ -451,6 +547,9 @@ static void planHeurRelaxFFMARequest(plan_heur_t *_heur,
     response = planMAMsgNew(PLAN_MA_MSG_HEUR, PLAN_MA_MSG_HEUR_FF_RESPONSE,
                             comm->node_id);
     planMAMsgSetGoalOpId(response, op_id);
+    // Requests are never relayed, so the state belongs to the requester
+    planMAMsgSetHeurStateAgent(response, agent_id);
+    planMAMsgSetHeurStateId(response, state_id);
     for (i = 0; i < heur->relax.cref.op_size; ++i){
         if (!heur->relax.plan_op[i])
             continue;
@@ -76,6 +76,7 @@ plan_heur_t *planHeurMAPotProjNew(const plan_problem_t *p, unsigned flags)
     planPotInit(&h->pot, p->var, p->var_size, p->goal,
                 p->proj_op, p->proj_op_size, h->state, flags, 0);
     planPotCompute(&h->pot);
+    planPotFreeLP(&h->pot);
 
     h->agent_id = p->agent_id;
     h->agent_size = p->num_agents;
@@ -0,0 +1,953 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <limits.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <boruvka/alloc.h>
+#include <plan/heur.h>
+#include <plan/dtg.h>
+#include <plan/causal_graph.h>
+#include <plan/prio_queue.h>
+
+#include "heur_common.h"
+
+#ifndef _GNU_SOURCE
+/** Declaration of qsort_r() function that should be available in libc */
+void qsort_r(void *base, size_t nmemb, size_t size,
+             int (*compar)(const void *, const void *, void *),
+             void *arg);
+#endif
+
+/** Goal distance of dead-end abstract states */
+#define DIST_INF INT_MAX
+
+/**
+ * Transition between two abstract states.
+ */
+struct _ms_tr_t {
+    int from;
+    int to;
+};
+typedef struct _ms_tr_t ms_tr_t;
+
+/**
+ * Transitions of one label. Labels that are not stored in a transition
+ * system induce self-loops in all its states.
+ */
+struct _ms_label_t {
+    int label;     /*!< ID of the label */
+    ms_tr_t *tr;   /*!< Sorted transitions */
+    int tr_size;
+    int exclusive; /*!< True if the label is not relevant in any other
+                        transition system */
+};
+typedef struct _ms_label_t ms_label_t;
+
+/**
+ * Transition system.
+ */
+struct _ms_ts_t {
+    int size;          /*!< Number of abstract states */
+    char *goal;        /*!< Goal flag for each state */
+    int *h;            /*!< Goal distances */
+    ms_label_t *label; /*!< Relevant labels sorted by ID */
+    int label_size;
+    int node;          /*!< Node of the mapping tree */
+};
+typedef struct _ms_ts_t ms_ts_t;
+
+/**
+ * Node of the tree mapping states to the abstract states.
+ * Leaves map values of variables, inner nodes map pairs of abstract
+ * states of their children. -1 stands for a pruned (dead-end) state.
+ */
+struct _ms_node_t {
+    int var;        /*!< Variable of a leaf or -1 */
+    int left;       /*!< Children of an inner node */
+    int right;
+    int right_size; /*!< Number of abstract states of the right child */
+    int *table;     /*!< Abstract states of values or of pairs */
+    int table_size;
+};
+typedef struct _ms_node_t ms_node_t;
+
+/**
+ * Main structure for merge-and-shrink heuristic
+ */
+struct _plan_heur_ms_t {
+    plan_heur_t heur;
+    ms_node_t *node; /*!< Mapping tree, children precede their parents */
+    int node_size;
+    int *value;      /*!< Pre-allocated abstract states of nodes */
+    int *h;          /*!< Goal distances of abstract states of the root */
+};
+typedef struct _plan_heur_ms_t plan_heur_ms_t;
+#define HEUR(parent) \
+    bor_container_of((parent), plan_heur_ms_t, heur)
+
+/**
+ * Context of the construction of the abstraction.
+ */
+struct _ms_t {
+    int *cost;       /*!< Cost of each label */
+    int label_size;
+    int *rel_count;  /*!< Number of transition systems each label is
+                          relevant in */
+    int max_states;  /*!< Size limit of transition systems */
+    ms_node_t *node;
+};
+typedef struct _ms_t ms_t;
+
+static void heurMSDel(plan_heur_t *_heur);
+static void heurMS(plan_heur_t *_heur, const plan_state_t *state,
+                   plan_heur_res_t *res);
+
+/** Builds atomic transition system of the variable */
+static void tsInitAtomic(ms_ts_t *ts, ms_t *ms, const plan_dtg_t *dtg,
+                         plan_var_id_t var, const plan_part_state_t *goal,
+                         const plan_op_t *op, int op_size);
+static void tsFree(ms_ts_t *ts);
+/** Computes goal distances .h of all states */
+static void tsGoalDist(ms_ts_t *ts, const ms_t *ms);
+/** Shrinks the transition system to at most max_size states using
+ *  greedy bisimulation, dead-end states are always pruned. */
+static void tsShrink(ms_ts_t *ts, ms_t *ms, int max_size);
+/** Computes synchronized product of a and b, both are freed */
+static void tsMerge(ms_ts_t *dst, ms_t *ms, ms_ts_t *a, ms_ts_t *b,
+                   int node_id);
+/** Merges exclusive labels with the same transitions */
+static void tsReduceLabels(ms_ts_t *ts, ms_t *ms);
+
+/** Merges two transition systems, the independent pairs of one level of
+ *  the merge tree are processed in parallel */
+struct _merge_th_t {
+    pthread_t th;
+    ms_t *ms;
+    ms_ts_t *ts;     /*!< All transition systems */
+    const int *cur;  /*!< Transition systems of the current level */
+    int pair_size;   /*!< Number of pairs to merge */
+    int *next;       /*!< Output transition systems */
+    int next_begin;  /*!< Index of the first free transition system */
+    int node_begin;  /*!< Index of the first free node */
+    int id;
+    int num_threads;
+};
+typedef struct _merge_th_t merge_th_t;
+
+static void *mergeTh(void *_th)
+{
+    merge_th_t *th = _th;
+    ms_ts_t *a, *b, *dst;
+    long size;
+    int i;
+
+    for (i = th->id; i < th->pair_size; i += th->num_threads){
+        a = th->ts + th->cur[2 * i];
+        b = th->ts + th->cur[2 * i + 1];
+        dst = th->ts + th->next_begin + i;
+
+        // Shrink the bigger factor first so that the product fits
+        size = (long)a->size * b->size;
+        if (size > th->ms->max_states){
+            if (a->size < b->size){
+                dst = a;
+                a = b;
+                b = dst;
+                dst = th->ts + th->next_begin + i;
+            }
+            tsShrink(a, th->ms, BOR_MAX(th->ms->max_states / b->size, 1));
+            size = (long)a->size * b->size;
+            if (size > th->ms->max_states)
+                tsShrink(b, th->ms, BOR_MAX(th->ms->max_states / a->size, 1));
+        }
+
+        tsMerge(dst, th->ms, a, b, th->node_begin + i);
+        tsReduceLabels(dst, th->ms);
+        tsShrink(dst, th->ms, INT_MAX);
+        th->next[i] = th->next_begin + i;
+    }
+
+    return NULL;
+}
+
+static void mergeLevel(ms_t *ms, ms_ts_t *ts, int *ts_size,
+                       int *cur, int *cur_size, int *node_size,
+                       int num_threads)
+{
+    merge_th_t *th;
+    int *next, next_size, pair_size;
+    int i, j;
+
+    // Count in how many transition systems each label is relevant
+    bzero(ms->rel_count, sizeof(int) * ms->label_size);
+    for (i = 0; i < *cur_size; ++i){
+        for (j = 0; j < ts[cur[i]].label_size; ++j)
+            ++ms->rel_count[ts[cur[i]].label[j].label];
+    }
+
+    pair_size = *cur_size / 2;
+    next = BOR_ALLOC_ARR(int, pair_size + 1);
+
+    num_threads = BOR_MAX(1, BOR_MIN(num_threads, pair_size));
+    th = BOR_ALLOC_ARR(merge_th_t, num_threads);
+    for (i = 0; i < num_threads; ++i){
+        th[i].ms = ms;
+        th[i].ts = ts;
+        th[i].cur = cur;
+        th[i].pair_size = pair_size;
+        th[i].next = next;
+        th[i].next_begin = *ts_size;
+        th[i].node_begin = *node_size;
+        th[i].id = i;
+        th[i].num_threads = num_threads;
+    }
+
+    if (num_threads == 1){
+        mergeTh(th);
+    }else{
+        for (i = 0; i < num_threads; ++i)
+            pthread_create(&th[i].th, NULL, mergeTh, th + i);
+        for (i = 0; i < num_threads; ++i)
+            pthread_join(th[i].th, NULL);
+    }
+    BOR_FREE(th);
+
+    *ts_size += pair_size;
+    *node_size += pair_size;
+    next_size = pair_size;
+    if (*cur_size % 2 == 1)
+        next[next_size++] = cur[*cur_size - 1];
+
+    memcpy(cur, next, sizeof(int) * next_size);
+    *cur_size = next_size;
+    BOR_FREE(next);
+}
+
+plan_heur_t *planHeurMSNew(const plan_var_t *var, int var_size,
+                           const plan_part_state_t *goal,
+                           const plan_op_t *op, int op_size,
+                           unsigned flags, int max_states)
+{
+    plan_heur_ms_t *h;
+    plan_causal_graph_t *cg;
+    plan_dtg_t dtg;
+    ms_t ms;
+    ms_ts_t *ts;
+    int *cur, cur_size, ts_size, node_size, num_threads;
+    int i, v;
+
+    if (max_states <= 0)
+        max_states = PLAN_HEUR_MS_MAX_STATES;
+
+    h = BOR_ALLOC(plan_heur_ms_t);
+    _planHeurInit(&h->heur, heurMSDel, heurMS, NULL);
+
+    ms.label_size = op_size;
+    ms.cost = BOR_ALLOC_ARR(int, BOR_MAX(op_size, 1));
+    for (i = 0; i < op_size; ++i)
+        ms.cost[i] = planHeurOpCost(op[i].cost, flags);
+    ms.rel_count = BOR_ALLOC_ARR(int, BOR_MAX(op_size, 1));
+    ms.max_states = max_states;
+
+    // Only the variables connected with the goal are abstracted, in the
+    // order given by the causal graph. Private variables are left out.
+    cg = planCausalGraphNew(var_size, op, op_size, goal);
+    planDTGInit(&dtg, var, var_size, op, op_size);
+
+    ms.node = BOR_ALLOC_ARR(ms_node_t, BOR_MAX(2 * cg->var_order_size, 1));
+    ts = BOR_ALLOC_ARR(ms_ts_t, BOR_MAX(2 * cg->var_order_size, 1));
+    cur = BOR_ALLOC_ARR(int, BOR_MAX(cg->var_order_size, 1));
+    ts_size = node_size = cur_size = 0;
+    for (i = 0; i < cg->var_order_size; ++i){
+        v = cg->var_order[i];
+        if (var[v].ma_privacy)
+            continue;
+
+        ms.node[node_size].var = v;
+        ms.node[node_size].left = ms.node[node_size].right = -1;
+        ms.node[node_size].right_size = 0;
+        ts[ts_size].node = node_size++;
+        tsInitAtomic(ts + ts_size, &ms, &dtg, v, goal, op, op_size);
+        tsShrink(ts + ts_size, &ms, INT_MAX);
+        cur[cur_size++] = ts_size++;
+    }
+    planDTGFree(&dtg);
+    planCausalGraphDel(cg);
+
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    while (cur_size > 1){
+        mergeLevel(&ms, ts, &ts_size, cur, &cur_size, &node_size,
+                   BOR_MAX(num_threads, 1));
+    }
+
+    h->node = ms.node;
+    h->node_size = node_size;
+    h->value = BOR_ALLOC_ARR(int, BOR_MAX(node_size, 1));
+    h->h = NULL;
+    if (cur_size == 1){
+        if (ts[cur[0]].h == NULL)
+            tsGoalDist(ts + cur[0], &ms);
+        h->h = ts[cur[0]].h;
+        ts[cur[0]].h = NULL;
+        tsFree(ts + cur[0]);
+    }
+
+    BOR_FREE(cur);
+    BOR_FREE(ts);
+    BOR_FREE(ms.cost);
+    BOR_FREE(ms.rel_count);
+
+    return &h->heur;
+}
+
+static void heurMSDel(plan_heur_t *_heur)
+{
+    plan_heur_ms_t *h = HEUR(_heur);
+    int i;
+
+    for (i = 0; i < h->node_size; ++i){
+        if (h->node[i].table)
+            BOR_FREE(h->node[i].table);
+    }
+    BOR_FREE(h->node);
+    BOR_FREE(h->value);
+    if (h->h)
+        BOR_FREE(h->h);
+
+    _planHeurFree(&h->heur);
+    BOR_FREE(h);
+}
+
+static void heurMS(plan_heur_t *_heur, const plan_state_t *state,
+                   plan_heur_res_t *res)
+{
+    plan_heur_ms_t *h = HEUR(_heur);
+    const ms_node_t *node;
+    int i, l, r;
+
+    if (h->node_size == 0){
+        res->heur = 0;
+        return;
+    }
+
+    for (i = 0; i < h->node_size; ++i){
+        node = h->node + i;
+        if (node->var >= 0){
+            h->value[i] = node->table[planStateGet(state, node->var)];
+        }else{
+            l = h->value[node->left];
+            r = h->value[node->right];
+            if (l < 0 || r < 0){
+                h->value[i] = -1;
+            }else{
+                h->value[i] = node->table[l * node->right_size + r];
+            }
+        }
+    }
+
+    if (h->value[h->node_size - 1] < 0){
+        res->heur = PLAN_HEUR_DEAD_END;
+    }else{
+        res->heur = h->h[h->value[h->node_size - 1]];
+    }
+}
+
+
+static int trCmp(const void *a, const void *b)
+{
+    const ms_tr_t *t1 = a, *t2 = b;
+    if (t1->from != t2->from)
+        return t1->from - t2->from;
+    return t1->to - t2->to;
+}
+
+/** Sorts transitions and removes duplicates */
+static void labelSortTr(ms_label_t *label)
+{
+    int i, j;
+
+    if (label->tr_size <= 1)
+        return;
+
+    qsort(label->tr, label->tr_size, sizeof(ms_tr_t), trCmp);
+    for (i = 1, j = 0; i < label->tr_size; ++i){
+        if (trCmp(label->tr + i, label->tr + j) != 0)
+            label->tr[++j] = label->tr[i];
+    }
+    label->tr_size = j + 1;
+}
+
+static void labelAddTr(ms_label_t *label, int *alloc, int from, int to)
+{
+    if (label->tr_size == *alloc){
+        *alloc = BOR_MAX(2 * *alloc, 4);
+        label->tr = BOR_REALLOC_ARR(label->tr, ms_tr_t, *alloc);
+    }
+    label->tr[label->tr_size].from = from;
+    label->tr[label->tr_size].to = to;
+    ++label->tr_size;
+}
+
+static void tsInitAtomic(ms_ts_t *ts, ms_t *ms, const plan_dtg_t *dtg,
+                         plan_var_id_t var, const plan_part_state_t *goal,
+                         const plan_op_t *op, int op_size)
+{
+    const plan_dtg_var_t *dv = dtg->dtg + var;
+    const plan_dtg_trans_t *trans;
+    const plan_op_cond_eff_t *ce;
+    ms_label_t *label;
+    int *alloc, *relevant;
+    int range = dv->val_size;
+    int i, j, from, to, pre, eff, ce_pre, ce_eff, id;
+
+    ts->size = range;
+    ts->goal = BOR_ALLOC_ARR(char, range);
+    for (i = 0; i < range; ++i){
+        ts->goal[i] = 1;
+        if (planPartStateIsSet(goal, var))
+            ts->goal[i] = (planPartStateGet(goal, var) == i);
+    }
+    ts->h = NULL;
+
+    ms->node[ts->node].table = BOR_ALLOC_ARR(int, BOR_MAX(range, 1));
+    ms->node[ts->node].table_size = range;
+    for (i = 0; i < range; ++i)
+        ms->node[ts->node].table[i] = i;
+
+    label = BOR_CALLOC_ARR(ms_label_t, BOR_MAX(op_size, 1));
+    alloc = BOR_CALLOC_ARR(int, BOR_MAX(op_size, 1));
+    relevant = BOR_CALLOC_ARR(int, BOR_MAX(op_size, 1));
+
+    // Transitions changing the value are taken from DTG
+    for (from = 0; from < range; ++from){
+        for (to = 0; to < range; ++to){
+            trans = planDTGTrans(dtg, var, from, to);
+            for (i = 0; i < trans->ops_size; ++i){
+                id = trans->ops[i] - op;
+                labelAddTr(label + id, alloc + id, from, to);
+                relevant[id] = 1;
+            }
+        }
+    }
+
+    // Self-loops of prevail conditions and of effects without
+    // preconditions are not part of DTG. Conditional effects may or may
+    // not fire, so both possibilities are added.
+    for (id = 0; id < op_size; ++id){
+        pre = planPartStateGet(op[id].pre, var);
+        eff = planPartStateGet(op[id].eff, var);
+
+        if (eff != PLAN_VAL_UNDEFINED){
+            relevant[id] = 1;
+            if (pre == PLAN_VAL_UNDEFINED)
+                labelAddTr(label + id, alloc + id, eff, eff);
+        }else if (pre != PLAN_VAL_UNDEFINED){
+            relevant[id] = 1;
+            labelAddTr(label + id, alloc + id, pre, pre);
+        }
+
+        for (i = 0; i < op[id].cond_eff_size; ++i){
+            ce = op[id].cond_eff + i;
+            ce_pre = planPartStateGet(ce->pre, var);
+            ce_eff = planPartStateGet(ce->eff, var);
+            if (ce_pre == PLAN_VAL_UNDEFINED && ce_eff == PLAN_VAL_UNDEFINED)
+                continue;
+            if (ce_pre == PLAN_VAL_UNDEFINED)
+                ce_pre = pre;
+            if (pre != PLAN_VAL_UNDEFINED && ce_pre != pre)
+                continue;
+
+            if (!relevant[id] && pre == PLAN_VAL_UNDEFINED){
+                for (j = 0; j < range; ++j)
+                    labelAddTr(label + id, alloc + id, j, j);
+            }
+            relevant[id] = 1;
+
+            if (ce_eff == PLAN_VAL_UNDEFINED)
+                continue;
+            for (j = 0; j < range; ++j){
+                if (ce_pre == PLAN_VAL_UNDEFINED || ce_pre == j)
+                    labelAddTr(label + id, alloc + id, j, ce_eff);
+            }
+        }
+    }
+
+    // Keep only relevant labels
+    ts->label = BOR_ALLOC_ARR(ms_label_t, BOR_MAX(op_size, 1));
+    ts->label_size = 0;
+    for (id = 0; id < op_size; ++id){
+        if (!relevant[id])
+            continue;
+        label[id].label = id;
+        label[id].exclusive = 0;
+        labelSortTr(label + id);
+        ts->label[ts->label_size++] = label[id];
+    }
+
+    BOR_FREE(label);
+    BOR_FREE(alloc);
+    BOR_FREE(relevant);
+}
+
+static void tsFree(ms_ts_t *ts)
+{
+    int i;
+
+    for (i = 0; i < ts->label_size; ++i){
+        if (ts->label[i].tr)
+            BOR_FREE(ts->label[i].tr);
+    }
+    BOR_FREE(ts->label);
+    BOR_FREE(ts->goal);
+    if (ts->h)
+        BOR_FREE(ts->h);
+}
+
+static void tsGoalDist(ms_ts_t *ts, const ms_t *ms)
+{
+    plan_prio_queue_t queue;
+    int *in_begin, *in_from, *in_cost;
+    const ms_tr_t *tr;
+    int i, j, s, d, cost, size;
+
+    // Incoming transitions of each state
+    in_begin = BOR_CALLOC_ARR(int, ts->size + 1);
+    for (size = 0, i = 0; i < ts->label_size; ++i){
+        for (j = 0; j < ts->label[i].tr_size; ++j)
+            ++in_begin[ts->label[i].tr[j].to + 1];
+        size += ts->label[i].tr_size;
+    }
+    for (i = 0; i < ts->size; ++i)
+        in_begin[i + 1] += in_begin[i];
+
+    in_from = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+    in_cost = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+    for (i = 0; i < ts->label_size; ++i){
+        cost = ms->cost[ts->label[i].label];
+        for (j = 0; j < ts->label[i].tr_size; ++j){
+            tr = ts->label[i].tr + j;
+            in_from[in_begin[tr->to]] = tr->from;
+            in_cost[in_begin[tr->to]] = cost;
+            ++in_begin[tr->to];
+        }
+    }
+    for (i = ts->size; i > 0; --i)
+        in_begin[i] = in_begin[i - 1];
+    in_begin[0] = 0;
+
+    if (ts->h == NULL)
+        ts->h = BOR_ALLOC_ARR(int, BOR_MAX(ts->size, 1));
+
+    planPrioQueueInit(&queue);
+    for (i = 0; i < ts->size; ++i){
+        ts->h[i] = DIST_INF;
+        if (ts->goal[i]){
+            ts->h[i] = 0;
+            planPrioQueuePush(&queue, 0, i);
+        }
+    }
+
+    while (!planPrioQueueEmpty(&queue)){
+        s = planPrioQueuePop(&queue, &d);
+        if (d != ts->h[s])
+            continue;
+
+        for (i = in_begin[s]; i < in_begin[s + 1]; ++i){
+            if (d + in_cost[i] < ts->h[in_from[i]]){
+                ts->h[in_from[i]] = d + in_cost[i];
+                planPrioQueuePush(&queue, ts->h[in_from[i]], in_from[i]);
+            }
+        }
+    }
+    planPrioQueueFree(&queue);
+
+    BOR_FREE(in_begin);
+    BOR_FREE(in_from);
+    BOR_FREE(in_cost);
+}
+
+/** Maps states of the transition system to new_size abstract states */
+static void tsApplyMap(ms_ts_t *ts, ms_t *ms, const int *map, int new_size)
+{
+    ms_node_t *node = ms->node + ts->node;
+    ms_label_t *label;
+    char *goal;
+    int i, j, k;
+
+    goal = BOR_CALLOC_ARR(char, BOR_MAX(new_size, 1));
+    for (i = 0; i < ts->size; ++i){
+        if (map[i] >= 0 && ts->goal[i])
+            goal[map[i]] = 1;
+    }
+    BOR_FREE(ts->goal);
+    ts->goal = goal;
+
+    for (i = 0; i < ts->label_size; ++i){
+        label = ts->label + i;
+        for (j = 0, k = 0; j < label->tr_size; ++j){
+            if (map[label->tr[j].from] < 0 || map[label->tr[j].to] < 0)
+                continue;
+            label->tr[k].from = map[label->tr[j].from];
+            label->tr[k].to = map[label->tr[j].to];
+            ++k;
+        }
+        label->tr_size = k;
+        labelSortTr(label);
+    }
+
+    for (i = 0; i < node->table_size; ++i){
+        if (node->table[i] >= 0)
+            node->table[i] = map[node->table[i]];
+    }
+
+    ts->size = new_size;
+    if (ts->h){
+        BOR_FREE(ts->h);
+        ts->h = NULL;
+    }
+}
+
+/** Context for sorting of states by their signatures */
+struct _sig_ctx_t {
+    const int *block;
+    const int *begin; /*!< Beginning of signature of each state */
+    const int *sig;   /*!< Pairs (label, block) */
+};
+typedef struct _sig_ctx_t sig_ctx_t;
+
+static int sigPairCmp(const void *a, const void *b)
+{
+    const int *p1 = a, *p2 = b;
+    if (p1[0] != p2[0])
+        return p1[0] - p2[0];
+    return p1[1] - p2[1];
+}
+
+static int sigCmp(const void *a, const void *b, void *_ctx)
+{
+    const sig_ctx_t *ctx = _ctx;
+    int s1 = *(const int *)a, s2 = *(const int *)b;
+    int i1, i2, e1, e2, cmp;
+
+    if (ctx->block[s1] != ctx->block[s2])
+        return ctx->block[s1] - ctx->block[s2];
+
+    i1 = ctx->begin[s1];
+    e1 = ctx->begin[s1 + 1];
+    i2 = ctx->begin[s2];
+    e2 = ctx->begin[s2 + 1];
+    for (; i1 < e1 && i2 < e2; i1 += 2, i2 += 2){
+        if ((cmp = sigPairCmp(ctx->sig + i1, ctx->sig + i2)) != 0)
+            return cmp;
+    }
+    return (e1 - i1) - (e2 - i2);
+}
+
+static int hCmp(const void *a, const void *b, void *_ts)
+{
+    const ms_ts_t *ts = _ts;
+    int s1 = *(const int *)a, s2 = *(const int *)b;
+
+    if (ts->h[s1] != ts->h[s2])
+        return (ts->h[s1] < ts->h[s2] ? -1 : 1);
+    return ts->goal[s2] - ts->goal[s1];
+}
+
+/**
+ * Greedy bisimulation: states are distinguished by goal distances and
+ * by transitions on their optimal paths to goal. The refinement stops
+ * before the number of blocks would exceed max_size.
+ * Returns the number of blocks stored in block[] for live states.
+ */
+static int bisim(const ms_ts_t *ts, const ms_t *ms,
+                 const int *live, int live_size, int *block, int max_size)
+{
+    sig_ctx_t ctx;
+    const ms_label_t *label;
+    int *order, *out_begin, *out, *sig, *new_block;
+    int i, j, s, t, size, block_size, new_size, cost;
+
+    // Initial partition by goal distances, neighbouring distances are
+    // merged if there is too many of them
+    order = BOR_ALLOC_ARR(int, live_size);
+    memcpy(order, live, sizeof(int) * live_size);
+    qsort_r(order, live_size, sizeof(int), hCmp, (void *)ts);
+    for (size = 0, i = 0; i < live_size; ++i){
+        if (i > 0 && hCmp(order + i - 1, order + i, (void *)ts) != 0)
+            ++size;
+    }
+    ++size;
+    for (block_size = 0, i = 0; i < live_size; ++i){
+        if (i > 0 && hCmp(order + i - 1, order + i, (void *)ts) != 0)
+            ++block_size;
+        block[order[i]] = block_size;
+        if (size > max_size)
+            block[order[i]] = (long)block_size * max_size / size;
+    }
+    block_size = BOR_MIN(size, max_size);
+
+    // Transitions on optimal paths of each state
+    out_begin = BOR_CALLOC_ARR(int, ts->size + 1);
+    for (i = 0; i < ts->label_size; ++i){
+        label = ts->label + i;
+        cost = ms->cost[label->label];
+        for (j = 0; j < label->tr_size; ++j){
+            s = label->tr[j].from;
+            t = label->tr[j].to;
+            if (ts->h[s] != DIST_INF && ts->h[t] != DIST_INF
+                    && ts->h[s] == ts->h[t] + cost)
+                ++out_begin[s + 1];
+        }
+    }
+    for (i = 0; i < ts->size; ++i)
+        out_begin[i + 1] += out_begin[i];
+
+    out = BOR_ALLOC_ARR(int, 2 * BOR_MAX(out_begin[ts->size], 1));
+    sig = BOR_ALLOC_ARR(int, 2 * BOR_MAX(out_begin[ts->size], 1));
+    for (i = 0; i < ts->label_size; ++i){
+        label = ts->label + i;
+        cost = ms->cost[label->label];
+        for (j = 0; j < label->tr_size; ++j){
+            s = label->tr[j].from;
+            t = label->tr[j].to;
+            if (ts->h[s] != DIST_INF && ts->h[t] != DIST_INF
+                    && ts->h[s] == ts->h[t] + cost){
+                out[2 * out_begin[s]] = label->label;
+                out[2 * out_begin[s] + 1] = t;
+                ++out_begin[s];
+            }
+        }
+    }
+    for (i = ts->size; i > 0; --i)
+        out_begin[i] = out_begin[i - 1];
+    out_begin[0] = 0;
+    for (i = 0; i <= ts->size; ++i)
+        out_begin[i] *= 2;
+
+    new_block = BOR_ALLOC_ARR(int, ts->size);
+    ctx.block = block;
+    ctx.begin = out_begin;
+    ctx.sig = sig;
+    while (block_size < max_size){
+        // Signatures are sorted pairs (label, block of the target)
+        for (i = 0; i < live_size; ++i){
+            s = live[i];
+            for (j = out_begin[s]; j < out_begin[s + 1]; j += 2){
+                sig[j] = out[j];
+                sig[j + 1] = block[out[j + 1]];
+            }
+            qsort(sig + out_begin[s], (out_begin[s + 1] - out_begin[s]) / 2,
+                  2 * sizeof(int), sigPairCmp);
+        }
+
+        memcpy(order, live, sizeof(int) * live_size);
+        qsort_r(order, live_size, sizeof(int), sigCmp, &ctx);
+        for (new_size = 0, i = 0; i < live_size; ++i){
+            if (i > 0 && sigCmp(order + i - 1, order + i, &ctx) != 0)
+                ++new_size;
+            new_block[order[i]] = new_size;
+        }
+        ++new_size;
+
+        if (new_size > max_size || new_size == block_size)
+            break;
+
+        for (i = 0; i < live_size; ++i)
+            block[live[i]] = new_block[live[i]];
+        block_size = new_size;
+    }
+
+    BOR_FREE(order);
+    BOR_FREE(out_begin);
+    BOR_FREE(out);
+    BOR_FREE(sig);
+    BOR_FREE(new_block);
+    return block_size;
+}
+
+static void tsShrink(ms_ts_t *ts, ms_t *ms, int max_size)
+{
+    int *map, *live, live_size, size, i;
+
+    if (ts->h == NULL)
+        tsGoalDist(ts, ms);
+
+    map = BOR_ALLOC_ARR(int, BOR_MAX(ts->size, 1));
+    live = BOR_ALLOC_ARR(int, BOR_MAX(ts->size, 1));
+    for (live_size = 0, i = 0; i < ts->size; ++i){
+        map[i] = -1;
+        if (ts->h[i] != DIST_INF){
+            map[i] = live_size;
+            live[live_size++] = i;
+        }
+    }
+
+    if (live_size > max_size){
+        size = bisim(ts, ms, live, live_size, map, max_size);
+        tsApplyMap(ts, ms, map, size);
+
+    }else if (live_size < ts->size){
+        tsApplyMap(ts, ms, map, live_size);
+    }
+
+    BOR_FREE(map);
+    BOR_FREE(live);
+}
+
+static void tsMerge(ms_ts_t *dst, ms_t *ms, ms_ts_t *a, ms_ts_t *b,
+                    int node_id)
+{
+    ms_node_t *node = ms->node + node_id;
+    const ms_label_t *la, *lb;
+    ms_label_t *label;
+    int ia, ib, i, j, k, alloc;
+
+    node->var = -1;
+    node->left = a->node;
+    node->right = b->node;
+    node->right_size = b->size;
+    node->table_size = a->size * b->size;
+    node->table = BOR_ALLOC_ARR(int, BOR_MAX(node->table_size, 1));
+    for (i = 0; i < node->table_size; ++i)
+        node->table[i] = i;
+
+    dst->node = node_id;
+    dst->size = a->size * b->size;
+    dst->h = NULL;
+    dst->goal = BOR_ALLOC_ARR(char, BOR_MAX(dst->size, 1));
+    for (i = 0; i < a->size; ++i){
+        for (j = 0; j < b->size; ++j)
+            dst->goal[i * b->size + j] = a->goal[i] && b->goal[j];
+    }
+
+    dst->label = BOR_ALLOC_ARR(ms_label_t,
+                               BOR_MAX(a->label_size + b->label_size, 1));
+    dst->label_size = 0;
+    for (ia = 0, ib = 0; ia < a->label_size || ib < b->label_size;){
+        la = lb = NULL;
+        if (ib == b->label_size){
+            la = a->label + ia++;
+        }else if (ia == a->label_size){
+            lb = b->label + ib++;
+        }else if (a->label[ia].label < b->label[ib].label){
+            la = a->label + ia++;
+        }else if (a->label[ia].label > b->label[ib].label){
+            lb = b->label + ib++;
+        }else{
+            la = a->label + ia++;
+            lb = b->label + ib++;
+        }
+
+        label = dst->label + dst->label_size++;
+        label->label = (la ? la->label : lb->label);
+        label->exclusive = (ms->rel_count[label->label]
+                                == (la != NULL) + (lb != NULL));
+        label->tr = NULL;
+        label->tr_size = alloc = 0;
+
+        if (la && lb){
+            for (i = 0; i < la->tr_size; ++i){
+                for (j = 0; j < lb->tr_size; ++j){
+                    labelAddTr(label, &alloc,
+                               la->tr[i].from * b->size + lb->tr[j].from,
+                               la->tr[i].to * b->size + lb->tr[j].to);
+                }
+            }
+        }else if (la){
+            for (i = 0; i < la->tr_size; ++i){
+                for (k = 0; k < b->size; ++k){
+                    labelAddTr(label, &alloc,
+                               la->tr[i].from * b->size + k,
+                               la->tr[i].to * b->size + k);
+                }
+            }
+        }else{
+            for (k = 0; k < a->size; ++k){
+                for (j = 0; j < lb->tr_size; ++j){
+                    labelAddTr(label, &alloc,
+                               k * b->size + lb->tr[j].from,
+                               k * b->size + lb->tr[j].to);
+                }
+            }
+        }
+        labelSortTr(label);
+    }
+
+    tsFree(a);
+    tsFree(b);
+}
+
+static int labelTrCmp(const void *a, const void *b, void *_ts)
+{
+    const ms_ts_t *ts = _ts;
+    const ms_label_t *l1 = ts->label + *(const int *)a;
+    const ms_label_t *l2 = ts->label + *(const int *)b;
+    int i, cmp;
+
+    if (l1->tr_size != l2->tr_size)
+        return l1->tr_size - l2->tr_size;
+    for (i = 0; i < l1->tr_size; ++i){
+        if ((cmp = trCmp(l1->tr + i, l2->tr + i)) != 0)
+            return cmp;
+    }
+    return 0;
+}
+
+static void tsReduceLabels(ms_ts_t *ts, ms_t *ms)
+{
+    ms_label_t *label;
+    int *excl, excl_size, *removed, rep, i, j;
+
+    excl = BOR_ALLOC_ARR(int, BOR_MAX(ts->label_size, 1));
+    removed = BOR_CALLOC_ARR(int, BOR_MAX(ts->label_size, 1));
+    for (excl_size = 0, i = 0; i < ts->label_size; ++i){
+        if (ts->label[i].exclusive)
+            excl[excl_size++] = i;
+    }
+
+    // Labels that do not appear anywhere else and have the same
+    // transitions are replaced by one label with the minimal cost
+    qsort_r(excl, excl_size, sizeof(int), labelTrCmp, ts);
+    for (i = 0; i < excl_size; i = j){
+        rep = excl[i];
+        for (j = i + 1; j < excl_size
+                && labelTrCmp(excl + i, excl + j, ts) == 0; ++j){
+            label = ts->label + excl[j];
+            ms->cost[ts->label[rep].label]
+                = BOR_MIN(ms->cost[ts->label[rep].label],
+                          ms->cost[label->label]);
+            removed[excl[j]] = 1;
+        }
+    }
+
+    for (i = 0, j = 0; i < ts->label_size; ++i){
+        if (removed[i]){
+            if (ts->label[i].tr)
+                BOR_FREE(ts->label[i].tr);
+        }else{
+            ts->label[j++] = ts->label[i];
+        }
+    }
+    ts->label_size = j;
+
+    BOR_FREE(excl);
+    BOR_FREE(removed);
+}
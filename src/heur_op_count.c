@@ -0,0 +1,792 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2015 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <math.h>
+#include <boruvka/alloc.h>
+#include <plan/config.h>
+#include <plan/heur.h>
+#include <plan/search.h>
+
+#include "plan/lp.h"
+#include "fact_id.h"
+#include "heur_common.h"
+
+#ifdef PLAN_LP
+
+#define ROUND_EPS 1E-6
+
+/** Number of slots in the cache of LP bases */
+#define BASIS_CACHE_SIZE 1024
+
+/** Distance of unreachable values in projections */
+#define DIST_INF INT_MAX
+
+typedef struct _plan_heur_op_count_t plan_heur_op_count_t;
+
+/**
+ * Generator of constraints over the operator-counting variables.
+ * Each generator owns a contiguous block of rows of the LP starting at
+ * .row_begin. The block of the last generator can grow.
+ */
+typedef struct _constr_gen_t constr_gen_t;
+struct _constr_gen_t {
+    /** Sets coefficients of the generator's rows */
+    void (*init)(constr_gen_t *gen, plan_lp_t *lp);
+    /** Updates the rows for the given state. Returns -1 if the state was
+     *  recognized as a dead-end, 0 otherwise. */
+    int (*set_state)(constr_gen_t *gen, plan_lp_t *lp,
+                     const plan_state_t *state);
+    /** Frees the generator */
+    void (*del)(constr_gen_t *gen);
+
+    int row_begin; /*!< First row of the generator */
+    int row_size;  /*!< Number of rows of the generator */
+};
+
+/**
+ * Optimal LP basis of an evaluated state
+ */
+struct _basis_t {
+    plan_state_id_t state_id; /*!< ID of the state or PLAN_NO_STATE */
+    int size;                 /*!< Number of elements in .basis */
+    int *basis;
+};
+typedef struct _basis_t basis_t;
+
+/**
+ * Main structure for operator-counting heuristic
+ */
+struct _plan_heur_op_count_t {
+    plan_heur_t heur;
+    int use_ilp;          /*!< True if ILP instead of LP should be used */
+    plan_lp_t *lp;        /*!< (I)LP with one column per operator */
+    constr_gen_t **gen;   /*!< Constraint generators */
+    int gen_size;
+    basis_t *basis;       /*!< Direct-mapped cache of optimal bases
+                               indexed by state ID */
+};
+#define HEUR(parent) \
+    bor_container_of((parent), plan_heur_op_count_t, heur)
+
+static void heurOpCountDel(plan_heur_t *_heur);
+static void heurOpCount(plan_heur_t *_heur, const plan_state_t *state,
+                        plan_heur_res_t *res);
+static void heurOpCountNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                            plan_search_t *search, plan_heur_res_t *res);
+/** Computes heuristic value for the state, see flowCompute() in
+ *  heur_flow.c for the meaning of state IDs. */
+static void opCountCompute(plan_heur_op_count_t *h, const plan_state_t *state,
+                           plan_state_id_t parent_state_id,
+                           plan_state_id_t state_id,
+                           plan_heur_res_t *res);
+
+/** Creates the generator of net change constraints */
+static constr_gen_t *seqNew(const plan_var_t *var, int var_size,
+                            const plan_part_state_t *goal,
+                            const plan_op_t *op, int op_size);
+/** Creates the generator of LM-Cut landmark constraints */
+static constr_gen_t *lmCutNew(const plan_var_t *var, int var_size,
+                              const plan_part_state_t *goal,
+                              const plan_op_t *op, int op_size,
+                              unsigned flags);
+/** Creates the generator of post-hoc optimization constraints */
+static constr_gen_t *phoNew(const plan_var_t *var, int var_size,
+                            const plan_part_state_t *goal,
+                            const plan_op_t *op, int op_size,
+                            unsigned flags);
+
+static void addGen(plan_heur_op_count_t *h, constr_gen_t *gen)
+{
+    ++h->gen_size;
+    h->gen = BOR_REALLOC_ARR(h->gen, constr_gen_t *, h->gen_size);
+    h->gen[h->gen_size - 1] = gen;
+}
+
+plan_heur_t *planHeurOpCountNew(const plan_var_t *var, int var_size,
+                                const plan_part_state_t *goal,
+                                const plan_op_t *op, int op_size,
+                                unsigned flags)
+{
+    plan_heur_op_count_t *h;
+    unsigned gen_flags, lp_flags = 0;
+    int i, rows;
+
+    h = BOR_ALLOC(plan_heur_op_count_t);
+    _planHeurInit(&h->heur, heurOpCountDel, heurOpCount, heurOpCountNode);
+    h->use_ilp = (flags & PLAN_HEUR_OP_COUNT_ILP);
+
+    gen_flags = flags & (PLAN_HEUR_OP_COUNT_SEQ
+                            | PLAN_HEUR_OP_COUNT_LM_CUT
+                            | PLAN_HEUR_OP_COUNT_PHO);
+    if (gen_flags == 0)
+        gen_flags = PLAN_HEUR_OP_COUNT_SEQ;
+
+    // Generators with fixed number of rows go first, the landmark
+    // generator must be the last one because its block of rows grows.
+    h->gen = NULL;
+    h->gen_size = 0;
+    if (gen_flags & PLAN_HEUR_OP_COUNT_SEQ)
+        addGen(h, seqNew(var, var_size, goal, op, op_size));
+    if (gen_flags & PLAN_HEUR_OP_COUNT_PHO)
+        addGen(h, phoNew(var, var_size, goal, op, op_size, flags));
+    if (gen_flags & PLAN_HEUR_OP_COUNT_LM_CUT)
+        addGen(h, lmCutNew(var, var_size, goal, op, op_size, flags));
+
+    for (rows = 0, i = 0; i < h->gen_size; ++i){
+        h->gen[i]->row_begin = rows;
+        rows += h->gen[i]->row_size;
+    }
+
+    // One column per operator with its cost as objective coefficient
+    lp_flags |= (flags & (0x3fu << 8u));
+    h->lp = planLPNew(rows, op_size, lp_flags);
+    for (i = 0; i < op_size; ++i){
+        if (h->use_ilp)
+            planLPSetVarInt(h->lp, i);
+        planLPSetObj(h->lp, i, planHeurOpCost(op[i].cost, flags));
+    }
+
+    for (i = 0; i < h->gen_size; ++i)
+        h->gen[i]->init(h->gen[i], h->lp);
+
+    h->basis = NULL;
+    if (!h->use_ilp){
+        h->basis = BOR_CALLOC_ARR(basis_t, BASIS_CACHE_SIZE);
+        for (i = 0; i < BASIS_CACHE_SIZE; ++i)
+            h->basis[i].state_id = PLAN_NO_STATE;
+    }
+
+    return &h->heur;
+}
+
+static void heurOpCountDel(plan_heur_t *_heur)
+{
+    plan_heur_op_count_t *h = HEUR(_heur);
+    int i;
+
+    for (i = 0; i < h->gen_size; ++i)
+        h->gen[i]->del(h->gen[i]);
+    if (h->gen)
+        BOR_FREE(h->gen);
+    planLPDel(h->lp);
+
+    for (i = 0; h->basis && i < BASIS_CACHE_SIZE; ++i){
+        if (h->basis[i].basis)
+            BOR_FREE(h->basis[i].basis);
+    }
+    if (h->basis)
+        BOR_FREE(h->basis);
+
+    _planHeurFree(&h->heur);
+    BOR_FREE(h);
+}
+
+static void heurOpCount(plan_heur_t *_heur, const plan_state_t *state,
+                        plan_heur_res_t *res)
+{
+    plan_heur_op_count_t *h = HEUR(_heur);
+    opCountCompute(h, state, PLAN_NO_STATE, PLAN_NO_STATE, res);
+}
+
+static void heurOpCountNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                            plan_search_t *search, plan_heur_res_t *res)
+{
+    plan_heur_op_count_t *h = HEUR(_heur);
+    const plan_state_space_node_t *node;
+
+    node = planSearchLoadNode(search, state_id);
+    opCountCompute(h, planSearchLoadState(search, state_id),
+                   node->parent_state_id, state_id, res);
+}
+
+static void basisStore(plan_heur_op_count_t *h, plan_state_id_t state_id)
+{
+    basis_t *b = h->basis + (state_id % BASIS_CACHE_SIZE);
+    int size;
+
+    size = planLPBasisSize(h->lp);
+    if (b->size != size){
+        b->basis = BOR_REALLOC_ARR(b->basis, int, size);
+        b->size = size;
+    }
+
+    b->state_id = state_id;
+    if (planLPGetBasis(h->lp, b->basis) != 0)
+        b->state_id = PLAN_NO_STATE;
+}
+
+static void basisRestore(plan_heur_op_count_t *h, plan_state_id_t state_id)
+{
+    const basis_t *b = h->basis + (state_id % BASIS_CACHE_SIZE);
+
+    // The basis is usable only if no rows were added since it was stored
+    if (b->state_id == state_id && b->size == planLPBasisSize(h->lp))
+        planLPSetBasis(h->lp, b->basis);
+}
+
+static plan_cost_t roundOff(double z)
+{
+    plan_cost_t v = z;
+    if (fabs(z - (double)v) > ROUND_EPS)
+        return ceil(z);
+    return v;
+}
+
+static void opCountCompute(plan_heur_op_count_t *h, const plan_state_t *state,
+                           plan_state_id_t parent_state_id,
+                           plan_state_id_t state_id,
+                           plan_heur_res_t *res)
+{
+    double z;
+    int i, status;
+
+    for (i = 0; i < h->gen_size; ++i){
+        if (h->gen[i]->set_state(h->gen[i], h->lp, state) != 0){
+            res->heur = PLAN_HEUR_DEAD_END;
+            return;
+        }
+    }
+
+    if (h->use_ilp){
+        z = planLPSolveILPObjVal(h->lp);
+    }else{
+        // All generators change only right hand sides and coefficients
+        // of a few rows, so the parent's optimal basis is usually close
+        // to the optimal one.
+        if (parent_state_id >= 0)
+            basisRestore(h, parent_state_id);
+        z = planLPSolveDualObjVal(h->lp);
+    }
+
+    status = planLPStatus(h->lp);
+    if (status == PLAN_LP_OPTIMAL){
+        if (!h->use_ilp && state_id >= 0)
+            basisStore(h, state_id);
+        res->heur = roundOff(z);
+
+    }else if (status == PLAN_LP_INFEASIBLE){
+        res->heur = PLAN_HEUR_DEAD_END;
+
+    }else{
+        // The solver gave up (or reported an unbounded problem which
+        // cannot happen for an admissible model), so nothing is known
+        // about the state: fall back to the trivial estimate and keep no
+        // basis of it.
+        res->heur = 0;
+    }
+}
+
+
+
+/**
+ * Net change constraints:
+ * For each fact f, the number of times f is produced minus the number of
+ * times it is consumed must be at least [f in goal] - [f in state].
+ * Operators that can produce f without consuming it (no precondition on
+ * its variable or conditional effects) are counted as producers, which
+ * keeps the constraints admissible.
+ */
+struct _gen_seq_t {
+    constr_gen_t gen;
+    plan_fact_id_t fact_id;
+    int *is_goal;        /*!< True for goal facts */
+    const plan_op_t *op; /*!< Operators, valid only until init() */
+    int op_size;
+    int *state_fact;     /*!< Facts of the last state, or -1 */
+};
+typedef struct _gen_seq_t gen_seq_t;
+#define GEN_SEQ(g) bor_container_of((g), gen_seq_t, gen)
+
+static void seqSetCoef(gen_seq_t *g, plan_lp_t *lp,
+                       plan_var_id_t var, plan_val_t val,
+                       int op_id, double coef)
+{
+    int fid = planFactId(&g->fact_id, var, val);
+    if (fid >= 0)
+        planLPSetCoef(lp, g->gen.row_begin + fid, op_id, coef);
+}
+
+static void seqInitOp(gen_seq_t *g, plan_lp_t *lp,
+                      const plan_op_t *op, int op_id)
+{
+    const plan_part_state_t *eff;
+    plan_var_id_t var;
+    plan_val_t val, pre_val;
+    int i, j;
+
+    // Conditional effects can only produce facts
+    for (j = 0; j < op->cond_eff_size; ++j){
+        eff = op->cond_eff[j].eff;
+        PLAN_PART_STATE_FOR_EACH(eff, i, var, val){
+            if (planPartStateGet(op->pre, var) != val)
+                seqSetCoef(g, lp, var, val, op_id, 1.);
+        }
+    }
+
+    PLAN_PART_STATE_FOR_EACH(op->eff, i, var, val){
+        pre_val = planPartStateGet(op->pre, var);
+        if (pre_val == val)
+            continue;
+
+        seqSetCoef(g, lp, var, val, op_id, 1.);
+        if (pre_val != PLAN_VAL_UNDEFINED)
+            seqSetCoef(g, lp, var, pre_val, op_id, -1.);
+    }
+}
+
+static void seqInit(constr_gen_t *_g, plan_lp_t *lp)
+{
+    gen_seq_t *g = GEN_SEQ(_g);
+    int i;
+
+    for (i = 0; i < g->op_size; ++i)
+        seqInitOp(g, lp, g->op + i, i);
+    for (i = 0; i < g->fact_id.fact_size; ++i)
+        planLPSetRHS(lp, g->gen.row_begin + i, g->is_goal[i], 'G');
+    g->op = NULL;
+}
+
+static int seqSetState(constr_gen_t *_g, plan_lp_t *lp,
+                       const plan_state_t *state)
+{
+    gen_seq_t *g = GEN_SEQ(_g);
+    int var, fid;
+
+    // Only rows of facts of the previous and the new state change
+    for (var = 0; var < g->fact_id.var_size; ++var){
+        fid = planFactId(&g->fact_id, var, planStateGet(state, var));
+        if (fid == g->state_fact[var])
+            continue;
+
+        if (g->state_fact[var] >= 0){
+            planLPSetRHS(lp, g->gen.row_begin + g->state_fact[var],
+                         g->is_goal[g->state_fact[var]], 'G');
+        }
+        if (fid >= 0){
+            planLPSetRHS(lp, g->gen.row_begin + fid,
+                         g->is_goal[fid] - 1, 'G');
+        }
+        g->state_fact[var] = fid;
+    }
+
+    return 0;
+}
+
+static void seqDel(constr_gen_t *_g)
+{
+    gen_seq_t *g = GEN_SEQ(_g);
+
+    BOR_FREE(g->is_goal);
+    BOR_FREE(g->state_fact);
+    planFactIdFree(&g->fact_id);
+    BOR_FREE(g);
+}
+
+static constr_gen_t *seqNew(const plan_var_t *var, int var_size,
+                            const plan_part_state_t *goal,
+                            const plan_op_t *op, int op_size)
+{
+    gen_seq_t *g;
+    plan_var_id_t gvar;
+    plan_val_t gval;
+    int i, fid;
+
+    g = BOR_ALLOC(gen_seq_t);
+    g->gen.init = seqInit;
+    g->gen.set_state = seqSetState;
+    g->gen.del = seqDel;
+
+    planFactIdInit(&g->fact_id, var, var_size);
+    g->gen.row_size = g->fact_id.fact_size;
+    g->op_size = op_size;
+
+    g->is_goal = BOR_CALLOC_ARR(int, g->fact_id.fact_size);
+    PLAN_PART_STATE_FOR_EACH(goal, i, gvar, gval){
+        fid = planFactId(&g->fact_id, gvar, gval);
+        if (fid >= 0)
+            g->is_goal[fid] = 1;
+    }
+
+    g->op = op;
+
+    g->state_fact = BOR_ALLOC_ARR(int, var_size);
+    for (i = 0; i < var_size; ++i)
+        g->state_fact[i] = -1;
+
+    return &g->gen;
+}
+
+
+
+/**
+ * Landmark constraints:
+ * For each disjunctive action landmark L found by LM-Cut, at least one
+ * operator from L must be used. The rows are only rewritten instead of
+ * being added and deleted (see lpSetLandmarks() in heur_flow.c) so the
+ * basis can be reused whenever the number of landmarks does not grow.
+ */
+struct _gen_lm_cut_t {
+    constr_gen_t gen;
+    plan_heur_t *lm_cut;
+    plan_landmark_t *row_ldm; /*!< Landmark currently set in each row */
+};
+typedef struct _gen_lm_cut_t gen_lm_cut_t;
+#define GEN_LM_CUT(g) bor_container_of((g), gen_lm_cut_t, gen)
+
+static void lmCutInit(constr_gen_t *_g, plan_lp_t *lp)
+{
+}
+
+static void lmCutSetLandmarks(gen_lm_cut_t *g, plan_lp_t *lp,
+                              const plan_landmark_set_t *ldms)
+{
+    const plan_landmark_t *ldm;
+    plan_landmark_t *row_ldm;
+    int i, j, row, size = ldms->size;
+
+    // Grow the pool if needed, new rows are empty: 0 >= 0
+    if (size > g->gen.row_size){
+        planLPAddRows(lp, size - g->gen.row_size, NULL, NULL);
+        g->row_ldm = BOR_REALLOC_ARR(g->row_ldm, plan_landmark_t, size);
+        for (i = g->gen.row_size; i < size; ++i){
+            bzero(g->row_ldm + i, sizeof(plan_landmark_t));
+            planLPSetRHS(lp, g->gen.row_begin + i, 0., 'G');
+        }
+        g->gen.row_size = size;
+    }
+
+    for (i = 0; i < g->gen.row_size; ++i){
+        row = g->gen.row_begin + i;
+        row_ldm = g->row_ldm + i;
+        if (i >= size && row_ldm->size == 0)
+            continue;
+
+        for (j = 0; j < row_ldm->size; ++j)
+            planLPSetCoef(lp, row, row_ldm->op_id[j], 0.);
+        planLandmarkFree(row_ldm);
+
+        if (i < size){
+            ldm = ldms->landmark + i;
+            planLandmarkInit(row_ldm, ldm->size, ldm->op_id);
+            for (j = 0; j < ldm->size; ++j)
+                planLPSetCoef(lp, row, ldm->op_id[j], 1.);
+            planLPSetRHS(lp, row, 1., 'G');
+        }else{
+            planLPSetRHS(lp, row, 0., 'G');
+        }
+    }
+}
+
+static int lmCutSetState(constr_gen_t *_g, plan_lp_t *lp,
+                         const plan_state_t *state)
+{
+    gen_lm_cut_t *g = GEN_LM_CUT(_g);
+    plan_heur_res_t res;
+
+    planHeurResInit(&res);
+    res.save_landmarks = 1;
+    planHeurState(g->lm_cut, state, &res);
+    if (res.heur == PLAN_HEUR_DEAD_END){
+        planLandmarkSetFree(&res.landmarks);
+        return -1;
+    }
+
+    lmCutSetLandmarks(g, lp, &res.landmarks);
+    planLandmarkSetFree(&res.landmarks);
+    return 0;
+}
+
+static void lmCutDel(constr_gen_t *_g)
+{
+    gen_lm_cut_t *g = GEN_LM_CUT(_g);
+    int i;
+
+    for (i = 0; i < g->gen.row_size; ++i)
+        planLandmarkFree(g->row_ldm + i);
+    if (g->row_ldm)
+        BOR_FREE(g->row_ldm);
+    planHeurDel(g->lm_cut);
+    BOR_FREE(g);
+}
+
+static constr_gen_t *lmCutNew(const plan_var_t *var, int var_size,
+                              const plan_part_state_t *goal,
+                              const plan_op_t *op, int op_size,
+                              unsigned flags)
+{
+    gen_lm_cut_t *g;
+
+    g = BOR_ALLOC(gen_lm_cut_t);
+    g->gen.init = lmCutInit;
+    g->gen.set_state = lmCutSetState;
+    g->gen.del = lmCutDel;
+    g->gen.row_size = 0;
+    g->row_ldm = NULL;
+
+    flags &= (PLAN_HEUR_OP_UNIT_COST | PLAN_HEUR_OP_COST_PLUS_ONE);
+    g->lm_cut = planHeurLMCutNew(var, var_size, goal, op, op_size, flags);
+    return &g->gen;
+}
+
+
+
+/**
+ * Post-hoc optimization constraints:
+ * For each goal variable V, the cost of operators affecting V must be at
+ * least the goal distance of the state in the atomic projection to V.
+ * The goal distances are precomputed for all values of V.
+ */
+struct _gen_pho_t {
+    constr_gen_t gen;
+    int *var;         /*!< Goal variable of each row */
+    int **dist;       /*!< Goal distance of each value of each row's var */
+    int **affect;     /*!< Operators affecting the variable of each row */
+    int *affect_size;
+    int *op_cost;     /*!< Cost of each operator */
+};
+typedef struct _gen_pho_t gen_pho_t;
+#define GEN_PHO(g) bor_container_of((g), gen_pho_t, gen)
+
+static void phoInit(constr_gen_t *_g, plan_lp_t *lp)
+{
+    gen_pho_t *g = GEN_PHO(_g);
+    int r, i, op_id;
+
+    for (r = 0; r < g->gen.row_size; ++r){
+        for (i = 0; i < g->affect_size[r]; ++i){
+            op_id = g->affect[r][i];
+            if (g->op_cost[op_id] != 0){
+                planLPSetCoef(lp, g->gen.row_begin + r, op_id,
+                              g->op_cost[op_id]);
+            }
+        }
+        planLPSetRHS(lp, g->gen.row_begin + r, 0., 'G');
+    }
+}
+
+static int phoSetState(constr_gen_t *_g, plan_lp_t *lp,
+                       const plan_state_t *state)
+{
+    gen_pho_t *g = GEN_PHO(_g);
+    int r, d;
+
+    for (r = 0; r < g->gen.row_size; ++r){
+        d = g->dist[r][planStateGet(state, g->var[r])];
+        if (d == DIST_INF)
+            return -1;
+        planLPSetRHS(lp, g->gen.row_begin + r, d, 'G');
+    }
+    return 0;
+}
+
+static void phoDel(constr_gen_t *_g)
+{
+    gen_pho_t *g = GEN_PHO(_g);
+    int r;
+
+    for (r = 0; r < g->gen.row_size; ++r){
+        BOR_FREE(g->dist[r]);
+        if (g->affect[r])
+            BOR_FREE(g->affect[r]);
+    }
+    if (g->var)
+        BOR_FREE(g->var);
+    if (g->dist)
+        BOR_FREE(g->dist);
+    if (g->affect)
+        BOR_FREE(g->affect);
+    if (g->affect_size)
+        BOR_FREE(g->affect_size);
+    BOR_FREE(g->op_cost);
+    BOR_FREE(g);
+}
+
+/** Transition in an atomic projection */
+struct _pho_tr_t {
+    int from; /*!< Source value or -1 for any value */
+    int to;   /*!< Target value */
+    int cost;
+};
+typedef struct _pho_tr_t pho_tr_t;
+
+static void phoAddTr(pho_tr_t **tr, int *tr_size, int *tr_alloc,
+                     int from, int to, int cost)
+{
+    if (from == to)
+        return;
+
+    if (*tr_size == *tr_alloc){
+        *tr_alloc = BOR_MAX(16, 2 * *tr_alloc);
+        *tr = BOR_REALLOC_ARR(*tr, pho_tr_t, *tr_alloc);
+    }
+    (*tr)[*tr_size].from = from;
+    (*tr)[*tr_size].to = to;
+    (*tr)[*tr_size].cost = cost;
+    ++(*tr_size);
+}
+
+/** Computes goal distances in the projection given by the transitions
+ *  using backward Dijkstra from the goal value. */
+static void phoDist(int *dist, int range, plan_val_t goal_val,
+                    const pho_tr_t *tr, int tr_size)
+{
+    int *closed, i, j, val, min, d;
+
+    closed = BOR_CALLOC_ARR(int, range);
+    for (i = 0; i < range; ++i)
+        dist[i] = DIST_INF;
+    dist[goal_val] = 0;
+
+    while (1){
+        val = -1;
+        min = DIST_INF;
+        for (i = 0; i < range; ++i){
+            if (!closed[i] && dist[i] < min){
+                val = i;
+                min = dist[i];
+            }
+        }
+        if (val < 0)
+            break;
+        closed[val] = 1;
+
+        for (i = 0; i < tr_size; ++i){
+            if (tr[i].to != val)
+                continue;
+            d = min + tr[i].cost;
+            if (tr[i].from >= 0){
+                if (d < dist[tr[i].from])
+                    dist[tr[i].from] = d;
+            }else{
+                for (j = 0; j < range; ++j){
+                    if (j != val && d < dist[j])
+                        dist[j] = d;
+                }
+            }
+        }
+    }
+
+    BOR_FREE(closed);
+}
+
+static void phoInitVar(gen_pho_t *g, int row, const plan_var_t *var,
+                       plan_var_id_t v, plan_val_t goal_val,
+                       const plan_op_t *op, int op_size)
+{
+    pho_tr_t *tr = NULL;
+    int tr_size = 0, tr_alloc = 0;
+    const plan_op_cond_eff_t *ce;
+    plan_val_t val, pre_val;
+    int i, j, affects;
+
+    g->var[row] = v;
+    g->affect[row] = NULL;
+    g->affect_size[row] = 0;
+
+    for (i = 0; i < op_size; ++i){
+        affects = 0;
+        pre_val = planPartStateGet(op[i].pre, v);
+
+        val = planPartStateGet(op[i].eff, v);
+        if (val != PLAN_VAL_UNDEFINED){
+            phoAddTr(&tr, &tr_size, &tr_alloc, pre_val, val, g->op_cost[i]);
+            affects = 1;
+        }
+
+        for (j = 0; j < op[i].cond_eff_size; ++j){
+            ce = op[i].cond_eff + j;
+            val = planPartStateGet(ce->eff, v);
+            if (val == PLAN_VAL_UNDEFINED)
+                continue;
+
+            if (planPartStateIsSet(ce->pre, v)){
+                phoAddTr(&tr, &tr_size, &tr_alloc,
+                         planPartStateGet(ce->pre, v), val, g->op_cost[i]);
+            }else{
+                phoAddTr(&tr, &tr_size, &tr_alloc,
+                         pre_val, val, g->op_cost[i]);
+            }
+            affects = 1;
+        }
+
+        if (affects){
+            ++g->affect_size[row];
+            g->affect[row] = BOR_REALLOC_ARR(g->affect[row], int,
+                                             g->affect_size[row]);
+            g->affect[row][g->affect_size[row] - 1] = i;
+        }
+    }
+
+    g->dist[row] = BOR_ALLOC_ARR(int, var[v].range);
+    phoDist(g->dist[row], var[v].range, goal_val, tr, tr_size);
+
+    if (tr)
+        BOR_FREE(tr);
+}
+
+static constr_gen_t *phoNew(const plan_var_t *var, int var_size,
+                            const plan_part_state_t *goal,
+                            const plan_op_t *op, int op_size,
+                            unsigned flags)
+{
+    gen_pho_t *g;
+    plan_var_id_t v;
+    plan_val_t val;
+    int i;
+
+    g = BOR_ALLOC(gen_pho_t);
+    g->gen.init = phoInit;
+    g->gen.set_state = phoSetState;
+    g->gen.del = phoDel;
+
+    g->op_cost = BOR_ALLOC_ARR(int, op_size);
+    for (i = 0; i < op_size; ++i)
+        g->op_cost[i] = planHeurOpCost(op[i].cost, flags);
+
+    g->gen.row_size = goal->vals_size;
+    g->var = g->affect_size = NULL;
+    g->dist = g->affect = NULL;
+    if (g->gen.row_size > 0){
+        g->var = BOR_ALLOC_ARR(int, g->gen.row_size);
+        g->dist = BOR_ALLOC_ARR(int *, g->gen.row_size);
+        g->affect = BOR_ALLOC_ARR(int *, g->gen.row_size);
+        g->affect_size = BOR_ALLOC_ARR(int, g->gen.row_size);
+    }
+
+    PLAN_PART_STATE_FOR_EACH(goal, i, v, val){
+        phoInitVar(g, i, var, v, val, op, op_size);
+    }
+
+    return &g->gen;
+}
+
+#else /* PLAN_LP */
+
+plan_heur_t *planHeurOpCountNew(const plan_var_t *var, int var_size,
+                                const plan_part_state_t *goal,
+                                const plan_op_t *op, int op_size,
+                                unsigned flags)
+{
+    fprintf(stderr, "Error: Cannot create Operator-counting heuristic"
+                    " object because no LP-solver was available during"
+                    " compilation!\n");
+    fflush(stderr);
+    return NULL;
+}
+#endif /* PLAN_LP */
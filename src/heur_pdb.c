@@ -0,0 +1,794 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <boruvka/alloc.h>
+#include <plan/heur.h>
+#include <plan/causal_graph.h>
+#include <plan/prio_queue.h>
+
+#include "heur_common.h"
+
+/** Distance of unreachable abstract states during the search */
+#define DIST_INF INT_MAX
+
+/** Maximal number of abstract states of one pattern */
+#define MAX_PATTERN_STATES (1 << 24)
+
+/** Values representing unreachable states in compact tables */
+#define TABLE8_INF UINT8_MAX
+#define TABLE16_INF UINT16_MAX
+
+/**
+ * Operator projected to a pattern. Variables are stored as indexes
+ * within the pattern.
+ */
+struct _pdb_op_t {
+    int *pre_var;   /*!< Preconditions on variables not in effect */
+    int *pre_val;
+    int pre_size;
+    int *eff_var;   /*!< Effects */
+    int *eff_val;
+    int *eff_pre;   /*!< Precondition of effect or -1 if there is none */
+    int eff_size;
+    int cost;
+};
+typedef struct _pdb_op_t pdb_op_t;
+
+/**
+ * Pattern database.
+ * Abstract state is mapped to the index in .table using perfect hash
+ * function rank(s) = sum_i s[var[i]] * mult[i].
+ */
+struct _pdb_t {
+    int *var;        /*!< Variables of the pattern (sorted) */
+    int *mult;       /*!< Multiplicators of the ranking function */
+    int var_size;
+    int size;        /*!< Number of abstract states */
+    int *relevant_op;     /*!< Sorted IDs of operators affecting pattern */
+    int relevant_op_size;
+
+    int width;       /*!< Number of bytes per element of the table */
+    void *table;     /*!< Goal distances of the abstract states */
+};
+typedef struct _pdb_t pdb_t;
+
+/**
+ * Main structure for PDB heuristic
+ */
+struct _plan_heur_pdb_t {
+    plan_heur_t heur;
+    pdb_t *pdb;       /*!< Pattern databases */
+    int pdb_size;
+    int **clique;     /*!< Maximal subsets of additive pattern databases */
+    int *clique_size;
+    int clique_num;
+    int *value;       /*!< Pre-allocated array for values of pdbs */
+};
+typedef struct _plan_heur_pdb_t plan_heur_pdb_t;
+#define HEUR(parent) \
+    bor_container_of((parent), plan_heur_pdb_t, heur)
+
+static void heurPDBDel(plan_heur_t *_heur);
+static void heurPDB(plan_heur_t *_heur, const plan_state_t *state,
+                    plan_heur_res_t *res);
+
+/** Returns list of variables that cannot be part of any pattern */
+static int *excludedVars(const plan_var_t *var, int var_size,
+                         const plan_op_t *op, int op_size);
+/** Selects pattern growing from the goal variable along the causal
+ *  graph. Returns the number of variables in the pattern. */
+static int selectPattern(int *pattern, plan_var_id_t goal_var,
+                         const plan_var_t *var, int var_size,
+                         const plan_causal_graph_t *cg,
+                         const int *excluded, long max_states);
+/** Computes pattern database for the given pattern */
+static void pdbInit(pdb_t *pdb, const int *pattern, int pattern_size,
+                    const plan_var_t *var, int var_size,
+                    const plan_part_state_t *goal,
+                    const plan_op_t *op, int op_size, unsigned flags,
+                    long max_bytes);
+static void pdbFree(pdb_t *pdb);
+/** Returns goal distance of the state or DIST_INF */
+static int pdbValue(const pdb_t *pdb, const plan_state_t *state);
+/** Finds all maximal subsets of additive pattern databases */
+static void additiveCliques(plan_heur_pdb_t *h);
+
+static int samePattern(const pdb_t *pdb, const int *pattern, int size)
+{
+    int i;
+
+    if (pdb->var_size != size)
+        return 0;
+    for (i = 0; i < size; ++i){
+        if (pdb->var[i] != pattern[i])
+            return 0;
+    }
+    return 1;
+}
+
+plan_heur_t *planHeurPDBNew(const plan_var_t *var, int var_size,
+                            const plan_part_state_t *goal,
+                            const plan_op_t *op, int op_size,
+                            unsigned flags, long max_mem)
+{
+    plan_heur_pdb_t *h;
+    plan_causal_graph_t *cg;
+    int *excluded, *pattern, pattern_size;
+    long max_states, used, share;
+    plan_var_id_t v;
+    int i, j, dup;
+
+    if (max_mem <= 0)
+        max_mem = PLAN_HEUR_PDB_MAX_MEM;
+
+    h = BOR_ALLOC(plan_heur_pdb_t);
+    _planHeurInit(&h->heur, heurPDBDel, heurPDB, NULL);
+    h->pdb = BOR_ALLOC_ARR(pdb_t, BOR_MAX(goal->vals_size, 1));
+    h->pdb_size = 0;
+
+    cg = planCausalGraphNew(var_size, op, op_size, goal);
+    excluded = excludedVars(var, var_size, op, op_size);
+    pattern = BOR_ALLOC_ARR(int, var_size);
+
+    used = 0;
+    PLAN_PART_STATE_FOR_EACH_VAR(goal, i, v){
+        if (excluded[v])
+            continue;
+
+        // Each remaining goal variable gets its share of the memory left.
+        // A table takes at most two bytes per abstract state unless the
+        // share allows more (see pdbCompress()), and the distances are
+        // computed in a transient array of ints that exists together with
+        // the table for a while.
+        share = (max_mem - used) / (goal->vals_size - i);
+        max_states = share / 2;
+        max_states = BOR_MIN(max_states,
+                             (max_mem - used) / (long)(sizeof(int) + 2));
+        max_states = BOR_MIN(max_states, MAX_PATTERN_STATES);
+        if (max_states <= 0)
+            break;
+
+        pattern_size = selectPattern(pattern, v, var, var_size, cg,
+                                     excluded, max_states);
+        if (pattern_size == 0)
+            continue;
+
+        for (dup = 0, j = 0; j < h->pdb_size && !dup; ++j)
+            dup = samePattern(h->pdb + j, pattern, pattern_size);
+        if (dup)
+            continue;
+
+        pdbInit(h->pdb + h->pdb_size, pattern, pattern_size,
+                var, var_size, goal, op, op_size, flags, share);
+        used += (long)h->pdb[h->pdb_size].size * h->pdb[h->pdb_size].width;
+        ++h->pdb_size;
+    }
+
+    BOR_FREE(pattern);
+    BOR_FREE(excluded);
+    planCausalGraphDel(cg);
+
+    h->value = BOR_ALLOC_ARR(int, BOR_MAX(h->pdb_size, 1));
+    additiveCliques(h);
+
+    return &h->heur;
+}
+
+static void heurPDBDel(plan_heur_t *_heur)
+{
+    plan_heur_pdb_t *h = HEUR(_heur);
+    int i;
+
+    for (i = 0; i < h->pdb_size; ++i)
+        pdbFree(h->pdb + i);
+    BOR_FREE(h->pdb);
+
+    for (i = 0; i < h->clique_num; ++i)
+        BOR_FREE(h->clique[i]);
+    if (h->clique)
+        BOR_FREE(h->clique);
+    if (h->clique_size)
+        BOR_FREE(h->clique_size);
+    BOR_FREE(h->value);
+
+    _planHeurFree(&h->heur);
+    BOR_FREE(h);
+}
+
+static void heurPDB(plan_heur_t *_heur, const plan_state_t *state,
+                    plan_heur_res_t *res)
+{
+    plan_heur_pdb_t *h = HEUR(_heur);
+    int i, j, sum, max;
+
+    for (i = 0; i < h->pdb_size; ++i){
+        h->value[i] = pdbValue(h->pdb + i, state);
+        if (h->value[i] == DIST_INF){
+            res->heur = PLAN_HEUR_DEAD_END;
+            return;
+        }
+    }
+
+    // Canonical heuristic: maximum over sums of additive subsets
+    max = 0;
+    for (i = 0; i < h->clique_num; ++i){
+        sum = 0;
+        for (j = 0; j < h->clique_size[i]; ++j)
+            sum += h->value[h->clique[i][j]];
+        max = BOR_MAX(max, sum);
+    }
+    res->heur = max;
+}
+
+
+static int *excludedVars(const plan_var_t *var, int var_size,
+                         const plan_op_t *op, int op_size)
+{
+    const plan_op_cond_eff_t *ce;
+    int *excluded, i, j, k;
+    plan_var_id_t v;
+
+    excluded = BOR_CALLOC_ARR(int, var_size);
+    for (i = 0; i < var_size; ++i){
+        if (var[i].ma_privacy)
+            excluded[i] = 1;
+    }
+
+    // Projections of conditional effects are not deterministic, so the
+    // variables they change are left out to keep the heuristic
+    // admissible.
+    for (i = 0; i < op_size; ++i){
+        for (j = 0; j < op[i].cond_eff_size; ++j){
+            ce = op[i].cond_eff + j;
+            PLAN_PART_STATE_FOR_EACH_VAR(ce->eff, k, v)
+                excluded[v] = 1;
+        }
+    }
+
+    return excluded;
+}
+
+static int selectPattern(int *pattern, plan_var_id_t goal_var,
+                         const plan_var_t *var, int var_size,
+                         const plan_causal_graph_t *cg,
+                         const int *excluded, long max_states)
+{
+    const plan_causal_graph_graph_t *pred = &cg->predecessor_graph;
+    int *in_pattern, *rejected;
+    int size, i, j, v, w, best, best_value;
+    long states;
+
+    if (var[goal_var].range > max_states)
+        return 0;
+
+    in_pattern = BOR_CALLOC_ARR(int, var_size);
+    rejected = BOR_CALLOC_ARR(int, var_size);
+
+    pattern[0] = goal_var;
+    in_pattern[goal_var] = 1;
+    size = 1;
+    states = var[goal_var].range;
+
+    // Greedily add the predecessor in the causal graph that is connected
+    // with the pattern by the most operators while the pattern fits.
+    while (1){
+        best = -1;
+        best_value = 0;
+        for (i = 0; i < size; ++i){
+            v = pattern[i];
+            for (j = 0; j < pred->edge_size[v]; ++j){
+                w = pred->end_var[v][j];
+                if (in_pattern[w] || rejected[w] || excluded[w])
+                    continue;
+                if (states * var[w].range > max_states){
+                    rejected[w] = 1;
+                    continue;
+                }
+
+                if (pred->value[v][j] > best_value
+                        || (pred->value[v][j] == best_value && w < best)){
+                    best = w;
+                    best_value = pred->value[v][j];
+                }
+            }
+        }
+
+        if (best < 0)
+            break;
+
+        pattern[size++] = best;
+        in_pattern[best] = 1;
+        states *= var[best].range;
+    }
+
+    // Keep the pattern sorted so that duplicates are easy to recognize
+    for (size = 0, v = 0; v < var_size; ++v){
+        if (in_pattern[v])
+            pattern[size++] = v;
+    }
+
+    BOR_FREE(in_pattern);
+    BOR_FREE(rejected);
+    return size;
+}
+
+static void projectOp(pdb_op_t *aop, const plan_op_t *op,
+                      const int *var_idx, unsigned flags)
+{
+    plan_var_id_t v;
+    plan_val_t val;
+    int i;
+
+    aop->pre_var = aop->pre_val = NULL;
+    aop->eff_var = aop->eff_val = aop->eff_pre = NULL;
+    aop->pre_size = aop->eff_size = 0;
+    aop->cost = planHeurOpCost(op->cost, flags);
+
+    PLAN_PART_STATE_FOR_EACH(op->eff, i, v, val){
+        if (var_idx[v] < 0)
+            continue;
+        ++aop->eff_size;
+        aop->eff_var = BOR_REALLOC_ARR(aop->eff_var, int, aop->eff_size);
+        aop->eff_val = BOR_REALLOC_ARR(aop->eff_val, int, aop->eff_size);
+        aop->eff_pre = BOR_REALLOC_ARR(aop->eff_pre, int, aop->eff_size);
+        aop->eff_var[aop->eff_size - 1] = var_idx[v];
+        aop->eff_val[aop->eff_size - 1] = val;
+        aop->eff_pre[aop->eff_size - 1] = -1;
+        if (planPartStateIsSet(op->pre, v))
+            aop->eff_pre[aop->eff_size - 1] = planPartStateGet(op->pre, v);
+    }
+
+    if (aop->eff_size == 0)
+        return;
+
+    PLAN_PART_STATE_FOR_EACH(op->pre, i, v, val){
+        if (var_idx[v] < 0 || planPartStateIsSet(op->eff, v))
+            continue;
+        ++aop->pre_size;
+        aop->pre_var = BOR_REALLOC_ARR(aop->pre_var, int, aop->pre_size);
+        aop->pre_val = BOR_REALLOC_ARR(aop->pre_val, int, aop->pre_size);
+        aop->pre_var[aop->pre_size - 1] = var_idx[v];
+        aop->pre_val[aop->pre_size - 1] = val;
+    }
+}
+
+static void pdbOpFree(pdb_op_t *aop)
+{
+    if (aop->pre_var)
+        BOR_FREE(aop->pre_var);
+    if (aop->pre_val)
+        BOR_FREE(aop->pre_val);
+    if (aop->eff_var)
+        BOR_FREE(aop->eff_var);
+    if (aop->eff_val)
+        BOR_FREE(aop->eff_val);
+    if (aop->eff_pre)
+        BOR_FREE(aop->eff_pre);
+}
+
+/** Returns true if the abstract state s can be reached by the operator */
+static int regressable(const pdb_op_t *aop, const int *s)
+{
+    int i;
+
+    for (i = 0; i < aop->eff_size; ++i){
+        if (s[aop->eff_var[i]] != aop->eff_val[i])
+            return 0;
+    }
+    for (i = 0; i < aop->pre_size; ++i){
+        if (s[aop->pre_var[i]] != aop->pre_val[i])
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * Relaxes all abstract states from which the state s (with rank s_rank
+ * and goal distance s_dist) is reached by the operator.
+ */
+static void regress(const pdb_t *pdb, const int *range,
+                    const pdb_op_t *aop, int s_rank, int s_dist,
+                    int *dist, plan_prio_queue_t *queue,
+                    int *free_var, int *free_val)
+{
+    int i, base, rank, d, free_size;
+
+    // Effects without precondition can be reached from any value
+    base = s_rank;
+    free_size = 0;
+    for (i = 0; i < aop->eff_size; ++i){
+        base -= aop->eff_val[i] * pdb->mult[aop->eff_var[i]];
+        if (aop->eff_pre[i] >= 0){
+            base += aop->eff_pre[i] * pdb->mult[aop->eff_var[i]];
+        }else{
+            free_var[free_size] = aop->eff_var[i];
+            free_val[free_size] = 0;
+            ++free_size;
+        }
+    }
+
+    d = s_dist + aop->cost;
+    rank = base;
+    while (1){
+        if (d < dist[rank]){
+            dist[rank] = d;
+            planPrioQueuePush(queue, d, rank);
+        }
+
+        for (i = 0; i < free_size; ++i){
+            rank += pdb->mult[free_var[i]];
+            if (++free_val[i] < range[free_var[i]])
+                break;
+            rank -= free_val[i] * pdb->mult[free_var[i]];
+            free_val[i] = 0;
+        }
+        if (i == free_size)
+            break;
+    }
+}
+
+static void pdbDecode(const pdb_t *pdb, const int *range, int rank, int *s)
+{
+    int i;
+
+    for (i = 0; i < pdb->var_size; ++i)
+        s[i] = (rank / pdb->mult[i]) % range[i];
+}
+
+/** Indexes operators by the value of their first effect: operators
+ *  op_idx[op_begin[f]], ..., op_idx[op_begin[f + 1] - 1] have the first
+ *  effect on the fact f = fact_off[var] + val. */
+static void indexOps(const pdb_t *pdb, const int *range,
+                     const pdb_op_t *aop, int aop_size,
+                     int *fact_off, int **op_begin, int **op_idx)
+{
+    int *begin, *idx;
+    int i, f, fact_size;
+
+    for (fact_size = 0, i = 0; i < pdb->var_size; ++i){
+        fact_off[i] = fact_size;
+        fact_size += range[i];
+    }
+
+    begin = BOR_CALLOC_ARR(int, fact_size + 1);
+    idx = BOR_ALLOC_ARR(int, BOR_MAX(aop_size, 1));
+    for (i = 0; i < aop_size; ++i)
+        ++begin[fact_off[aop[i].eff_var[0]] + aop[i].eff_val[0] + 1];
+    for (f = 0; f < fact_size; ++f)
+        begin[f + 1] += begin[f];
+    for (i = 0; i < aop_size; ++i){
+        f = fact_off[aop[i].eff_var[0]] + aop[i].eff_val[0];
+        idx[begin[f]++] = i;
+    }
+    // Shift the begins back after they were used as insert positions
+    for (f = fact_size; f > 0; --f)
+        begin[f] = begin[f - 1];
+    begin[0] = 0;
+
+    *op_begin = begin;
+    *op_idx = idx;
+}
+
+static void pdbDijkstra(const pdb_t *pdb, const int *range,
+                        const int *goal_val,
+                        const pdb_op_t *aop, int aop_size, int *dist)
+{
+    plan_prio_queue_t queue;
+    const pdb_op_t *o;
+    int *s, *free_var, *free_val;
+    int *fact_off, *op_begin, *op_idx;
+    int i, j, f, rank, d, is_goal;
+
+    fact_off = BOR_ALLOC_ARR(int, pdb->var_size);
+    indexOps(pdb, range, aop, aop_size, fact_off, &op_begin, &op_idx);
+
+    s = BOR_ALLOC_ARR(int, pdb->var_size);
+    free_var = BOR_ALLOC_ARR(int, pdb->var_size);
+    free_val = BOR_ALLOC_ARR(int, pdb->var_size);
+    planPrioQueueInit(&queue);
+
+    for (rank = 0; rank < pdb->size; ++rank){
+        dist[rank] = DIST_INF;
+        pdbDecode(pdb, range, rank, s);
+        for (is_goal = 1, i = 0; i < pdb->var_size && is_goal; ++i){
+            if (goal_val[i] >= 0 && s[i] != goal_val[i])
+                is_goal = 0;
+        }
+
+        if (is_goal){
+            dist[rank] = 0;
+            planPrioQueuePush(&queue, 0, rank);
+        }
+    }
+
+    while (!planPrioQueueEmpty(&queue)){
+        rank = planPrioQueuePop(&queue, &d);
+        if (d != dist[rank])
+            continue;
+
+        // Only operators whose first effect holds in s can reach s
+        pdbDecode(pdb, range, rank, s);
+        for (i = 0; i < pdb->var_size; ++i){
+            f = fact_off[i] + s[i];
+            for (j = op_begin[f]; j < op_begin[f + 1]; ++j){
+                o = aop + op_idx[j];
+                if (regressable(o, s)){
+                    regress(pdb, range, o, rank, d, dist, &queue,
+                            free_var, free_val);
+                }
+            }
+        }
+    }
+
+    BOR_FREE(fact_off);
+    BOR_FREE(op_begin);
+    BOR_FREE(op_idx);
+    planPrioQueueFree(&queue);
+    BOR_FREE(s);
+    BOR_FREE(free_var);
+    BOR_FREE(free_val);
+}
+
+/** Stores distances into the table with the smallest sufficient width.
+ *  If a table of ints would not fit into max_bytes, the distances are
+ *  clamped to fit into two bytes, which keeps them admissible. */
+static void pdbCompress(pdb_t *pdb, int *dist, long max_bytes)
+{
+    uint8_t *t8;
+    uint16_t *t16;
+    int i, max;
+
+    max = 0;
+    for (i = 0; i < pdb->size; ++i){
+        if (dist[i] != DIST_INF)
+            max = BOR_MAX(max, dist[i]);
+    }
+
+    if (max < TABLE8_INF){
+        pdb->width = 1;
+        t8 = BOR_ALLOC_ARR(uint8_t, pdb->size);
+        for (i = 0; i < pdb->size; ++i)
+            t8[i] = (dist[i] == DIST_INF ? TABLE8_INF : dist[i]);
+        pdb->table = t8;
+        BOR_FREE(dist);
+
+    }else if (max < TABLE16_INF
+                || (long)pdb->size * (long)sizeof(int) > max_bytes){
+        pdb->width = 2;
+        t16 = BOR_ALLOC_ARR(uint16_t, pdb->size);
+        for (i = 0; i < pdb->size; ++i){
+            if (dist[i] == DIST_INF){
+                t16[i] = TABLE16_INF;
+            }else{
+                t16[i] = BOR_MIN(dist[i], TABLE16_INF - 1);
+            }
+        }
+        pdb->table = t16;
+        BOR_FREE(dist);
+
+    }else{
+        pdb->width = sizeof(int);
+        pdb->table = dist;
+    }
+}
+
+static void pdbInit(pdb_t *pdb, const int *pattern, int pattern_size,
+                    const plan_var_t *var, int var_size,
+                    const plan_part_state_t *goal,
+                    const plan_op_t *op, int op_size, unsigned flags,
+                    long max_bytes)
+{
+    pdb_op_t *aop;
+    int *var_idx, *range, *goal_val, *dist;
+    int i, aop_size;
+
+    pdb->var_size = pattern_size;
+    pdb->var = BOR_ALLOC_ARR(int, pattern_size);
+    pdb->mult = BOR_ALLOC_ARR(int, pattern_size);
+    range = BOR_ALLOC_ARR(int, pattern_size);
+    goal_val = BOR_ALLOC_ARR(int, pattern_size);
+    var_idx = BOR_ALLOC_ARR(int, var_size);
+    for (i = 0; i < var_size; ++i)
+        var_idx[i] = -1;
+
+    pdb->size = 1;
+    for (i = 0; i < pattern_size; ++i){
+        pdb->var[i] = pattern[i];
+        pdb->mult[i] = pdb->size;
+        range[i] = var[pattern[i]].range;
+        goal_val[i] = -1;
+        if (planPartStateIsSet(goal, pattern[i]))
+            goal_val[i] = planPartStateGet(goal, pattern[i]);
+        var_idx[pattern[i]] = i;
+        pdb->size *= range[i];
+    }
+
+    // Project operators, the ones not affecting the pattern are
+    // self-loops in the abstract space and can be skipped.
+    aop = BOR_ALLOC_ARR(pdb_op_t, BOR_MAX(op_size, 1));
+    pdb->relevant_op = BOR_ALLOC_ARR(int, BOR_MAX(op_size, 1));
+    pdb->relevant_op_size = 0;
+    aop_size = 0;
+    for (i = 0; i < op_size; ++i){
+        projectOp(aop + aop_size, op + i, var_idx, flags);
+        if (aop[aop_size].eff_size > 0){
+            pdb->relevant_op[pdb->relevant_op_size++] = i;
+            ++aop_size;
+        }else{
+            pdbOpFree(aop + aop_size);
+        }
+    }
+
+    dist = BOR_ALLOC_ARR(int, pdb->size);
+    pdbDijkstra(pdb, range, goal_val, aop, aop_size, dist);
+    pdbCompress(pdb, dist, max_bytes);
+
+    for (i = 0; i < aop_size; ++i)
+        pdbOpFree(aop + i);
+    BOR_FREE(aop);
+    BOR_FREE(var_idx);
+    BOR_FREE(range);
+    BOR_FREE(goal_val);
+}
+
+static void pdbFree(pdb_t *pdb)
+{
+    BOR_FREE(pdb->var);
+    BOR_FREE(pdb->mult);
+    BOR_FREE(pdb->relevant_op);
+    BOR_FREE(pdb->table);
+}
+
+static int pdbValue(const pdb_t *pdb, const plan_state_t *state)
+{
+    int i, rank, val;
+
+    rank = 0;
+    for (i = 0; i < pdb->var_size; ++i)
+        rank += planStateGet(state, pdb->var[i]) * pdb->mult[i];
+
+    if (pdb->width == 1){
+        val = ((const uint8_t *)pdb->table)[rank];
+        return (val == TABLE8_INF ? DIST_INF : val);
+    }else if (pdb->width == 2){
+        val = ((const uint16_t *)pdb->table)[rank];
+        return (val == TABLE16_INF ? DIST_INF : val);
+    }
+    return ((const int *)pdb->table)[rank];
+}
+
+
+/** Returns true if the two pdbs do not share any relevant operator */
+static int additive(const pdb_t *p1, const pdb_t *p2)
+{
+    int i, j;
+
+    for (i = 0, j = 0; i < p1->relevant_op_size
+                        && j < p2->relevant_op_size;){
+        if (p1->relevant_op[i] == p2->relevant_op[j]){
+            return 0;
+        }else if (p1->relevant_op[i] < p2->relevant_op[j]){
+            ++i;
+        }else{
+            ++j;
+        }
+    }
+    return 1;
+}
+
+static void addClique(plan_heur_pdb_t *h, const int *clique, int size)
+{
+    ++h->clique_num;
+    h->clique = BOR_REALLOC_ARR(h->clique, int *, h->clique_num);
+    h->clique_size = BOR_REALLOC_ARR(h->clique_size, int, h->clique_num);
+    h->clique[h->clique_num - 1] = BOR_ALLOC_ARR(int, size);
+    memcpy(h->clique[h->clique_num - 1], clique, sizeof(int) * size);
+    h->clique_size[h->clique_num - 1] = size;
+}
+
+/** Bron-Kerbosch algorithm with pivoting */
+static void bronKerbosch(plan_heur_pdb_t *h, const int *compat,
+                         int *R, int R_size,
+                         int *P, int P_size,
+                         int *X, int X_size)
+{
+    int n = h->pdb_size;
+    int *cand, cand_size, *P2, P2_size, *X2, X2_size;
+    int pivot, i, j, v;
+
+    if (P_size == 0 && X_size == 0){
+        addClique(h, R, R_size);
+        return;
+    }
+    if (P_size == 0)
+        return;
+
+    pivot = P[0];
+    cand = BOR_ALLOC_ARR(int, n);
+    P2 = BOR_ALLOC_ARR(int, n);
+    X2 = BOR_ALLOC_ARR(int, n);
+
+    cand_size = 0;
+    for (i = 0; i < P_size; ++i){
+        if (!compat[pivot * n + P[i]])
+            cand[cand_size++] = P[i];
+    }
+
+    for (i = 0; i < cand_size; ++i){
+        v = cand[i];
+
+        P2_size = X2_size = 0;
+        for (j = 0; j < P_size; ++j){
+            if (compat[v * n + P[j]])
+                P2[P2_size++] = P[j];
+        }
+        for (j = 0; j < X_size; ++j){
+            if (compat[v * n + X[j]])
+                X2[X2_size++] = X[j];
+        }
+
+        R[R_size] = v;
+        bronKerbosch(h, compat, R, R_size + 1, P2, P2_size, X2, X2_size);
+
+        // Move v from P to X
+        for (j = 0; j < P_size && P[j] != v; ++j);
+        P[j] = P[--P_size];
+        X[X_size++] = v;
+    }
+
+    BOR_FREE(cand);
+    BOR_FREE(P2);
+    BOR_FREE(X2);
+}
+
+static void additiveCliques(plan_heur_pdb_t *h)
+{
+    int n = h->pdb_size;
+    int *compat, *R, *P, *X;
+    int i, j;
+
+    h->clique = NULL;
+    h->clique_size = NULL;
+    h->clique_num = 0;
+    if (n == 0)
+        return;
+
+    compat = BOR_CALLOC_ARR(int, n * n);
+    for (i = 0; i < n; ++i){
+        for (j = i + 1; j < n; ++j){
+            if (additive(h->pdb + i, h->pdb + j))
+                compat[i * n + j] = compat[j * n + i] = 1;
+        }
+    }
+
+    R = BOR_ALLOC_ARR(int, n);
+    P = BOR_ALLOC_ARR(int, n);
+    X = BOR_ALLOC_ARR(int, n);
+    for (i = 0; i < n; ++i)
+        P[i] = i;
+    bronKerbosch(h, compat, R, 0, P, n, X, 0);
+
+    BOR_FREE(compat);
+    BOR_FREE(R);
+    BOR_FREE(P);
+    BOR_FREE(X);
+}
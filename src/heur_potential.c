@@ -18,8 +18,11 @@
  */
 
 #include <boruvka/alloc.h>
+#include <boruvka/rand.h>
 #include <plan/config.h>
 #include <plan/heur.h>
+#include <plan/search.h>
+#include <plan/succ_gen.h>
 
 #ifdef PLAN_LP
 #include "plan/pot.h"
@@ -28,6 +31,19 @@ struct _plan_heur_potential_t {
     plan_heur_t heur;
     plan_pot_t pot;
     plan_lp_t *lp;
+
+    int fn_size;         /*!< Number of potential functions */
+    int64_t *fpot;       /*!< Fixed-point potentials of all functions
+                              interleaved per (var, val) pair, i.e.,
+                              .fn_size values for each pair */
+    int64_t *scale;      /*!< Scale of each function */
+    int64_t *sum;        /*!< Pre-allocated potentials of a state */
+
+    plan_state_id_t parent_id; /*!< State whose potentials are in
+                                    .parent_sum */
+    int64_t *parent_sum; /*!< Potentials of the last expanded state, so
+                              that its successors are evaluated
+                              incrementally */
 };
 typedef struct _plan_heur_potential_t plan_heur_potential_t;
 #define HEUR(parent) bor_container_of((parent), plan_heur_potential_t, heur)
@@ -35,22 +51,59 @@ typedef struct _plan_heur_potential_t plan_heur_potential_t;
 static void heurPotentialDel(plan_heur_t *_heur);
 static void heurPotential(plan_heur_t *_heur, const plan_state_t *state,
                           plan_heur_res_t *res);
+static void heurPotentialNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                              plan_search_t *search, plan_heur_res_t *res);
+/** Copies fixed-point potentials from h->pot as the fn-th function */
+static void fnSet(plan_heur_potential_t *h, int fn);
+/** Computes potentials for states sampled by random walks from the
+ *  initial state as functions 1, ..., h->fn_size - 1 */
+static void fnSample(plan_heur_potential_t *h, const plan_op_t *op,
+                     int op_size, const plan_state_t *init_state,
+                     unsigned seed);
+/** Computes potentials of the state by all functions */
+static void statePot(const plan_heur_potential_t *h,
+                     const plan_state_t *state, int64_t *sum);
+/** Returns maximum over all functions */
+static plan_cost_t potToCost(const plan_heur_potential_t *h,
+                             const int64_t *sum);
+/** Computes potentials of the state created by op from the potentials of
+ *  the parent state. Returns -1 if the change of the potential cannot be
+ *  derived from the operator alone. */
+static int potFromParent(const plan_heur_potential_t *h, const plan_op_t *op,
+                         const int64_t *parent_sum, int64_t *sum);
 
 plan_heur_t *planHeurPotentialNew(const plan_var_t *var, int var_size,
                                   const plan_part_state_t *goal,
                                   const plan_op_t *op, int op_size,
                                   const plan_state_t *init_state,
-                                  unsigned flags)
+                                  unsigned flags, unsigned seed)
 {
     plan_heur_potential_t *heur;
+    int i, size;
 
     heur = BOR_ALLOC(plan_heur_potential_t);
     bzero(heur, sizeof(*heur));
-    _planHeurInit(&heur->heur, heurPotentialDel, heurPotential, NULL);
+    _planHeurInit(&heur->heur, heurPotentialDel, heurPotential,
+                  heurPotentialNode);
 
     planPotInit(&heur->pot, var, var_size, goal, op, op_size, init_state, flags, 0);
     planPotCompute(&heur->pot);
 
+    heur->fn_size = BOR_MAX(1, PLAN_HEUR_POT_ENSEMBLE_SIZE(flags));
+    for (size = 0, i = 0; i < var_size; ++i)
+        size += var[i].range;
+    heur->fpot = BOR_ALLOC_ARR(int64_t, size * heur->fn_size);
+    heur->scale = BOR_ALLOC_ARR(int64_t, heur->fn_size);
+    heur->sum = BOR_ALLOC_ARR(int64_t, heur->fn_size);
+    heur->parent_sum = BOR_ALLOC_ARR(int64_t, heur->fn_size);
+    heur->parent_id = PLAN_NO_STATE;
+
+    // The first function is always the one computed above
+    fnSet(heur, 0);
+    if (heur->fn_size > 1)
+        fnSample(heur, op, op_size, init_state, seed);
+    planPotFreeLP(&heur->pot);
+
     return &heur->heur;
 }
 
@@ -59,6 +112,14 @@ static void heurPotentialDel(plan_heur_t *_heur)
     plan_heur_potential_t *h = HEUR(_heur);
 
     planPotFree(&h->pot);
+    if (h->fpot != NULL)
+        BOR_FREE(h->fpot);
+    if (h->scale != NULL)
+        BOR_FREE(h->scale);
+    if (h->sum != NULL)
+        BOR_FREE(h->sum);
+    if (h->parent_sum != NULL)
+        BOR_FREE(h->parent_sum);
     _planHeurFree(&h->heur);
     BOR_FREE(h);
 }
@@ -68,8 +129,186 @@ static void heurPotential(plan_heur_t *_heur, const plan_state_t *state,
 {
     plan_heur_potential_t *h = HEUR(_heur);
 
-    res->heur = planPotStatePot(&h->pot, state);
-    res->heur = BOR_MAX(0, res->heur);
+    statePot(h, state, h->sum);
+    res->heur = potToCost(h, h->sum);
+}
+
+static void heurPotentialNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                              plan_search_t *search, plan_heur_res_t *res)
+{
+    plan_heur_potential_t *h = HEUR(_heur);
+    const plan_state_space_node_t *node;
+    plan_state_id_t parent_id;
+    const plan_op_t *op;
+
+    node = planSearchLoadNode(search, state_id);
+    parent_id = node->parent_state_id;
+    op = node->op;
+
+    // Successors of the same state are evaluated one after another, so
+    // the potentials of the parent are computed only once per expansion
+    if (parent_id != PLAN_NO_STATE && op != NULL
+            && parent_id != h->parent_id){
+        statePot(h, planSearchLoadState(search, parent_id), h->parent_sum);
+        h->parent_id = parent_id;
+    }
+
+    if (parent_id == PLAN_NO_STATE || op == NULL
+            || potFromParent(h, op, h->parent_sum, h->sum) != 0){
+        statePot(h, planSearchLoadState(search, state_id), h->sum);
+    }
+
+    res->heur = potToCost(h, h->sum);
+}
+
+static void fnSet(plan_heur_potential_t *h, int fn)
+{
+    const plan_pot_t *pot = &h->pot;
+    int var, val, id;
+
+    for (var = 0; var < pot->var_size; ++var){
+        for (val = 0; val < pot->var[var].range; ++val){
+            id = pot->fpot_off[var] + val;
+            h->fpot[(long)id * h->fn_size + fn] = pot->fpot[id];
+        }
+    }
+    h->scale[fn] = pot->fpot_scale;
+}
+
+/** Applies operator (including conditional effects) on the state the same
+ *  way as planOpApply(), i.e., conditions of all conditional effects are
+ *  evaluated on the original state before any effect is applied */
+static void walkApplyOp(const plan_op_t *op, plan_state_t *state)
+{
+    const plan_part_state_t *eff[op->cond_eff_size + 1];
+    const plan_op_cond_eff_t *ce;
+    const plan_part_state_pair_t *p;
+    int i, j, efflen, applicable;
+
+    eff[0] = op->eff;
+    efflen = 1;
+    for (i = 0; i < op->cond_eff_size; ++i){
+        ce = op->cond_eff + i;
+        applicable = 1;
+        for (j = 0; applicable && j < ce->pre->vals_size; ++j){
+            p = ce->pre->vals + j;
+            applicable = (planStateGet(state, p->var) == p->val);
+        }
+        if (applicable)
+            eff[efflen++] = ce->eff;
+    }
+
+    for (i = 0; i < efflen; ++i){
+        for (j = 0; j < eff[i]->vals_size; ++j){
+            p = eff[i]->vals + j;
+            planStateSet(state, p->var, p->val);
+        }
+    }
+}
+
+static void fnSample(plan_heur_potential_t *h, const plan_op_t *op,
+                     int op_size, const plan_state_t *init_state,
+                     unsigned seed)
+{
+    plan_succ_gen_t *succ_gen;
+    plan_op_t **app;
+    plan_state_t *state;
+    bor_rand_t rnd;
+    double avg_cost, hinit;
+    int i, fn, len, step, app_size;
+
+    // Walk lengths are drawn uniformly around the estimated number of
+    // steps to the goal
+    avg_cost = 0.;
+    for (i = 0; i < op_size; ++i)
+        avg_cost += op[i].cost;
+    avg_cost = BOR_MAX(1., avg_cost / BOR_MAX(op_size, 1));
+    hinit = planPotStatePot(&h->pot, init_state);
+    len = BOR_MAX(1, (int)(2. * hinit / avg_cost));
+
+    succ_gen = planSuccGenNew(op, op_size, NULL);
+    app = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(op_size, 1));
+    state = planStateNew(init_state->size);
+    borRandInitSeed(&rnd, seed);
+
+    for (fn = 1; fn < h->fn_size; ++fn){
+        planStateCopy(state, init_state);
+        step = borRand(&rnd, 0, len + 1);
+        for (; step > 0; --step){
+            app_size = planSuccGenFind(succ_gen, state, app, op_size);
+            if (app_size == 0)
+                break;
+            i = BOR_MIN(app_size - 1, (int)borRand(&rnd, 0, app_size));
+            walkApplyOp(app[i], state);
+        }
+
+        planPotSetState(&h->pot, state);
+        planPotCompute(&h->pot);
+        fnSet(h, fn);
+    }
+
+    planStateDel(state);
+    BOR_FREE(app);
+    planSuccGenDel(succ_gen);
+}
+
+static void statePot(const plan_heur_potential_t *h,
+                     const plan_state_t *state, int64_t *sum)
+{
+    const int64_t *row;
+    const int *off = h->pot.fpot_off;
+    const plan_val_t *val = state->val;
+    int var, fn, fn_size = h->fn_size;
+
+    for (fn = 0; fn < fn_size; ++fn)
+        sum[fn] = 0;
+
+    for (var = 0; var < h->pot.var_size; ++var){
+        row = h->fpot + (long)(off[var] + val[var]) * fn_size;
+        for (fn = 0; fn < fn_size; ++fn)
+            sum[fn] += row[fn];
+    }
+}
+
+static plan_cost_t potToCost(const plan_heur_potential_t *h,
+                             const int64_t *sum)
+{
+    plan_cost_t hval = 0;
+    int fn;
+
+    for (fn = 0; fn < h->fn_size; ++fn)
+        hval = BOR_MAX(hval, planPotFixedToCost(sum[fn], h->scale[fn]));
+    return hval;
+}
+
+static int potFromParent(const plan_heur_potential_t *h, const plan_op_t *op,
+                         const int64_t *parent_sum, int64_t *sum)
+{
+    const plan_part_state_pair_t *eff;
+    const int64_t *row_eff, *row_pre;
+    const int *off = h->pot.fpot_off;
+    plan_val_t pre;
+    int i, fn, fn_size = h->fn_size;
+
+    if (op->cond_eff_size > 0)
+        return -1;
+
+    // The parent's value of each effect variable is known only if it is
+    // fixed by the precondition
+    memcpy(sum, parent_sum, sizeof(int64_t) * fn_size);
+    for (i = 0; i < op->eff->vals_size; ++i){
+        eff = op->eff->vals + i;
+        pre = planPartStateGet(op->pre, eff->var);
+        if (pre == PLAN_VAL_UNDEFINED)
+            return -1;
+
+        row_eff = h->fpot + (long)(off[eff->var] + eff->val) * fn_size;
+        row_pre = h->fpot + (long)(off[eff->var] + pre) * fn_size;
+        for (fn = 0; fn < fn_size; ++fn)
+            sum[fn] += row_eff[fn] - row_pre[fn];
+    }
+
+    return 0;
 }
 
 #else /* PLAN_LP */
@@ -78,7 +317,7 @@ plan_heur_t *planHeurPotentialNew(const plan_var_t *var, int var_size,
                                   const plan_part_state_t *goal,
                                   const plan_op_t *op, int op_size,
                                   const plan_state_t *init_state,
-                                  unsigned flags)
+                                  unsigned flags, unsigned seed)
 {
     fprintf(stderr, "Fatal Error: heur-potential needs some LP library!\n");
     return NULL;
@@ -21,15 +21,7 @@
 #include "plan/prio_queue.h"
 #include "plan/heur.h"
 #include "heur_relax.h"
-
-_bor_inline plan_cost_t _cost(plan_cost_t cost, unsigned flags)
-{
-    if (flags & PLAN_HEUR_OP_UNIT_COST)
-        return 1;
-    if (flags & PLAN_HEUR_OP_COST_PLUS_ONE)
-        return cost + 1;
-    return cost;
-}
+#include "heur_common.h"
 
 void planHeurRelaxInit(plan_heur_relax_t *relax, int type,
                        const plan_var_t *var, int var_size,
@@ -64,13 +56,14 @@ void planHeurRelaxInit(plan_heur_relax_t *relax, int type,
 
         op_id = relax->cref.op_id[i];
         if (op_id >= 0){
-            relax->op_init[i].cost = _cost(op[op_id].cost, flags);
+            relax->op_init[i].cost = planHeurOpCost(op[op_id].cost, flags);
         }
     }
 
     relax->plan_fact = NULL;
     relax->plan_op = NULL;
     relax->goal_fact = NULL;
+    planPrioQueueInit(&relax->queue);
 }
 
 void planHeurRelaxFree(plan_heur_relax_t *relax)
@@ -85,6 +78,7 @@ void planHeurRelaxFree(plan_heur_relax_t *relax)
         BOR_FREE(relax->plan_op);
     if (relax->goal_fact)
         BOR_FREE(relax->goal_fact);
+    planPrioQueueFree(&relax->queue);
     planFactOpCrossRefFree(&relax->cref);
 }
 
@@ -193,7 +187,7 @@ static void exploreAdd(plan_heur_relax_t *relax, const plan_state_t *state)
 #define PLAN_HEUR_RELAX_EXPLORE_CHECK_GOAL  \
     if (fact_id == goal_id) break
 #define PLAN_HEUR_RELAX_EXPLORE_OP_ADD \
-    relaxOpAdd(relax, &queue, op_id, fact_id, value)
+    relaxOpAdd(relax, queue, op_id, fact_id, value)
 #include "_heur_relax_explore.h"
 }
 
@@ -204,7 +198,7 @@ static void exploreMax(plan_heur_relax_t *relax, const plan_state_t *state)
 #define PLAN_HEUR_RELAX_EXPLORE_CHECK_GOAL  \
     if (fact_id == goal_id) break
 #define PLAN_HEUR_RELAX_EXPLORE_OP_ADD \
-    relaxOpMax(relax, &queue, op_id, fact_id, value)
+    relaxOpMax(relax, queue, op_id, fact_id, value)
 #include "_heur_relax_explore.h"
 }
 
@@ -221,7 +215,7 @@ static void exploreAddFull(plan_heur_relax_t *relax, const plan_state_t *state)
 {
 #define PLAN_HEUR_RELAX_EXPLORE_CHECK_GOAL
 #define PLAN_HEUR_RELAX_EXPLORE_OP_ADD \
-    relaxOpAdd(relax, &queue, op_id, fact_id, value)
+    relaxOpAdd(relax, queue, op_id, fact_id, value)
 #include "_heur_relax_explore.h"
 }
 
@@ -229,7 +223,7 @@ static void exploreMaxFull(plan_heur_relax_t *relax, const plan_state_t *state)
 {
 #define PLAN_HEUR_RELAX_EXPLORE_CHECK_GOAL
 #define PLAN_HEUR_RELAX_EXPLORE_OP_ADD \
-    relaxOpMax(relax, &queue, op_id, fact_id, value)
+    relaxOpMax(relax, queue, op_id, fact_id, value)
 #include "_heur_relax_explore.h"
 }
 
@@ -272,7 +266,7 @@ static plan_cost_t exploreAdd2(plan_heur_relax_t *relax,
     if (relax->goal_fact[fact_id] && --gc == 0) \
         break
 #define PLAN_HEUR_RELAX_EXPLORE_OP_ADD \
-    relaxOpAdd(relax, &queue, op_id, fact_id, value)
+    relaxOpAdd(relax, queue, op_id, fact_id, value)
 #include "_heur_relax_explore.h"
 
     if (gc != 0)
@@ -302,7 +296,7 @@ static plan_cost_t exploreMax2(plan_heur_relax_t *relax,
     if (relax->goal_fact[fact_id] && --gc == 0) \
         break
 #define PLAN_HEUR_RELAX_EXPLORE_OP_ADD \
-    relaxOpMax(relax, &queue, op_id, fact_id, value)
+    relaxOpMax(relax, queue, op_id, fact_id, value)
 #include "_heur_relax_explore.h"
 
     if (gc != 0)
@@ -394,24 +388,22 @@ static void incRelaxOpMax(plan_heur_relax_t *relax,
 void incMax(plan_heur_relax_t *relax,
             const int *changed_op, int changed_op_size, int goal_id)
 {
-    plan_prio_queue_t queue;
+    plan_prio_queue_t *queue = &relax->queue;
     int i, size, *op, op_id;
     int fact_id;
     plan_cost_t value;
     plan_heur_relax_fact_t *fact;
 
-    planPrioQueueInit(&queue);
-
     for (i = 0; i < changed_op_size; ++i){
         // Skip unreachable operators
         if (relax->op[changed_op[i]].unsat > 0)
             continue;
-        relaxAddEffects(relax, &queue, changed_op[i],
+        relaxAddEffects(relax, queue, changed_op[i],
                         relax->op[changed_op[i]].value);
     }
 
-    while (!planPrioQueueEmpty(&queue)){
-        fact_id = planPrioQueuePop(&queue, &value);
+    while (!planPrioQueueEmpty(queue)){
+        fact_id = planPrioQueuePop(queue, &value);
         fact = relax->fact + fact_id;
         if (fact->value != value)
             continue;
@@ -423,11 +415,11 @@ void incMax(plan_heur_relax_t *relax,
         op   = relax->cref.fact_pre[fact_id].op;
         for (i = 0; i < size; ++i){
             op_id = op[i];
-            incRelaxOpMax(relax, &queue, op_id, fact_id, value);
+            incRelaxOpMax(relax, queue, op_id, fact_id, value);
         }
     }
 
-    planPrioQueueFree(&queue);
+    planPrioQueueClear(queue);
 }
 
 void planHeurRelaxIncMax(plan_heur_relax_t *relax, const int *op, int op_size)
@@ -534,28 +526,26 @@ void planHeurRelaxUpdateMaxFull(plan_heur_relax_t *relax,
                                 const int *op, int op_size)
 {
     int i, fact_id, fact_value;
-    plan_prio_queue_t queue;
-
-    planPrioQueueInit(&queue);
+    plan_prio_queue_t *queue = &relax->queue;
 
     for (i = 0; i < op_size; ++i){
         // Skip unreachable operators
         if (relax->op[op[i]].unsat > 0)
             continue;
         relax->op[op[i]].supp = -1;
-        updateMaxOp(relax, &queue, op[i]);
+        updateMaxOp(relax, queue, op[i]);
     }
 
 
-    while (!planPrioQueueEmpty(&queue)){
-        fact_id = planPrioQueuePop(&queue, &fact_value);
+    while (!planPrioQueueEmpty(queue)){
+        fact_id = planPrioQueuePop(queue, &fact_value);
         if (relax->fact[fact_id].value != fact_value)
             continue;
 
-        updateMaxFact(relax, &queue, fact_id, fact_value);
+        updateMaxFact(relax, queue, fact_id, fact_value);
     }
 
-    planPrioQueueFree(&queue);
+    planPrioQueueClear(queue);
 }
 
 
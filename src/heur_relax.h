@@ -20,6 +20,7 @@
 #ifndef __PLAN_HEUR_RELAX_H__
 #define __PLAN_HEUR_RELAX_H__
 
+#include "plan/prio_queue.h"
 #include "fact_op_cross_ref.h"
 
 #ifdef __cplusplus
@@ -56,6 +57,8 @@ struct _plan_heur_relax_t {
     int *goal_fact; /*!< Array with flags set to 1 on facts that are the
                          goal facts. This array is used in planHeurRelax2()
                          function. */
+    plan_prio_queue_t queue; /*!< Priority queue shared by all runs so that
+                                  the buckets are not re-allocated */
 };
 typedef struct _plan_heur_relax_t plan_heur_relax_t;
 
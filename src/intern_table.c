@@ -0,0 +1,142 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2015 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <boruvka/alloc.h>
+#include <boruvka/hfunc.h>
+#include "plan/intern_table.h"
+
+/** Initial number of slots */
+#define INIT_SLOT_SIZE 64
+/** Initial number of elements */
+#define INIT_ALLOC 32
+
+/** Returns hash value of the element */
+static uint32_t elHash(const plan_intern_table_t *t, const void *el);
+/** Returns the first slot that is either empty or contains the element */
+static uint32_t findSlot(const plan_intern_table_t *t, const void *el,
+                         uint32_t hash);
+/** Resizes the hash table to the new number of slots */
+static void resizeSlots(plan_intern_table_t *t, uint32_t slot_size);
+
+void planInternTableInit(plan_intern_table_t *t, size_t el_size)
+{
+    bzero(t, sizeof(*t));
+    t->el_size = el_size;
+}
+
+void planInternTableFree(plan_intern_table_t *t)
+{
+    if (t->data)
+        BOR_FREE(t->data);
+    if (t->hash)
+        BOR_FREE(t->hash);
+    if (t->slot)
+        BOR_FREE(t->slot);
+}
+
+int planInternTableInsert(plan_intern_table_t *t, const void *el)
+{
+    uint32_t hash, slot, id;
+
+    // Keep load factor under 3/4
+    if ((t->size + 1) * 4 > t->slot_size * 3){
+        if (t->slot_size == 0){
+            resizeSlots(t, INIT_SLOT_SIZE);
+        }else{
+            resizeSlots(t, t->slot_size * 2);
+        }
+    }
+
+    hash = elHash(t, el);
+    slot = findSlot(t, el, hash);
+    if (t->slot[slot] != 0)
+        return t->slot[slot] - 1;
+
+    if (t->size == t->alloc){
+        t->alloc = (t->alloc == 0 ? INIT_ALLOC : t->alloc * 2);
+        t->data = BOR_REALLOC_ARR(t->data, char, t->el_size * t->alloc);
+        t->hash = BOR_REALLOC_ARR(t->hash, uint32_t, t->alloc);
+    }
+
+    id = t->size++;
+    memcpy(t->data + t->el_size * id, el, t->el_size);
+    t->hash[id] = hash;
+    t->slot[slot] = id + 1;
+    return id;
+}
+
+int planInternTableFind(const plan_intern_table_t *t, const void *el)
+{
+    uint32_t slot;
+
+    if (t->size == 0)
+        return -1;
+
+    slot = findSlot(t, el, elHash(t, el));
+    return (int)t->slot[slot] - 1;
+}
+
+size_t planInternTableMemUsage(const plan_intern_table_t *t)
+{
+    size_t size;
+
+    size  = sizeof(*t);
+    size += (t->el_size + sizeof(uint32_t)) * t->alloc;
+    size += sizeof(uint32_t) * t->slot_size;
+    return size;
+}
+
+static uint32_t elHash(const plan_intern_table_t *t, const void *el)
+{
+    return (uint32_t)borCityHash_64(el, t->el_size);
+}
+
+static uint32_t findSlot(const plan_intern_table_t *t, const void *el,
+                         uint32_t hash)
+{
+    uint32_t mask, slot, id;
+
+    mask = t->slot_size - 1;
+    for (slot = hash & mask; t->slot[slot] != 0; slot = (slot + 1) & mask){
+        id = t->slot[slot] - 1;
+        if (t->hash[id] == hash
+                && memcmp(t->data + t->el_size * id, el, t->el_size) == 0)
+            return slot;
+    }
+    return slot;
+}
+
+static void resizeSlots(plan_intern_table_t *t, uint32_t slot_size)
+{
+    uint32_t mask, slot, id;
+
+    if (t->slot)
+        BOR_FREE(t->slot);
+    t->slot_size = slot_size;
+    t->slot = BOR_CALLOC_ARR(uint32_t, t->slot_size);
+
+    // Re-insert all elements using stored hash values, elements are
+    // unique so no comparison is needed.
+    mask = t->slot_size - 1;
+    for (id = 0; id < t->size; ++id){
+        for (slot = t->hash[id] & mask; t->slot[slot] != 0;
+                slot = (slot + 1) & mask);
+        t->slot[slot] = id + 1;
+    }
+}
@@ -17,38 +17,42 @@
  * See the License for more information.
  */
 
+#include <limits.h>
 #include <boruvka/alloc.h>
-#include <boruvka/hfunc.h>
 #include "plan/landmark.h"
 
-/** Landmark record in hash table */
-struct _ldm_t {
-    plan_landmark_t ldm;
-    int refcount;      /*!< Reference counter */
-    bor_list_t htable; /*!< Connection to the hash table */
-};
-typedef struct _ldm_t ldm_t;
-#define LDM(lst) BOR_LIST_ENTRY((lst), ldm_t, htable)
-
-/** Landmark set */
-struct _ldm_set_t {
-    int size;
-    ldm_t **ldm_pts;
-    bor_splaytree_int_node_t tree; /*!< Connection to the list of landmarks */
-    bor_list_t prune; /*!< Connection to list of prune-ready landmarks */
-};
-typedef struct _ldm_set_t ldm_set_t;
-
-static bor_htable_key_t ldmHash(const bor_list_t *k, void *ud);
-static int ldmEq(const bor_list_t *k1, const bor_list_t *k2, void *ud);
-
-static ldm_set_t *ldmSetNew(plan_landmark_set_t *l);
-static void ldmSetSoftDel(ldm_set_t *ldms);
-static void ldmSetDel(plan_landmark_cache_t *ldmc, ldm_set_t *ldms);
-static ldm_t *ldmInsert(plan_landmark_cache_t *ldmc,
-                        plan_landmark_t *ldm);
-static void ldmDel(ldm_t *ldm);
-
+/** Number of ints in the header of each cached set */
+#define HDR_SIZE 4
+/** Offsets in the header */
+#define HDR_ID   0 /*!< ID of the set or -1 if the set was removed */
+#define HDR_LEN  1 /*!< Overall length of the entry (incl. header) */
+#define HDR_FLAG 2 /*!< Flags, see below */
+#define HDR_NUM  3 /*!< Number of landmarks in the set */
+
+/** The set was accessed since it was stored or moved */
+#define FLAG_REF   0x1
+/** The set is in the list of prune-ready sets */
+#define FLAG_PRUNE 0x2
+
+/** Initial size of the buffer */
+#define INIT_BUF_SIZE 1024
+/** Initial number of slots of the index */
+#define INIT_IDX_SIZE 64
+/** Memory taken by one slot of the index */
+#define IDX_SLOT_BYTES ((long)(sizeof(int) + sizeof(long)))
+
+static long entryPlace(plan_landmark_cache_t *ldmc, long len);
+static void entryPopTail(plan_landmark_cache_t *ldmc);
+static void entryRemove(plan_landmark_cache_t *ldmc, long off);
+static void evictTail(plan_landmark_cache_t *ldmc);
+static int makeRoom(plan_landmark_cache_t *ldmc, long len);
+static void resize(plan_landmark_cache_t *ldmc, long size);
+static long idxGet(const plan_landmark_cache_t *ldmc, int id);
+static void idxSet(plan_landmark_cache_t *ldmc, int id, long off);
+static void idxDel(plan_landmark_cache_t *ldmc, int id);
+static void idxResize(plan_landmark_cache_t *ldmc, long size);
+static void idxReserve(plan_landmark_cache_t *ldmc);
+static void statsUpdateBytes(plan_landmark_cache_t *ldmc);
 
 void planLandmarkInit(plan_landmark_t *ldm, int size, const int *op_id)
 {
@@ -117,12 +121,18 @@ void planLandmarkSetAdd(plan_landmark_set_t *ldms, int size, int *op_id)
 plan_landmark_cache_t *planLandmarkCacheNew(unsigned flags)
 {
     plan_landmark_cache_t *ldmc;
+    long max_mb;
 
     ldmc = BOR_ALLOC(plan_landmark_cache_t);
-    ldmc->ldm_table = borHTableNew(ldmHash, ldmEq, NULL);
-    ldmc->ldms = borSplayTreeIntNew();
-    borListInit(&ldmc->prune);
-    ldmc->prune_enable = 0;
+    bzero(ldmc, sizeof(*ldmc));
+
+    max_mb = (flags >> 8u) & 0xffffffu;
+    ldmc->max_bytes = max_mb * 1024L * 1024L;
+    ldmc->buf_size = INIT_BUF_SIZE;
+    ldmc->buf = BOR_ALLOC_ARR(int, ldmc->buf_size);
+    ldmc->wrap = -1;
+    idxResize(ldmc, INIT_IDX_SIZE);
+
     if (flags & PLAN_LANDMARK_CACHE_PRUNE)
         ldmc->prune_enable = 1;
 
@@ -134,16 +144,14 @@ plan_landmark_cache_t *planLandmarkCacheNew(unsigned flags)
 
 void planLandmarkCacheDel(plan_landmark_cache_t *ldmc)
 {
-    bor_splaytree_int_node_t *node, *tmp;
-    ldm_set_t *ldms;
-
-    BOR_SPLAYTREE_INT_FOR_EACH_SAFE(ldmc->ldms, node, tmp){
-        ldms = bor_container_of(node, ldm_set_t, tree);
-        ldmSetDel(ldmc, ldms);
-    }
-
-    borHTableDel(ldmc->ldm_table);
-    borSplayTreeIntDel(ldmc->ldms);
+    if (ldmc->buf)
+        BOR_FREE(ldmc->buf);
+    if (ldmc->idx_id)
+        BOR_FREE(ldmc->idx_id);
+    if (ldmc->idx_off)
+        BOR_FREE(ldmc->idx_off);
+    if (ldmc->prune)
+        BOR_FREE(ldmc->prune);
     if (ldmc->ldms_out.landmark)
         BOR_FREE(ldmc->ldms_out.landmark);
     BOR_FREE(ldmc);
@@ -152,29 +160,55 @@ void planLandmarkCacheDel(plan_landmark_cache_t *ldmc)
 int planLandmarkCacheAdd(plan_landmark_cache_t *ldmc,
                          int id, plan_landmark_set_t *ldms_in)
 {
-    bor_splaytree_int_node_t *ins;
-    ldm_set_t *ldms;
-    ldm_t *ldm;
-    int i;
+    plan_landmark_t *ldm;
+    long len, off;
+    int i, *w;
+
+    if (idxGet(ldmc, id) >= 0)
+        return -1;
 
     // Prune old landmarks if pruning is enable
     if (ldmc->prune_enable){
         planLandmarkPrune(ldmc);
     }
 
-    ldms = ldmSetNew(ldms_in);
-    ins = borSplayTreeIntInsert(ldmc->ldms, id, &ldms->tree);
-    if (ins != NULL){
-        ldmSetSoftDel(ldms);
-        return -1;
+    len = HDR_SIZE;
+    for (i = 0; i < ldms_in->size; ++i){
+        planLandmarkUnify(ldms_in->landmark + i);
+        len += 1 + ldms_in->landmark[i].size;
     }
 
-    for (i = 0; i < ldms->size; ++i){
-        ldm = ldmInsert(ldmc, ldms_in->landmark + i);
-        ldms->ldm_pts[i] = ldm;
+    idxReserve(ldmc);
+    if (makeRoom(ldmc, len) != 0){
+        // The set cannot fit in the cache at all
+        planLandmarkSetFree(ldms_in);
+        bzero(ldms_in, sizeof(*ldms_in));
+        ++ldmc->stats.rejected;
+        return 0;
+    }
+
+    off = entryPlace(ldmc, len);
+    w = ldmc->buf + off;
+    w[HDR_ID] = id;
+    w[HDR_LEN] = len;
+    w[HDR_FLAG] = 0;
+    w[HDR_NUM] = ldms_in->size;
+    w += HDR_SIZE;
+    for (i = 0; i < ldms_in->size; ++i){
+        ldm = ldms_in->landmark + i;
+        *w++ = ldm->size;
+        memcpy(w, ldm->op_id, sizeof(int) * ldm->size);
+        w += ldm->size;
     }
 
-    BOR_FREE(ldms_in->landmark);
+    idxSet(ldmc, id, off);
+    ldmc->live += len;
+
+    ++ldmc->stats.inserts;
+    ++ldmc->stats.sets;
+    statsUpdateBytes(ldmc);
+
+    planLandmarkSetFree(ldms_in);
     bzero(ldms_in, sizeof(*ldms_in));
     return 0;
 }
@@ -182,133 +216,388 @@ int planLandmarkCacheAdd(plan_landmark_cache_t *ldmc,
 const plan_landmark_set_t *planLandmarkCacheGet(plan_landmark_cache_t *ldmc,
                                                 int ldmid)
 {
-    bor_splaytree_int_node_t *node;
-    ldm_set_t *ldms;
     plan_landmark_set_t *out = &ldmc->ldms_out;
+    int *e, *r;
     int i;
+    long off;
 
-    node = borSplayTreeIntFind(ldmc->ldms, ldmid);
-    if (node == NULL)
+    off = idxGet(ldmc, ldmid);
+    if (off < 0){
+        ++ldmc->stats.misses;
         return NULL;
+    }
+    ++ldmc->stats.hits;
+
+    e = ldmc->buf + off;
+    e[HDR_FLAG] |= FLAG_REF;
 
-    ldms = bor_container_of(node, ldm_set_t, tree);
-    if (ldms->size > ldmc->ldms_alloc){
-        ldmc->ldms_alloc = ldms->size;
+    if (e[HDR_NUM] > ldmc->ldms_alloc){
+        ldmc->ldms_alloc = e[HDR_NUM];
         out->landmark = BOR_REALLOC_ARR(out->landmark, plan_landmark_t,
                                         ldmc->ldms_alloc);
     }
 
     // If prunig is enabled and the landmark was not marked for pruning
     // yet, add the landmark to the list of prune-ready landmarks.
-    if (ldmc->prune_enable && borListEmpty(&ldms->prune)){
-        borListAppend(&ldmc->prune, &ldms->prune);
+    if (ldmc->prune_enable && !(e[HDR_FLAG] & FLAG_PRUNE)){
+        e[HDR_FLAG] |= FLAG_PRUNE;
+        if (ldmc->prune_size == ldmc->prune_alloc){
+            ldmc->prune_alloc = BOR_MAX(16, 2 * ldmc->prune_alloc);
+            ldmc->prune = BOR_REALLOC_ARR(ldmc->prune, int,
+                                          ldmc->prune_alloc);
+        }
+        ldmc->prune[ldmc->prune_size++] = ldmid;
     }
 
-    out->size = ldms->size;
-    for (i = 0; i < ldms->size; ++i)
-        out->landmark[i] = ldms->ldm_pts[i]->ldm;
+    out->size = e[HDR_NUM];
+    r = e + HDR_SIZE;
+    for (i = 0; i < out->size; ++i){
+        out->landmark[i].size = *r;
+        out->landmark[i].op_id = r + 1;
+        r += 1 + *r;
+    }
     return out;
 }
 
 int planLandmarkPrune(plan_landmark_cache_t *ldmc)
 {
-    int cnt = 0;
-    bor_list_t *item;
-    ldm_set_t *ldms;
+    int i, ins, id, keep, cnt = 0;
+    long off;
 
-    while (!borListEmpty(&ldmc->prune)){
-        // Get next landmark in set
-        item = borListNext(&ldmc->prune);
+    if (ldmc->prune_size <= 1)
+        return 0;
 
-        // Leave one landmark in the list under all circumstances because
-        // the last one will be probably needed in near future.
-        if (borListNext(item) == &ldmc->prune)
-            break;
+    // Leave one landmark in the list under all circumstances because
+    // the last one will be probably needed in near future. A set that was
+    // pruned and stored again can be in the list more than once, so all
+    // other copies of the kept set are dropped first.
+    keep = ldmc->prune[ldmc->prune_size - 1];
+    for (ins = 0, i = 0; i < ldmc->prune_size - 1; ++i){
+        if (ldmc->prune[i] != keep)
+            ldmc->prune[ins++] = ldmc->prune[i];
+    }
+
+    for (i = 0; i < ins; ++i){
+        id = ldmc->prune[i];
+        off = idxGet(ldmc, id);
+        if (off < 0)
+            continue;
 
-        // Delete landmark from the list
-        borListDel(item);
+        // The set could have been evicted and re-inserted since it was
+        // put into the list
+        if (!(ldmc->buf[off + HDR_FLAG] & FLAG_PRUNE))
+            continue;
 
-        // Delete landmark
-        ldms = BOR_LIST_ENTRY(item, ldm_set_t, prune);
-        ldmSetDel(ldmc, ldms);
+        entryRemove(ldmc, off);
+        ++ldmc->stats.pruned;
+        ++cnt;
     }
 
+    ldmc->prune[0] = keep;
+    ldmc->prune_size = 1;
+
     return cnt;
 }
 
-static bor_htable_key_t ldmHash(const bor_list_t *k, void *ud)
+void planLandmarkCacheStatsPrint(const plan_landmark_cache_t *ldmc,
+                                 FILE *fout)
 {
-    ldm_t *ldm = LDM(k);
-    return borCityHash_64(ldm->ldm.op_id, sizeof(int) * ldm->ldm.size);
+    const plan_landmark_cache_stats_t *st = &ldmc->stats;
+
+    fprintf(fout, "Landmark Cache Hits: %ld\n", st->hits);
+    fprintf(fout, "Landmark Cache Misses: %ld\n", st->misses);
+    fprintf(fout, "Landmark Cache Inserts: %ld\n", st->inserts);
+    fprintf(fout, "Landmark Cache Evictions: %ld\n", st->evictions);
+    fprintf(fout, "Landmark Cache Rejected: %ld\n", st->rejected);
+    fprintf(fout, "Landmark Cache Pruned: %ld\n", st->pruned);
+    fprintf(fout, "Landmark Cache Sets: %ld\n", st->sets);
+    fprintf(fout, "Landmark Cache Bytes: %ld\n", st->bytes);
+    fprintf(fout, "Landmark Cache Peak Bytes: %ld\n", st->max_bytes);
 }
 
-static int ldmEq(const bor_list_t *k1, const bor_list_t *k2, void *ud)
+/** Returns offset in the buffer where an entry of the given length can be
+ *  stored and moves the head behind it. The space must be available (see
+ *  makeRoom()). */
+static long entryPlace(plan_landmark_cache_t *ldmc, long len)
 {
-    ldm_t *l1 = LDM(k1);
-    ldm_t *l2 = LDM(k2);
+    long off;
 
-    if (l1->ldm.size != l2->ldm.size)
-        return 0;
-    return !memcmp(l1->ldm.op_id, l2->ldm.op_id, sizeof(int) * l1->ldm.size);
+    if (ldmc->used == 0){
+        ldmc->head = ldmc->tail = 0;
+        ldmc->wrap = -1;
+    }
+
+    if (ldmc->head >= ldmc->tail && ldmc->head + len > ldmc->buf_size){
+        // Continue at the beginning of the buffer
+        ldmc->wrap = ldmc->head;
+        ldmc->head = 0;
+    }
+
+    off = ldmc->head;
+    ldmc->head += len;
+    ldmc->used += len;
+    return off;
+}
+
+/** Returns true if an entry of the given length fits in the free space of
+ *  the buffer */
+static int entryFits(const plan_landmark_cache_t *ldmc, long len)
+{
+    if (ldmc->used == 0)
+        return len <= ldmc->buf_size;
+
+    if (ldmc->head > ldmc->tail){
+        return ldmc->head + len <= ldmc->buf_size
+                || len <= ldmc->tail;
+    }else if (ldmc->head < ldmc->tail){
+        return ldmc->head + len <= ldmc->tail;
+    }
+    return 0;
 }
 
-static ldm_set_t *ldmSetNew(plan_landmark_set_t *l)
+/** Removes the oldest entry from the buffer */
+static void entryPopTail(plan_landmark_cache_t *ldmc)
 {
-    ldm_set_t *ldms;
+    long len = ldmc->buf[ldmc->tail + HDR_LEN];
 
-    ldms = BOR_ALLOC(ldm_set_t);
-    ldms->size = l->size;
-    ldms->ldm_pts = BOR_ALLOC_ARR(ldm_t *, ldms->size);
-    borListInit(&ldms->prune);
-    return ldms;
+    ldmc->tail += len;
+    ldmc->used -= len;
+    if (ldmc->tail == ldmc->wrap){
+        ldmc->tail = 0;
+        ldmc->wrap = -1;
+    }
+    if (ldmc->used == 0){
+        ldmc->head = ldmc->tail = 0;
+        ldmc->wrap = -1;
+    }
 }
 
-static void ldmSetSoftDel(ldm_set_t *ldms)
+/** Marks the entry as removed, its space is reclaimed later */
+static void entryRemove(plan_landmark_cache_t *ldmc, long off)
 {
-    BOR_FREE(ldms->ldm_pts);
-    BOR_FREE(ldms);
+    int *e = ldmc->buf + off;
+
+    idxDel(ldmc, e[HDR_ID]);
+    e[HDR_ID] = -1;
+    --ldmc->stats.sets;
+    ldmc->live -= e[HDR_LEN];
+    statsUpdateBytes(ldmc);
 }
 
-static void ldmSetDel(plan_landmark_cache_t *ldmc, ldm_set_t *ldms)
+/** Reclaims the oldest entry of the buffer unless it was recently used */
+static void evictTail(plan_landmark_cache_t *ldmc)
 {
-    int i;
+    int *e = ldmc->buf + ldmc->tail;
+    long src, off, elen = e[HDR_LEN];
+
+    if (e[HDR_ID] >= 0 && (e[HDR_FLAG] & FLAG_REF)){
+        // Give the recently used set a second chance by moving it to the
+        // head. Once the entry is popped from the tail, there is always
+        // enough space for it and the data stay in place until they are
+        // overwritten.
+        e[HDR_FLAG] &= ~FLAG_REF;
+        src = ldmc->tail;
+        entryPopTail(ldmc);
+        off = entryPlace(ldmc, elen);
+        memmove(ldmc->buf + off, ldmc->buf + src, sizeof(int) * elen);
+        idxSet(ldmc, ldmc->buf[off + HDR_ID], off);
+        return;
+    }
 
-    borSplayTreeIntRemove(ldmc->ldms, &ldms->tree);
-    for (i = 0; i < ldms->size; ++i){
-        if (--ldms->ldm_pts[i]->refcount == 0){
-            borHTableErase(ldmc->ldm_table, &ldms->ldm_pts[i]->htable);
-            ldmDel(ldms->ldm_pts[i]);
+    if (e[HDR_ID] >= 0){
+        entryRemove(ldmc, ldmc->tail);
+        ++ldmc->stats.evictions;
+    }
+    entryPopTail(ldmc);
+}
+
+/** Returns the maximal size of the buffer allowed by the memory limit and
+ *  the current size of the index */
+static long bufLimit(const plan_landmark_cache_t *ldmc)
+{
+    if (ldmc->max_bytes == 0)
+        return LONG_MAX;
+    return (ldmc->max_bytes - ldmc->idx_size * IDX_SLOT_BYTES)
+                / (long)sizeof(int);
+}
+
+/** Makes sure there is enough space for an entry of the given length.
+ *  Returns -1 if the entry is larger than the memory limit allows. */
+static int makeRoom(plan_landmark_cache_t *ldmc, long len)
+{
+    long limit, size;
+
+    limit = bufLimit(ldmc);
+    if (len > limit)
+        return -1;
+
+    while (!entryFits(ldmc, len)){
+        size = BOR_MAX(ldmc->buf_size, 2 * (ldmc->live + len));
+        size = BOR_MIN(size, limit);
+
+        if (ldmc->live + len <= size
+                && (ldmc->max_bytes == 0 || size > ldmc->buf_size)){
+            // Grow (and compact) the buffer while the limit allows it
+            resize(ldmc, size);
+        }else{
+            evictTail(ldmc);
+        }
+    }
+
+    return 0;
+}
+
+/** Re-allocates the buffer to the given size which must be enough for all
+ *  live entries. Removed entries are dropped. */
+static void resize(plan_landmark_cache_t *ldmc, long size)
+{
+    int *buf, *e;
+    long off;
+
+    buf = BOR_ALLOC_ARR(int, size);
+
+    off = 0;
+    while (ldmc->used > 0){
+        e = ldmc->buf + ldmc->tail;
+        if (e[HDR_ID] >= 0){
+            memcpy(buf + off, e, sizeof(int) * e[HDR_LEN]);
+            idxSet(ldmc, e[HDR_ID], off);
+            off += e[HDR_LEN];
         }
+        entryPopTail(ldmc);
+    }
+
+    BOR_FREE(ldmc->buf);
+    ldmc->buf = buf;
+    ldmc->buf_size = size;
+    ldmc->head = off;
+    ldmc->tail = 0;
+    ldmc->wrap = -1;
+    ldmc->used = off;
+}
+
+/** Returns the slot of the ID or the empty slot where it belongs */
+static long idxSlot(const plan_landmark_cache_t *ldmc, int id)
+{
+    long mask = ldmc->idx_size - 1;
+    long i;
+
+    i = ((unsigned long)(unsigned)id * 2654435761UL) & mask;
+    while (ldmc->idx_id[i] >= 0 && ldmc->idx_id[i] != id)
+        i = (i + 1) & mask;
+    return i;
+}
+
+/** Returns offset of the set stored under the ID or -1 */
+static long idxGet(const plan_landmark_cache_t *ldmc, int id)
+{
+    long i;
+
+    if (id < 0)
+        return -1;
+    i = idxSlot(ldmc, id);
+    if (ldmc->idx_id[i] == id)
+        return ldmc->idx_off[i];
+    return -1;
+}
+
+static void idxSet(plan_landmark_cache_t *ldmc, int id, long off)
+{
+    long i = idxSlot(ldmc, id);
+
+    if (ldmc->idx_id[i] < 0){
+        ldmc->idx_id[i] = id;
+        ++ldmc->idx_num;
+    }
+    ldmc->idx_off[i] = off;
+}
+
+static void idxDel(plan_landmark_cache_t *ldmc, int id)
+{
+    long mask = ldmc->idx_size - 1;
+    long i, j, home;
+
+    i = idxSlot(ldmc, id);
+    if (ldmc->idx_id[i] != id)
+        return;
+    ldmc->idx_id[i] = -1;
+    --ldmc->idx_num;
+
+    // Shift back the following IDs that would not be found otherwise
+    for (j = (i + 1) & mask; ldmc->idx_id[j] >= 0; j = (j + 1) & mask){
+        home = ((unsigned long)(unsigned)ldmc->idx_id[j] * 2654435761UL)
+                    & mask;
+        if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+            continue;
+
+        ldmc->idx_id[i] = ldmc->idx_id[j];
+        ldmc->idx_off[i] = ldmc->idx_off[j];
+        ldmc->idx_id[j] = -1;
+        i = j;
     }
-    BOR_FREE(ldms->ldm_pts);
-    BOR_FREE(ldms);
 }
 
-static ldm_t *ldmInsert(plan_landmark_cache_t *ldmc,
-                        plan_landmark_t *ldm)
+static void idxResize(plan_landmark_cache_t *ldmc, long size)
 {
-    ldm_t *l;
-    bor_list_t *ins;
+    int *old_id = ldmc->idx_id;
+    long *old_off = ldmc->idx_off;
+    long i, old_size = ldmc->idx_size;
+
+    ldmc->idx_id = BOR_ALLOC_ARR(int, size);
+    ldmc->idx_off = BOR_ALLOC_ARR(long, size);
+    ldmc->idx_size = size;
+    ldmc->idx_num = 0;
+    for (i = 0; i < size; ++i)
+        ldmc->idx_id[i] = -1;
+
+    for (i = 0; i < old_size; ++i){
+        if (old_id[i] >= 0)
+            idxSet(ldmc, old_id[i], old_off[i]);
+    }
 
-    planLandmarkUnify(ldm);
+    if (old_id != NULL)
+        BOR_FREE(old_id);
+    if (old_off != NULL)
+        BOR_FREE(old_off);
+    statsUpdateBytes(ldmc);
+}
 
-    l = BOR_ALLOC(ldm_t);
-    l->ldm = *ldm;
-    l->refcount = 1;
+/** Makes sure that one more ID can be stored in the index. If the index
+ *  cannot grow because of the memory limit, sets are evicted instead. */
+static void idxReserve(plan_landmark_cache_t *ldmc)
+{
+    long size, limit;
+
+    if (4 * (ldmc->idx_num + 1) <= 3 * ldmc->idx_size)
+        return;
+
+    size = 2 * ldmc->idx_size;
+    if (ldmc->max_bytes > 0){
+        if (size * IDX_SLOT_BYTES > ldmc->max_bytes / 2){
+            // The index can take at most half of the memory
+            while (ldmc->used > 0
+                    && 4 * (ldmc->idx_num + 1) > 3 * ldmc->idx_size)
+                evictTail(ldmc);
+            return;
+        }
 
-    ins = borHTableInsertUnique(ldmc->ldm_table, &l->htable);
-    if (ins != NULL){
-        BOR_FREE(l);
-        planLandmarkFree(ldm);
-        l = LDM(ins);
-        ++l->refcount;
+        // Shrink the buffer so that both fit in the limit
+        limit = (ldmc->max_bytes - size * IDX_SLOT_BYTES)
+                    / (long)sizeof(int);
+        if (ldmc->buf_size > limit){
+            while (ldmc->live > limit)
+                evictTail(ldmc);
+            resize(ldmc, limit);
+        }
     }
 
-    return l;
+    idxResize(ldmc, size);
 }
 
-static void ldmDel(ldm_t *ldm)
+static void statsUpdateBytes(plan_landmark_cache_t *ldmc)
 {
-    planLandmarkFree(&ldm->ldm);
-    BOR_FREE(ldm);
+    ldmc->stats.bytes = ldmc->live * (long)sizeof(int)
+                            + ldmc->idx_size * IDX_SLOT_BYTES;
+    if (ldmc->stats.bytes > ldmc->stats.max_bytes)
+        ldmc->stats.max_bytes = ldmc->stats.bytes;
 }
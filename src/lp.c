@@ -23,9 +23,10 @@
 
 #ifdef PLAN_LP
 
-#if defined(PLAN_USE_LP_SOLVE) && defined(PLAN_USE_CPLEX)
+#if (defined(PLAN_USE_LP_SOLVE) + defined(PLAN_USE_CPLEX) \
+        + defined(PLAN_USE_LP_INTERNAL)) > 1
 # error "Only one LP solver can be defined!"
-#endif /* defined(PLAN_USE_LP_SOLVE) && defined(PLAN_USE_CPLEX) */
+#endif
 
 #ifdef PLAN_USE_LP_SOLVE
 # include <lpsolve/lp_lib.h>
@@ -90,6 +91,19 @@ static double cplexObjVal(plan_lp_t *lp)
 
 #endif /* PLAN_USE_CPLEX */
 
+
+#ifdef PLAN_USE_LP_INTERNAL
+# include <float.h>
+# include <string.h>
+# include "lp_simplex.h"
+
+struct _plan_lp_t {
+    plan_lp_simplex_t lp;
+    int status; /*!< Status of the last solve, PLAN_LP_SIMPLEX_* */
+};
+
+#endif /* PLAN_USE_LP_INTERNAL */
+
 plan_lp_t *planLPNew(int rows, int cols, unsigned flags)
 {
 #ifdef PLAN_USE_LP_SOLVE
@@ -148,6 +162,15 @@ plan_lp_t *planLPNew(int rows, int cols, unsigned flags)
 
     return lp;
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    plan_lp_t *lp;
+
+    lp = BOR_ALLOC(plan_lp_t);
+    planLPSimplexInit(&lp->lp, rows, cols, (flags & 0x1u));
+    lp->status = -1;
+    return lp;
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 
@@ -164,6 +187,10 @@ void planLPDel(plan_lp_t *lp)
     if (lp->env)
         CPXcloseCPLEX(&lp->env);
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexFree(&lp->lp);
+#endif /* PLAN_USE_LP_INTERNAL */
     BOR_FREE(lp);
 }
 
@@ -181,6 +208,10 @@ void planLPSetObj(plan_lp_t *lp, int i, double coef)
     if (st != 0)
         cplexErr(lp, st, "Could not set objective coeficient.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetObj(&lp->lp, i, coef);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPSetVarRange(plan_lp_t *lp, int i, double lb, double ub)
@@ -202,6 +233,10 @@ void planLPSetVarRange(plan_lp_t *lp, int i, double lb, double ub)
     if (st != 0)
         cplexErr(lp, st, "Could not set variable as free.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetVarRange(&lp->lp, i, lb, ub);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPSetVarFree(plan_lp_t *lp, int i)
@@ -214,6 +249,11 @@ void planLPSetVarFree(plan_lp_t *lp, int i)
 #ifdef PLAN_USE_CPLEX
     planLPSetVarRange(lp, i, -CPX_INFBOUND, CPX_INFBOUND);
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetVarRange(&lp->lp, i, -PLAN_LP_SIMPLEX_INF,
+                             PLAN_LP_SIMPLEX_INF);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPSetVarInt(plan_lp_t *lp, int i)
@@ -231,6 +271,10 @@ void planLPSetVarInt(plan_lp_t *lp, int i)
     if (st != 0)
         cplexErr(lp, st, "Could not set variable as integer.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetVarInt(&lp->lp, i);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPSetCoef(plan_lp_t *lp, int row, int col, double coef)
@@ -247,6 +291,10 @@ void planLPSetCoef(plan_lp_t *lp, int row, int col, double coef)
     if (st != 0)
         cplexErr(lp, st, "Could not set constraint coeficient.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetCoef(&lp->lp, row, col, coef);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPSetRHS(plan_lp_t *lp, int row, double rhs, char sense)
@@ -268,6 +316,10 @@ void planLPSetRHS(plan_lp_t *lp, int row, double rhs, char sense)
     if (st != 0)
         cplexErr(lp, st, "Could not set right-hand-side sense.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetRHS(&lp->lp, row, rhs, sense);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPAddRows(plan_lp_t *lp, int cnt, const double *rhs, const char *sense)
@@ -294,6 +346,10 @@ void planLPAddRows(plan_lp_t *lp, int cnt, const double *rhs, const char *sense)
     if (st != 0)
         cplexErr(lp, st, "Could not add new rows.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexAddRows(&lp->lp, cnt, rhs, sense);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPDelRows(plan_lp_t *lp, int begin, int end)
@@ -313,6 +369,10 @@ void planLPDelRows(plan_lp_t *lp, int begin, int end)
     if (st != 0)
         cplexErr(lp, st, "Could not delete rows.");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexDelRows(&lp->lp, begin, end);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 int planLPNumRows(const plan_lp_t *lp)
@@ -325,6 +385,89 @@ int planLPNumRows(const plan_lp_t *lp)
 #ifdef PLAN_USE_CPLEX
     return CPXgetnumrows(lp->env, lp->lp);
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    return lp->lp.rows;
+#endif /* PLAN_USE_LP_INTERNAL */
+}
+
+int planLPNumCols(const plan_lp_t *lp)
+{
+#ifdef PLAN_USE_LP_SOLVE
+    lprec *l = (lprec *)lp;
+    return get_Ncolumns(l);
+#endif /* PLAN_USE_LP_SOLVE */
+
+#ifdef PLAN_USE_CPLEX
+    return CPXgetnumcols(lp->env, lp->lp);
+#endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    return lp->lp.cols;
+#endif /* PLAN_USE_LP_INTERNAL */
+}
+
+int planLPBasisSize(const plan_lp_t *lp)
+{
+#ifdef PLAN_USE_LP_SOLVE
+    // lp_solve stores basic and non-basic variables in one array indexed
+    // from 1
+    return 1 + planLPNumRows(lp) + planLPNumCols(lp);
+#endif /* PLAN_USE_LP_SOLVE */
+
+#ifdef PLAN_USE_CPLEX
+    // Statuses of columns followed by statuses of rows
+    return planLPNumCols(lp) + planLPNumRows(lp);
+#endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    // The same layout as CPLEX uses
+    return planLPNumCols(lp) + planLPNumRows(lp);
+#endif /* PLAN_USE_LP_INTERNAL */
+}
+
+int planLPGetBasis(plan_lp_t *lp, int *basis)
+{
+#ifdef PLAN_USE_LP_SOLVE
+    lprec *l = (lprec *)lp;
+    if (!get_basis(l, basis, TRUE))
+        return -1;
+    return 0;
+#endif /* PLAN_USE_LP_SOLVE */
+
+#ifdef PLAN_USE_CPLEX
+    int st;
+
+    st = CPXgetbase(lp->env, lp->lp, basis, basis + planLPNumCols(lp));
+    if (st != 0)
+        return -1;
+    return 0;
+#endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    return planLPSimplexGetBasis(&lp->lp, basis);
+#endif /* PLAN_USE_LP_INTERNAL */
+}
+
+void planLPSetBasis(plan_lp_t *lp, const int *basis)
+{
+#ifdef PLAN_USE_LP_SOLVE
+    lprec *l = (lprec *)lp;
+    if (!set_basis(l, (int *)basis, TRUE))
+        fprintf(stderr, "LP Error: Could not set basis.\n");
+#endif /* PLAN_USE_LP_SOLVE */
+
+#ifdef PLAN_USE_CPLEX
+    int st;
+
+    st = CPXcopybase(lp->env, lp->lp, basis, basis + planLPNumCols(lp));
+    if (st != 0)
+        cplexErr(lp, st, "Could not set basis.");
+#endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    planLPSimplexSetBasis(&lp->lp, basis);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 double planLPSolveObjVal(plan_lp_t *lp)
@@ -349,6 +492,47 @@ double planLPSolveObjVal(plan_lp_t *lp)
 
     return cplexObjVal(lp);
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    double z;
+
+    lp->status = planLPSimplexSolve(&lp->lp, &z);
+    if (lp->status == PLAN_LP_SIMPLEX_OPTIMAL)
+        return z;
+    return DBL_MAX;
+#endif /* PLAN_USE_LP_INTERNAL */
+}
+
+double planLPSolveDualObjVal(plan_lp_t *lp)
+{
+#ifdef PLAN_USE_LP_SOLVE
+    lprec *l = (lprec *)lp;
+    int ret, simplex_type;
+
+    set_verbose(l, NEUTRAL);
+    simplex_type = get_simplextype(l);
+    set_simplextype(l, SIMPLEX_DUAL_DUAL);
+    ret = solve(l);
+    set_simplextype(l, simplex_type);
+    if (ret == OPTIMAL || ret == SUBOPTIMAL)
+        return get_objective(l);
+    return DBL_MAX;
+#endif /* PLAN_USE_LP_SOLVE */
+
+#ifdef PLAN_USE_CPLEX
+    int st;
+
+    st = CPXdualopt(lp->env, lp->lp);
+    if (st != 0)
+        cplexErr(lp, st, "Failed to optimize LP");
+
+    return cplexObjVal(lp);
+#endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    // The internal solver always starts with the dual simplex
+    return planLPSolveObjVal(lp);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 double planLPSolveILPObjVal(plan_lp_t *lp)
@@ -366,6 +550,15 @@ double planLPSolveILPObjVal(plan_lp_t *lp)
 
     return cplexObjVal(lp);
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    double z;
+
+    lp->status = planLPSimplexSolveILP(&lp->lp, &z);
+    if (lp->status == PLAN_LP_SIMPLEX_OPTIMAL)
+        return z;
+    return DBL_MAX;
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 double planLPSolve(plan_lp_t *lp, double *obj)
@@ -398,6 +591,66 @@ double planLPSolve(plan_lp_t *lp, double *obj)
         cplexErr(lp, st, "Cannot retrieve solution");
     return ov;
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    double z;
+
+    lp->status = planLPSimplexSolve(&lp->lp, &z);
+    if (lp->status == PLAN_LP_SIMPLEX_OPTIMAL){
+        memcpy(obj, lp->lp.x, sizeof(double) * lp->lp.cols);
+        return z;
+    }
+
+    bzero(obj, sizeof(double) * lp->lp.cols);
+    return DBL_MAX;
+#endif /* PLAN_USE_LP_INTERNAL */
+}
+
+int planLPStatus(const plan_lp_t *lp)
+{
+#ifdef PLAN_USE_LP_SOLVE
+    switch (get_status((lprec *)lp)){
+        case OPTIMAL:
+        case SUBOPTIMAL:
+            return PLAN_LP_OPTIMAL;
+        case INFEASIBLE:
+            return PLAN_LP_INFEASIBLE;
+        case UNBOUNDED:
+            return PLAN_LP_UNBOUNDED;
+        default:
+            return PLAN_LP_FAILED;
+    }
+#endif /* PLAN_USE_LP_SOLVE */
+
+#ifdef PLAN_USE_CPLEX
+    switch (CPXgetstat(lp->env, lp->lp)){
+        case CPX_STAT_OPTIMAL:
+        case CPXMIP_OPTIMAL:
+        case CPXMIP_OPTIMAL_TOL:
+            return PLAN_LP_OPTIMAL;
+        case CPX_STAT_INFEASIBLE:
+        case CPXMIP_INFEASIBLE:
+            return PLAN_LP_INFEASIBLE;
+        case CPX_STAT_UNBOUNDED:
+        case CPXMIP_UNBOUNDED:
+            return PLAN_LP_UNBOUNDED;
+        default:
+            return PLAN_LP_FAILED;
+    }
+#endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    switch (lp->status){
+        case PLAN_LP_SIMPLEX_OPTIMAL:
+            return PLAN_LP_OPTIMAL;
+        case PLAN_LP_SIMPLEX_INFEASIBLE:
+            return PLAN_LP_INFEASIBLE;
+        case PLAN_LP_SIMPLEX_UNBOUNDED:
+            return PLAN_LP_UNBOUNDED;
+        default:
+            return PLAN_LP_FAILED;
+    }
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 void planLPWrite(plan_lp_t *lp, const char *fn)
@@ -414,6 +667,18 @@ void planLPWrite(plan_lp_t *lp, const char *fn)
     if (st != 0)
         cplexErr(lp, st, "Failed to optimize ILP");
 #endif /* PLAN_USE_CPLEX */
+
+#ifdef PLAN_USE_LP_INTERNAL
+    FILE *fout;
+
+    fout = fopen(fn, "w");
+    if (fout == NULL){
+        fprintf(stderr, "LP Error: Could not open file %s\n", fn);
+        return;
+    }
+    planLPSimplexWrite(&lp->lp, fout);
+    fclose(fout);
+#endif /* PLAN_USE_LP_INTERNAL */
 }
 
 #else /* PLAN_LP */
@@ -0,0 +1,1069 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2015 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <boruvka/alloc.h>
+
+#include "lp_simplex.h"
+
+#define AT_LB PLAN_LP_SIMPLEX_AT_LB
+#define BASIC PLAN_LP_SIMPLEX_BASIC
+#define AT_UB PLAN_LP_SIMPLEX_AT_UB
+#define FREE  PLAN_LP_SIMPLEX_FREE
+#define INF   PLAN_LP_SIMPLEX_INF
+
+/** Primal feasibility tolerance */
+#define PRIMAL_TOL 1E-7
+/** Dual feasibility tolerance */
+#define DUAL_TOL 1E-7
+/** Minimal absolute value of a pivot */
+#define PIVOT_TOL 1E-9
+/** Drop tolerance for elements of eta vectors */
+#define DROP_TOL 1E-12
+/** Value of artificial bounds */
+#define BOX 1E7
+/** Number of eta vectors after which the basis is re-inverted */
+#define REINVERT_FREQ 100
+/** Integrality tolerance */
+#define INT_TOL 1E-6
+
+#define IS_INF(v) ((v) <= -INF || (v) >= INF)
+
+static void resizeVars(plan_lp_simplex_t *lp, int size);
+static void resizeRows(plan_lp_simplex_t *lp, int size);
+static void setRowBounds(plan_lp_simplex_t *lp, int row,
+                         double rhs, char sense);
+/** Resets the basis to the all-logical basis */
+static void slackBasis(plan_lp_simplex_t *lp);
+static void etaFree(plan_lp_simplex_t *lp);
+/** Re-computes the eta file from the set of basic variables */
+static void reinvert(plan_lp_simplex_t *lp);
+
+void planLPSimplexInit(plan_lp_simplex_t *lp, int rows, int cols,
+                       int maximize)
+{
+    int i;
+
+    bzero(lp, sizeof(*lp));
+    lp->cols = cols;
+    lp->maximize = maximize;
+    lp->obj = BOR_CALLOC_ARR(double, cols);
+    lp->is_int = BOR_CALLOC_ARR(int, cols);
+    lp->col = BOR_CALLOC_ARR(plan_lp_simplex_col_t, cols);
+
+    resizeVars(lp, cols + rows);
+    for (i = 0; i < cols; ++i){
+        lp->lb[i] = 0.;
+        lp->ub[i] = INF;
+        lp->status[i] = AT_LB;
+        lp->x[i] = lp->d[i] = 0.;
+        lp->box[i] = 0;
+    }
+
+    planLPSimplexAddRows(lp, rows, NULL, NULL);
+}
+
+void planLPSimplexFree(plan_lp_simplex_t *lp)
+{
+    int i;
+
+    for (i = 0; i < lp->cols; ++i){
+        if (lp->col[i].row)
+            BOR_FREE(lp->col[i].row);
+        if (lp->col[i].val)
+            BOR_FREE(lp->col[i].val);
+    }
+    if (lp->col)
+        BOR_FREE(lp->col);
+    if (lp->obj)
+        BOR_FREE(lp->obj);
+    if (lp->is_int)
+        BOR_FREE(lp->is_int);
+
+    if (lp->lb)
+        BOR_FREE(lp->lb);
+    if (lp->ub)
+        BOR_FREE(lp->ub);
+    if (lp->status)
+        BOR_FREE(lp->status);
+    if (lp->x)
+        BOR_FREE(lp->x);
+    if (lp->d)
+        BOR_FREE(lp->d);
+    if (lp->box)
+        BOR_FREE(lp->box);
+
+    etaFree(lp);
+    if (lp->eta)
+        BOR_FREE(lp->eta);
+    if (lp->head)
+        BOR_FREE(lp->head);
+    if (lp->work)
+        BOR_FREE(lp->work);
+    if (lp->work2)
+        BOR_FREE(lp->work2);
+}
+
+void planLPSimplexSetObj(plan_lp_simplex_t *lp, int col, double coef)
+{
+    lp->obj[col] = coef;
+}
+
+void planLPSimplexSetVarRange(plan_lp_simplex_t *lp, int col,
+                              double lb, double ub)
+{
+    lp->lb[col] = lb;
+    lp->ub[col] = ub;
+}
+
+void planLPSimplexSetVarInt(plan_lp_simplex_t *lp, int col)
+{
+    lp->is_int[col] = 1;
+}
+
+void planLPSimplexSetCoef(plan_lp_simplex_t *lp, int row, int col,
+                          double coef)
+{
+    plan_lp_simplex_col_t *c = lp->col + col;
+    int i;
+
+    for (i = 0; i < c->size && c->row[i] != row; ++i);
+
+    if (i < c->size){
+        if (coef == 0.){
+            c->row[i] = c->row[c->size - 1];
+            c->val[i] = c->val[c->size - 1];
+            --c->size;
+        }else{
+            c->val[i] = coef;
+        }
+
+    }else if (coef != 0.){
+        if (c->size == c->alloc){
+            c->alloc = BOR_MAX(2 * c->alloc, 4);
+            c->row = BOR_REALLOC_ARR(c->row, int, c->alloc);
+            c->val = BOR_REALLOC_ARR(c->val, double, c->alloc);
+        }
+        c->row[c->size] = row;
+        c->val[c->size] = coef;
+        ++c->size;
+
+    }else{
+        return;
+    }
+
+    // Changing a basic column changes the basis matrix
+    if (lp->status[col] == BASIC)
+        lp->factor_valid = 0;
+}
+
+void planLPSimplexSetRHS(plan_lp_simplex_t *lp, int row,
+                         double rhs, char sense)
+{
+    setRowBounds(lp, row, rhs, sense);
+}
+
+void planLPSimplexAddRows(plan_lp_simplex_t *lp, int cnt,
+                          const double *rhs, const char *sense)
+{
+    int i, row, var;
+
+    resizeVars(lp, lp->cols + lp->rows + cnt);
+    resizeRows(lp, lp->rows + cnt);
+
+    for (i = 0; i < cnt; ++i){
+        row = lp->rows + i;
+        var = lp->cols + row;
+        lp->box[var] = 0;
+        lp->x[var] = 0.;
+        lp->d[var] = 0.;
+        setRowBounds(lp, row, (rhs ? rhs[i] : 0.), (sense ? sense[i] : 'E'));
+
+        // Logical variables of new rows are basic, so the basis stays
+        // valid
+        lp->status[var] = BASIC;
+        lp->head[row] = var;
+    }
+
+    lp->rows += cnt;
+    lp->factor_valid = 0;
+}
+
+void planLPSimplexDelRows(plan_lp_simplex_t *lp, int begin, int end)
+{
+    plan_lp_simplex_col_t *c;
+    int i, j, ins, cnt, var, num_basic;
+
+    cnt = end - begin + 1;
+    if (cnt <= 0)
+        return;
+
+    // Remove coefficients from columns and shift row indexes
+    for (i = 0; i < lp->cols; ++i){
+        c = lp->col + i;
+        for (j = 0, ins = 0; j < c->size; ++j){
+            if (c->row[j] >= begin && c->row[j] <= end)
+                continue;
+            c->row[ins] = c->row[j];
+            if (c->row[ins] > end)
+                c->row[ins] -= cnt;
+            c->val[ins] = c->val[j];
+            ++ins;
+        }
+        c->size = ins;
+    }
+
+    // Shift logical variables
+    for (var = lp->cols + begin; var + cnt < lp->cols + lp->rows; ++var){
+        lp->lb[var] = lp->lb[var + cnt];
+        lp->ub[var] = lp->ub[var + cnt];
+        lp->status[var] = lp->status[var + cnt];
+        lp->x[var] = lp->x[var + cnt];
+        lp->d[var] = lp->d[var + cnt];
+        lp->box[var] = lp->box[var + cnt];
+    }
+    lp->rows -= cnt;
+    lp->factor_valid = 0;
+
+    // The basis stays valid only if logical variables of all deleted rows
+    // were basic
+    num_basic = 0;
+    for (var = 0; var < lp->cols + lp->rows; ++var){
+        if (lp->status[var] == BASIC)
+            ++num_basic;
+    }
+    if (num_basic != lp->rows)
+        lp->basis_valid = 0;
+}
+
+int planLPSimplexGetBasis(const plan_lp_simplex_t *lp, int *basis)
+{
+    if (!lp->basis_valid)
+        return -1;
+    memcpy(basis, lp->status, sizeof(int) * (lp->cols + lp->rows));
+    return 0;
+}
+
+void planLPSimplexSetBasis(plan_lp_simplex_t *lp, const int *basis)
+{
+    int i, num_basic = 0;
+
+    for (i = 0; i < lp->cols + lp->rows; ++i){
+        if (basis[i] == BASIC)
+            ++num_basic;
+    }
+    if (num_basic != lp->rows)
+        return;
+
+    memcpy(lp->status, basis, sizeof(int) * (lp->cols + lp->rows));
+    lp->basis_valid = 1;
+    lp->factor_valid = 0;
+}
+
+
+static void resizeVars(plan_lp_simplex_t *lp, int size)
+{
+    if (size <= lp->var_alloc)
+        return;
+
+    lp->var_alloc = BOR_MAX(size, 2 * lp->var_alloc);
+    lp->lb = BOR_REALLOC_ARR(lp->lb, double, lp->var_alloc);
+    lp->ub = BOR_REALLOC_ARR(lp->ub, double, lp->var_alloc);
+    lp->status = BOR_REALLOC_ARR(lp->status, int, lp->var_alloc);
+    lp->x = BOR_REALLOC_ARR(lp->x, double, lp->var_alloc);
+    lp->d = BOR_REALLOC_ARR(lp->d, double, lp->var_alloc);
+    lp->box = BOR_REALLOC_ARR(lp->box, int, lp->var_alloc);
+}
+
+static void resizeRows(plan_lp_simplex_t *lp, int size)
+{
+    if (size <= lp->row_alloc)
+        return;
+
+    lp->row_alloc = BOR_MAX(size, 2 * lp->row_alloc);
+    lp->head = BOR_REALLOC_ARR(lp->head, int, lp->row_alloc);
+    lp->work = BOR_REALLOC_ARR(lp->work, double, lp->row_alloc);
+    lp->work2 = BOR_REALLOC_ARR(lp->work2, double, lp->row_alloc);
+}
+
+static void setRowBounds(plan_lp_simplex_t *lp, int row,
+                         double rhs, char sense)
+{
+    int var = lp->cols + row;
+
+    if (sense == 'L'){
+        lp->lb[var] = -INF;
+        lp->ub[var] = rhs;
+    }else if (sense == 'G'){
+        lp->lb[var] = rhs;
+        lp->ub[var] = INF;
+    }else{
+        if (sense != 'E')
+            fprintf(stderr, "LP Error: Unkown sense: %c\n", sense);
+        lp->lb[var] = rhs;
+        lp->ub[var] = rhs;
+    }
+}
+
+static void slackBasis(plan_lp_simplex_t *lp)
+{
+    int i;
+
+    for (i = 0; i < lp->cols; ++i){
+        if (lp->status[i] == BASIC)
+            lp->status[i] = AT_LB;
+    }
+    for (i = 0; i < lp->rows; ++i)
+        lp->status[lp->cols + i] = BASIC;
+
+    lp->basis_valid = 1;
+    lp->factor_valid = 0;
+}
+
+
+
+/*** Basis inverse in product form ***/
+static void etaFree(plan_lp_simplex_t *lp)
+{
+    int i;
+
+    for (i = 0; i < lp->eta_size; ++i){
+        if (lp->eta[i].idx)
+            BOR_FREE(lp->eta[i].idx);
+        if (lp->eta[i].val)
+            BOR_FREE(lp->eta[i].val);
+    }
+    lp->eta_size = 0;
+}
+
+/** Appends eta vector corresponding to pivoting column w (=B^-1 a) in
+ *  the position pivot */
+static void etaAdd(plan_lp_simplex_t *lp, int pivot, const double *w)
+{
+    plan_lp_simplex_eta_t *eta;
+    int i, size;
+
+    if (lp->eta_size == lp->eta_alloc){
+        lp->eta_alloc = BOR_MAX(2 * lp->eta_alloc, 16);
+        lp->eta = BOR_REALLOC_ARR(lp->eta, plan_lp_simplex_eta_t,
+                                  lp->eta_alloc);
+    }
+    eta = lp->eta + lp->eta_size++;
+
+    for (size = 0, i = 0; i < lp->rows; ++i){
+        if (i != pivot && fabs(w[i]) > DROP_TOL)
+            ++size;
+    }
+
+    eta->pivot = pivot;
+    eta->pivot_val = w[pivot];
+    eta->size = size;
+    eta->idx = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+    eta->val = BOR_ALLOC_ARR(double, BOR_MAX(size, 1));
+    for (size = 0, i = 0; i < lp->rows; ++i){
+        if (i != pivot && fabs(w[i]) > DROP_TOL){
+            eta->idx[size] = i;
+            eta->val[size] = w[i];
+            ++size;
+        }
+    }
+}
+
+/** v := B^-1 v */
+static void ftran(const plan_lp_simplex_t *lp, double *v)
+{
+    const plan_lp_simplex_eta_t *eta;
+    double vp;
+    int i, k;
+
+    // Initial basis consists of logical variables, i.e., B_0 = -I
+    for (i = 0; i < lp->rows; ++i)
+        v[i] = -v[i];
+
+    for (k = 0; k < lp->eta_size; ++k){
+        eta = lp->eta + k;
+        vp = v[eta->pivot];
+        if (vp == 0.)
+            continue;
+        vp /= eta->pivot_val;
+        v[eta->pivot] = vp;
+        for (i = 0; i < eta->size; ++i)
+            v[eta->idx[i]] -= eta->val[i] * vp;
+    }
+}
+
+/** v := B^-T v */
+static void btran(const plan_lp_simplex_t *lp, double *v)
+{
+    const plan_lp_simplex_eta_t *eta;
+    double vp;
+    int i, k;
+
+    for (k = lp->eta_size - 1; k >= 0; --k){
+        eta = lp->eta + k;
+        vp = v[eta->pivot];
+        for (i = 0; i < eta->size; ++i)
+            vp -= eta->val[i] * v[eta->idx[i]];
+        v[eta->pivot] = vp / eta->pivot_val;
+    }
+
+    for (i = 0; i < lp->rows; ++i)
+        v[i] = -v[i];
+}
+
+/** Loads column of variable var into dense vector v */
+static void loadCol(const plan_lp_simplex_t *lp, int var, double *v)
+{
+    const plan_lp_simplex_col_t *c;
+    int i;
+
+    bzero(v, sizeof(double) * lp->rows);
+    if (var >= lp->cols){
+        v[var - lp->cols] = -1.;
+    }else{
+        c = lp->col + var;
+        for (i = 0; i < c->size; ++i)
+            v[c->row[i]] = c->val[i];
+    }
+}
+
+/** Returns dot product of the column of var and the dense vector v */
+static double dotCol(const plan_lp_simplex_t *lp, int var, const double *v)
+{
+    const plan_lp_simplex_col_t *c;
+    double dot = 0.;
+    int i;
+
+    if (var >= lp->cols)
+        return -v[var - lp->cols];
+
+    c = lp->col + var;
+    for (i = 0; i < c->size; ++i)
+        dot += c->val[i] * v[c->row[i]];
+    return dot;
+}
+
+/** Moves non-basic variable to its bound according to its status */
+static void nonbasicSetValue(plan_lp_simplex_t *lp, int var)
+{
+    double lb = lp->lb[var], ub = lp->ub[var];
+
+    lp->box[var] = 0;
+    if (lp->status[var] == AT_LB && IS_INF(lb))
+        lp->status[var] = (IS_INF(ub) ? FREE : AT_UB);
+    if (lp->status[var] == AT_UB && IS_INF(ub))
+        lp->status[var] = (IS_INF(lb) ? FREE : AT_LB);
+    if (lp->status[var] == FREE && !IS_INF(lb))
+        lp->status[var] = AT_LB;
+    if (lp->status[var] == FREE && !IS_INF(ub))
+        lp->status[var] = AT_UB;
+
+    if (lp->status[var] == AT_LB){
+        lp->x[var] = lb;
+    }else if (lp->status[var] == AT_UB){
+        lp->x[var] = ub;
+    }else{
+        lp->x[var] = 0.;
+    }
+}
+
+static void reinvert(plan_lp_simplex_t *lp)
+{
+    double *w = lp->work;
+    int i, p, var, best;
+    double best_val;
+
+    etaFree(lp);
+
+    // Start with all-logical basis and pivot in basic columns one by one
+    for (i = 0; i < lp->rows; ++i)
+        lp->head[i] = lp->cols + i;
+
+    for (var = 0; var < lp->cols; ++var){
+        if (lp->status[var] != BASIC)
+            continue;
+
+        loadCol(lp, var, w);
+        ftran(lp, w);
+
+        // Replace a logical variable that is not supposed to be basic
+        best = -1;
+        best_val = PIVOT_TOL;
+        for (p = 0; p < lp->rows; ++p){
+            if (lp->head[p] < lp->cols
+                    || lp->status[lp->head[p]] == BASIC)
+                continue;
+            if (fabs(w[p]) > best_val){
+                best = p;
+                best_val = fabs(w[p]);
+            }
+        }
+
+        if (best < 0){
+            // The basis is singular, the column is removed from the basis
+            lp->status[var] = AT_LB;
+            nonbasicSetValue(lp, var);
+            continue;
+        }
+
+        etaAdd(lp, best, w);
+        lp->head[best] = var;
+    }
+
+    // Logical variables not replaced by columns must be basic
+    for (p = 0; p < lp->rows; ++p){
+        var = lp->head[p];
+        if (var >= lp->cols && lp->status[var] != BASIC){
+            lp->status[var] = BASIC;
+            lp->box[var] = 0;
+        }
+    }
+
+    lp->factor_valid = 1;
+}
+
+/** Computes values of basic variables from values of non-basic ones */
+static void computeX(plan_lp_simplex_t *lp)
+{
+    const plan_lp_simplex_col_t *c;
+    double *b = lp->work;
+    int i, var;
+
+    bzero(b, sizeof(double) * lp->rows);
+    for (var = 0; var < lp->cols; ++var){
+        if (lp->status[var] == BASIC || lp->x[var] == 0.)
+            continue;
+        c = lp->col + var;
+        for (i = 0; i < c->size; ++i)
+            b[c->row[i]] -= c->val[i] * lp->x[var];
+    }
+    for (i = 0; i < lp->rows; ++i){
+        var = lp->cols + i;
+        if (lp->status[var] != BASIC)
+            b[i] += lp->x[var];
+    }
+
+    ftran(lp, b);
+    for (i = 0; i < lp->rows; ++i)
+        lp->x[lp->head[i]] = b[i];
+}
+
+_bor_inline double cost(const plan_lp_simplex_t *lp, int var)
+{
+    if (var >= lp->cols)
+        return 0.;
+    return (lp->maximize ? -lp->obj[var] : lp->obj[var]);
+}
+
+/** Computes reduced costs of all variables */
+static void computeDuals(plan_lp_simplex_t *lp)
+{
+    double *y = lp->work;
+    int i, var;
+
+    for (i = 0; i < lp->rows; ++i)
+        y[i] = cost(lp, lp->head[i]);
+    btran(lp, y);
+
+    for (var = 0; var < lp->cols + lp->rows; ++var){
+        if (lp->status[var] == BASIC){
+            lp->d[var] = 0.;
+        }else{
+            lp->d[var] = cost(lp, var) - dotCol(lp, var, y);
+        }
+    }
+}
+
+/** Moves non-basic variables to bounds that make the basis dual feasible,
+ *  missing bounds are replaced by artificial ones. */
+static void makeDualFeasible(plan_lp_simplex_t *lp)
+{
+    int var;
+
+    for (var = 0; var < lp->cols + lp->rows; ++var){
+        if (lp->status[var] == BASIC || lp->lb[var] == lp->ub[var])
+            continue;
+
+        if (lp->d[var] > DUAL_TOL){
+            lp->status[var] = AT_LB;
+            lp->box[var] = IS_INF(lp->lb[var]);
+            lp->x[var] = (lp->box[var] ? -BOX : lp->lb[var]);
+
+        }else if (lp->d[var] < -DUAL_TOL){
+            lp->status[var] = AT_UB;
+            lp->box[var] = IS_INF(lp->ub[var]);
+            lp->x[var] = (lp->box[var] ? BOX : lp->ub[var]);
+        }
+    }
+}
+
+/** Performs pivot: var enters into position p with the value x_enter,
+ *  the leaving variable gets status leave_status and value x_leave.
+ *  w is the pivot column B^-1 a_var and delta is the change of the
+ *  entering variable. Returns true if the basis was re-inverted. */
+static int pivot(plan_lp_simplex_t *lp, int p, int var, const double *w,
+                  double delta, int leave_status, double x_leave)
+{
+    int i, leave = lp->head[p];
+
+    for (i = 0; i < lp->rows; ++i){
+        if (w[i] != 0.)
+            lp->x[lp->head[i]] -= delta * w[i];
+    }
+    lp->x[var] += delta;
+
+    lp->status[leave] = leave_status;
+    lp->x[leave] = x_leave;
+    lp->box[leave] = 0;
+
+    lp->status[var] = BASIC;
+    lp->box[var] = 0;
+    lp->head[p] = var;
+
+    if (lp->eta_size >= REINVERT_FREQ){
+        reinvert(lp);
+        computeX(lp);
+        return 1;
+    }
+
+    etaAdd(lp, p, w);
+    return 0;
+}
+
+/** Dual simplex, returns PLAN_LP_SIMPLEX_* status */
+static int dualSimplex(plan_lp_simplex_t *lp, long *iter, long max_iter)
+{
+    double *rho = lp->work2, *w = lp->work;
+    double viol, best_viol, alpha, dir, ratio, best_ratio, best_alpha;
+    double bound;
+    int p, leave, var, enter, to_lb, reinverted, fresh = 0;
+
+    for (; *iter < max_iter; ++*iter){
+        // Select leaving variable with the largest infeasibility
+        leave = -1;
+        best_viol = PRIMAL_TOL;
+        to_lb = 0;
+        for (p = 0; p < lp->rows; ++p){
+            var = lp->head[p];
+            viol = lp->lb[var] - lp->x[var];
+            if (viol > best_viol){
+                leave = p;
+                best_viol = viol;
+                to_lb = 1;
+            }
+            viol = lp->x[var] - lp->ub[var];
+            if (viol > best_viol){
+                leave = p;
+                best_viol = viol;
+                to_lb = 0;
+            }
+        }
+
+        if (leave < 0)
+            return PLAN_LP_SIMPLEX_OPTIMAL;
+
+        // Compute pivot row
+        bzero(rho, sizeof(double) * lp->rows);
+        rho[leave] = 1.;
+        btran(lp, rho);
+
+        // Ratio test
+        dir = (to_lb ? -1. : 1.);
+        enter = -1;
+        best_ratio = INF;
+        best_alpha = 0.;
+        for (var = 0; var < lp->cols + lp->rows; ++var){
+            if (lp->status[var] == BASIC || lp->lb[var] == lp->ub[var])
+                continue;
+
+            alpha = dotCol(lp, var, rho);
+            if (fabs(alpha) < PIVOT_TOL)
+                continue;
+
+            if (lp->status[var] == AT_LB && dir * alpha <= 0.)
+                continue;
+            if (lp->status[var] == AT_UB && dir * alpha >= 0.)
+                continue;
+
+            ratio = fabs(lp->d[var]) / fabs(alpha);
+            if (ratio < best_ratio - DUAL_TOL
+                    || (ratio < best_ratio + DUAL_TOL
+                            && fabs(alpha) > fabs(best_alpha))){
+                enter = var;
+                best_ratio = ratio;
+                best_alpha = alpha;
+            }
+        }
+
+        if (enter < 0){
+            if (fresh)
+                return PLAN_LP_SIMPLEX_INFEASIBLE;
+
+            // The infeasibility can be an accumulated round-off error, so
+            // re-compute everything from a fresh inverse before giving up
+            reinvert(lp);
+            computeDuals(lp);
+            makeDualFeasible(lp);
+            computeX(lp);
+            fresh = 1;
+            continue;
+        }
+        fresh = 0;
+
+        // Update primal values and the basis
+        loadCol(lp, enter, w);
+        ftran(lp, w);
+        if (fabs(w[leave]) < PIVOT_TOL){
+            // Numerical troubles, start again from a fresh inverse
+            reinvert(lp);
+            computeDuals(lp);
+            makeDualFeasible(lp);
+            computeX(lp);
+            continue;
+        }
+
+        var = lp->head[leave];
+        bound = (to_lb ? lp->lb[var] : lp->ub[var]);
+        reinverted = pivot(lp, leave, enter, w,
+                           (lp->x[var] - bound) / w[leave],
+                           (to_lb ? AT_LB : AT_UB), bound);
+
+        computeDuals(lp);
+        if (reinverted){
+            makeDualFeasible(lp);
+            computeX(lp);
+        }
+    }
+
+    return PLAN_LP_SIMPLEX_ITER_LIMIT;
+}
+
+/** Primal simplex starting from a primal feasible basis */
+static int primalSimplex(plan_lp_simplex_t *lp, long *iter, long max_iter)
+{
+    double *w = lp->work2;
+    double best_d, dir, t, lim, delta;
+    int p, var, enter, leave, leave_status = AT_LB;
+
+    for (; *iter < max_iter; ++*iter){
+        computeDuals(lp);
+
+        // Dantzig's pricing
+        enter = -1;
+        best_d = DUAL_TOL;
+        for (var = 0; var < lp->cols + lp->rows; ++var){
+            if (lp->status[var] == BASIC)
+                continue;
+            if (lp->d[var] < -best_d && lp->x[var] < lp->ub[var] - PRIMAL_TOL){
+                enter = var;
+                best_d = -lp->d[var];
+            }else if (lp->d[var] > best_d
+                        && lp->x[var] > lp->lb[var] + PRIMAL_TOL){
+                enter = var;
+                best_d = lp->d[var];
+            }
+        }
+
+        if (enter < 0)
+            return PLAN_LP_SIMPLEX_OPTIMAL;
+        dir = (lp->d[enter] < 0. ? 1. : -1.);
+
+        loadCol(lp, enter, w);
+        ftran(lp, w);
+
+        // Ratio test, the entering variable itself can reach its bound
+        t = INF;
+        leave = -1;
+        if (dir > 0. && !IS_INF(lp->ub[enter]))
+            t = lp->ub[enter] - lp->x[enter];
+        if (dir < 0. && !IS_INF(lp->lb[enter]))
+            t = lp->x[enter] - lp->lb[enter];
+
+        for (p = 0; p < lp->rows; ++p){
+            if (fabs(w[p]) < PIVOT_TOL)
+                continue;
+            var = lp->head[p];
+            delta = -dir * w[p];
+            if (delta < 0. && !IS_INF(lp->lb[var])){
+                lim = (lp->x[var] - lp->lb[var]) / -delta;
+                if (lim < t){
+                    t = lim;
+                    leave = p;
+                    leave_status = AT_LB;
+                }
+            }else if (delta > 0. && !IS_INF(lp->ub[var])){
+                lim = (lp->ub[var] - lp->x[var]) / delta;
+                if (lim < t){
+                    t = lim;
+                    leave = p;
+                    leave_status = AT_UB;
+                }
+            }
+        }
+
+        if (t >= INF)
+            return PLAN_LP_SIMPLEX_UNBOUNDED;
+        t = BOR_MAX(t, 0.);
+
+        if (leave < 0){
+            // Bound flip of the entering variable
+            for (p = 0; p < lp->rows; ++p)
+                lp->x[lp->head[p]] -= dir * t * w[p];
+            lp->status[enter] = (dir > 0. ? AT_UB : AT_LB);
+            lp->x[enter] = (dir > 0. ? lp->ub[enter] : lp->lb[enter]);
+            continue;
+        }
+
+        var = lp->head[leave];
+        pivot(lp, leave, enter, w, dir * t, leave_status,
+              (leave_status == AT_LB ? lp->lb[var] : lp->ub[var]));
+    }
+
+    return PLAN_LP_SIMPLEX_ITER_LIMIT;
+}
+
+/** Returns true if all basic variables are within their bounds */
+static int isPrimalFeasible(const plan_lp_simplex_t *lp)
+{
+    int p, var;
+
+    for (p = 0; p < lp->rows; ++p){
+        var = lp->head[p];
+        if (lp->x[var] < lp->lb[var] - PRIMAL_TOL
+                || lp->x[var] > lp->ub[var] + PRIMAL_TOL)
+            return 0;
+    }
+    return 1;
+}
+
+int planLPSimplexSolve(plan_lp_simplex_t *lp, double *obj_val)
+{
+    long iter = 0, max_iter;
+    int var, ret, boxed, round;
+
+    if (!lp->basis_valid)
+        slackBasis(lp);
+    if (!lp->factor_valid)
+        reinvert(lp);
+
+    // Bounds could have changed since the last solve
+    for (var = 0; var < lp->cols + lp->rows; ++var){
+        if (lp->status[var] != BASIC)
+            nonbasicSetValue(lp, var);
+    }
+
+    max_iter = 1000L + 50L * (lp->rows + lp->cols);
+    ret = PLAN_LP_SIMPLEX_ITER_LIMIT;
+    for (round = 0; round < 3; ++round){
+        computeDuals(lp);
+        makeDualFeasible(lp);
+        computeX(lp);
+
+        ret = dualSimplex(lp, &iter, max_iter);
+        if (ret != PLAN_LP_SIMPLEX_OPTIMAL)
+            break;
+
+        // Remove artificial bounds, the variables stay on their values and
+        // the primal simplex moves them if it is profitable
+        boxed = 0;
+        for (var = 0; var < lp->cols + lp->rows; ++var){
+            if (lp->status[var] != BASIC && lp->box[var]){
+                lp->box[var] = 0;
+                lp->status[var] = FREE;
+                boxed = 1;
+            }
+        }
+        if (!boxed)
+            break;
+
+        ret = primalSimplex(lp, &iter, max_iter);
+        if (ret != PLAN_LP_SIMPLEX_OPTIMAL || isPrimalFeasible(lp))
+            break;
+
+        // Basis repair during re-inversion broke primal feasibility, so
+        // start again with the dual simplex
+        for (var = 0; var < lp->cols + lp->rows; ++var){
+            if (lp->status[var] != BASIC)
+                nonbasicSetValue(lp, var);
+        }
+    }
+
+    *obj_val = 0.;
+    for (var = 0; var < lp->cols; ++var)
+        *obj_val += lp->obj[var] * lp->x[var];
+    return ret;
+}
+
+/** State of branch and bound */
+struct _bb_t {
+    double best;    /*!< Objective value of the best solution */
+    double *best_x; /*!< The best solution found so far */
+    int found;      /*!< True if some solution was found */
+    long nodes;     /*!< Number of explored nodes */
+    int status;     /*!< PLAN_LP_SIMPLEX_OPTIMAL if no subproblem failed */
+};
+typedef struct _bb_t bb_t;
+
+static void branchAndBound(plan_lp_simplex_t *lp, bb_t *bb)
+{
+    double z, v, frac, best_frac, lb, ub;
+    int var, branch, ret;
+
+    if (bb->status != PLAN_LP_SIMPLEX_OPTIMAL)
+        return;
+    if (++bb->nodes > PLAN_LP_SIMPLEX_MAX_NODES){
+        bb->status = PLAN_LP_SIMPLEX_NODE_LIMIT;
+        return;
+    }
+
+    ret = planLPSimplexSolve(lp, &z);
+    if (ret == PLAN_LP_SIMPLEX_INFEASIBLE)
+        return;
+    if (ret != PLAN_LP_SIMPLEX_OPTIMAL){
+        // Unbounded or unsolved relaxation, nothing can be pruned
+        bb->status = ret;
+        return;
+    }
+
+    if (lp->maximize)
+        z = -z;
+    if (bb->found && z >= bb->best - INT_TOL)
+        return;
+
+    // Branch on the most fractional variable
+    branch = -1;
+    best_frac = INT_TOL;
+    for (var = 0; var < lp->cols; ++var){
+        if (!lp->is_int[var])
+            continue;
+        frac = lp->x[var] - floor(lp->x[var]);
+        frac = BOR_MIN(frac, 1. - frac);
+        if (frac > best_frac){
+            branch = var;
+            best_frac = frac;
+        }
+    }
+
+    if (branch < 0){
+        bb->found = 1;
+        bb->best = z;
+        memcpy(bb->best_x, lp->x, sizeof(double) * lp->cols);
+        return;
+    }
+
+    v = lp->x[branch];
+    lb = lp->lb[branch];
+    ub = lp->ub[branch];
+
+    lp->ub[branch] = floor(v);
+    branchAndBound(lp, bb);
+    lp->ub[branch] = ub;
+
+    lp->lb[branch] = ceil(v);
+    branchAndBound(lp, bb);
+    lp->lb[branch] = lb;
+}
+
+int planLPSimplexSolveILP(plan_lp_simplex_t *lp, double *obj_val)
+{
+    bb_t bb;
+
+    bb.best = 0.;
+    bb.best_x = BOR_ALLOC_ARR(double, BOR_MAX(lp->cols, 1));
+    bb.found = 0;
+    bb.nodes = 0L;
+    bb.status = PLAN_LP_SIMPLEX_OPTIMAL;
+    branchAndBound(lp, &bb);
+
+    *obj_val = 0.;
+    if (bb.found){
+        memcpy(lp->x, bb.best_x, sizeof(double) * lp->cols);
+        *obj_val = (lp->maximize ? -bb.best : bb.best);
+    }
+    BOR_FREE(bb.best_x);
+
+    if (bb.status != PLAN_LP_SIMPLEX_OPTIMAL)
+        return bb.status;
+    if (!bb.found)
+        return PLAN_LP_SIMPLEX_INFEASIBLE;
+    return PLAN_LP_SIMPLEX_OPTIMAL;
+}
+
+static void writeBound(FILE *fout, double v)
+{
+    if (v <= -INF){
+        fprintf(fout, "-inf");
+    }else if (v >= INF){
+        fprintf(fout, "+inf");
+    }else{
+        fprintf(fout, "%.12g", v);
+    }
+}
+
+void planLPSimplexWrite(const plan_lp_simplex_t *lp, FILE *fout)
+{
+    const plan_lp_simplex_col_t *c;
+    int i, j, k, var;
+
+    fprintf(fout, "%s\n obj:", (lp->maximize ? "Maximize" : "Minimize"));
+    for (i = 0; i < lp->cols; ++i){
+        if (lp->obj[i] != 0.)
+            fprintf(fout, " %+.12g x%d", lp->obj[i], i);
+    }
+
+    fprintf(fout, "\nSubject To\n");
+    for (j = 0; j < lp->rows; ++j){
+        var = lp->cols + j;
+        fprintf(fout, " c%d:", j);
+        for (i = 0; i < lp->cols; ++i){
+            c = lp->col + i;
+            for (k = 0; k < c->size; ++k){
+                if (c->row[k] == j)
+                    fprintf(fout, " %+.12g x%d", c->val[k], i);
+            }
+        }
+
+        if (lp->lb[var] == lp->ub[var]){
+            fprintf(fout, " = %.12g\n", lp->lb[var]);
+        }else if (IS_INF(lp->lb[var])){
+            fprintf(fout, " <= %.12g\n", lp->ub[var]);
+        }else{
+            fprintf(fout, " >= %.12g\n", lp->lb[var]);
+        }
+    }
+
+    fprintf(fout, "Bounds\n");
+    for (i = 0; i < lp->cols; ++i){
+        fprintf(fout, " ");
+        writeBound(fout, lp->lb[i]);
+        fprintf(fout, " <= x%d <= ", i);
+        writeBound(fout, lp->ub[i]);
+        fprintf(fout, "\n");
+    }
+
+    for (k = 0, i = 0; i < lp->cols; ++i){
+        if (!lp->is_int[i])
+            continue;
+        if (k++ == 0)
+            fprintf(fout, "General\n");
+        fprintf(fout, " x%d\n", i);
+    }
+    fprintf(fout, "End\n");
+}
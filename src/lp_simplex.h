@@ -0,0 +1,214 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2015 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#ifndef __PLAN_LP_SIMPLEX_H__
+#define __PLAN_LP_SIMPLEX_H__
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Built-in LP solver
+ * ===================
+ *
+ * Bounded revised simplex method working on the model
+ *      min/max c^T x  s.t.  A x - r = 0,  lb <= (x, r) <= ub
+ * where x are structural variables (columns) and r are logical variables,
+ * one for each row, whose bounds encode the right hand side and the sense
+ * of the row. The matrix A is stored column-wise in sparse form and the
+ * inverse of the basis is kept in the product form (eta file) starting
+ * from the all-logical basis.
+ *
+ * The problem is solved by the dual simplex method, variables without the
+ * bound needed for the dual feasibility of the basis are temporarily
+ * boxed by artificial bounds which are then removed and the solution is
+ * finished by the primal simplex. Since the basis is kept between solves,
+ * the problems that differ only in bounds or right hand sides are usually
+ * re-solved in a few iterations.
+ */
+
+/** Status of a variable -- the same values as CPLEX uses */
+#define PLAN_LP_SIMPLEX_AT_LB 0
+#define PLAN_LP_SIMPLEX_BASIC 1
+#define PLAN_LP_SIMPLEX_AT_UB 2
+#define PLAN_LP_SIMPLEX_FREE  3
+
+/** Values of bounds with greater absolute value are considered infinite */
+#define PLAN_LP_SIMPLEX_INF 1E20
+
+/** Return values of planLPSimplexSolve() and planLPSimplexSolveILP() */
+#define PLAN_LP_SIMPLEX_OPTIMAL    0
+#define PLAN_LP_SIMPLEX_INFEASIBLE 1
+#define PLAN_LP_SIMPLEX_UNBOUNDED  2
+#define PLAN_LP_SIMPLEX_ITER_LIMIT 3
+#define PLAN_LP_SIMPLEX_NODE_LIMIT 4
+
+/** Maximal number of nodes explored by branch and bound */
+#define PLAN_LP_SIMPLEX_MAX_NODES 100000L
+
+/**
+ * Sparse column of the matrix
+ */
+struct _plan_lp_simplex_col_t {
+    int size;
+    int alloc;
+    int *row;    /*!< Row indexes */
+    double *val; /*!< Non-zero coefficients */
+};
+typedef struct _plan_lp_simplex_col_t plan_lp_simplex_col_t;
+
+/**
+ * Elementary transformation of the basis inverse
+ */
+struct _plan_lp_simplex_eta_t {
+    int pivot;        /*!< Position of the pivot */
+    double pivot_val; /*!< Value of the pivot */
+    int size;         /*!< Number of off-pivot elements */
+    int *idx;         /*!< Positions of off-pivot elements */
+    double *val;      /*!< Values of off-pivot elements */
+};
+typedef struct _plan_lp_simplex_eta_t plan_lp_simplex_eta_t;
+
+struct _plan_lp_simplex_t {
+    int rows;     /*!< Number of rows */
+    int cols;     /*!< Number of columns */
+    int maximize; /*!< True if the objective is maximized */
+    double *obj;  /*!< Objective coefficients of columns */
+    int *is_int;  /*!< Integrality flag of each column */
+    plan_lp_simplex_col_t *col; /*!< Columns of the matrix */
+
+    /** Bounds, statuses and values of all variables: columns first, then
+     *  logical variables of rows. */
+    double *lb;
+    double *ub;
+    int *status;
+    double *x;
+    double *d;    /*!< Reduced costs */
+    int *box;     /*!< True if the variable is at an artificial bound */
+    int var_alloc;
+
+    int *head;    /*!< Basic variable in each position of the basis */
+    int basis_valid;  /*!< True if .status describes a valid basis */
+    int factor_valid; /*!< True if the eta file represents .head */
+    plan_lp_simplex_eta_t *eta;
+    int eta_size;
+    int eta_alloc;
+
+    double *work; /*!< Work arrays of .rows elements */
+    double *work2;
+    int row_alloc;
+};
+typedef struct _plan_lp_simplex_t plan_lp_simplex_t;
+
+/**
+ * Initializes the model with all coefficients set to zero, columns
+ * bounded from below by zero and rows set to "= 0".
+ */
+void planLPSimplexInit(plan_lp_simplex_t *lp, int rows, int cols,
+                       int maximize);
+
+/**
+ * Frees allocated resources.
+ */
+void planLPSimplexFree(plan_lp_simplex_t *lp);
+
+/**
+ * Sets objective coefficient of the column.
+ */
+void planLPSimplexSetObj(plan_lp_simplex_t *lp, int col, double coef);
+
+/**
+ * Sets bounds of the column.
+ */
+void planLPSimplexSetVarRange(plan_lp_simplex_t *lp, int col,
+                              double lb, double ub);
+
+/**
+ * Marks the column as integer.
+ */
+void planLPSimplexSetVarInt(plan_lp_simplex_t *lp, int col);
+
+/**
+ * Sets coefficient of the matrix.
+ */
+void planLPSimplexSetCoef(plan_lp_simplex_t *lp, int row, int col,
+                          double coef);
+
+/**
+ * Sets right hand side and sense ('L', 'G', 'E') of the row.
+ */
+void planLPSimplexSetRHS(plan_lp_simplex_t *lp, int row,
+                         double rhs, char sense);
+
+/**
+ * Appends cnt empty rows, rhs and sense may be NULL in which case "= 0" is
+ * used.
+ */
+void planLPSimplexAddRows(plan_lp_simplex_t *lp, int cnt,
+                          const double *rhs, const char *sense);
+
+/**
+ * Deletes rows begin, ..., end.
+ */
+void planLPSimplexDelRows(plan_lp_simplex_t *lp, int begin, int end);
+
+/**
+ * Stores statuses of columns followed by statuses of rows' logical
+ * variables (cols + rows elements).
+ * Returns -1 if there is no basis.
+ */
+int planLPSimplexGetBasis(const plan_lp_simplex_t *lp, int *basis);
+
+/**
+ * Sets basis in the same format as planLPSimplexGetBasis() returns.
+ * Invalid bases (with a wrong number of basic variables) are ignored.
+ */
+void planLPSimplexSetBasis(plan_lp_simplex_t *lp, const int *basis);
+
+/**
+ * Solves the LP relaxation of the problem.
+ * Returns one of PLAN_LP_SIMPLEX_* return values and the objective value
+ * via obj_val.
+ */
+int planLPSimplexSolve(plan_lp_simplex_t *lp, double *obj_val);
+
+/**
+ * Solves the problem with integrality constraints by branch and bound.
+ * PLAN_LP_SIMPLEX_OPTIMAL is returned only if the optimality of the
+ * solution was proved. If the LP relaxation of some node could not be
+ * solved or the search reached PLAN_LP_SIMPLEX_MAX_NODES nodes,
+ * PLAN_LP_SIMPLEX_ITER_LIMIT or PLAN_LP_SIMPLEX_NODE_LIMIT is returned,
+ * respectively, and the problem is not known to be infeasible even if no
+ * solution was found.
+ */
+int planLPSimplexSolveILP(plan_lp_simplex_t *lp, double *obj_val);
+
+/**
+ * Writes the problem in CPLEX LP format.
+ */
+void planLPSimplexWrite(const plan_lp_simplex_t *lp, FILE *fout);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* __PLAN_LP_SIMPLEX_H__ */
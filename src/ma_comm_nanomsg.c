@@ -20,6 +20,7 @@
 #include <nanomsg/nn.h>
 #include <nanomsg/pipeline.h>
 #include <boruvka/alloc.h>
+#include <boruvka/timer.h>
 #include "plan/ma_comm.h"
 
 static plan_ma_comm_t *nanomsgNew(int agent_id, int agent_size, char **urls)
@@ -30,6 +31,9 @@ static plan_ma_comm_t *nanomsgNew(int agent_id, int agent_size, char **urls)
     comm = BOR_ALLOC(plan_ma_comm_t);
     comm->node_id = agent_id;
     comm->node_size = agent_size;
+    comm->msg_sent = 0L;
+    comm->msg_recv = 0L;
+    comm->recv_block_time = 0.;
 
     comm->recv_sock = nn_socket(AF_SP, NN_PULL);
     if (comm->recv_sock < 0){
@@ -157,6 +161,8 @@ int planMACommSendToNode(plan_ma_comm_t *comm, int node_id,
         fprintf(stderr, "Error Nanomsg[%d]: Could not setnd message to %d: %s\n",
                 comm->node_id, node_id, nn_strerror(errno));
         ret = -1;
+    }else{
+        ++comm->msg_sent;
     }
 
     if (buf)
@@ -174,6 +180,7 @@ static plan_ma_msg_t *recv(plan_ma_comm_t *comm, int flag)
     if (recv_count > 0){
         msg = planMAMsgUnpacked(buf, recv_count);
         nn_freemsg(buf);
+        ++comm->msg_recv;
 
     }else if (recv_count == 0){
         fprintf(stderr, "Error Nanomsg[%d]: Received zero-sized message.",
@@ -234,7 +241,17 @@ static plan_ma_msg_t *recvTimeout(plan_ma_comm_t *comm, int timeout)
 
 plan_ma_msg_t *planMACommRecvBlock(plan_ma_comm_t *comm, int timeout_in_ms)
 {
-    if (timeout_in_ms <= 0)
-        return recvBlock(comm);
-    return recvTimeout(comm, timeout_in_ms);
+    plan_ma_msg_t *msg;
+    bor_timer_t timer;
+
+    borTimerStart(&timer);
+    if (timeout_in_ms <= 0){
+        msg = recvBlock(comm);
+    }else{
+        msg = recvTimeout(comm, timeout_in_ms);
+    }
+    borTimerStop(&timer);
+    comm->recv_block_time += borTimerElapsedInSF(&timer);
+
+    return msg;
 }
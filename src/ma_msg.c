@@ -113,6 +113,10 @@ struct _plan_ma_msg_t {
     int op_size;
 
     plan_ma_msg_pot_t pot;
+    int32_t heur_state_id;
+    int64_t term_counter;
+    int32_t term_black;
+    int32_t heur_state_agent;
 };
 
 PLAN_MSG_SCHEMA_BEGIN(schema_pot_submatrix)
@@ -209,6 +213,10 @@ PLAN_MSG_SCHEMA_ADD_MSG(plan_ma_msg_t, dtg_req, &schema_dtg_req)
 PLAN_MSG_SCHEMA_ADD(plan_ma_msg_t, search_res, INT32)
 PLAN_MSG_SCHEMA_ADD_MSG_ARR(plan_ma_msg_t, op, op_size, &schema_op)
 PLAN_MSG_SCHEMA_ADD_MSG(plan_ma_msg_t, pot, &schema_pot)
+PLAN_MSG_SCHEMA_ADD(plan_ma_msg_t, heur_state_id, INT32)
+PLAN_MSG_SCHEMA_ADD(plan_ma_msg_t, term_counter, INT64)
+PLAN_MSG_SCHEMA_ADD(plan_ma_msg_t, term_black, INT32)
+PLAN_MSG_SCHEMA_ADD(plan_ma_msg_t, heur_state_agent, INT32)
 PLAN_MSG_SCHEMA_END(schema_msg, plan_ma_msg_t, header)
 #define M_type                 0x000001u
 #define M_agent_id             0x000002u
@@ -234,6 +242,10 @@ PLAN_MSG_SCHEMA_END(schema_msg, plan_ma_msg_t, header)
 
 #define M_op                   0x080000u
 #define M_pot                  0x100000u
+#define M_heur_state_id        0x200000u
+#define M_term_counter         0x400000u
+#define M_term_black           0x800000u
+#define M_heur_state_agent     0x1000000u
 
 
 #define SET_VAL(msg, member, val) \
@@ -531,7 +543,11 @@ int planMAMsgHeurRequestedAgent(const plan_ma_msg_t *msg, int i)
 }
 
 GETTER_SETTER(HeurCost, heur_cost, int)
+GETTER_SETTER(HeurStateId, heur_state_id, plan_state_id_t)
+GETTER_SETTER(HeurStateAgent, heur_state_agent, int)
 GETTER_SETTER(SearchRes, search_res, int)
+GETTER_SETTER(TermCounter, term_counter, long)
+GETTER_SETTER(TermBlack, term_black, int)
 
 
 
@@ -15,6 +15,8 @@
  * See the License for more information.
  */
 
+#include <stdio.h>
+#include <string.h>
 #include <boruvka/alloc.h>
 
 #include "plan/ma_search.h"
@@ -22,9 +24,6 @@
 
 #include "ma_snapshot.h"
 
-/** Timeout before dead-end verification is started */
-#define DEAD_END_BLOCK_TIME 1000 // 1 second
-
 struct _term_t {
     int is_initiator;
     int initiator_id;
@@ -39,6 +38,36 @@ struct _term_t {
 };
 typedef struct _term_t term_t;
 
+/** Detection of a global dead-end, i.e., all agents are idle and there are
+ *  no messages in transit (Safra's termination detection algorithm).
+ *  Agent 0 starts a probe whenever it becomes idle and the token travels
+ *  around the ring. Each agent passes the token only when it is idle and
+ *  adds its counter of messages (sent - received) to it. The token is
+ *  marked "black" if the agent received a message since the last time the
+ *  token passed through it. The global dead-end is detected when the token
+ *  returns white to agent 0 and the sum of counters is zero. */
+struct _dead_end_t {
+    int has_token;      /*!< True if the agent holds the token */
+    long token_counter; /*!< Counter carried by the held token */
+    int token_black;    /*!< Color of the held token */
+    int probe;          /*!< True if agent 0 sent the token around */
+    long token_sent;    /*!< Number of sent token messages */
+    long token_recv;    /*!< Number of received token messages */
+    long last_recv;     /*!< Number of received messages (without
+                             tokens) when the token left the agent */
+};
+typedef struct _dead_end_t dead_end_t;
+
+/** Heuristic evaluation that waits for responses from other agents */
+struct _heur_pending_t {
+    plan_state_id_t state_id; /*!< Evaluated state or PLAN_NO_STATE if
+                                   the slot is free */
+    plan_heur_res_t res;      /*!< Result passed to the heuristic */
+    plan_cost_t heur;         /*!< Lower bound on heuristic received with
+                                   public states in the meantime */
+};
+typedef struct _heur_pending_t heur_pending_t;
+
 /** Main mutli-agent search structure. */
 struct _plan_ma_search_t {
     plan_search_t *search;
@@ -53,11 +82,28 @@ struct _plan_ma_search_t {
     int res; /*!< Result of search */
     plan_state_id_t goal;
     plan_cost_t goal_cost;
-    int blocked;
     int terminate;
     term_t term;
+    dead_end_t dead_end;
 
     plan_heur_t *heur;
+    int heur_pipeline;             /*!< Max. number of evaluations in
+                                        flight, 0 if pipelining is off */
+    heur_pending_t *heur_pending;  /*!< Evaluations in flight */
+    int heur_pending_size;         /*!< Number of evaluations in flight */
+
+    const plan_op_t *op;       /*!< Operators referenced by nodes */
+    int op_size;               /*!< Number of operators */
+    char *checkpoint;          /*!< Path prefix of checkpoint files or
+                                    NULL */
+    char *restore;             /*!< Path prefix of the checkpoint to restore
+                                    from or NULL */
+    long checkpoint_token;     /*!< Token of the last committed checkpoint
+                                    or -1 */
+    float checkpoint_interval; /*!< Seconds between checkpoints */
+    bor_timer_t checkpoint_timer; /*!< Time since the last checkpoint */
+    int checkpoint_running;    /*!< True if initiated checkpoint is not
+                                    finished yet */
 };
 
 /** Reference data for the received public states */
@@ -77,11 +123,36 @@ static void searchMAHeur(plan_search_t *search, plan_heur_t *heur,
                          plan_state_id_t state_id, plan_heur_res_t *res,
                          void *userdata);
 static void processMsg(plan_ma_search_t *ma, plan_ma_msg_t *msg);
+
+/** Returns pending evaluation of the specified state or NULL */
+static heur_pending_t *heurPendingFind(plan_ma_search_t *ma,
+                                       plan_state_id_t state_id);
+/** Registers a new pending evaluation */
+static void heurPendingAdd(plan_ma_search_t *ma, plan_state_id_t state_id,
+                           const plan_heur_res_t *res);
+/** Returns true if the heur response belongs to the evaluation of the
+ *  local state state_id. */
+static int heurMsgIsState(const plan_ma_search_t *ma,
+                          const plan_ma_msg_t *msg,
+                          plan_state_id_t state_id);
+/** Passes the heur response to the corresponding pending evaluation and
+ *  inserts the node into open-list once the heuristic value is known.
+ *  Responses that do not belong to any pending evaluation are passed
+ *  directly to the heuristic. */
+static void heurPendingUpdate(plan_ma_search_t *ma, plan_ma_msg_t *msg);
+/** Returns the lowest cost of nodes with pending evaluation */
+static plan_cost_t heurPendingLowestCost(const plan_ma_search_t *ma);
 static void publicStateSend(plan_ma_search_t *ma,
                             plan_state_space_node_t *node);
 static void publicStateRecv(plan_ma_search_t *ma,
                             plan_ma_msg_t *msg);
 
+/** Passes the dead-end detection token if held, must be called only when
+ *  the agent is idle. */
+static void deadEndIdle(plan_ma_search_t *ma);
+/** Process DEAD_END token message */
+static void deadEndTokenRecv(plan_ma_search_t *ma, plan_ma_msg_t *msg);
+
 /** Starts termination schema */
 static void terminate(plan_ma_search_t *ma);
 /** Process TERMINATE message */
@@ -146,30 +217,88 @@ static int solutionVerifyMarkFinalize(plan_ma_snapshot_t *s);
 static void solutionVerifyResponseFinalize(plan_ma_snapshot_t *s);
 
 
-/** Struct for verification of global dead end using distributed snapshot */
-struct _dead_end_verify_t {
+/** Checkpoint object -- a consistent global snapshot of the search
+ *  written to disk. Each agent writes its state pool with the
+ *  corresponding state space nodes when it learns about the checkpoint
+ *  (before it processes any later message) and then it records public
+ *  states received from each agent until the mark message from that agent
+ *  arrives, i.e., the public states that were in transit.
+ *  Files of all agents are named by the token of the checkpoint and the
+ *  checkpoint is committed by agent 0 writing the manifest with the token
+ *  once all agents acknowledged that their files are complete. */
+struct _checkpoint_t {
     plan_ma_snapshot_t snapshot;
     plan_ma_search_t *ma;
     plan_ma_msg_t *init_msg;
-    int ack;
+    FILE *fout;           /*!< Opened checkpoint file */
+    char *fn;             /*!< Name of the checkpoint file */
+    plan_ma_msg_t **msg;  /*!< Public states in transit */
+    int msg_size;
+    int msg_alloc;
+    int ack;              /*!< False if writing of the checkpoint failed */
 };
-typedef struct _dead_end_verify_t dead_end_verify_t;
-
-#define DEAD_END_VERIFY(s) bor_container_of((s), dead_end_verify_t, snapshot)
-
-/** Starts verification of global dead end */
-static void deadEndVerify(plan_ma_search_t *ma);
-static dead_end_verify_t *deadEndVerifyNew(plan_ma_search_t *ma,
-                                           plan_ma_msg_t *msg,
-                                           int initiator);
-static void deadEndVerifyDel(plan_ma_snapshot_t *s);
-static void deadEndVerifyResponse(plan_ma_snapshot_t *s, plan_ma_msg_t *msg);
-static void deadEndVerifyInitMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg);
-static void deadEndVerifyMarkMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg);
-static int deadEndVerifyMarkFinalize(plan_ma_snapshot_t *s);
-static void deadEndVerifyResponseFinalize(plan_ma_snapshot_t *s);
-
+typedef struct _checkpoint_t checkpoint_t;
+
+#define CHECKPOINT(s) bor_container_of((s), checkpoint_t, snapshot)
+#define CHECKPOINT_MAGIC "MAPLCKP1"
+#define CHECKPOINT_END   "MAPLCKPE"
+#define CHECKPOINT_MANIFEST_MAGIC "MAPLCKPM"
+
+/** Header of the checkpoint file */
+struct _checkpoint_header_t {
+    char magic[8];
+    int32_t agent_id;
+    int32_t agent_size;
+    int64_t token;
+    int32_t op_size;
+    int32_t bufsize;    /*!< Size of packed state */
+    int64_t num_states;
+};
+typedef struct _checkpoint_header_t checkpoint_header_t;
+
+/** Stored state space node, each one follows the packed state */
+struct _checkpoint_node_t {
+    int32_t parent_state_id;
+    int32_t op;         /*!< Index of operator or -1 */
+    int32_t cost;
+    int32_t heuristic;
+    int32_t status;     /*!< 0 -- new, 1 -- open, 2 -- closed */
+    int32_t pub_agent_id;
+    int32_t pub_state_id;
+};
+typedef struct _checkpoint_node_t checkpoint_node_t;
 
+/** Manifest naming the last committed checkpoint */
+struct _checkpoint_manifest_t {
+    char magic[8];
+    int32_t agent_size;
+    int64_t token;
+};
+typedef struct _checkpoint_manifest_t checkpoint_manifest_t;
+
+/** Starts a new checkpoint */
+static void checkpoint(plan_ma_search_t *ma);
+static checkpoint_t *checkpointNew(plan_ma_search_t *ma,
+                                   plan_ma_msg_t *msg,
+                                   int initiator);
+static void checkpointDel(plan_ma_snapshot_t *s);
+static void checkpointUpdate(plan_ma_snapshot_t *s, plan_ma_msg_t *msg);
+static void checkpointInitMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg);
+static void checkpointResponseMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg);
+static int checkpointMarkFinalize(plan_ma_snapshot_t *s);
+static void checkpointResponseFinalize(plan_ma_snapshot_t *s);
+/** Writes the manifest naming the checkpoint with the specified token.
+ *  Returns 0 on success, -1 otherwise. */
+static int checkpointCommit(plan_ma_search_t *ma, long token);
+/** Removes files of all agents belonging to the specified checkpoint */
+static void checkpointRemove(plan_ma_search_t *ma, long token);
+/** Restores the search from the committed checkpoint with the specified
+ *  path prefix. Returns 0 on success, -1 otherwise. */
+static int checkpointRestore(plan_ma_search_t *ma, const char *prefix);
+/** Reads the token of the committed checkpoint from the manifest.
+ *  Returns 0 on success, -1 otherwise. */
+static int checkpointRestoreManifest(plan_ma_search_t *ma,
+                                     const char *prefix, long *token);
 
 
 void planMASearchParamsInit(plan_ma_search_params_t *params)
@@ -177,10 +306,28 @@ void planMASearchParamsInit(plan_ma_search_params_t *params)
     bzero(params, sizeof(*params));
 }
 
+/** Returns a newly allocated name of the file of the specified agent's
+ *  part of the checkpoint, or name of the manifest if agent_id is -1. */
+static char *checkpointFilename(const char *prefix, long token, int agent_id)
+{
+    char *fn;
+    int size;
+
+    size = strlen(prefix) + 48;
+    fn = BOR_ALLOC_ARR(char, size);
+    if (agent_id < 0){
+        snprintf(fn, size, "%s.manifest", prefix);
+    }else{
+        snprintf(fn, size, "%s.%ld.%d", prefix, token, agent_id);
+    }
+    return fn;
+}
+
 plan_ma_search_t *planMASearchNew(plan_ma_search_params_t *params)
 {
     plan_ma_search_t *ma_search;
     pub_state_data_t msg_init;
+    int i;
 
     ma_search = BOR_ALLOC(plan_ma_search_t);
     ma_search->search = params->search;
@@ -201,17 +348,46 @@ plan_ma_search_t *planMASearchNew(plan_ma_search_params_t *params)
     ma_search->res = -1;
     ma_search->goal = PLAN_NO_STATE;
     ma_search->goal_cost = PLAN_COST_MAX;
-    ma_search->blocked = 0;
     ma_search->terminate = 0;
     ma_search->term.is_initiator = 0;
     ma_search->term.initiator_id = INT_MAX;
+    bzero(&ma_search->dead_end, sizeof(ma_search->dead_end));
 
     ma_search->heur = NULL;
+    ma_search->heur_pipeline = 0;
+    ma_search->heur_pending = NULL;
+    ma_search->heur_pending_size = 0;
     if (ma_search->search->heur->ma){
         ma_search->heur = ma_search->search->heur;
         planHeurMAInit(ma_search->heur, ma_search->comm->node_size,
                        ma_search->comm->node_id, ma_search->ma_state);
+
+        if (ma_search->heur->ma_pipeline && params->heur_pipeline > 1){
+            ma_search->heur_pipeline = params->heur_pipeline;
+            ma_search->heur_pending = BOR_ALLOC_ARR(heur_pending_t,
+                                                    params->heur_pipeline);
+            for (i = 0; i < params->heur_pipeline; ++i)
+                ma_search->heur_pending[i].state_id = PLAN_NO_STATE;
+        }
+    }
+
+    ma_search->op = NULL;
+    ma_search->op_size = 0;
+    if (params->prob != NULL){
+        ma_search->op = params->prob->op;
+        ma_search->op_size = params->prob->op_size;
+    }
+    ma_search->checkpoint = NULL;
+    ma_search->restore = NULL;
+    ma_search->checkpoint_token = -1;
+    ma_search->checkpoint_interval = 0;
+    ma_search->checkpoint_running = 0;
+    if (params->checkpoint != NULL){
+        ma_search->checkpoint = BOR_STRDUP(params->checkpoint);
+        ma_search->checkpoint_interval = params->checkpoint_interval;
     }
+    if (params->restore != NULL)
+        ma_search->restore = BOR_STRDUP(params->restore);
 
     return ma_search;
 }
@@ -221,6 +397,12 @@ void planMASearchDel(plan_ma_search_t *ma_search)
     planMAStateDel(ma_search->ma_state);
     planMASnapshotRegFree(&ma_search->snapshot);
     planPathFree(&ma_search->path);
+    if (ma_search->heur_pending)
+        BOR_FREE(ma_search->heur_pending);
+    if (ma_search->checkpoint)
+        BOR_FREE(ma_search->checkpoint);
+    if (ma_search->restore)
+        BOR_FREE(ma_search->restore);
     BOR_FREE(ma_search);
 }
 
@@ -233,6 +415,24 @@ int planMASearchRun(plan_ma_search_t *ma, plan_path_t *path)
     planSearchSetReachedGoal(ma->search, searchReachedGoal, ma);
     planSearchSetMAHeur(ma->search, searchMAHeur, ma);
 
+    if (ma->restore != NULL
+            && checkpointRestore(ma, ma->restore) != 0){
+        fprintf(stderr, "[%d] MASearch Error: Could not restore search"
+                        " from checkpoint `%s'.\n",
+                ma->comm->node_id, ma->restore);
+        ma->res = PLAN_SEARCH_ABORT;
+        terminate(ma);
+    }
+
+    // Agent 0 must know the checkpoint already committed under the same
+    // prefix so that it never overwrites it.
+    if (ma->checkpoint != NULL && ma->comm->node_id == 0
+            && checkpointRestoreManifest(ma, ma->checkpoint,
+                                         &ma->checkpoint_token) != 0){
+        ma->checkpoint_token = -1;
+    }
+    borTimerStart(&ma->checkpoint_timer);
+
     planPathInit(&dummy_path);
     planSearchRun(ma->search, &dummy_path);
     planPathFree(&dummy_path);
@@ -255,6 +455,10 @@ static int searchPostStep(plan_search_t *search, int res, void *ud)
 {
     plan_ma_search_t *ma = ud;
     plan_ma_msg_t *msg = NULL;
+    int timeout;
+
+    search->stat.ma_private_parts = planMAStatePrivatePartSize(ma->ma_state);
+    search->stat.ma_private_mem = planMAStatePrivateMemUsage(ma->ma_state);
 
     if (res == PLAN_SEARCH_FOUND){
         res = PLAN_SEARCH_CONT;
@@ -263,19 +467,35 @@ static int searchPostStep(plan_search_t *search, int res, void *ud)
         // Initialize termination of a whole cluster
         terminate(ma);
 
+    }else if (res == PLAN_SEARCH_NOT_FOUND && ma->heur_pending_size > 0){
+        // The open-list is empty, but some states still wait for their
+        // heuristic value, so the agent is not idle. Wait for the next
+        // message.
+        msg = planMACommRecvBlock(ma->comm, 0);
+        if (msg != NULL){
+            processMsg(ma, msg);
+            planMAMsgDel(msg);
+        }
+        res = PLAN_SEARCH_CONT;
+
     }else if (res == PLAN_SEARCH_NOT_FOUND){
-        // Block until some message unblocks the process
-        ma->blocked = 1;
-        msg = planMACommRecvBlock(ma->comm, DEAD_END_BLOCK_TIME);
-        while (msg == NULL){
-            if (ma->comm->node_id == 0)
-                deadEndVerify(ma);
-            msg = planMACommRecvBlock(ma->comm, DEAD_END_BLOCK_TIME);
+        // The agent is idle, so pass the dead-end detection token and
+        // block until some message wakes up the process
+        deadEndIdle(ma);
+        if (!ma->terminate){
+            // The initiator of checkpoints must wake up regularly
+            timeout = 0;
+            if (ma->checkpoint_interval > 0 && ma->comm->node_id == 0){
+                timeout = BOR_MIN(1000, ma->checkpoint_interval * 1000);
+                timeout = BOR_MAX(timeout, 1);
+            }
+            msg = planMACommRecvBlock(ma->comm, timeout);
+            if (msg != NULL){
+                processMsg(ma, msg);
+                planMAMsgDel(msg);
+            }
         }
-        processMsg(ma, msg);
-        planMAMsgDel(msg);
         res = PLAN_SEARCH_CONT;
-        ma->blocked = 0;
     }
 
     // Process all messages -- non-blocking
@@ -284,6 +504,19 @@ static int searchPostStep(plan_search_t *search, int res, void *ud)
         planMAMsgDel(msg);
     }
 
+    // Agent 0 periodically initiates checkpoints
+    if (ma->checkpoint_interval > 0
+            && ma->comm->node_id == 0
+            && !ma->terminate
+            && !ma->checkpoint_running){
+        borTimerStop(&ma->checkpoint_timer);
+        if (borTimerElapsedInSF(&ma->checkpoint_timer)
+                >= ma->checkpoint_interval){
+            checkpoint(ma);
+            borTimerStart(&ma->checkpoint_timer);
+        }
+    }
+
     // If we are in termination process, ignore all messages except
     // terminate messages
     while (ma->terminate == 1 && (msg = planMACommRecvBlock(ma->comm, -1)) != NULL){
@@ -346,11 +579,51 @@ static void searchMAHeur(plan_search_t *search, plan_heur_t *heur,
         return;
     }
 
+    // Preferred operators are needed right away, so only plain
+    // heuristic values can be pipelined.
+    if (ma->heur_pipeline > 0 && res->pref_op == NULL){
+        // The state is already being evaluated
+        if (heurPendingFind(ma, state_id) != NULL){
+            res->heur = PLAN_HEUR_DEAD_END;
+            return;
+        }
+
+        // Wait for a free slot
+        while (ma->heur_pending_size == ma->heur_pipeline
+                && !ma->terminate
+                && (msg = planMACommRecvBlock(ma->comm, 0)) != NULL){
+            processMsg(ma, msg);
+            planMAMsgDel(msg);
+        }
+
+        if (ma->terminate){
+            res->heur = PLAN_HEUR_DEAD_END;
+            return;
+        }
+
+        ret = planHeurMANode(heur, ma->comm, state_id, search, res);
+        if (ret == 0)
+            return;
+
+        // Responses from other agents will be processed later, until
+        // then the state is kept aside (see heurPendingUpdate()) and the
+        // search continues with other states.
+        heurPendingAdd(ma, state_id, res);
+        res->heur = PLAN_HEUR_DEAD_END;
+        return;
+    }
+
     ret = planHeurMANode(heur, ma->comm, state_id, search, res);
     while (ret == -1
             && !ma->terminate
             && (msg = planMACommRecvBlock(ma->comm, 0)) != NULL){
         if (planMAMsgType(msg) == PLAN_MA_MSG_HEUR
+                && planMAMsgHeurType(msg) == PLAN_MA_MSG_HEUR_UPDATE
+                && ma->heur_pipeline > 0
+                && !heurMsgIsState(ma, msg, state_id)){
+            heurPendingUpdate(ma, msg);
+
+        }else if (planMAMsgType(msg) == PLAN_MA_MSG_HEUR
                 && planMAMsgHeurType(msg) == PLAN_MA_MSG_HEUR_UPDATE){
             ret = planHeurMAUpdate(ma->heur, ma->comm, msg, res);
         }else{
@@ -360,13 +633,103 @@ static void searchMAHeur(plan_search_t *search, plan_heur_t *heur,
     }
 }
 
+static heur_pending_t *heurPendingFind(plan_ma_search_t *ma,
+                                       plan_state_id_t state_id)
+{
+    int i;
+
+    if (ma->heur_pending_size == 0)
+        return NULL;
+
+    for (i = 0; i < ma->heur_pipeline; ++i){
+        if (ma->heur_pending[i].state_id == state_id)
+            return ma->heur_pending + i;
+    }
+    return NULL;
+}
+
+static void heurPendingAdd(plan_ma_search_t *ma, plan_state_id_t state_id,
+                           const plan_heur_res_t *res)
+{
+    heur_pending_t *pend;
+    int i;
+
+    for (i = 0; ma->heur_pending[i].state_id != PLAN_NO_STATE; ++i);
+    pend = ma->heur_pending + i;
+    pend->state_id = state_id;
+    pend->res = *res;
+    pend->heur = -1;
+    ++ma->heur_pending_size;
+}
+
+static int heurMsgIsState(const plan_ma_search_t *ma,
+                          const plan_ma_msg_t *msg,
+                          plan_state_id_t state_id)
+{
+    return planMAMsgHeurStateAgent(msg) == ma->comm->node_id
+            && planMAMsgHeurStateId(msg) == state_id;
+}
+
+static void heurPendingUpdate(plan_ma_search_t *ma, plan_ma_msg_t *msg)
+{
+    heur_pending_t *pend = NULL;
+    plan_state_space_node_t *node;
+    plan_heur_res_t res;
+    plan_cost_t heur;
+
+    if (planMAMsgHeurStateAgent(msg) == ma->comm->node_id)
+        pend = heurPendingFind(ma, planMAMsgHeurStateId(msg));
+
+    if (pend == NULL){
+        // The response belongs either to a request relayed on behalf of
+        // other agent or to an evaluation that was already finished
+        // (e.g., ma-ff found a dead-end before all responses arrived).
+        // Either way, the heuristic knows what to do with it.
+        planHeurResInit(&res);
+        planHeurMAUpdate(ma->heur, ma->comm, msg, &res);
+        return;
+    }
+
+    if (planHeurMAUpdate(ma->heur, ma->comm, msg, &pend->res) != 0)
+        return;
+
+    heur = pend->res.heur;
+    if (heur != PLAN_HEUR_DEAD_END)
+        heur = BOR_MAX(heur, pend->heur);
+
+    node = planStateSpaceNode(ma->search->state_space, pend->state_id);
+    node->heuristic = heur;
+
+    pend->state_id = PLAN_NO_STATE;
+    --ma->heur_pending_size;
+
+    if (heur != PLAN_HEUR_DEAD_END && node->cost < ma->goal_cost)
+        planSearchInsertNode(ma->search, node);
+}
+
+static plan_cost_t heurPendingLowestCost(const plan_ma_search_t *ma)
+{
+    const plan_state_space_node_t *node;
+    plan_cost_t cost = PLAN_COST_MAX;
+    int i;
+
+    for (i = 0; ma->heur_pending_size > 0 && i < ma->heur_pipeline; ++i){
+        if (ma->heur_pending[i].state_id == PLAN_NO_STATE)
+            continue;
+        node = planStateSpaceNode(ma->search->state_space,
+                                  ma->heur_pending[i].state_id);
+        cost = BOR_MIN(cost, node->cost);
+    }
+    return cost;
+}
+
 static void processMsg(plan_ma_search_t *ma, plan_ma_msg_t *msg)
 {
     int type, snapshot_type;
     int res;
     plan_ma_snapshot_t *snapshot = NULL;
     solution_verify_t *ver;
-    dead_end_verify_t *dead_end_ver;
+    checkpoint_t *cp;
 
     type = planMAMsgType(msg);
     if (type == PLAN_MA_MSG_TERMINATE){
@@ -376,6 +739,11 @@ static void processMsg(plan_ma_search_t *ma, plan_ma_msg_t *msg)
         return;
     }
 
+    if (type == PLAN_MA_MSG_DEAD_END){
+        deadEndTokenRecv(ma, msg);
+        return;
+    }
+
     if (!planMASnapshotRegEmpty(&ma->snapshot)
             || type == PLAN_MA_MSG_SNAPSHOT){
 
@@ -387,10 +755,9 @@ static void processMsg(plan_ma_search_t *ma, plan_ma_msg_t *msg)
             if (snapshot_type == PLAN_MA_MSG_SOLUTION_VERIFICATION){
                 ver = solutionVerifyNew(ma, msg, 0);
                 snapshot = &ver->snapshot;
-
-            }else if (snapshot_type == PLAN_MA_MSG_DEAD_END_VERIFICATION){
-                dead_end_ver = deadEndVerifyNew(ma, msg, 0);
-                snapshot = &dead_end_ver->snapshot;
+            }else if (snapshot_type == PLAN_MA_MSG_CHECKPOINT){
+                cp = checkpointNew(ma, msg, 0);
+                snapshot = &cp->snapshot;
             }
 
             if (snapshot){
@@ -417,6 +784,9 @@ static void processMsg(plan_ma_search_t *ma, plan_ma_msg_t *msg)
     }else if (type == PLAN_MA_MSG_HEUR){
         if (planMAMsgHeurType(msg) == PLAN_MA_MSG_HEUR_REQUEST && ma->heur){
             planHeurMARequest(ma->heur, ma->comm, msg);
+        }else if (planMAMsgHeurType(msg) == PLAN_MA_MSG_HEUR_UPDATE
+                    && ma->heur && ma->heur->ma_pipeline){
+            heurPendingUpdate(ma, msg);
         }else{
             fprintf(stderr, "[%d] MASearch Error: Unexpected heur message"
                             " (%d) from %d.\n",
@@ -479,6 +849,7 @@ static void publicStateRecv(plan_ma_search_t *ma,
     pub_state_data_t *pub_state;
     plan_state_id_t state_id;
     plan_state_space_node_t *node;
+    heur_pending_t *pend;
 
     // Unroll data from the message
     cost         = planMAMsgStateCost(msg);
@@ -500,6 +871,22 @@ static void publicStateRecv(plan_ma_search_t *ma,
 
     // TODO: Heuristic re-computation
 
+    // If the heuristic of the state is still being computed, just
+    // remember the better path. The node is inserted into open-list
+    // when the evaluation is finished.
+    pend = heurPendingFind(ma, state_id);
+    if (pend != NULL){
+        pend->heur = BOR_MAX(pend->heur, heur);
+        if (node->cost > cost){
+            node->parent_state_id = PLAN_NO_STATE;
+            node->op              = NULL;
+            node->cost            = cost;
+            pub_state->agent_id = planMAMsgAgent(msg);
+            pub_state->state_id = planMAMsgStateId(msg);
+        }
+        return;
+    }
+
     if (planStateSpaceNodeIsNew(node) || node->cost > cost){
         // Insert node into open-list of not already there
         node->parent_state_id = PLAN_NO_STATE;
@@ -858,6 +1245,7 @@ static solution_verify_t *solutionVerifyNew(plan_ma_search_t *ma,
     // Initialize to lowest currently known value
     ver->lowest_cost = planSearchTopNodeCost(ma->search);
     ver->lowest_cost = BOR_MIN(ver->lowest_cost, ma->goal_cost);
+    ver->lowest_cost = BOR_MIN(ver->lowest_cost, heurPendingLowestCost(ma));
 
     if (initiator){
         ver->init_msg = planMAMsgClone(msg);
@@ -1026,57 +1414,246 @@ static void solutionVerifyResponseFinalize(plan_ma_snapshot_t *s)
     }
 }
 
-static void deadEndVerify(plan_ma_search_t *ma)
+static void deadEndTokenSend(plan_ma_search_t *ma, long counter, int black)
 {
     plan_ma_msg_t *msg;
-    dead_end_verify_t *ver;
 
-    // Create snapshot-init message
+    msg = planMAMsgNew(PLAN_MA_MSG_DEAD_END, 0, ma->comm->node_id);
+    planMAMsgSetTermCounter(msg, counter);
+    planMAMsgSetTermBlack(msg, black);
+    planMACommSendInRing(ma->comm, msg);
+    planMAMsgDel(msg);
+    ++ma->dead_end.token_sent;
+}
+
+static void deadEndIdle(plan_ma_search_t *ma)
+{
+    dead_end_t *de = &ma->dead_end;
+    long sent, recv, counter;
+    int black;
+
+    // Only messages of the search itself are counted, i.e., tokens are
+    // excluded.
+    sent = ma->comm->msg_sent - de->token_sent;
+    recv = ma->comm->msg_recv - de->token_recv;
+    counter = sent - recv;
+    black = (recv != de->last_recv);
+
+    if (ma->comm->node_id == 0){
+        if (ma->comm->node_size == 1){
+            terminate(ma);
+            return;
+        }
+
+        if (de->has_token){
+            // The token went around the whole ring
+            de->has_token = 0;
+            de->probe = 0;
+            if (!de->token_black && !black && de->token_counter + counter == 0){
+                // All agents are idle and no message is in transit
+                terminate(ma);
+                return;
+            }
+        }
+
+        // Start a new probe
+        if (!de->probe){
+            de->probe = 1;
+            de->last_recv = recv;
+            deadEndTokenSend(ma, 0L, 0);
+        }
+
+    }else if (de->has_token){
+        de->has_token = 0;
+        de->last_recv = recv;
+        deadEndTokenSend(ma, de->token_counter + counter,
+                         de->token_black || black);
+    }
+}
+
+static void deadEndTokenRecv(plan_ma_search_t *ma, plan_ma_msg_t *msg)
+{
+    dead_end_t *de = &ma->dead_end;
+
+    ++de->token_recv;
+    de->has_token = 1;
+    de->token_counter = planMAMsgTermCounter(msg);
+    de->token_black = planMAMsgTermBlack(msg);
+}
+
+
+static void checkpoint(plan_ma_search_t *ma)
+{
+    plan_ma_msg_t *msg;
+    checkpoint_t *cp;
+
     msg = planMAMsgNew(PLAN_MA_MSG_SNAPSHOT, PLAN_MA_MSG_SNAPSHOT_INIT,
                        ma->comm->node_id);
-    planMAMsgSetSnapshotType(msg, PLAN_MA_MSG_DEAD_END_VERIFICATION);
+    if (planMAMsgSnapshotToken(msg) == ma->checkpoint_token){
+        // Files are named by tokens and the committed checkpoint (possibly
+        // from a previous run) must not be overwritten. Tokens are
+        // assigned sequentially, so the next one differs.
+        planMAMsgDel(msg);
+        msg = planMAMsgNew(PLAN_MA_MSG_SNAPSHOT, PLAN_MA_MSG_SNAPSHOT_INIT,
+                           ma->comm->node_id);
+    }
+    planMAMsgSetSnapshotType(msg, PLAN_MA_MSG_CHECKPOINT);
+    cp = checkpointNew(ma, msg, 1);
+
+    if (ma->comm->node_size == 1){
+        // There is nobody to wait for
+        checkpointMarkFinalize(&cp->snapshot);
+        checkpointResponseFinalize(&cp->snapshot);
+        checkpointDel(&cp->snapshot);
+        planMAMsgDel(msg);
+        return;
+    }
 
-    // Create snapshot object and register it
-    ver = deadEndVerifyNew(ma, msg, 1);
-    planMASnapshotRegAdd(&ma->snapshot, &ver->snapshot);
+    planMASnapshotRegAdd(&ma->snapshot, &cp->snapshot);
+    ma->checkpoint_running = 1;
 
-    // Send message to all agents
     planMACommSendToAll(ma->comm, msg);
     planMAMsgDel(msg);
 }
 
-static dead_end_verify_t *deadEndVerifyNew(plan_ma_search_t *ma,
-                                           plan_ma_msg_t *msg,
-                                           int initiator)
+static int checkpointWriteLocal(checkpoint_t *cp, long token)
+{
+    plan_ma_search_t *ma = cp->ma;
+    plan_state_pool_t *pool = ma->search->state_pool;
+    checkpoint_header_t hdr;
+    checkpoint_node_t cnode;
+    const plan_state_space_node_t *node;
+    const pub_state_data_t *pub_state;
+    plan_state_id_t state_id;
+
+    bzero(&hdr, sizeof(hdr));
+    memcpy(hdr.magic, CHECKPOINT_MAGIC, 8);
+    hdr.agent_id = ma->comm->node_id;
+    hdr.agent_size = ma->comm->node_size;
+    hdr.token = token;
+    hdr.op_size = ma->op_size;
+    hdr.bufsize = planStatePackerBufSize(pool->packer);
+    hdr.num_states = pool->num_states;
+    if (fwrite(&hdr, sizeof(hdr), 1, cp->fout) != 1)
+        return -1;
+
+    if (planMAStateSave(ma->ma_state, cp->fout) != 0)
+        return -1;
+
+    for (state_id = 0; state_id < (plan_state_id_t)hdr.num_states; ++state_id){
+        node = planStateSpaceNode(ma->search->state_space, state_id);
+        pub_state = planStatePoolData(pool, ma->pub_state_reg, state_id);
+
+        bzero(&cnode, sizeof(cnode));
+        cnode.parent_state_id = node->parent_state_id;
+        cnode.op = -1;
+        if (node->op != NULL){
+            // Operators can be stored only if they are known
+            if (ma->op == NULL)
+                return -1;
+            cnode.op = node->op - ma->op;
+        }
+        cnode.cost = node->cost;
+        cnode.heuristic = node->heuristic;
+        cnode.status = 0;
+        if (planStateSpaceNodeIsOpen(node)){
+            cnode.status = 1;
+        }else if (planStateSpaceNodeIsClosed(node)){
+            cnode.status = 2;
+        }
+        cnode.pub_agent_id = pub_state->agent_id;
+        cnode.pub_state_id = pub_state->state_id;
+
+        // Heuristic of the state is still being computed, so use zero as
+        // the safe lower bound
+        if (heurPendingFind(ma, state_id) != NULL)
+            cnode.heuristic = 0;
+
+        if (fwrite(planStatePoolGetPackedState(pool, state_id),
+                   hdr.bufsize, 1, cp->fout) != 1
+                || fwrite(&cnode, sizeof(cnode), 1, cp->fout) != 1)
+            return -1;
+    }
+
+    return 0;
+}
+
+static int checkpointWriteFinal(checkpoint_t *cp)
 {
-    dead_end_verify_t *ver;
+    int64_t size = cp->msg_size;
+    uint64_t bufsize;
+    size_t msgsize;
+    void *buf;
+    int i, ret = 0;
+
+    if (fwrite(&size, sizeof(size), 1, cp->fout) != 1)
+        return -1;
+
+    for (i = 0; ret == 0 && i < cp->msg_size; ++i){
+        buf = planMAMsgPacked(cp->msg[i], &msgsize);
+        bufsize = msgsize;
+        if (fwrite(&bufsize, sizeof(bufsize), 1, cp->fout) != 1
+                || fwrite(buf, 1, msgsize, cp->fout) != msgsize)
+            ret = -1;
+        BOR_FREE(buf);
+    }
+
+    if (ret == 0 && fwrite(CHECKPOINT_END, 8, 1, cp->fout) != 1)
+        ret = -1;
+    return ret;
+}
+
+static checkpoint_t *checkpointNew(plan_ma_search_t *ma,
+                                   plan_ma_msg_t *msg,
+                                   int initiator)
+{
+    checkpoint_t *cp;
     plan_ma_msg_t *mark_msg;
 
-    ver = BOR_ALLOC(dead_end_verify_t);
-    ver->ma = ma;
-    ver->ack = 1;
-    ver->init_msg = NULL;
+    cp = BOR_ALLOC(checkpoint_t);
+    cp->ma = ma;
+    cp->init_msg = NULL;
+    cp->msg = NULL;
+    cp->msg_size = cp->msg_alloc = 0;
+    cp->ack = 0;
+    cp->fn = NULL;
+    cp->fout = NULL;
+
+    // Record the local state right away. The file is named by the token,
+    // so the previous checkpoint stays valid until this one is committed.
+    if (ma->checkpoint != NULL){
+        cp->fn = checkpointFilename(ma->checkpoint,
+                                    planMAMsgSnapshotToken(msg),
+                                    ma->comm->node_id);
+        cp->fout = fopen(cp->fn, "wb");
+        if (cp->fout == NULL){
+            fprintf(stderr, "[%d] MASearch Error: Could not open `%s' for"
+                            " writing.\n", ma->comm->node_id, cp->fn);
+        }else if (checkpointWriteLocal(cp, planMAMsgSnapshotToken(msg)) == 0){
+            cp->ack = 1;
+        }
+    }
 
     if (initiator){
-        ver->init_msg = planMAMsgClone(msg);
-        _planMASnapshotInit(&ver->snapshot, planMAMsgSnapshotToken(msg),
+        cp->init_msg = planMAMsgClone(msg);
+        _planMASnapshotInit(&cp->snapshot, planMAMsgSnapshotToken(msg),
                             ma->comm->node_id, ma->comm->node_size,
-                            deadEndVerifyDel,
-                            NULL,
+                            checkpointDel,
+                            checkpointUpdate,
                             NULL,
                             NULL,
-                            deadEndVerifyResponse,
-                            NULL,
-                            deadEndVerifyResponseFinalize);
+                            checkpointResponseMsg,
+                            checkpointMarkFinalize,
+                            checkpointResponseFinalize);
     }else{
-        _planMASnapshotInit(&ver->snapshot, planMAMsgSnapshotToken(msg),
+        _planMASnapshotInit(&cp->snapshot, planMAMsgSnapshotToken(msg),
                             ma->comm->node_id, ma->comm->node_size,
-                            deadEndVerifyDel,
+                            checkpointDel,
+                            checkpointUpdate,
+                            checkpointInitMsg,
                             NULL,
-                            deadEndVerifyInitMsg,
-                            deadEndVerifyMarkMsg,
                             NULL,
-                            deadEndVerifyMarkFinalize,
+                            checkpointMarkFinalize,
                             NULL);
 
         // Send mark message to all agents
@@ -1085,55 +1662,338 @@ static dead_end_verify_t *deadEndVerifyNew(plan_ma_search_t *ma,
         planMAMsgDel(mark_msg);
     }
 
-    return ver;
+    return cp;
 }
 
-static void deadEndVerifyDel(plan_ma_snapshot_t *s)
+static void checkpointDel(plan_ma_snapshot_t *s)
 {
-    dead_end_verify_t *ver = DEAD_END_VERIFY(s);
+    checkpoint_t *cp = CHECKPOINT(s);
+    int i;
+
     _planMASnapshotFree(s);
-    if (ver->init_msg)
-        planMAMsgDel(ver->init_msg);
-    BOR_FREE(ver);
+    if (cp->fout != NULL){
+        fclose(cp->fout);
+        remove(cp->fn);
+    }
+    if (cp->fn)
+        BOR_FREE(cp->fn);
+    if (cp->init_msg)
+        planMAMsgDel(cp->init_msg);
+    for (i = 0; i < cp->msg_size; ++i)
+        planMAMsgDel(cp->msg[i]);
+    if (cp->msg)
+        BOR_FREE(cp->msg);
+    BOR_FREE(cp);
 }
 
-static void deadEndVerifyInitMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg)
+static void checkpointUpdate(plan_ma_snapshot_t *s, plan_ma_msg_t *msg)
 {
-    dead_end_verify_t *ver = DEAD_END_VERIFY(s);
-    ver->init_msg = planMAMsgClone(msg);
-    ver->ack &= ver->ma->blocked;
+    checkpoint_t *cp = CHECKPOINT(s);
+
+    if (planMAMsgType(msg) != PLAN_MA_MSG_PUBLIC_STATE)
+        return;
+
+    if (cp->msg_size == cp->msg_alloc){
+        cp->msg_alloc = BOR_MAX(2 * cp->msg_alloc, 8);
+        cp->msg = BOR_REALLOC_ARR(cp->msg, plan_ma_msg_t *, cp->msg_alloc);
+    }
+    cp->msg[cp->msg_size++] = planMAMsgClone(msg);
+}
+
+static void checkpointInitMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg)
+{
+    checkpoint_t *cp = CHECKPOINT(s);
+    cp->init_msg = planMAMsgClone(msg);
 }
 
-static void deadEndVerifyMarkMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg)
+static void checkpointResponseMsg(plan_ma_snapshot_t *s, plan_ma_msg_t *msg)
 {
-    dead_end_verify_t *ver = DEAD_END_VERIFY(s);
-    ver->ack &= ver->ma->blocked;
+    checkpoint_t *cp = CHECKPOINT(s);
+    cp->ack &= planMAMsgSnapshotAck(msg);
 }
 
-static int deadEndVerifyMarkFinalize(plan_ma_snapshot_t *s)
+static int checkpointMarkFinalize(plan_ma_snapshot_t *s)
 {
-    dead_end_verify_t *ver = DEAD_END_VERIFY(s);
+    checkpoint_t *cp = CHECKPOINT(s);
+    plan_ma_search_t *ma = cp->ma;
     plan_ma_msg_t *msg;
+    int ack = cp->ack;
+
+    // All messages in transit are known now, so the local part of the
+    // checkpoint can be finished. It becomes valid only after agent 0
+    // commits it (see checkpointResponseFinalize()).
+    if (cp->fout != NULL){
+        if (ack && checkpointWriteFinal(cp) != 0)
+            ack = 0;
+        if (fclose(cp->fout) != 0)
+            ack = 0;
+        cp->fout = NULL;
+
+        if (!ack){
+            fprintf(stderr, "[%d] MASearch Error: Could not write checkpoint"
+                            " `%s'.\n", ma->comm->node_id, cp->fn);
+            remove(cp->fn);
+        }
+    }
+    cp->ack = ack;
 
-    msg = planMAMsgSnapshotNewResponse(ver->init_msg, ver->ma->comm->node_id);
-    planMAMsgSetSnapshotAck(msg, ver->ack);
-    planMACommSendToNode(ver->ma->comm, planMAMsgAgent(ver->init_msg), msg);
-    planMAMsgDel(msg);
+    // The initiator waits for responses
+    if (planMAMsgAgent(cp->init_msg) == ma->comm->node_id)
+        return 0;
 
+    msg = planMAMsgSnapshotNewResponse(cp->init_msg, ma->comm->node_id);
+    planMAMsgSetSnapshotAck(msg, ack);
+    planMACommSendToNode(ma->comm, planMAMsgAgent(cp->init_msg), msg);
+    planMAMsgDel(msg);
     return -1;
 }
 
+static void checkpointResponseFinalize(plan_ma_snapshot_t *s)
+{
+    checkpoint_t *cp = CHECKPOINT(s);
+    plan_ma_search_t *ma = cp->ma;
+    long token = cp->snapshot.token;
+
+    if (cp->ack && checkpointCommit(ma, token) != 0)
+        cp->ack = 0;
+
+    if (cp->ack){
+        // The previous checkpoint is not needed anymore
+        if (ma->checkpoint_token != -1)
+            checkpointRemove(ma, ma->checkpoint_token);
+        ma->checkpoint_token = token;
+
+    }else{
+        fprintf(stderr, "[%d] MASearch Error: Checkpoint %ld is not"
+                        " complete.\n", ma->comm->node_id, token);
+        checkpointRemove(ma, token);
+    }
+    ma->checkpoint_running = 0;
+}
+
+static int checkpointCommit(plan_ma_search_t *ma, long token)
+{
+    checkpoint_manifest_t man;
+    char *fn, *tmp_fn;
+    FILE *fout;
+    int size, ret = -1;
+
+    bzero(&man, sizeof(man));
+    memcpy(man.magic, CHECKPOINT_MANIFEST_MAGIC, 8);
+    man.agent_size = ma->comm->node_size;
+    man.token = token;
+
+    // The manifest is replaced atomically, so it always names either the
+    // previous or the new checkpoint.
+    fn = checkpointFilename(ma->checkpoint, token, -1);
+    size = strlen(fn) + 5;
+    tmp_fn = BOR_ALLOC_ARR(char, size);
+    snprintf(tmp_fn, size, "%s.tmp", fn);
+
+    fout = fopen(tmp_fn, "wb");
+    if (fout != NULL){
+        if (fwrite(&man, sizeof(man), 1, fout) == 1)
+            ret = 0;
+        if (fclose(fout) != 0)
+            ret = -1;
+        if (ret == 0 && rename(tmp_fn, fn) != 0)
+            ret = -1;
+        if (ret != 0)
+            remove(tmp_fn);
+    }
 
-static void deadEndVerifyResponse(plan_ma_snapshot_t *s, plan_ma_msg_t *msg)
+    if (ret != 0){
+        fprintf(stderr, "[%d] MASearch Error: Could not write checkpoint"
+                        " manifest `%s'.\n", ma->comm->node_id, fn);
+    }
+
+    BOR_FREE(tmp_fn);
+    BOR_FREE(fn);
+    return ret;
+}
+
+static void checkpointRemove(plan_ma_search_t *ma, long token)
 {
-    dead_end_verify_t *ver = DEAD_END_VERIFY(s);
-    ver->ack &= planMAMsgSnapshotAck(msg);
-    ver->ack &= ver->ma->blocked;
+    char *fn;
+    int i;
+
+    for (i = 0; i < ma->comm->node_size; ++i){
+        fn = checkpointFilename(ma->checkpoint, token, i);
+        remove(fn);
+        BOR_FREE(fn);
+    }
 }
 
-static void deadEndVerifyResponseFinalize(plan_ma_snapshot_t *s)
+static int checkpointRestoreMsgs(plan_ma_search_t *ma, FILE *fin)
 {
-    dead_end_verify_t *ver = DEAD_END_VERIFY(s);
-    if (!ver->ack)
-        terminate(ver->ma);
+    int64_t size, i;
+    uint64_t bufsize;
+    plan_ma_msg_t *msg;
+    char *buf;
+    int ret = 0;
+
+    if (fread(&size, sizeof(size), 1, fin) != 1)
+        return -1;
+
+    for (i = 0; ret == 0 && i < size; ++i){
+        if (fread(&bufsize, sizeof(bufsize), 1, fin) != 1)
+            return -1;
+        buf = BOR_ALLOC_ARR(char, bufsize);
+        if (fread(buf, 1, bufsize, fin) == bufsize){
+            msg = planMAMsgUnpacked(buf, bufsize);
+            publicStateRecv(ma, msg);
+            planMAMsgDel(msg);
+        }else{
+            ret = -1;
+        }
+        BOR_FREE(buf);
+    }
+
+    return ret;
+}
+
+static int checkpointRestoreManifest(plan_ma_search_t *ma,
+                                     const char *prefix, long *token)
+{
+    checkpoint_manifest_t man;
+    char *fn;
+    FILE *fin;
+    int ret = -1;
+
+    fn = checkpointFilename(prefix, 0, -1);
+    fin = fopen(fn, "rb");
+    BOR_FREE(fn);
+    if (fin == NULL)
+        return -1;
+
+    if (fread(&man, sizeof(man), 1, fin) == 1
+            && memcmp(man.magic, CHECKPOINT_MANIFEST_MAGIC, 8) == 0
+            && man.agent_size == ma->comm->node_size){
+        *token = man.token;
+        ret = 0;
+    }
+
+    fclose(fin);
+    return ret;
+}
+
+static int checkpointRestoreHeader(plan_ma_search_t *ma, FILE *fin,
+                                   long token, checkpoint_header_t *hdr)
+{
+    const plan_state_pool_t *pool = ma->search->state_pool;
+
+    if (fread(hdr, sizeof(*hdr), 1, fin) != 1
+            || memcmp(hdr->magic, CHECKPOINT_MAGIC, 8) != 0
+            || hdr->token != token
+            || hdr->agent_id != ma->comm->node_id
+            || hdr->agent_size != ma->comm->node_size
+            || hdr->op_size != ma->op_size
+            || hdr->bufsize != planStatePackerBufSize(pool->packer)
+            || hdr->num_states < (int64_t)pool->num_states)
+        return -1;
+    return 0;
+}
+
+static int checkpointRestoreNode(plan_ma_search_t *ma,
+                                 plan_state_id_t state_id,
+                                 const void *buf,
+                                 const checkpoint_node_t *cnode)
+{
+    plan_state_pool_t *pool = ma->search->state_pool;
+    plan_state_space_node_t *node;
+    pub_state_data_t *pub_state;
+
+    if (cnode->op < -1 || cnode->op >= ma->op_size)
+        return -1;
+
+    // The states must get the same IDs as in the checkpoint
+    if ((size_t)state_id < pool->num_states){
+        if (memcmp(buf, planStatePoolGetPackedState(pool, state_id),
+                   planStatePackerBufSize(pool->packer)) != 0)
+            return -1;
+    }else if (planStatePoolInsertPacked(pool, buf) != state_id){
+        return -1;
+    }
+
+    if (cnode->status == 0)
+        return 0;
+
+    node = planStateSpaceNode(ma->search->state_space, state_id);
+    node->parent_state_id = cnode->parent_state_id;
+    node->op = NULL;
+    if (cnode->op >= 0)
+        node->op = (plan_op_t *)ma->op + cnode->op;
+    node->cost = cnode->cost;
+    node->heuristic = cnode->heuristic;
+    planStateSpaceOpen(ma->search->state_space, node);
+    if (cnode->status == 2)
+        planStateSpaceClose(ma->search->state_space, node);
+
+    pub_state = planStatePoolData(pool, ma->pub_state_reg, state_id);
+    pub_state->agent_id = cnode->pub_agent_id;
+    pub_state->state_id = cnode->pub_state_id;
+
+    // Closed nodes stay closed unless the search keeps closed parents of
+    // not yet generated states in its open-list (lazy search algorithms).
+    // Re-expansion of already expanded nodes does not lead to any new
+    // heuristic evaluations.
+    if (node->heuristic != PLAN_HEUR_DEAD_END
+            && (cnode->status == 1 || ma->search->reinsert_closed)){
+        planSearchInsertNode(ma->search, node);
+    }
+    return 0;
+}
+
+static int checkpointRestoreStates(plan_ma_search_t *ma, FILE *fin,
+                                   const checkpoint_header_t *hdr)
+{
+    checkpoint_node_t cnode;
+    plan_state_id_t state_id;
+    char *buf;
+    int ret = 0;
+
+    buf = BOR_ALLOC_ARR(char, hdr->bufsize);
+    for (state_id = 0;
+            ret == 0 && state_id < (plan_state_id_t)hdr->num_states;
+            ++state_id){
+        if (fread(buf, hdr->bufsize, 1, fin) != 1
+                || fread(&cnode, sizeof(cnode), 1, fin) != 1
+                || checkpointRestoreNode(ma, state_id, buf, &cnode) != 0)
+            ret = -1;
+    }
+    BOR_FREE(buf);
+
+    return ret;
+}
+
+static int checkpointRestore(plan_ma_search_t *ma, const char *prefix)
+{
+    checkpoint_header_t hdr;
+    char end[8], *fn;
+    long token;
+    FILE *fin;
+    int ret = -1;
+
+    // Only the checkpoint committed in the manifest is used, so all
+    // agents are restored from the same global checkpoint.
+    if (checkpointRestoreManifest(ma, prefix, &token) != 0)
+        return -1;
+
+    fn = checkpointFilename(prefix, token, ma->comm->node_id);
+    fin = fopen(fn, "rb");
+    BOR_FREE(fn);
+    if (fin == NULL)
+        return -1;
+
+    if (checkpointRestoreHeader(ma, fin, token, &hdr) == 0
+            && planMAStateLoad(ma->ma_state, fin) == 0
+            && checkpointRestoreStates(ma, fin, &hdr) == 0
+            && checkpointRestoreMsgs(ma, fin) == 0
+            && fread(end, 8, 1, fin) == 1
+            && memcmp(end, CHECKPOINT_END, 8) == 0){
+        ret = 0;
+    }
+
+    fclose(fin);
+    return ret;
 }
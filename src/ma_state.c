@@ -18,22 +18,10 @@
  */
 
 #include <boruvka/alloc.h>
-#include <boruvka/hfunc.h>
 #include <plan/ma_state.h>
 
 //#define ENABLE_ASSERTS
 
-struct _priv_el_t {
-    int id;
-    bor_list_t htable; /*!< Connector to bor_htable_t */
-    char buf[];        /*!< Buffer with private part of packed state */
-};
-typedef struct _priv_el_t priv_el_t;
-
-static void privInitEl(void *el, int id, const void *userdata);
-static bor_htable_key_t privTableHash(const bor_list_t *key, void *ud);
-static int privTableEq(const bor_list_t *k1, const bor_list_t *k2, void *ud);
-
 /** Returns unique ID corresponding to the private part of the given state */
 static int privID(plan_ma_state_t *ma_state, const void *statebuf);
 /** Returns private part buffer corresponding to the specified buffer ID */
@@ -43,7 +31,7 @@ plan_ma_state_t *planMAStateNew(plan_state_pool_t *state_pool,
                                 int num_agents, int agent_id)
 {
     plan_ma_state_t *ma_state;
-    int i, id, size;
+    int i, id;
     const void *buf;
 
     ma_state = BOR_ALLOC(plan_ma_state_t);
@@ -58,9 +46,8 @@ plan_ma_state_t *planMAStateNew(plan_state_pool_t *state_pool,
     ma_state->pub_buf = NULL;
     ma_state->pub_bufsize = 0;
     ma_state->priv_bufsize = 0;
-    ma_state->priv_data = NULL;
-    ma_state->priv_table = NULL;
-    ma_state->priv_size = 0;
+    ma_state->priv_buf = NULL;
+    planInternTableInit(&ma_state->priv_table, 0);
 
     if (state_pool->packer->ma_privacy){
         // Enable ma-privacy mode
@@ -85,10 +72,8 @@ plan_ma_state_t *planMAStateNew(plan_state_pool_t *state_pool,
         // Initialize structure for private parts of packed states
         ma_state->priv_bufsize = planStatePackerBufSizePrivatePart(ma_state->packer);
         if (ma_state->priv_bufsize > 0){
-            size = sizeof(priv_el_t) + ma_state->priv_bufsize;
-            ma_state->priv_data = borExtArrNew2(size, 32, 128, privInitEl, NULL);
-            ma_state->priv_table = borHTableNew(privTableHash, privTableEq,
-                                                (void *)ma_state);
+            ma_state->priv_buf = BOR_ALLOC_ARR(char, ma_state->priv_bufsize);
+            planInternTableInit(&ma_state->priv_table, ma_state->priv_bufsize);
         }
 
         // Make sure that we don't need any more records in
@@ -118,10 +103,9 @@ void planMAStateDel(plan_ma_state_t *ma_state)
         BOR_FREE(ma_state->pub_buf);
     if (ma_state->buf != NULL)
         BOR_FREE(ma_state->buf);
-    if (ma_state->priv_table)
-        borHTableDel(ma_state->priv_table);
-    if (ma_state->priv_data)
-        borExtArrDel(ma_state->priv_data);
+    if (ma_state->priv_buf != NULL)
+        BOR_FREE(ma_state->priv_buf);
+    planInternTableFree(&ma_state->priv_table);
     BOR_FREE(ma_state);
 }
 
@@ -281,60 +265,106 @@ int planMAStateMAMsgIsSet(const plan_ma_state_t *ma_state,
     }
 }
 
-static void privInitEl(void *_el, int id, const void *userdata)
+int planMAStatePrivatePartSize(const plan_ma_state_t *ma_state)
 {
-    priv_el_t *el = _el;
-    el->id = id;
+    return planInternTableSize(&ma_state->priv_table);
 }
 
-static bor_htable_key_t privTableHash(const bor_list_t *key, void *ud)
+size_t planMAStatePrivateMemUsage(const plan_ma_state_t *ma_state)
 {
-    const priv_el_t *el = BOR_LIST_ENTRY(key, priv_el_t, htable);
-    const plan_ma_state_t *ma_state = ud;
-    return borCityHash_64(el->buf, ma_state->priv_bufsize);
+    size_t size;
+
+    if (!ma_state->ma_privacy)
+        return 0;
+
+    size  = ma_state->priv_bufsize;
+    size += planInternTableMemUsage(&ma_state->priv_table);
+    size += planMAPrivateStateMemUsage(&ma_state->private_state);
+    return size;
 }
 
-static int privTableEq(const bor_list_t *k1, const bor_list_t *k2, void *ud)
+static int tableSave(const plan_intern_table_t *t, FILE *fout)
 {
-    const priv_el_t *el1 = BOR_LIST_ENTRY(k1, priv_el_t, htable);
-    const priv_el_t *el2 = BOR_LIST_ENTRY(k2, priv_el_t, htable);
-    const plan_ma_state_t *ma_state = ud;
-    return memcmp(el1->buf, el2->buf, ma_state->priv_bufsize) == 0;
+    int32_t size = planInternTableSize(t);
+
+    if (fwrite(&size, sizeof(size), 1, fout) != 1)
+        return -1;
+    if (size > 0 && t->el_size > 0
+            && fwrite(t->data, t->el_size, size, fout) != (size_t)size)
+        return -1;
+    return 0;
 }
 
-static int privID(plan_ma_state_t *ma_state, const void *statebuf)
+static int tableLoad(plan_intern_table_t *t, FILE *fin)
 {
-    priv_el_t *el;
-    bor_list_t *hfound;
+    int32_t size, i;
+    char *el;
+    int ret = 0;
 
-    if (ma_state->priv_data == NULL)
+    if (fread(&size, sizeof(size), 1, fin) != 1)
+        return -1;
+    // Elements of zero size carry no data, so such a table is always
+    // loaded as an empty table.
+    if (size == 0 || t->el_size == 0)
         return 0;
 
-    // Get next element from array
-    el = borExtArrGet(ma_state->priv_data, ma_state->priv_size);
+    // Elements get sequential IDs, so inserting them in the same order
+    // reproduces the saved IDs. Elements already present must have the
+    // same ID as well.
+    el = BOR_ALLOC_ARR(char, t->el_size);
+    for (i = 0; ret == 0 && i < size; ++i){
+        if (fread(el, t->el_size, 1, fin) != 1
+                || planInternTableInsert(t, el) != i)
+            ret = -1;
+    }
+    BOR_FREE(el);
+    return ret;
+}
 
-    // Read private part into that element so we can avoid another mem
-    // allocation
-    planStatePackerExtractPrivatePart(ma_state->packer, statebuf, el->buf);
+int planMAStateSave(const plan_ma_state_t *ma_state, FILE *fout)
+{
+    int32_t ma_privacy = ma_state->ma_privacy;
 
-    // Try to insert it into hash table and return result
-    hfound = borHTableInsertUnique(ma_state->priv_table, &el->htable);
-    if (hfound == NULL){
-        ++ma_state->priv_size;
-        return el->id;
-    }else{
-        el = BOR_LIST_ENTRY(hfound, priv_el_t, htable);
-        return el->id;
-    }
+    if (fwrite(&ma_privacy, sizeof(ma_privacy), 1, fout) != 1)
+        return -1;
+    if (!ma_state->ma_privacy)
+        return 0;
+
+    if (tableSave(&ma_state->private_state.table, fout) != 0
+            || tableSave(&ma_state->priv_table, fout) != 0)
+        return -1;
+    return 0;
 }
 
-static const void *privBuf(plan_ma_state_t *ma_state, int id)
+int planMAStateLoad(plan_ma_state_t *ma_state, FILE *fin)
 {
-    priv_el_t *el;
+    int32_t ma_privacy;
 
-    if (ma_state->priv_data == NULL)
-        return NULL;
+    if (fread(&ma_privacy, sizeof(ma_privacy), 1, fin) != 1
+            || ma_privacy != ma_state->ma_privacy)
+        return -1;
+    if (!ma_state->ma_privacy)
+        return 0;
+
+    if (tableLoad(&ma_state->private_state.table, fin) != 0
+            || tableLoad(&ma_state->priv_table, fin) != 0)
+        return -1;
+    return 0;
+}
 
-    el = borExtArrGet(ma_state->priv_data, id);
-    return el->buf;
+static int privID(plan_ma_state_t *ma_state, const void *statebuf)
+{
+    if (ma_state->priv_buf == NULL)
+        return 0;
+
+    planStatePackerExtractPrivatePart(ma_state->packer, statebuf,
+                                      ma_state->priv_buf);
+    return planInternTableInsert(&ma_state->priv_table, ma_state->priv_buf);
+}
+
+static const void *privBuf(plan_ma_state_t *ma_state, int id)
+{
+    if (ma_state->priv_buf == NULL)
+        return NULL;
+    return planInternTableGet(&ma_state->priv_table, id);
 }
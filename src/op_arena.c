@@ -0,0 +1,198 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <string.h>
+#include <boruvka/alloc.h>
+
+#include "plan/op_arena.h"
+
+/** Allocation from an arena under construction. If .buf is NULL, only
+ *  the size of the arena is computed. */
+struct _fill_t {
+    char *buf;
+    size_t size;
+};
+typedef struct _fill_t fill_t;
+
+static void *fillAlloc(fill_t *f, size_t size)
+{
+    void *ptr = NULL;
+
+    if (f->buf != NULL)
+        ptr = f->buf + f->size;
+    f->size += (size + 7) & ~(size_t)7;
+    return ptr;
+}
+
+/** Reserves space for the part-state and if the arena is allocated it
+ *  moves the part-state there */
+static plan_part_state_t *fillPartState(fill_t *f, plan_part_state_t *src)
+{
+    plan_part_state_t *ps;
+    void *vals, *valbuf, *maskbuf;
+
+    ps = fillAlloc(f, sizeof(*ps));
+    vals = fillAlloc(f, sizeof(plan_part_state_pair_t) * src->vals_size);
+    valbuf = fillAlloc(f, src->bufsize);
+    maskbuf = fillAlloc(f, src->bufsize);
+    if (f->buf == NULL)
+        return NULL;
+
+    *ps = *src;
+    ps->vals = NULL;
+    if (src->vals_size > 0){
+        ps->vals = vals;
+        memcpy(vals, src->vals,
+               sizeof(plan_part_state_pair_t) * src->vals_size);
+    }
+
+    ps->valbuf = ps->maskbuf = NULL;
+    if (src->valbuf != NULL){
+        ps->valbuf = valbuf;
+        ps->maskbuf = maskbuf;
+        memcpy(valbuf, src->valbuf, src->bufsize);
+        memcpy(maskbuf, src->maskbuf, src->bufsize);
+    }
+
+    planPartStateDel(src);
+    return ps;
+}
+
+static void fillOp(fill_t *f, plan_op_t *op)
+{
+    plan_op_cond_eff_t *cond_eff;
+    plan_part_state_t *pre, *eff, *cpre, *ceff;
+    char *name;
+    int i;
+
+    pre = fillPartState(f, op->pre);
+    eff = fillPartState(f, op->eff);
+    cond_eff = fillAlloc(f, sizeof(plan_op_cond_eff_t) * op->cond_eff_size);
+    for (i = 0; i < op->cond_eff_size; ++i){
+        cpre = fillPartState(f, op->cond_eff[i].pre);
+        ceff = fillPartState(f, op->cond_eff[i].eff);
+        if (f->buf != NULL){
+            cond_eff[i].pre = cpre;
+            cond_eff[i].eff = ceff;
+        }
+    }
+
+    name = NULL;
+    if (op->name != NULL)
+        name = fillAlloc(f, strlen(op->name) + 1);
+
+    if (f->buf == NULL)
+        return;
+
+    op->pre = pre;
+    op->eff = eff;
+    if (op->cond_eff_size > 0){
+        BOR_FREE(op->cond_eff);
+        op->cond_eff = cond_eff;
+    }
+    if (op->name != NULL){
+        strcpy(name, op->name);
+        BOR_FREE(op->name);
+        op->name = name;
+    }
+}
+
+plan_op_arena_t *planOpArenaNew(plan_op_t *op, int op_size)
+{
+    plan_op_arena_t *arena;
+    fill_t fill;
+    int i;
+
+    // First compute the size of the arena and then move the operators
+    fill.buf = NULL;
+    fill.size = 0;
+    for (i = 0; i < op_size; ++i)
+        fillOp(&fill, op + i);
+
+    arena = BOR_ALLOC(plan_op_arena_t);
+    arena->size = fill.size;
+    arena->buf = BOR_ALLOC_ARR(char, BOR_MAX(arena->size, 1));
+
+    fill.buf = arena->buf;
+    fill.size = 0;
+    for (i = 0; i < op_size; ++i)
+        fillOp(&fill, op + i);
+
+    return arena;
+}
+
+void planOpArenaDel(plan_op_arena_t *arena)
+{
+    BOR_FREE(arena->buf);
+    BOR_FREE(arena);
+}
+
+/** Translates pointer to the source arena to the destination arena */
+_bor_inline void *reloc(const void *ptr, const plan_op_arena_t *src,
+                        const plan_op_arena_t *dst)
+{
+    if (ptr == NULL)
+        return NULL;
+    return dst->buf + ((const char *)ptr - src->buf);
+}
+
+static plan_part_state_t *relocPartState(const plan_part_state_t *src_ps,
+                                         const plan_op_arena_t *src,
+                                         const plan_op_arena_t *dst)
+{
+    plan_part_state_t *ps;
+
+    ps = reloc(src_ps, src, dst);
+    ps->vals = reloc(ps->vals, src, dst);
+    ps->valbuf = reloc(ps->valbuf, src, dst);
+    ps->maskbuf = reloc(ps->maskbuf, src, dst);
+    return ps;
+}
+
+plan_op_arena_t *planOpArenaClone(const plan_op_arena_t *arena,
+                                  const plan_op_t *op, int op_size,
+                                  plan_op_t **op_out)
+{
+    plan_op_arena_t *dst;
+    plan_op_t *dop;
+    int i, j;
+
+    dst = BOR_ALLOC(plan_op_arena_t);
+    dst->size = arena->size;
+    dst->buf = BOR_ALLOC_ARR(char, BOR_MAX(dst->size, 1));
+    memcpy(dst->buf, arena->buf, dst->size);
+
+    dop = BOR_ALLOC_ARR(plan_op_t, BOR_MAX(op_size, 1));
+    memcpy(dop, op, sizeof(plan_op_t) * op_size);
+    for (i = 0; i < op_size; ++i){
+        dop[i].name = reloc(dop[i].name, arena, dst);
+        dop[i].pre = relocPartState(dop[i].pre, arena, dst);
+        dop[i].eff = relocPartState(dop[i].eff, arena, dst);
+        dop[i].cond_eff = reloc(dop[i].cond_eff, arena, dst);
+        for (j = 0; j < dop[i].cond_eff_size; ++j){
+            dop[i].cond_eff[j].pre = relocPartState(dop[i].cond_eff[j].pre,
+                                                    arena, dst);
+            dop[i].cond_eff[j].eff = relocPartState(dop[i].cond_eff[j].eff,
+                                                    arena, dst);
+        }
+    }
+
+    *op_out = dop;
+    return dst;
+}
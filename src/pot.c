@@ -17,6 +17,7 @@
  * See the License for more information.
  */
 
+#include <math.h>
 #include <boruvka/alloc.h>
 
 #include "plan/heur.h"
@@ -424,6 +425,69 @@ static void allocLPVarIDs(plan_pot_t *pot, int is_private)
     }
 }
 
+/** Builds table of fixed-point potentials from pot->pot.
+ *  All potentials are rounded to the nearest fixed-point value and the
+ *  sum is rounded down only once by planPotFixedToCost(). The scale is
+ *  chosen so that the sum of the greatest potentials of all variables
+ *  fits into int64_t and the potentials lower than minus this sum are
+ *  clamped to it: any state containing such a value has a negative
+ *  potential anyway. */
+static void computeFixed(plan_pot_t *pot)
+{
+    double maxsum, maxp;
+    int64_t scale, pmax, *fpot;
+    int i, j, size;
+
+    if (pot->fpot_off == NULL){
+        pot->fpot_off = BOR_ALLOC_ARR(int, pot->var_size);
+        for (size = 0, i = 0; i < pot->var_size; ++i){
+            pot->fpot_off[i] = size;
+            size += pot->var[i].range;
+        }
+        pot->fpot = BOR_ALLOC_ARR(int64_t, BOR_MAX(size, 1));
+    }
+    fpot = pot->fpot;
+
+    // Sum of the greatest potentials over all variables
+    maxsum = 0.;
+    for (i = 0; i < pot->var_size; ++i){
+        if (i == pot->ma_privacy_var)
+            continue;
+        maxp = 0.;
+        for (j = 0; j < pot->var[i].range; ++j)
+            maxp = BOR_MAX(maxp, planPotPot(pot, i, j));
+        maxsum += maxp;
+    }
+
+    scale = PLAN_POT_FIXED_SCALE;
+    while (scale > 1
+            && (pot->var_size + 1.) * (maxsum * scale + 1.) >= 0x1p62)
+        scale /= 2;
+    pot->fpot_scale = scale;
+
+    // pmax is the exact sum of the greatest fixed-point potentials
+    pmax = 0;
+    for (i = 0; i < pot->var_size; ++i){
+        if (i == pot->ma_privacy_var)
+            continue;
+        maxp = 0.;
+        for (j = 0; j < pot->var[i].range; ++j)
+            maxp = BOR_MAX(maxp, round(planPotPot(pot, i, j) * scale));
+        pmax += (int64_t)maxp;
+    }
+
+    for (i = 0; i < pot->var_size; ++i){
+        for (j = 0; j < pot->var[i].range; ++j){
+            maxp = round(planPotPot(pot, i, j) * scale);
+            if (maxp < -pmax - 1.){
+                fpot[pot->fpot_off[i] + j] = -pmax - 1;
+            }else{
+                fpot[pot->fpot_off[i] + j] = (int64_t)maxp;
+            }
+        }
+    }
+}
+
 void planPotInit(plan_pot_t *pot,
                  const plan_var_t *var, int var_size,
                  const plan_part_state_t *goal,
@@ -499,14 +563,16 @@ void planPotFree(plan_pot_t *pot)
     planPotProbFree(&pot->prob);
     if (pot->pot != NULL)
         BOR_FREE(pot->pot);
+    if (pot->fpot != NULL)
+        BOR_FREE(pot->fpot);
+    if (pot->fpot_off != NULL)
+        BOR_FREE(pot->fpot_off);
+    planPotFreeLP(pot);
 }
 
-void planPotCompute2(const plan_pot_prob_t *prob, double *pot)
+static void lpSolve(plan_lp_t *lp, const plan_pot_prob_t *prob, double *pot)
 {
     int i;
-    plan_lp_t *lp;
-
-    lp = lpNew(prob);
 
     // First zeroize potentials
     for (i = 0; i < prob->var_size; ++i)
@@ -517,6 +583,14 @@ void planPotCompute2(const plan_pot_prob_t *prob, double *pot)
         planLPSetObj(lp, i, prob->state_coef[i]);
 
     planLPSolve(lp, pot);
+}
+
+void planPotCompute2(const plan_pot_prob_t *prob, double *pot)
+{
+    plan_lp_t *lp;
+
+    lp = lpNew(prob);
+    lpSolve(lp, prob, pot);
     planLPDel(lp);
 }
 
@@ -527,7 +601,19 @@ void planPotCompute(plan_pot_t *pot)
     if (pot->pot == NULL)
         pot->pot = BOR_ALLOC_ARR(double, prob->var_size);
 
-    planPotCompute2(prob, pot->pot);
+    // Constraints do not depend on the state the potentials are optimized
+    // for, so only the objective is changed in the following calls
+    if (pot->lp == NULL)
+        pot->lp = lpNew(prob);
+    lpSolve(pot->lp, prob, pot->pot);
+    computeFixed(pot);
+}
+
+void planPotFreeLP(plan_pot_t *pot)
+{
+    if (pot->lp != NULL)
+        planLPDel(pot->lp);
+    pot->lp = NULL;
 }
 
 int planPotToVarIds(const plan_pot_t *pot, const plan_state_t *state,
@@ -547,6 +633,12 @@ int planPotToVarIds(const plan_pot_t *pot, const plan_state_t *state,
     return size;
 }
 
+void planPotSetState(plan_pot_t *pot, const plan_state_t *state)
+{
+    bzero(pot->prob.state_coef, sizeof(int) * pot->prob.var_size);
+    probInitState(&pot->prob, pot, state);
+}
+
 void planPotSetAllSyntacticStatesRange(plan_pot_t *pot, int fact_range)
 {
     probInitAllSyntacticStatesRange(&pot->prob, fact_range, pot);
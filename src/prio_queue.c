@@ -31,6 +31,7 @@ typedef struct _heap_node_t heap_node_t;
 
 static void planBucketQueueInit(plan_bucket_queue_t *q);
 static void planBucketQueueFree(plan_bucket_queue_t *q);
+static void planBucketQueueClear(plan_bucket_queue_t *q);
 static void planBucketQueuePush(plan_bucket_queue_t *q, int key, int value);
 static int planBucketQueuePop(plan_bucket_queue_t *q, int *key);
 /** Convets bucket queue to heap queue */
@@ -57,6 +58,19 @@ void planPrioQueueFree(plan_prio_queue_t *q)
     }
 }
 
+void planPrioQueueClear(plan_prio_queue_t *q)
+{
+    if (q->bucket){
+        planBucketQueueClear(&q->bucket_queue);
+    }else{
+        // Switch back to the bucket queue because the keys will probably
+        // start from zero again
+        planHeapQueueFree(&q->heap_queue);
+        planBucketQueueInit(&q->bucket_queue);
+        q->bucket = 1;
+    }
+}
+
 void planPrioQueuePush(plan_prio_queue_t *q, int key, int value)
 {
     if (q->bucket){
@@ -106,6 +120,18 @@ static void planBucketQueueFree(plan_bucket_queue_t *q)
     BOR_FREE(q->bucket);
 }
 
+static void planBucketQueueClear(plan_bucket_queue_t *q)
+{
+    int i;
+
+    for (i = q->lowest_key; q->size > 0 && i < q->bucket_size; ++i){
+        q->size -= q->bucket[i].size;
+        q->bucket[i].size = 0;
+    }
+    q->lowest_key = q->bucket_size;
+    q->size = 0;
+}
+
 static void planBucketQueuePush(plan_bucket_queue_t *q, int key, int value)
 {
     plan_prioqueue_bucket_t *bucket;
@@ -18,8 +18,11 @@
  */
 
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <boruvka/alloc.h>
+#include <boruvka/timer.h>
 
 #include "plan/problem.h"
 #include "fact_id.h"
@@ -50,6 +53,9 @@ void planProblemFree(plan_problem_t *plan)
 {
     int i;
 
+    if (plan->bin_map)
+        _planProblemBinFree(plan);
+
     if (plan->succ_gen)
         planSuccGenDel(plan->succ_gen);
 
@@ -67,14 +73,22 @@ void planProblemFree(plan_problem_t *plan)
     if (plan->state_pool)
         planStatePoolDel(plan->state_pool);
 
-    if (plan->op)
+    if (plan->op_arena){
+        planOpArenaDel(plan->op_arena);
+        BOR_FREE(plan->op);
+    }else if (plan->op){
         freeOps(plan->op, plan->op_size);
+    }
 
     if (plan->agent_name)
         BOR_FREE(plan->agent_name);
 
-    if (plan->proj_op)
+    if (plan->proj_op_arena){
+        planOpArenaDel(plan->proj_op_arena);
+        BOR_FREE(plan->proj_op);
+    }else if (plan->proj_op){
         freeOps(plan->proj_op, plan->proj_op_size);
+    }
 
     if (plan->private_val)
         BOR_FREE(plan->private_val);
@@ -96,6 +110,8 @@ void planProblemCopy(plan_problem_t *dst, const plan_problem_t *src)
     int i;
 
     memcpy(dst, src, sizeof(*src));
+    dst->bin_map = NULL;
+    dst->bin_map_size = 0;
 
     dst->var = BOR_ALLOC_ARR(plan_var_t, src->var_size);
     for (i = 0; i < src->var_size; ++i)
@@ -103,10 +119,16 @@ void planProblemCopy(plan_problem_t *dst, const plan_problem_t *src)
     dst->state_pool = planStatePoolClone(src->state_pool);
     dst->goal = planPartStateClone(src->goal);
 
-    dst->op = BOR_ALLOC_ARR(plan_op_t, src->op_size);
-    for (i = 0; i < src->op_size; ++i){
-        planOpInit(dst->op + i, src->var_size);
-        planOpCopy(dst->op + i, src->op + i);
+    // Operators moved to an arena are copied wholesale
+    if (src->op_arena){
+        dst->op_arena = planOpArenaClone(src->op_arena, src->op,
+                                         src->op_size, &dst->op);
+    }else{
+        dst->op = BOR_ALLOC_ARR(plan_op_t, src->op_size);
+        for (i = 0; i < src->op_size; ++i){
+            planOpInit(dst->op + i, src->var_size);
+            planOpCopy(dst->op + i, src->op + i);
+        }
     }
 
     if (src->succ_gen)
@@ -115,7 +137,12 @@ void planProblemCopy(plan_problem_t *dst, const plan_problem_t *src)
 
     if (src->agent_name)
         dst->agent_name = BOR_STRDUP(src->agent_name);
-    if (src->proj_op_size > 0){
+    if (src->proj_op_arena){
+        dst->proj_op_arena = planOpArenaClone(src->proj_op_arena,
+                                              src->proj_op,
+                                              src->proj_op_size,
+                                              &dst->proj_op);
+    }else if (src->proj_op_size > 0){
         dst->proj_op = BOR_ALLOC_ARR(plan_op_t, src->proj_op_size);
         for (i = 0; i < src->proj_op_size; ++i){
             planOpInit(dst->proj_op + i, src->var_size);
@@ -161,15 +188,84 @@ plan_problem_agents_t *planProblemAgentsClone(const plan_problem_agents_t *a)
     return prob;
 }
 
+/** Minimal number of operators packed by one thread */
+#define PACK_MIN_OPS_PER_THREAD 2048
+
+/** Thread packing one contiguous block of operators */
+struct _pack_th_t {
+    pthread_t th;
+    plan_op_t *op;
+    int op_size;
+    plan_state_packer_t *packer;
+    int id;
+    int num_threads;
+};
+typedef struct _pack_th_t pack_th_t;
+
+static void *packTh(void *_th)
+{
+    pack_th_t *th = _th;
+    int i, from, to;
+
+    from = ((long)th->op_size * th->id) / th->num_threads;
+    to = ((long)th->op_size * (th->id + 1)) / th->num_threads;
+    for (i = from; i < to; ++i)
+        planOpPack(th->op + i, th->packer);
+    return NULL;
+}
+
+static void packOps(plan_op_t *op, int op_size,
+                    plan_state_packer_t *packer)
+{
+    pack_th_t *th;
+    int i, num_threads;
+
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = BOR_MIN(num_threads, op_size / PACK_MIN_OPS_PER_THREAD);
+    num_threads = BOR_MAX(num_threads, 1);
+
+    th = BOR_ALLOC_ARR(pack_th_t, num_threads);
+    for (i = 0; i < num_threads; ++i){
+        th[i].op = op;
+        th[i].op_size = op_size;
+        th[i].packer = packer;
+        th[i].id = i;
+        th[i].num_threads = num_threads;
+    }
+
+    if (num_threads == 1){
+        packTh(th);
+    }else{
+        for (i = 0; i < num_threads; ++i)
+            pthread_create(&th[i].th, NULL, packTh, th + i);
+        for (i = 0; i < num_threads; ++i)
+            pthread_join(th[i].th, NULL);
+    }
+    BOR_FREE(th);
+}
+
 void planProblemPack(plan_problem_t *p)
 {
-    int i;
+    bor_timer_t timer;
 
+    borTimerStart(&timer);
     planPartStatePack(p->goal, p->state_pool->packer);
-    for (i = 0; i < p->op_size; ++i)
-        planOpPack(p->op + i, p->state_pool->packer);
-    for (i = 0; i < p->proj_op_size; ++i)
-        planOpPack(p->proj_op + i, p->state_pool->packer);
+
+    // Operators in arenas are already packed
+    if (p->op_arena == NULL){
+        packOps(p->op, p->op_size, p->state_pool->packer);
+        p->op_arena = planOpArenaNew(p->op, p->op_size);
+    }
+    if (p->proj_op_arena == NULL && p->proj_op_size > 0){
+        packOps(p->proj_op, p->proj_op_size, p->state_pool->packer);
+        p->proj_op_arena = planOpArenaNew(p->proj_op, p->proj_op_size);
+    }
+
+    // Successor generator may switch to testing packed preconditions
+    if (p->succ_gen)
+        planSuccGenPack(p->succ_gen, p->op, p->op_size, 0);
+    borTimerStop(&timer);
+    p->load_time.pack = borTimerElapsedInSF(&timer);
 }
 
 void planProblemAgentsPack(plan_problem_agents_t *p)
@@ -21,13 +21,16 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <algorithm>
 #include <boruvka/alloc.h>
+#include <boruvka/timer.h>
 
 #include "plan/problem.h"
 #include "plan/causal_graph.h"
 #include "problemdef.pb.h"
 #include "fact_id.h"
+#include "h2.h"
 
 void planShutdownProtobuf(void)
 {
@@ -59,6 +62,8 @@ static void pruneUnimportantVars(plan_problem_t *oldp,
                                  const int *important_var,
                                  plan_var_id_t *var_order);
 static void pruneDuplicateOps(plan_problem_t *prob);
+/** Removes unreachable facts and useless operators using h^2 */
+static void pruneH2(plan_problem_t *prob);
 
 /** Initializes agent's problem struct from global problem struct */
 static void agentInitProblem(plan_problem_t *dst, const plan_problem_t *src);
@@ -91,10 +96,16 @@ plan_problem_t *planProblemFromProto(const char *fn, unsigned flags)
 {
     plan_problem_t *p = NULL;
     PlanProblem *proto = NULL;
+    bor_timer_t timer, total;
+    float parse_time;
 
+    borTimerStart(&total);
+    borTimerStart(&timer);
     proto = parseProto(fn);
     if (proto == NULL)
         return NULL;
+    borTimerStop(&timer);
+    parse_time = borTimerElapsedInSF(&timer);
 
     p = BOR_ALLOC(plan_problem_t);
     loadProblem(p, proto, flags);
@@ -102,6 +113,10 @@ plan_problem_t *planProblemFromProto(const char *fn, unsigned flags)
 
     delete proto;
 
+    borTimerStop(&total);
+    p->load_time.parse = parse_time;
+    p->load_time.total = borTimerElapsedInSF(&total);
+
     return p;
 }
 
@@ -109,18 +124,33 @@ plan_problem_agents_t *planProblemAgentsFromProto(const char *fn, unsigned flags
 {
     plan_problem_agents_t *p = NULL;
     PlanProblem *proto = NULL;
+    bor_timer_t timer, total;
+    float parse_time;
 
+    borTimerStart(&total);
+    borTimerStart(&timer);
     proto = parseProto(fn);
     if (proto == NULL)
         return NULL;
+    borTimerStop(&timer);
+    parse_time = borTimerElapsedInSF(&timer);
 
     p = BOR_ALLOC(plan_problem_agents_t);
     loadProblem(&p->glob, proto, flags);
+
+    borTimerStart(&timer);
     loadAgents(p, proto, flags);
+    borTimerStop(&timer);
+    p->glob.load_time.agents = borTimerElapsedInSF(&timer);
+
     planProblemAgentsPack(p);
 
     delete proto;
 
+    borTimerStop(&total);
+    p->glob.load_time.parse = parse_time;
+    p->glob.load_time.total = borTimerElapsedInSF(&total);
+
     return p;
 }
 
@@ -166,6 +196,8 @@ static int loadProblem(plan_problem_t *p,
 {
     plan_causal_graph_t *cg;
     plan_var_id_t *var_order;
+    plan_problem_load_time_t load_time;
+    bor_timer_t timer;
     int i, size, num_agents, ma_state_privacy;
 
 
@@ -175,30 +207,60 @@ static int loadProblem(plan_problem_t *p,
         ma_state_privacy = 1;
     loadProtoProblem(p, proto, NULL, -1, ma_state_privacy);
     p->duplicate_ops_removed = 0;
+    p->h2_ops_removed = 0;
+    p->h2_facts_removed = 0;
+
+    // The problem struct is zeroized whenever it is reloaded, so the
+    // timings are collected aside
+    bzero(&load_time, sizeof(load_time));
 
     // Fix problem with causal graph
+    var_order = NULL;
+    cg = NULL;
     if (flags & PLAN_PROBLEM_USE_CG){
+        borTimerStart(&timer);
         cg = planCausalGraphNew(p->var_size, p->op, p->op_size, p->goal);
+        borTimerStop(&timer);
+        load_time.causal_graph = borTimerElapsedInSF(&timer);
 
         if (hasUnimportantVars(cg)){
+            borTimerStart(&timer);
             size = sizeof(plan_var_id_t) * (cg->var_order_size + 1);
             var_order = (plan_var_id_t *)alloca(size);
             memcpy(var_order, cg->var_order, size);
             pruneUnimportantVars(p, proto, cg->important_var, var_order);
+            borTimerStop(&timer);
+            load_time.prune_vars = borTimerElapsedInSF(&timer);
         }else{
             var_order = cg->var_order;
         }
+    }
 
-        if (flags & PLAN_PROBLEM_PRUNE_DUPLICATES)
-            pruneDuplicateOps(p);
-        p->succ_gen = planSuccGenNew(p->op, p->op_size, var_order);
-        planCausalGraphDel(cg);
-    }else{
-        if (flags & PLAN_PROBLEM_PRUNE_DUPLICATES)
-            pruneDuplicateOps(p);
-        p->succ_gen = planSuccGenNew(p->op, p->op_size, NULL);
+    // h^2 goes first, because tightened preconditions can make more
+    // operators duplicate
+    if (flags & PLAN_PROBLEM_PRUNE_H2){
+        borTimerStart(&timer);
+        pruneH2(p);
+        borTimerStop(&timer);
+        load_time.prune_h2 = borTimerElapsedInSF(&timer);
+    }
+
+    if (flags & PLAN_PROBLEM_PRUNE_DUPLICATES){
+        borTimerStart(&timer);
+        pruneDuplicateOps(p);
+        borTimerStop(&timer);
+        load_time.prune_duplicates = borTimerElapsedInSF(&timer);
     }
 
+    borTimerStart(&timer);
+    p->succ_gen = planSuccGenNew(p->op, p->op_size, var_order);
+    borTimerStop(&timer);
+    load_time.succ_gen = borTimerElapsedInSF(&timer);
+
+    if (cg != NULL)
+        planCausalGraphDel(cg);
+    p->load_time = load_time;
+
     if (flags & PLAN_PROBLEM_OP_UNIT_COST){
         for (i = 0; i < p->op_size; ++i)
             p->op[i].cost = 1;
@@ -409,12 +471,46 @@ class AgentVarVals {
 };
 
 
+/** Thread constructing every num_threads-th agent's problem */
+struct agent_th_t {
+    pthread_t th;
+    plan_problem_agents_t *p;
+    const AgentVarVals *var_vals;
+    int id;
+    int num_threads;
+};
+
+static void *agentTh(void *_th)
+{
+    agent_th_t *th = (agent_th_t *)_th;
+    plan_problem_agents_t *p = th->p;
+    int i;
+
+    for (i = th->id; i < p->agent_size; i += th->num_threads){
+        // Create operators that belong to the specified agent
+        createOps(p->glob.op, p->glob.op_size, i, p->agent + i);
+
+        // Create projected operators
+        createProjectedOps(p->glob.op, p->glob.op_size,
+                           i, p->agent + i, *th->var_vals);
+
+        // Create successor generator from operators that are owned by the
+        // agent
+        p->agent[i].succ_gen = planSuccGenNew(p->agent[i].op,
+                                              p->agent[i].op_size, NULL);
+
+        setPrivateVals(p->agent + i, i, *th->var_vals);
+    }
+    return NULL;
+}
+
 static void loadAgents(plan_problem_agents_t *p,
                        const PlanProblem *proto,
                        unsigned flags)
 {
-    int i;
+    int i, num_threads;
     plan_problem_t *agent;
+    agent_th_t *th;
 
     p->agent_size = proto->agent_name_size();
     if (p->agent_size == 0){
@@ -449,21 +545,25 @@ static void loadAgents(plan_problem_agents_t *p,
     setOpPrivate(p->glob.op, p->glob.op_size, var_vals);
 
 
-    for (i = 0; i < p->agent_size; ++i){
-        // Create operators that belong to the specified agent
-        createOps(p->glob.op, p->glob.op_size, i, p->agent + i);
-
-        // Create projected operators
-        createProjectedOps(p->glob.op, p->glob.op_size,
-                           i, p->agent + i, var_vals);
-
-        // Create successor generator from operators that are owned by the
-        // agent
-        p->agent[i].succ_gen = planSuccGenNew(p->agent[i].op,
-                                              p->agent[i].op_size, NULL);
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = BOR_MAX(1, BOR_MIN(num_threads, p->agent_size));
+    th = BOR_ALLOC_ARR(agent_th_t, num_threads);
+    for (i = 0; i < num_threads; ++i){
+        th[i].p = p;
+        th[i].var_vals = &var_vals;
+        th[i].id = i;
+        th[i].num_threads = num_threads;
+    }
 
-        setPrivateVals(p->agent + i, i, var_vals);
+    if (num_threads == 1){
+        agentTh(th);
+    }else{
+        for (i = 0; i < num_threads; ++i)
+            pthread_create(&th[i].th, NULL, agentTh, th + i);
+        for (i = 0; i < num_threads; ++i)
+            pthread_join(th[i].th, NULL);
     }
+    BOR_FREE(th);
 }
 
 static void loadVar(plan_problem_t *p, const PlanProblem *proto,
@@ -811,11 +911,66 @@ static int cmpOp(const plan_op_t *op1, const plan_op_t *op2)
     return 0;
 }
 
-static int duplicateOpsCmp(const void *a, const void *b)
+/** Orders operators by cmpOp() and equal operators by their position in
+ *  the array, so the last copy of duplicate operators is the one kept. */
+static bool sortCmpOp(const plan_op_t *op1, const plan_op_t *op2)
+{
+    int cmp = cmpOp(op1, op2);
+    if (cmp != 0)
+        return cmp < 0;
+    return op1 < op2;
+}
+
+/** Minimal number of operators sorted by one thread */
+#define SORT_MIN_OPS_PER_THREAD 4096
+
+/** Thread sorting one contiguous block of operators */
+struct sort_th_t {
+    pthread_t th;
+    plan_op_t **op;
+    int from;
+    int to;
+};
+
+static void *sortOpsTh(void *_th)
 {
-    const plan_op_t *op1 = *(const plan_op_t **)a;
-    const plan_op_t *op2 = *(const plan_op_t **)b;
-    return cmpOp(op1, op2);
+    sort_th_t *th = (sort_th_t *)_th;
+    std::sort(th->op + th->from, th->op + th->to, sortCmpOp);
+    return NULL;
+}
+
+/** Sorts operators using sortCmpOp(): blocks are sorted in parallel and
+ *  then merged */
+static void sortOps(plan_op_t **op, int op_size)
+{
+    sort_th_t *th;
+    int i, num_threads;
+
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = BOR_MIN(num_threads, op_size / SORT_MIN_OPS_PER_THREAD);
+    num_threads = BOR_MAX(num_threads, 1);
+
+    th = BOR_ALLOC_ARR(sort_th_t, num_threads);
+    for (i = 0; i < num_threads; ++i){
+        th[i].op = op;
+        th[i].from = ((long)op_size * i) / num_threads;
+        th[i].to = ((long)op_size * (i + 1)) / num_threads;
+    }
+
+    if (num_threads == 1){
+        sortOpsTh(th);
+    }else{
+        for (i = 0; i < num_threads; ++i)
+            pthread_create(&th[i].th, NULL, sortOpsTh, th + i);
+        for (i = 0; i < num_threads; ++i)
+            pthread_join(th[i].th, NULL);
+
+        for (i = 1; i < num_threads; ++i){
+            std::inplace_merge(op, op + th[i].from, op + th[i].to,
+                               sortCmpOp);
+        }
+    }
+    BOR_FREE(th);
 }
 
 static void pruneDuplicateOps(plan_problem_t *prob)
@@ -827,7 +982,7 @@ static void pruneDuplicateOps(plan_problem_t *prob)
     sorted_ops = BOR_ALLOC_ARR(plan_op_t *, prob->op_size);
     for (i = 0; i < prob->op_size; ++i)
         sorted_ops[i] = prob->op + i;
-    qsort(sorted_ops, prob->op_size, sizeof(plan_op_t *), duplicateOpsCmp);
+    sortOps(sorted_ops, prob->op_size);
 
     // Free duplicate operators and mark their position with global_id set
     // to -1
@@ -853,12 +1008,125 @@ static void pruneDuplicateOps(plan_problem_t *prob)
     BOR_FREE(sorted_ops);
 }
 
+/** Removes values of variables that are not reachable according to h^2
+ *  and renumbers the remaining ones */
+static void pruneUnreachableFacts(plan_problem_t *p, const plan_h2_t *h2,
+                                  plan_state_t *init)
+{
+    plan_var_t *var;
+    plan_part_state_t *ps[2];
+    int *val_map;
+    int i, j, k, val, fact, removed;
+
+    val_map = BOR_ALLOC_ARR(int, BOR_MAX(h2->fact_size, 1));
+    removed = 0;
+    for (i = 0; i < p->var_size; ++i){
+        for (val = 0, j = 0; j < (int)p->var[i].range; ++j){
+            fact = planH2Fact(h2, i, j);
+            if (h2->fact[fact]){
+                val_map[fact] = val++;
+            }else{
+                val_map[fact] = -1;
+                ++removed;
+            }
+        }
+    }
+
+    if (removed == 0){
+        BOR_FREE(val_map);
+        return;
+    }
+
+    for (i = 0; i < p->var_size; ++i){
+        var = p->var + i;
+        for (val = 0, j = 0; j < (int)var->range; ++j){
+            fact = planH2Fact(h2, i, j);
+            if (val_map[fact] < 0){
+                if (var->val_name[j] != NULL)
+                    BOR_FREE(var->val_name[j]);
+                continue;
+            }
+            var->val_name[val] = var->val_name[j];
+            var->is_val_private[val] = var->is_val_private[j];
+            ++val;
+        }
+        var->range = val;
+        planStateSet(init, i, val_map[planH2Fact(h2, i,
+                                                 planStateGet(init, i))]);
+    }
+
+    for (k = 0; k < p->goal->vals_size; ++k){
+        fact = planH2Fact(h2, p->goal->vals[k].var, p->goal->vals[k].val);
+        p->goal->vals[k].val = val_map[fact];
+    }
+    for (i = 0; i < p->op_size; ++i){
+        ps[0] = p->op[i].pre;
+        ps[1] = p->op[i].eff;
+        for (j = 0; j < 2; ++j){
+            for (k = 0; k < ps[j]->vals_size; ++k){
+                fact = planH2Fact(h2, ps[j]->vals[k].var, ps[j]->vals[k].val);
+                ps[j]->vals[k].val = val_map[fact];
+            }
+        }
+    }
+
+    // States must be re-packed with the new ranges
+    planStatePoolDel(p->state_pool);
+    p->state_pool = planStatePoolNew(p->var, p->var_size);
+    p->initial_state = planStatePoolInsert(p->state_pool, init);
+
+    p->h2_facts_removed = removed;
+    BOR_FREE(val_map);
+}
+
+static void pruneH2(plan_problem_t *p)
+{
+    plan_h2_t h2;
+    plan_state_t *init;
+    int i, ins;
+
+    init = planStateNew(p->var_size);
+    planStatePoolGetState(p->state_pool, p->initial_state, init);
+    if (planH2Init(&h2, p->var, p->var_size, init, p->goal,
+                   p->op, p->op_size) != 0){
+        planStateDel(init);
+        return;
+    }
+
+    for (i = 0; i < p->op_size; ++i){
+        if (h2.op_alive[i] && planH2TightenPre(&h2, p->op + i) < 0)
+            h2.op_alive[i] = 0;
+    }
+
+    // Squash remaining operators to a continuous array
+    for (i = 0, ins = 0; i < p->op_size; ++i){
+        if (!h2.op_alive[i]){
+            planOpFree(p->op + i);
+            continue;
+        }
+        if (ins != i)
+            p->op[ins] = p->op[i];
+        p->op[ins].global_id = ins;
+        ++ins;
+    }
+    p->h2_ops_removed = p->op_size - ins;
+    p->op_size = ins;
+
+    // Unsolvable problem keeps its facts so that the goal stays valid
+    if (h2.solvable)
+        pruneUnreachableFacts(p, &h2, init);
+
+    planH2Free(&h2);
+    planStateDel(init);
+}
+
 static void agentInitProblem(plan_problem_t *dst, const plan_problem_t *src)
 {
     int i;
     plan_state_t *state;
 
     memcpy(dst, src, sizeof(*src));
+    bzero(&dst->load_time, sizeof(dst->load_time));
 
     dst->var_size = src->var_size;
     dst->var = BOR_ALLOC_ARR(plan_var_t, src->var_size);
@@ -881,10 +1149,12 @@ static void agentInitProblem(plan_problem_t *dst, const plan_problem_t *src)
 
     dst->op_size = 0;
     dst->op = NULL;
+    dst->op_arena = NULL;
     dst->succ_gen = NULL;
     dst->agent_name = NULL;
     dst->proj_op = NULL;
     dst->proj_op_size = 0;
+    dst->proj_op_arena = NULL;
     dst->private_val = NULL;
     dst->private_val_size = 0;
 }
@@ -0,0 +1,648 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <boruvka/alloc.h>
+
+#include "plan/problem.h"
+
+/**
+ * Binary problem format
+ * ----------------------
+ * The file starts with bin_header_t and all other parts are referenced
+ * by offsets from the beginning of the file. Every part is aligned to 8
+ * bytes so that it can be used directly from the memory mapped file.
+ * Strings are zero terminated, missing parts have offset -1.
+ */
+#define BIN_MAGIC "MAPLANB"
+#define BIN_VERSION 1
+#define BIN_ENDIAN 0x01020304u
+
+struct _bin_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;          /*!< BIN_ENDIAN in native byte order */
+    uint32_t pair_size;       /*!< sizeof(plan_part_state_pair_t) */
+    uint32_t word_size;       /*!< sizeof(plan_packer_word_t) */
+    int32_t var_size;
+    int32_t op_size;
+    int32_t bufsize;          /*!< Size of packed part states or 0 */
+    int32_t duplicate_ops_removed;
+    int64_t var;              /*!< Array of bin_var_t */
+    int64_t init;             /*!< Values of the initial state */
+    int64_t goal;             /*!< bin_part_state_t */
+    int64_t op;               /*!< Array of bin_op_t */
+    int64_t succ_gen;         /*!< See planSuccGenToBin() */
+    int64_t succ_gen_size;
+    int64_t size;             /*!< Size of the whole file */
+};
+typedef struct _bin_header_t bin_header_t;
+
+struct _bin_var_t {
+    int64_t name;
+    int64_t is_val_private;   /*!< Array of int32_t */
+    int64_t val_name;         /*!< Array of offsets of strings */
+    int32_t range;
+    int32_t is_private;
+    int32_t ma_privacy;
+    int32_t pad;
+};
+typedef struct _bin_var_t bin_var_t;
+
+struct _bin_part_state_t {
+    int64_t vals;             /*!< Array of plan_part_state_pair_t */
+    int64_t valbuf;
+    int64_t maskbuf;
+    int32_t vals_size;
+    int32_t bufsize;
+};
+typedef struct _bin_part_state_t bin_part_state_t;
+
+struct _bin_cond_eff_t {
+    bin_part_state_t pre;
+    bin_part_state_t eff;
+};
+typedef struct _bin_cond_eff_t bin_cond_eff_t;
+
+struct _bin_op_t {
+    int64_t name;
+    int64_t cond_eff;         /*!< Array of bin_cond_eff_t */
+    bin_part_state_t pre;
+    bin_part_state_t eff;
+    uint64_t ownerarr;
+    int32_t cond_eff_size;
+    int32_t cost;
+    int32_t global_id;
+    int32_t owner;
+    int32_t is_private;
+    int32_t pad;
+};
+typedef struct _bin_op_t bin_op_t;
+
+/** Growing buffer the file is built in */
+struct _bin_writer_t {
+    char *buf;
+    size_t size;
+    size_t alloc;
+};
+typedef struct _bin_writer_t bin_writer_t;
+
+/** Reserves zeroed aligned space and returns its offset */
+static int64_t wReserve(bin_writer_t *w, size_t size);
+/** Appends data and returns their offset, -1 for NULL data */
+static int64_t wAppend(bin_writer_t *w, const void *data, size_t size);
+static int64_t wString(bin_writer_t *w, const char *str);
+static void wVars(bin_writer_t *w, const plan_problem_t *p);
+static void wPartState(bin_writer_t *w, const plan_part_state_t *ps,
+                       bin_part_state_t *bps);
+static void wOps(bin_writer_t *w, const plan_problem_t *p);
+
+/** Returns pointer into the mapping or NULL if the part would lay outside
+ *  of the mapping */
+static const void *rPtr(const plan_problem_t *p, int64_t off, size_t size);
+static const char *rString(const plan_problem_t *p, int64_t off);
+static int rVars(plan_problem_t *p, const bin_header_t *h);
+static plan_part_state_t *rPartState(plan_problem_t *p,
+                                     const bin_part_state_t *bps,
+                                     int bufsize);
+static int rOps(plan_problem_t *p, const bin_header_t *h);
+static int rProblem(plan_problem_t *p, const bin_header_t *h);
+
+int planProblemToBin(const plan_problem_t *p, const char *fn)
+{
+    bin_writer_t w;
+    bin_header_t *h;
+    bin_part_state_t goal;
+    plan_state_t *state;
+    int64_t off;
+    FILE *fout;
+    int ret = 0;
+
+    if (p->agent_name != NULL || p->proj_op_size > 0
+            || p->private_val_size > 0){
+        fprintf(stderr, "Error: Agent problems cannot be stored in the"
+                        " binary format.\n");
+        return -1;
+    }
+
+    bzero(&w, sizeof(w));
+    wReserve(&w, sizeof(bin_header_t));
+
+    wVars(&w, p);
+
+    state = planStateNew(p->var_size);
+    planStatePoolGetState(p->state_pool, p->initial_state, state);
+    off = wAppend(&w, state->val, sizeof(plan_val_t) * p->var_size);
+    planStateDel(state);
+    ((bin_header_t *)w.buf)->init = off;
+
+    wPartState(&w, p->goal, &goal);
+    off = wAppend(&w, &goal, sizeof(goal));
+    ((bin_header_t *)w.buf)->goal = off;
+
+    wOps(&w, p);
+
+    h = (bin_header_t *)w.buf;
+    h->succ_gen = h->succ_gen_size = -1;
+    if (p->succ_gen){
+        off = wReserve(&w, planSuccGenBinSize(p->succ_gen));
+        planSuccGenToBin(p->succ_gen, p->op, w.buf + off);
+        h = (bin_header_t *)w.buf;
+        h->succ_gen = off;
+        h->succ_gen_size = planSuccGenBinSize(p->succ_gen);
+    }
+
+    memcpy(h->magic, BIN_MAGIC, sizeof(BIN_MAGIC));
+    h->version = BIN_VERSION;
+    h->endian = BIN_ENDIAN;
+    h->pair_size = sizeof(plan_part_state_pair_t);
+    h->word_size = sizeof(plan_packer_word_t);
+    h->var_size = p->var_size;
+    h->op_size = p->op_size;
+    h->bufsize = p->goal->bufsize;
+    h->duplicate_ops_removed = p->duplicate_ops_removed;
+    h->size = w.size;
+
+    fout = fopen(fn, "wb");
+    if (fout == NULL){
+        fprintf(stderr, "Error: Could not open `%s'.\n", fn);
+        ret = -1;
+    }else{
+        if (fwrite(w.buf, 1, w.size, fout) != w.size){
+            fprintf(stderr, "Error: Could not write to `%s'.\n", fn);
+            ret = -1;
+        }
+        if (fclose(fout) != 0)
+            ret = -1;
+    }
+
+    if (w.buf)
+        BOR_FREE(w.buf);
+    return ret;
+}
+
+plan_problem_t *planProblemFromBin(const char *fn)
+{
+    plan_problem_t *p;
+    const bin_header_t *h;
+    struct stat st;
+    void *map;
+    int fd;
+
+    fd = open(fn, O_RDONLY);
+    if (fd < 0){
+        fprintf(stderr, "Error: Could not read `%s'.\n", fn);
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(bin_header_t)){
+        fprintf(stderr, "Error: `%s' is not a binary problem.\n", fn);
+        close(fd);
+        return NULL;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        fprintf(stderr, "Error: Could not map `%s'.\n", fn);
+        return NULL;
+    }
+
+    h = map;
+    if (memcmp(h->magic, BIN_MAGIC, sizeof(BIN_MAGIC)) != 0
+            || h->version != BIN_VERSION
+            || h->endian != BIN_ENDIAN
+            || h->pair_size != sizeof(plan_part_state_pair_t)
+            || h->word_size != sizeof(plan_packer_word_t)
+            || h->size != st.st_size
+            || h->var_size <= 0 || h->op_size < 0){
+        fprintf(stderr, "Error: `%s' is not a binary problem of this"
+                        " version.\n", fn);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    p = BOR_ALLOC(plan_problem_t);
+    planProblemInit(p);
+    p->bin_map = map;
+    p->bin_map_size = st.st_size;
+    if (rProblem(p, h) != 0){
+        fprintf(stderr, "Error: `%s' is corrupted.\n", fn);
+        planProblemDel(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+void _planProblemBinFree(plan_problem_t *p)
+{
+    int i, j;
+
+    // Only the structures were allocated, their content points to the
+    // mapped file
+    if (p->goal)
+        BOR_FREE(p->goal);
+    p->goal = NULL;
+
+    for (i = 0; p->op != NULL && i < p->op_size; ++i){
+        if (p->op[i].pre)
+            BOR_FREE(p->op[i].pre);
+        if (p->op[i].eff)
+            BOR_FREE(p->op[i].eff);
+        for (j = 0; j < p->op[i].cond_eff_size; ++j){
+            if (p->op[i].cond_eff[j].pre)
+                BOR_FREE(p->op[i].cond_eff[j].pre);
+            if (p->op[i].cond_eff[j].eff)
+                BOR_FREE(p->op[i].cond_eff[j].eff);
+        }
+        if (p->op[i].cond_eff)
+            BOR_FREE(p->op[i].cond_eff);
+    }
+    if (p->op)
+        BOR_FREE(p->op);
+    p->op = NULL;
+    p->op_size = 0;
+
+    munmap(p->bin_map, p->bin_map_size);
+    p->bin_map = NULL;
+    p->bin_map_size = 0;
+}
+
+
+static int64_t wReserve(bin_writer_t *w, size_t size)
+{
+    size_t off;
+
+    off = (w->size + 7) & ~(size_t)7;
+    if (off + size > w->alloc){
+        w->alloc = BOR_MAX(2 * w->alloc, off + size + 1024);
+        w->buf = BOR_REALLOC_ARR(w->buf, char, w->alloc);
+    }
+    bzero(w->buf + w->size, off + size - w->size);
+    w->size = off + size;
+    return off;
+}
+
+static int64_t wAppend(bin_writer_t *w, const void *data, size_t size)
+{
+    int64_t off;
+
+    if (data == NULL)
+        return -1;
+    off = wReserve(w, size);
+    if (size > 0)
+        memcpy(w->buf + off, data, size);
+    return off;
+}
+
+static int64_t wString(bin_writer_t *w, const char *str)
+{
+    if (str == NULL)
+        return -1;
+    return wAppend(w, str, strlen(str) + 1);
+}
+
+static void wVars(bin_writer_t *w, const plan_problem_t *p)
+{
+    const plan_var_t *var;
+    bin_var_t *bvar;
+    int64_t *val_name, off;
+    int32_t *is_val_private;
+    int i, j;
+
+    bvar = BOR_CALLOC_ARR(bin_var_t, p->var_size);
+    for (i = 0; i < p->var_size; ++i){
+        var = p->var + i;
+        bvar[i].name = wString(w, var->name);
+        bvar[i].range = var->range;
+        bvar[i].is_private = var->is_private;
+        bvar[i].ma_privacy = var->ma_privacy;
+        bvar[i].is_val_private = bvar[i].val_name = -1;
+
+        if (var->is_val_private){
+            is_val_private = BOR_ALLOC_ARR(int32_t, var->range);
+            for (j = 0; j < var->range; ++j)
+                is_val_private[j] = var->is_val_private[j];
+            bvar[i].is_val_private = wAppend(w, is_val_private,
+                                             sizeof(int32_t) * var->range);
+            BOR_FREE(is_val_private);
+        }
+
+        if (var->val_name){
+            val_name = BOR_ALLOC_ARR(int64_t, var->range);
+            for (j = 0; j < var->range; ++j)
+                val_name[j] = wString(w, var->val_name[j]);
+            bvar[i].val_name = wAppend(w, val_name,
+                                       sizeof(int64_t) * var->range);
+            BOR_FREE(val_name);
+        }
+    }
+
+    off = wAppend(w, bvar, sizeof(bin_var_t) * p->var_size);
+    ((bin_header_t *)w->buf)->var = off;
+    BOR_FREE(bvar);
+}
+
+static void wPartState(bin_writer_t *w, const plan_part_state_t *ps,
+                       bin_part_state_t *bps)
+{
+    bin_part_state_t b;
+
+    b.vals = wAppend(w, ps->vals,
+                     sizeof(plan_part_state_pair_t) * ps->vals_size);
+    b.vals_size = ps->vals_size;
+    b.bufsize = ps->bufsize;
+    b.valbuf = b.maskbuf = -1;
+    if (ps->bufsize > 0){
+        b.valbuf = wAppend(w, ps->valbuf, ps->bufsize);
+        b.maskbuf = wAppend(w, ps->maskbuf, ps->bufsize);
+    }
+
+    *bps = b;
+}
+
+static void wOps(bin_writer_t *w, const plan_problem_t *p)
+{
+    const plan_op_t *op;
+    bin_op_t *bop;
+    bin_cond_eff_t *bce;
+    int64_t off;
+    int i, j;
+
+    bop = BOR_CALLOC_ARR(bin_op_t, BOR_MAX(p->op_size, 1));
+    for (i = 0; i < p->op_size; ++i){
+        op = p->op + i;
+        bop[i].name = wString(w, op->name);
+        wPartState(w, op->pre, &bop[i].pre);
+        wPartState(w, op->eff, &bop[i].eff);
+        bop[i].ownerarr = op->ownerarr;
+        bop[i].cond_eff_size = op->cond_eff_size;
+        bop[i].cost = op->cost;
+        bop[i].global_id = op->global_id;
+        bop[i].owner = op->owner;
+        bop[i].is_private = op->is_private;
+
+        bop[i].cond_eff = -1;
+        if (op->cond_eff_size > 0){
+            bce = BOR_CALLOC_ARR(bin_cond_eff_t, op->cond_eff_size);
+            for (j = 0; j < op->cond_eff_size; ++j){
+                wPartState(w, op->cond_eff[j].pre, &bce[j].pre);
+                wPartState(w, op->cond_eff[j].eff, &bce[j].eff);
+            }
+            bop[i].cond_eff = wAppend(w, bce, sizeof(bin_cond_eff_t)
+                                                * op->cond_eff_size);
+            BOR_FREE(bce);
+        }
+    }
+
+    off = wAppend(w, bop, sizeof(bin_op_t) * p->op_size);
+    ((bin_header_t *)w->buf)->op = off;
+    BOR_FREE(bop);
+}
+
+
+static const void *rPtr(const plan_problem_t *p, int64_t off, size_t size)
+{
+    if (off < 0 || (off & 7) != 0
+            || (uint64_t)off > p->bin_map_size
+            || size > p->bin_map_size - off)
+        return NULL;
+    return (const char *)p->bin_map + off;
+}
+
+static const char *rString(const plan_problem_t *p, int64_t off)
+{
+    const char *str;
+
+    if ((str = rPtr(p, off, 0)) == NULL)
+        return NULL;
+    if (memchr(str, 0, p->bin_map_size - off) == NULL)
+        return NULL;
+    return str;
+}
+
+static int rVars(plan_problem_t *p, const bin_header_t *h)
+{
+    const bin_var_t *bvar;
+    const int32_t *is_val_private;
+    const int64_t *val_name;
+    const char *name;
+    plan_var_t *var;
+    int i, j;
+
+    bvar = rPtr(p, h->var, sizeof(bin_var_t) * h->var_size);
+    if (bvar == NULL)
+        return -1;
+
+    // Variables are small, they are copied so that planVarFree() can be
+    // used on them
+    p->var = BOR_CALLOC_ARR(plan_var_t, h->var_size);
+    p->var_size = h->var_size;
+    for (i = 0; i < p->var_size; ++i){
+        var = p->var + i;
+        var->range = bvar[i].range;
+        var->is_private = bvar[i].is_private;
+        var->ma_privacy = bvar[i].ma_privacy;
+        if (var->range <= 0)
+            return -1;
+        if (var->ma_privacy)
+            p->ma_privacy_var = i;
+
+        if (bvar[i].name >= 0){
+            if ((name = rString(p, bvar[i].name)) == NULL)
+                return -1;
+            var->name = BOR_STRDUP(name);
+        }
+
+        if (bvar[i].is_val_private >= 0){
+            is_val_private = rPtr(p, bvar[i].is_val_private,
+                                  sizeof(int32_t) * var->range);
+            if (is_val_private == NULL)
+                return -1;
+            var->is_val_private = BOR_ALLOC_ARR(int, var->range);
+            for (j = 0; j < var->range; ++j)
+                var->is_val_private[j] = is_val_private[j];
+        }
+
+        if (bvar[i].val_name >= 0){
+            val_name = rPtr(p, bvar[i].val_name, sizeof(int64_t) * var->range);
+            if (val_name == NULL)
+                return -1;
+            var->val_name = BOR_CALLOC_ARR(char *, var->range);
+            for (j = 0; j < var->range; ++j){
+                if (val_name[j] < 0)
+                    continue;
+                if ((name = rString(p, val_name[j])) == NULL)
+                    return -1;
+                var->val_name[j] = BOR_STRDUP(name);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static plan_part_state_t *rPartState(plan_problem_t *p,
+                                     const bin_part_state_t *bps,
+                                     int bufsize)
+{
+    plan_part_state_t *ps;
+    const plan_part_state_pair_t *vals = NULL;
+    const void *valbuf = NULL, *maskbuf = NULL;
+    int i;
+
+    if (bps->vals_size < 0
+            || (bps->bufsize != 0 && bps->bufsize != bufsize))
+        return NULL;
+    if (bps->vals_size > 0){
+        vals = rPtr(p, bps->vals,
+                    sizeof(plan_part_state_pair_t) * bps->vals_size);
+        if (vals == NULL)
+            return NULL;
+        for (i = 0; i < bps->vals_size; ++i){
+            if (vals[i].var < 0 || vals[i].var >= p->var_size
+                    || vals[i].val >= (plan_val_t)p->var[vals[i].var].range)
+                return NULL;
+        }
+    }
+    if (bps->bufsize > 0){
+        valbuf = rPtr(p, bps->valbuf, bps->bufsize);
+        maskbuf = rPtr(p, bps->maskbuf, bps->bufsize);
+        if (valbuf == NULL || maskbuf == NULL)
+            return NULL;
+    }
+
+    // The part-state is read-only because all its arrays point to the
+    // mapped file
+    ps = BOR_ALLOC(plan_part_state_t);
+    planPartStateInit(ps, p->var_size);
+    ps->vals = (plan_part_state_pair_t *)vals;
+    ps->vals_size = bps->vals_size;
+    ps->valbuf = (void *)valbuf;
+    ps->maskbuf = (void *)maskbuf;
+    ps->bufsize = bps->bufsize;
+    return ps;
+}
+
+static int rOps(plan_problem_t *p, const bin_header_t *h)
+{
+    const bin_op_t *bop;
+    const bin_cond_eff_t *bce;
+    plan_op_t *op;
+    int i, j;
+
+    bop = rPtr(p, h->op, sizeof(bin_op_t) * h->op_size);
+    if (bop == NULL)
+        return -1;
+
+    p->op = BOR_CALLOC_ARR(plan_op_t, BOR_MAX(h->op_size, 1));
+    p->op_size = h->op_size;
+    for (i = 0; i < p->op_size; ++i){
+        op = p->op + i;
+        op->cost = bop[i].cost;
+        op->global_id = bop[i].global_id;
+        op->owner = bop[i].owner;
+        op->ownerarr = bop[i].ownerarr;
+        op->is_private = bop[i].is_private;
+        if (bop[i].name >= 0
+                && (op->name = (char *)rString(p, bop[i].name)) == NULL)
+            return -1;
+        if ((op->pre = rPartState(p, &bop[i].pre, h->bufsize)) == NULL
+                || (op->eff = rPartState(p, &bop[i].eff, h->bufsize)) == NULL)
+            return -1;
+
+        if (bop[i].cond_eff_size <= 0)
+            continue;
+        bce = rPtr(p, bop[i].cond_eff,
+                   sizeof(bin_cond_eff_t) * bop[i].cond_eff_size);
+        if (bce == NULL)
+            return -1;
+        op->cond_eff = BOR_CALLOC_ARR(plan_op_cond_eff_t,
+                                      bop[i].cond_eff_size);
+        op->cond_eff_size = bop[i].cond_eff_size;
+        for (j = 0; j < op->cond_eff_size; ++j){
+            op->cond_eff[j].pre = rPartState(p, &bce[j].pre, h->bufsize);
+            op->cond_eff[j].eff = rPartState(p, &bce[j].eff, h->bufsize);
+            if (op->cond_eff[j].pre == NULL || op->cond_eff[j].eff == NULL)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int rProblem(plan_problem_t *p, const bin_header_t *h)
+{
+    const plan_val_t *init;
+    const bin_part_state_t *goal;
+    const void *succ_gen;
+    plan_state_t *state;
+    int i;
+
+    p->ma_privacy_var = -1;
+    p->duplicate_ops_removed = h->duplicate_ops_removed;
+
+    if (rVars(p, h) != 0)
+        return -1;
+
+    p->state_pool = planStatePoolNew(p->var, p->var_size);
+    if (h->bufsize != 0
+            && h->bufsize != planStatePackerBufSize(p->state_pool->packer))
+        return -1;
+
+    init = rPtr(p, h->init, sizeof(plan_val_t) * p->var_size);
+    goal = rPtr(p, h->goal, sizeof(bin_part_state_t));
+    if (init == NULL || goal == NULL)
+        return -1;
+    for (i = 0; i < p->var_size; ++i){
+        if (init[i] >= (plan_val_t)p->var[i].range)
+            return -1;
+    }
+
+    state = planStateNew(p->var_size);
+    for (i = 0; i < p->var_size; ++i)
+        planStateSet(state, i, init[i]);
+    p->initial_state = planStatePoolInsert(p->state_pool, state);
+    planStateDel(state);
+
+    if ((p->goal = rPartState(p, goal, h->bufsize)) == NULL)
+        return -1;
+    if (rOps(p, h) != 0)
+        return -1;
+
+    if (h->succ_gen >= 0){
+        succ_gen = rPtr(p, h->succ_gen, h->succ_gen_size);
+        if (succ_gen == NULL)
+            return -1;
+        p->succ_gen = planSuccGenFromBin(succ_gen, h->succ_gen_size,
+                                         p->op, p->op_size, p->var_size);
+    }else{
+        p->succ_gen = planSuccGenNew(p->op, p->op_size, NULL);
+    }
+    if (p->succ_gen == NULL)
+        return -1;
+
+    if (h->bufsize != 0)
+        planSuccGenPack(p->succ_gen, p->op, p->op_size, 0);
+    return 0;
+}
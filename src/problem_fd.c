@@ -1,5 +1,15 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <boruvka/alloc.h>
 #include "plan/problem.h"
+#include "fd_reader.h"
+
+/** Minimal number of operators parsed by one thread */
+#define OP_MIN_PER_THREAD 4096
 
 static int loadFD(plan_problem_t *plan, const char *filename);
 
@@ -20,24 +30,14 @@ plan_problem_t *planProblemFromFD(const char *fn)
 }
 
 
-static int fdAssert(FILE *fin, const char *str)
-{
-    char read_s[1024];
-    if (fscanf(fin, "%s", read_s) != 1)
-        return -1;
-    if (strcmp(read_s, str) != 0)
-        return -1;
-    return 0;
-}
-
-static int fdVersion(plan_problem_t *plan, FILE *fin)
+static int fdVersion(plan_problem_t *plan, plan_fd_reader_t *r)
 {
     int version;
 
-    if (fdAssert(fin, "begin_version") != 0)
+    if (planFDReaderAssert(r, "begin_version") != 0)
         return -1;
 
-    if (fscanf(fin, "%d", &version) != 1)
+    if (planFDReaderInt(r, &version) != 0)
         return -1;
 
     if (version != 3){
@@ -45,35 +45,41 @@ static int fdVersion(plan_problem_t *plan, FILE *fin)
         return -1;
     }
 
-    if (fdAssert(fin, "end_version") != 0)
+    if (planFDReaderAssert(r, "end_version") != 0)
         return -1;
 
     return 0;
 }
 
-static int fdMetric(FILE *fin)
+static int fdMetric(plan_fd_reader_t *r)
 {
     int val;
 
-    if (fdAssert(fin, "begin_metric") != 0)
+    if (planFDReaderAssert(r, "begin_metric") != 0)
         return -1;
-    if (fscanf(fin, "%d", &val) != 1)
+    if (planFDReaderInt(r, &val) != 0)
         return -1;
-    if (fdAssert(fin, "end_metric") != 0)
+    if (planFDReaderAssert(r, "end_metric") != 0)
         return -1;
     return val;
 }
 
-static int fdVar1(plan_var_t *var, FILE *fin)
+static int fdVar1(plan_var_t *var, plan_fd_reader_t *r)
 {
     plan_val_t i;
-    char sval[1024], *fact_name;
-    size_t size;
-    int layer, range;
+    char sval[1024];
+    const char *word;
+    int len, layer, range;
 
-    if (fdAssert(fin, "begin_variable") != 0)
+    if (planFDReaderAssert(r, "begin_variable") != 0)
+        return -1;
+    if (planFDReaderWord(r, &word, &len) != 0)
         return -1;
-    if (fscanf(fin, "%s %d %d", sval, &layer, &range) != 3)
+    len = BOR_MIN(len, (int)sizeof(sval) - 1);
+    memcpy(sval, word, len);
+    sval[len] = 0x0;
+    if (planFDReaderInt(r, &layer) != 0
+            || planFDReaderInt(r, &range) != 0)
         return -1;
 
     planVarInit(var, sval, range);
@@ -85,33 +91,29 @@ static int fdVar1(plan_var_t *var, FILE *fin)
         return -1;
     }
 
-    fact_name = NULL;
-    size = 0;
-    getline(&fact_name, &size, fin);
-    for (i = 0; i < var->range; ++i){
-        getline(&fact_name, &size, fin);
-    }
-
-    if (fact_name)
-        free(fact_name);
+    // Skip the rest of the line and names of the facts
+    planFDReaderLine(r, &word, &len);
+    for (i = 0; i < var->range; ++i)
+        planFDReaderLine(r, &word, &len);
 
-    if (fdAssert(fin, "end_variable") != 0)
+    if (planFDReaderAssert(r, "end_variable") != 0)
         return -1;
 
     return 0;
 }
 
-static int fdVars(plan_problem_t *plan, FILE *fin)
+static int fdVars(plan_problem_t *plan, plan_fd_reader_t *r)
 {
     int i, num_vars;
 
-    if (fscanf(fin, "%d", &num_vars) != 1)
+    if (planFDReaderInt(r, &num_vars) != 0)
         return -1;
 
     plan->var_size = num_vars;
     plan->var = BOR_CALLOC_ARR(plan_var_t, plan->var_size);
     for (i = 0; i < plan->var_size; ++i){
-        fdVar1(plan->var + i, fin);
+        if (fdVar1(plan->var + i, r) != 0)
+            return -1;
     }
 
     // create state pool
@@ -120,126 +122,130 @@ static int fdVars(plan_problem_t *plan, FILE *fin)
     return 0;
 }
 
-static int fdMutexes(plan_problem_t *plan, FILE *fin)
+static int fdMutexes(plan_problem_t *plan, plan_fd_reader_t *r)
 {
     int i, j, len;
     int num_facts, var, val;
 
-    if (fscanf(fin, "%d", &len) != 1)
+    if (planFDReaderInt(r, &len) != 0)
         return -1;
 
     for (i = 0; i < len; ++i){
-        if (fdAssert(fin, "begin_mutex_group") != 0)
+        if (planFDReaderAssert(r, "begin_mutex_group") != 0)
             return -1;
-        if (fscanf(fin, "%d", &num_facts) != 1)
+        if (planFDReaderInt(r, &num_facts) != 0)
             return -1;
 
         for (j = 0; j < num_facts; ++j){
-            if (fscanf(fin, "%d %d", &var, &val) != 2)
+            if (planFDReaderInt(r, &var) != 0
+                    || planFDReaderInt(r, &val) != 0)
                 return -1;
         }
 
-        if (fdAssert(fin, "end_mutex_group") != 0)
+        if (planFDReaderAssert(r, "end_mutex_group") != 0)
             return -1;
     }
 
     return 0;
 }
 
-static int fdInitState(plan_problem_t *plan, FILE *fin)
+static int fdInitState(plan_problem_t *plan, plan_fd_reader_t *r)
 {
     plan_state_t *state;
     int var, val;
 
-    if (fdAssert(fin, "begin_state") != 0)
+    if (planFDReaderAssert(r, "begin_state") != 0)
         return -1;
 
     state = planStateNew(plan->state_pool->num_vars);
     for (var = 0; var < plan->var_size; ++var){
-        if (fscanf(fin, "%d", &val) != 1)
+        if (planFDReaderInt(r, &val) != 0){
+            planStateDel(state);
             return -1;
+        }
         planStateSet(state, var, val);
     }
     plan->initial_state = planStatePoolInsert(plan->state_pool, state);
 
     planStateDel(state);
 
-    if (fdAssert(fin, "end_state") != 0)
+    if (planFDReaderAssert(r, "end_state") != 0)
         return -1;
 
     return 0;
 }
 
-static int fdGoal(plan_problem_t *plan, FILE *fin)
+static int fdGoal(plan_problem_t *plan, plan_fd_reader_t *r)
 {
     int i, len, var, val;
 
-    if (fdAssert(fin, "begin_goal") != 0)
+    if (planFDReaderAssert(r, "begin_goal") != 0)
         return -1;
 
-    if (fscanf(fin, "%d", &len) != 1)
+    if (planFDReaderInt(r, &len) != 0)
         return -1;
 
     plan->goal = planPartStateNew(plan->state_pool->num_vars);
     for (i = 0; i < len; ++i){
-        if (fscanf(fin, "%d %d", &var, &val) != 2)
+        if (planFDReaderInt(r, &var) != 0
+                || planFDReaderInt(r, &val) != 0)
             return -1;
         planPartStateSet(plan->goal, var, val);
     }
 
-    if (fdAssert(fin, "end_goal") != 0)
+    if (planFDReaderAssert(r, "end_goal") != 0)
         return -1;
 
     return 0;
 }
 
-static int fdOperator(plan_op_t *op, FILE *fin, int use_metric)
+static int fdOperator(plan_op_t *op, plan_fd_reader_t *r, int use_metric)
 {
-    char *name;
-    size_t name_size;
-    ssize_t name_len;
+    const char *name;
+    int name_len;
     int i, len, var, cond, ci, pre, post, cost;
     int cond_eff_id = 0;
 
-    if (fdAssert(fin, "begin_operator") != 0)
+    if (planFDReaderAssert(r, "begin_operator") != 0)
         return -1;
 
-    name = NULL;
-    name_size = 0;
-    getline(&name, &name_size, fin);
-    name_len = getline(&name, &name_size, fin);
-    if (name_len > 0)
-        name[name_len - 1] = 0x0;
-    op->name = strdup(name);
-
-    if (name)
-        free(name);
+    // Skip the rest of the line and read the name from the next one
+    planFDReaderLine(r, &name, &name_len);
+    if (planFDReaderLine(r, &name, &name_len) != 0)
+        return -1;
+    op->name = BOR_ALLOC_ARR(char, name_len + 1);
+    memcpy(op->name, name, name_len);
+    op->name[name_len] = 0x0;
 
     // prevail
-    if (fscanf(fin, "%d", &len) != 1)
+    if (planFDReaderInt(r, &len) != 0)
         return -1;
     for (i = 0; i < len; ++i){
-        if (fscanf(fin, "%d %d", &var, &pre) != 2)
+        if (planFDReaderInt(r, &var) != 0
+                || planFDReaderInt(r, &pre) != 0)
             return -1;
         planOpSetPre(op, var, pre);
     }
 
     // pre-post
-    if (fscanf(fin, "%d", &len) != 1)
+    if (planFDReaderInt(r, &len) != 0)
         return -1;
     for (i = 0; i < len; ++i){
-        if (fscanf(fin, "%d", &cond) != 1)
+        if (planFDReaderInt(r, &cond) != 0)
             return -1;
         if (cond > 0){
             cond_eff_id = planOpAddCondEff(op);
             for (ci = 0; ci < cond; ++ci){
-                if (fscanf(fin, "%d %d", &var, &pre) != 2)
+                if (planFDReaderInt(r, &var) != 0
+                        || planFDReaderInt(r, &pre) != 0)
                     return -1;
                 planOpCondEffSetPre(op, cond_eff_id, var, pre);
             }
         }
 
-        if (fscanf(fin, "%d %d %d", &var, &pre, &post) != 3)
+        if (planFDReaderInt(r, &var) != 0
+                || planFDReaderInt(r, &pre) != 0
+                || planFDReaderInt(r, &post) != 0)
             return -1;
 
         if (pre != -1)
@@ -254,21 +260,113 @@ static int fdOperator(plan_op_t *op, FILE *fin, int use_metric)
 
     planOpCondEffSimplify(op);
 
-    if (fscanf(fin, "%d", &cost) != 1)
+    if (planFDReaderInt(r, &cost) != 0)
         return -1;
     op->cost = (use_metric ? cost : 1);
 
-    if (fdAssert(fin, "end_operator") != 0)
+    if (planFDReaderAssert(r, "end_operator") != 0)
         return -1;
 
     return 0;
 }
 
-static int fdOperators(plan_problem_t *plan, FILE *fin, int use_metric)
+/** Moves the reader behind the next line consisting of the "end_operator"
+ *  token. Returns -1 if there is no such line. */
+static int fdSkipOperator(plan_fd_reader_t *r)
+{
+    const char *line;
+    int len;
+
+    while (planFDReaderLine(r, &line, &len) == 0){
+        while (len > 0 && (*line == ' ' || *line == '\t')){
+            ++line;
+            --len;
+        }
+        while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' '
+                            || line[len - 1] == '\t'))
+            --len;
+        if (len == 12 && strncmp(line, "end_operator", 12) == 0)
+            return 0;
+    }
+    return -1;
+}
+
+/** Thread parsing one contiguous block of operators. Operator i is
+ *  stored between bound[i] and bound[i + 1]. */
+struct _fd_op_th_t {
+    pthread_t th;
+    plan_op_t *op;
+    const char **bound;
+    int from;
+    int to;
+    int use_metric;
+    int ret;
+};
+typedef struct _fd_op_th_t fd_op_th_t;
+
+static void *fdOperatorTh(void *_th)
+{
+    fd_op_th_t *th = _th;
+    plan_fd_reader_t r;
+    int i;
+
+    th->ret = 0;
+    for (i = th->from; i < th->to && th->ret == 0; ++i){
+        planFDReaderInit(&r, th->bound[i], th->bound[i + 1] - th->bound[i]);
+        th->ret = fdOperator(th->op + i, &r, th->use_metric);
+    }
+    return NULL;
+}
+
+/** Splits the operators into blocks first and then parses the blocks in
+ *  parallel */
+static int fdOperatorsParallel(plan_problem_t *plan, plan_fd_reader_t *r,
+                               int use_metric, int num_threads)
 {
-    int i, num_ops;
+    fd_op_th_t *th;
+    const char **bound;
+    int i, ret;
+
+    bound = BOR_ALLOC_ARR(const char *, plan->op_size + 1);
+    for (i = 0; i < plan->op_size; ++i){
+        bound[i] = r->cur;
+        if (fdSkipOperator(r) != 0){
+            BOR_FREE(bound);
+            return -1;
+        }
+    }
+    bound[plan->op_size] = r->cur;
+
+    th = BOR_ALLOC_ARR(fd_op_th_t, num_threads);
+    for (i = 0; i < num_threads; ++i){
+        th[i].op = plan->op;
+        th[i].bound = bound;
+        th[i].from = ((long)plan->op_size * i) / num_threads;
+        th[i].to = ((long)plan->op_size * (i + 1)) / num_threads;
+        th[i].use_metric = use_metric;
+    }
+    for (i = 0; i < num_threads; ++i)
+        pthread_create(&th[i].th, NULL, fdOperatorTh, th + i);
+    for (i = 0; i < num_threads; ++i)
+        pthread_join(th[i].th, NULL);
+
+    ret = 0;
+    for (i = 0; i < num_threads; ++i){
+        if (th[i].ret != 0)
+            ret = -1;
+    }
+
+    BOR_FREE(th);
+    BOR_FREE(bound);
+    return ret;
+}
 
-    if (fscanf(fin, "%d", &num_ops) != 1)
+static int fdOperators(plan_problem_t *plan, plan_fd_reader_t *r,
+                       int use_metric)
+{
+    int i, num_ops, num_threads;
+
+    if (planFDReaderInt(r, &num_ops) != 0 || num_ops < 0)
         return -1;
 
     plan->op_size = num_ops;
@@ -277,22 +375,24 @@ static int fdOperators(plan_problem_t *plan, FILE *fin, int use_metric)
         planOpInit(plan->op + i, plan->state_pool->num_vars);
     }
 
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = BOR_MIN(num_threads, num_ops / OP_MIN_PER_THREAD);
+    if (num_threads > 1)
+        return fdOperatorsParallel(plan, r, use_metric, num_threads);
+
     for (i = 0; i < num_ops; ++i){
-        if (fdOperator(plan->op + i, fin, use_metric) != 0)
+        if (fdOperator(plan->op + i, r, use_metric) != 0)
             return -1;
     }
 
     return 0;
 }
 
-static int fdAxioms(plan_problem_t *plan, FILE *fin)
+static int fdAxioms(plan_problem_t *plan, plan_fd_reader_t *r)
 {
-    int i, len;
-    char *line;
-    size_t line_size;
-    ssize_t line_len;
+    int len;
 
-    if (fscanf(fin, "%d", &len) != 1)
+    if (planFDReaderInt(r, &len) != 0)
         return -1;
 
     if (len > 0){
@@ -300,47 +400,35 @@ static int fdAxioms(plan_problem_t *plan, FILE *fin)
         return -1;
     }
 
-    line = NULL;
-    line_size = 0;
-    for (i = 0; i < len; ++i){
-        while (1){
-            line_len = getline(&line, &line_size, fin);
-            if (line_len > 1){
-                line[line_len - 1] = 0;
-                if (strcmp(line, "end_operator") == 0)
-                    break;
-            }
-        }
-    }
-
     return 0;
 }
 
-static int loadFDBase(plan_problem_t *plan, FILE *fin,
+static int loadFDBase(plan_problem_t *plan, plan_fd_reader_t *r,
                       int *use_metric_out)
 {
     int use_metric;
 
-    if (fdVersion(plan, fin) != 0)
+    if (fdVersion(plan, r) != 0)
         return -1;
-    if ((use_metric = fdMetric(fin)) < 0)
+    if ((use_metric = fdMetric(r)) < 0)
         return -1;
-    if (fdVars(plan, fin) != 0)
+    if (fdVars(plan, r) != 0)
         return -1;
-    if (fdMutexes(plan, fin) != 0)
+    if (fdMutexes(plan, r) != 0)
         return -1;
-    if (fdInitState(plan, fin) != 0)
+    if (fdInitState(plan, r) != 0)
         return -1;
-    if (fdGoal(plan, fin) != 0)
+    if (fdGoal(plan, r) != 0)
         return -1;
-    if (fdOperators(plan, fin, use_metric) != 0)
+    if (fdOperators(plan, r, use_metric) != 0)
         return -1;
-    if (fdAxioms(plan, fin) != 0)
+    if (fdAxioms(plan, r) != 0)
         return -1;
 
-    if (fdAssert(fin, "begin_SG") == 0){
-        plan->succ_gen = planSuccGenFromFD(fin, plan->var, plan->op);
-        if (fdAssert(fin, "end_SG") != 0)
+    if (planFDReaderAssert(r, "begin_SG") == 0){
+        plan->succ_gen = planSuccGenFromFDBuf(&r->cur, r->end,
+                                              plan->var, plan->op);
+        if (planFDReaderAssert(r, "end_SG") != 0)
             return -1;
     }else{
         plan->succ_gen = planSuccGenNew(plan->op, plan->op_size, NULL);
@@ -354,18 +442,30 @@ static int loadFDBase(plan_problem_t *plan, FILE *fin,
 
 static int loadFD(plan_problem_t *plan, const char *filename)
 {
-    FILE *fin;
+    plan_fd_reader_t r;
+    struct stat st;
+    void *map;
+    int fd, ret;
 
-    fin = fopen(filename, "r");
-    if (fin == NULL){
+    fd = open(filename, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st) != 0 || st.st_size == 0){
         fprintf(stderr, "Error: Could not read `%s'.\n", filename);
+        if (fd != -1)
+            close(fd);
         return -1;
     }
 
-    if (loadFDBase(plan, fin, NULL) != 0)
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        fprintf(stderr, "Error: Could not read `%s'.\n", filename);
         return -1;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
 
-    fclose(fin);
+    planFDReaderInit(&r, map, st.st_size);
+    ret = loadFDBase(plan, &r, NULL);
 
-    return 0;
+    munmap(map, st.st_size);
+    return ret;
 }
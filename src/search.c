@@ -22,9 +22,13 @@
 
 #include "plan/search.h"
 
-static plan_state_id_t extractPath(plan_state_space_t *state_space,
+static plan_state_id_t extractPath(const plan_search_t *search,
                                    plan_state_id_t goal_state,
                                    plan_path_t *path);
+/** Extracts path found among canonical states (see plan/symmetry.h) */
+static plan_state_id_t extractPathSymmetry(const plan_search_t *search,
+                                           plan_state_id_t goal_state,
+                                           plan_path_t *path);
 static void _planSearchLoadState(plan_search_t *search,
                                  plan_state_id_t state_id);
 
@@ -71,7 +75,7 @@ int planSearchRun(plan_search_t *search, plan_path_t *path)
 
     if (res == PLAN_SEARCH_FOUND){
         if (search->goal_state != PLAN_NO_STATE)
-            extractPath(search->state_space, search->goal_state, path);
+            extractPath(search, search->goal_state, path);
         planSearchStatSetFound(&search->stat);
     }else{
         planSearchStatSetNotFound(&search->stat);
@@ -95,7 +99,7 @@ plan_state_id_t planSearchExtractPath(const plan_search_t *search,
                                       plan_state_id_t goal_state,
                                       plan_path_t *path)
 {
-    return extractPath(search->state_space, goal_state, path);
+    return extractPath(search, goal_state, path);
 }
 
 plan_cost_t planSearchStateHeur(const plan_search_t *search,
@@ -191,12 +195,27 @@ void _planSearchInit(plan_search_t *search,
     search->state_id = PLAN_NO_STATE;
     planSearchStatInit(&search->stat);
     planSearchApplicableOpsInit(&search->app_ops, params->prob->op_size);
+    search->stubborn = NULL;
+    search->symmetry = NULL;
+    search->reinsert_closed = 0;
+    if (params->stubborn_sets){
+        search->stubborn = BOR_ALLOC(plan_search_stubborn_t);
+        planSearchStubbornInit(search->stubborn, params->prob);
+    }
     search->goal_state  = PLAN_NO_STATE;
 }
 
 void _planSearchFree(plan_search_t *search)
 {
     planSearchApplicableOpsFree(&search->app_ops);
+    if (search->stubborn){
+        planSearchStubbornFree(search->stubborn);
+        BOR_FREE(search->stubborn);
+    }
+    if (search->symmetry){
+        planSymmetryFree(search->symmetry);
+        BOR_FREE(search->symmetry);
+    }
     if (search->heur && search->heur_del)
         planHeurDel(search->heur);
     if (search->state)
@@ -208,9 +227,25 @@ void _planSearchFree(plan_search_t *search)
 int _planSearchFindApplicableOps(plan_search_t *search,
                                  plan_state_id_t state_id)
 {
+    const void *bufstate;
+    int found;
+
     _planSearchLoadState(search, state_id);
-    return planSearchApplicableOpsFind(&search->app_ops, search->state,
-                                       state_id, search->succ_gen);
+    if (planSuccGenUseMask(search->succ_gen)){
+        bufstate = planStatePoolGetPackedState(search->state_pool, state_id);
+        found = planSearchApplicableOpsFindPacked(&search->app_ops,
+                                                  search->state_pool->packer,
+                                                  bufstate, state_id,
+                                                  search->succ_gen);
+    }else{
+        found = planSearchApplicableOpsFind(&search->app_ops, search->state,
+                                            state_id, search->succ_gen);
+    }
+
+    if (found && search->stubborn)
+        planSearchStubbornPrune(search->stubborn, search->state,
+                                &search->app_ops);
+    return found;
 }
 
 int _planSearchHeur(plan_search_t *search,
@@ -236,6 +271,12 @@ int _planSearchHeur(plan_search_t *search,
                             " Multi agent heuristic cannot be computed!\n");
             res.heur = PLAN_HEUR_DEAD_END;
         }
+    }else if (search->symmetry){
+        // The canonical state was not created by applying node->op on
+        // the parent state, so node-based (incremental) heuristics would
+        // compute the value from a wrong state
+        planHeurState(search->heur,
+                      planSearchLoadState(search, node->state_id), &res);
     }else{
         planHeurNode(search->heur, node->state_id, search, &res);
     }
@@ -264,12 +305,16 @@ int _planSearchCheckGoal(plan_search_t *search, plan_state_space_node_t *node)
 }
 
 
-static plan_state_id_t extractPath(plan_state_space_t *state_space,
+static plan_state_id_t extractPath(const plan_search_t *search,
                                    plan_state_id_t goal_state,
                                    plan_path_t *path)
 {
+    plan_state_space_t *state_space = search->state_space;
     plan_state_space_node_t *node;
 
+    if (search->symmetry)
+        return extractPathSymmetry(search, goal_state, path);
+
     planPathInit(path);
 
     node = planStateSpaceNode(state_space, goal_state);
@@ -284,6 +329,46 @@ static plan_state_id_t extractPath(plan_state_space_t *state_space,
     return PLAN_NO_STATE;
 }
 
+static plan_state_id_t extractPathSymmetry(const plan_search_t *search,
+                                           plan_state_id_t goal_state,
+                                           plan_path_t *path)
+{
+    plan_state_space_node_t *node;
+    plan_op_t **op;
+    plan_state_id_t *state;
+    int i, op_size;
+
+    planPathInit(path);
+
+    op_size = 0;
+    node = planStateSpaceNode(search->state_space, goal_state);
+    while (node->op){
+        ++op_size;
+        node = planStateSpaceNode(search->state_space,
+                                  node->parent_state_id);
+    }
+
+    op = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(op_size, 1));
+    state = BOR_ALLOC_ARR(plan_state_id_t, op_size + 1);
+    node = planStateSpaceNode(search->state_space, goal_state);
+    for (i = op_size - 1; i >= 0; --i){
+        op[i] = node->op;
+        node = planStateSpaceNode(search->state_space,
+                                  node->parent_state_id);
+    }
+
+    // The operators were applied on canonical states, so they must be
+    // mapped back to the states reachable from the initial state
+    planSymmetryRepairPath(search->symmetry, search->state_pool,
+                           search->initial_state, op, op_size, state);
+    for (i = op_size - 1; i >= 0; --i)
+        planPathPrependOp(path, op[i], state[i], state[i + 1]);
+
+    BOR_FREE(op);
+    BOR_FREE(state);
+    return search->initial_state;
+}
+
 static void _planSearchLoadState(plan_search_t *search,
                                  plan_state_id_t state_id)
 {
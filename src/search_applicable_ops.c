@@ -20,6 +20,28 @@
 #include <boruvka/alloc.h>
 
 #include "plan/search_applicable_ops.h"
+#include "fact_op_cross_ref.h"
+
+/** Sets .base[] to the applicable operators of the parent state */
+static void incSetBase(plan_search_applicable_ops_t *app,
+                       plan_search_applicable_ops_inc_t *inc,
+                       plan_state_id_t parent_state_id,
+                       plan_state_pool_t *state_pool,
+                       const plan_succ_gen_t *succ_gen);
+/** Marks variables that can be changed by the operator */
+static void incMarkVars(plan_search_applicable_ops_inc_t *inc,
+                        const plan_op_t *op);
+/** Returns true if the operator has precondition on a marked variable */
+static int incTouchesMarked(const plan_search_applicable_ops_inc_t *inc,
+                            const plan_op_t *op);
+/** Adds operators enabled by the value of the variable in the state to
+ *  app->op[] starting at found. Returns the new number of operators. */
+static int incAddVar(plan_search_applicable_ops_t *app,
+                     plan_search_applicable_ops_inc_t *inc,
+                     const plan_state_t *state, plan_var_id_t var,
+                     int found);
+/** Returns true if the operator is applicable in the state */
+static int isApplicable(const plan_op_t *op, const plan_state_t *state);
 
 
 void planSearchApplicableOpsInit(plan_search_applicable_ops_t *app_ops,
@@ -52,3 +74,214 @@ int planSearchApplicableOpsFind(plan_search_applicable_ops_t *app,
     app->state = state_id;
     return 1;
 }
+
+int planSearchApplicableOpsFindPacked(plan_search_applicable_ops_t *app,
+                                      const plan_state_packer_t *packer,
+                                      const void *bufstate,
+                                      plan_state_id_t state_id,
+                                      const plan_succ_gen_t *succ_gen)
+{
+    if (state_id == app->state)
+        return 0;
+
+    app->op_found = planSuccGenFindPacked(succ_gen, packer, bufstate,
+                                          app->op, app->op_size);
+    app->op_preferred = 0;
+    app->state = state_id;
+    return 1;
+}
+
+void planSearchApplicableOpsIncInit(plan_search_applicable_ops_inc_t *inc,
+                                    const plan_problem_t *prob)
+{
+    plan_fact_op_cross_ref_t cref;
+    int i, j, fact_id, size;
+
+    planFactOpCrossRefInit(&cref, prob->var, prob->var_size, prob->goal,
+                           prob->op, prob->op_size);
+
+    inc->op = prob->op;
+    inc->var_fact = BOR_ALLOC_ARR(int, prob->var_size);
+    for (i = 0; i < prob->var_size; ++i)
+        inc->var_fact[i] = planFactId(&cref.fact_id, i, 0);
+
+    // Keep only the real operators, conditional effects and the
+    // artificial goal operator have IDs above prob->op_size.
+    inc->fact_op_begin = BOR_ALLOC_ARR(int, cref.fact_id.fact_size + 1);
+    for (size = 0, fact_id = 0; fact_id < cref.fact_id.fact_size; ++fact_id){
+        inc->fact_op_begin[fact_id] = size;
+        for (j = 0; j < cref.fact_pre[fact_id].size; ++j){
+            if (cref.fact_pre[fact_id].op[j] < prob->op_size)
+                ++size;
+        }
+    }
+    inc->fact_op_begin[fact_id] = size;
+
+    inc->fact_op = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+    for (size = 0, fact_id = 0; fact_id < cref.fact_id.fact_size; ++fact_id){
+        for (j = 0; j < cref.fact_pre[fact_id].size; ++j){
+            if (cref.fact_pre[fact_id].op[j] < prob->op_size)
+                inc->fact_op[size++] = cref.fact_pre[fact_id].op[j];
+        }
+    }
+
+    planFactOpCrossRefFree(&cref);
+
+    inc->var_mark = BOR_CALLOC_ARR(int, prob->var_size);
+    inc->op_mark = BOR_CALLOC_ARR(int, BOR_MAX(prob->op_size, 1));
+    inc->mark = 0;
+
+    inc->base = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(prob->op_size, 1));
+    inc->base_size = 0;
+    inc->base_state = PLAN_NO_STATE;
+    inc->state = planStateNew(prob->var_size);
+}
+
+void planSearchApplicableOpsIncFree(plan_search_applicable_ops_inc_t *inc)
+{
+    BOR_FREE(inc->var_fact);
+    BOR_FREE(inc->fact_op_begin);
+    BOR_FREE(inc->fact_op);
+    BOR_FREE(inc->var_mark);
+    BOR_FREE(inc->op_mark);
+    BOR_FREE(inc->base);
+    planStateDel(inc->state);
+}
+
+int planSearchApplicableOpsFindInc(plan_search_applicable_ops_t *app,
+                                   plan_search_applicable_ops_inc_t *inc,
+                                   const plan_state_t *state,
+                                   plan_state_id_t state_id,
+                                   plan_state_id_t parent_state_id,
+                                   const plan_op_t *parent_op,
+                                   plan_state_pool_t *state_pool,
+                                   const plan_succ_gen_t *succ_gen)
+{
+    plan_op_t *op;
+    plan_var_id_t var;
+    int i, j, found;
+
+    if (state_id == app->state)
+        return 0;
+
+    incSetBase(app, inc, parent_state_id, state_pool, succ_gen);
+
+    ++inc->mark;
+    incMarkVars(inc, parent_op);
+
+    // Keep the parent's operators not depending on the changed variables
+    found = 0;
+    for (i = 0; i < inc->base_size; ++i){
+        op = inc->base[i];
+        if (!incTouchesMarked(inc, op)){
+            app->op[found++] = op;
+            inc->op_mark[op - inc->op] = inc->mark;
+        }
+    }
+
+    // Add operators with a precondition on the new values of the changed
+    // variables
+    PLAN_PART_STATE_FOR_EACH_VAR(parent_op->eff, i, var)
+        found = incAddVar(app, inc, state, var, found);
+    for (j = 0; j < parent_op->cond_eff_size; ++j){
+        PLAN_PART_STATE_FOR_EACH_VAR(parent_op->cond_eff[j].eff, i, var)
+            found = incAddVar(app, inc, state, var, found);
+    }
+
+    app->op_found = found;
+    app->op_preferred = 0;
+    app->state = state_id;
+    return 1;
+}
+
+static void incSetBase(plan_search_applicable_ops_t *app,
+                       plan_search_applicable_ops_inc_t *inc,
+                       plan_state_id_t parent_state_id,
+                       plan_state_pool_t *state_pool,
+                       const plan_succ_gen_t *succ_gen)
+{
+    plan_op_t **tmp;
+
+    if (app->state == parent_state_id){
+        // The parent's operators are going to be overwritten, so just
+        // swap the buffers
+        tmp = inc->base;
+        inc->base = app->op;
+        app->op = tmp;
+        inc->base_size = app->op_found;
+        inc->base_state = parent_state_id;
+        app->state = PLAN_NO_STATE;
+
+    }else if (inc->base_state != parent_state_id){
+        planStatePoolGetState(state_pool, parent_state_id, inc->state);
+        inc->base_size = planSuccGenFind(succ_gen, inc->state,
+                                         inc->base, app->op_size);
+        inc->base_state = parent_state_id;
+    }
+}
+
+static void incMarkVars(plan_search_applicable_ops_inc_t *inc,
+                        const plan_op_t *op)
+{
+    plan_var_id_t var;
+    int i, j;
+
+    PLAN_PART_STATE_FOR_EACH_VAR(op->eff, i, var)
+        inc->var_mark[var] = inc->mark;
+
+    for (j = 0; j < op->cond_eff_size; ++j){
+        PLAN_PART_STATE_FOR_EACH_VAR(op->cond_eff[j].eff, i, var)
+            inc->var_mark[var] = inc->mark;
+    }
+}
+
+static int incTouchesMarked(const plan_search_applicable_ops_inc_t *inc,
+                            const plan_op_t *op)
+{
+    plan_var_id_t var;
+    int i;
+
+    PLAN_PART_STATE_FOR_EACH_VAR(op->pre, i, var){
+        if (inc->var_mark[var] == inc->mark)
+            return 1;
+    }
+    return 0;
+}
+
+static int incAddVar(plan_search_applicable_ops_t *app,
+                     plan_search_applicable_ops_inc_t *inc,
+                     const plan_state_t *state, plan_var_id_t var,
+                     int found)
+{
+    int i, op_id, fact_id;
+
+    if (inc->var_fact[var] < 0)
+        return found;
+
+    fact_id = inc->var_fact[var] + planStateGet(state, var);
+    for (i = inc->fact_op_begin[fact_id];
+            i < inc->fact_op_begin[fact_id + 1]; ++i){
+        op_id = inc->fact_op[i];
+        if (inc->op_mark[op_id] == inc->mark)
+            continue;
+        inc->op_mark[op_id] = inc->mark;
+
+        if (isApplicable(inc->op + op_id, state))
+            app->op[found++] = inc->op + op_id;
+    }
+
+    return found;
+}
+
+static int isApplicable(const plan_op_t *op, const plan_state_t *state)
+{
+    plan_var_id_t var;
+    plan_val_t val;
+    int i;
+
+    PLAN_PART_STATE_FOR_EACH(op->pre, i, var, val){
+        if (planStateGet(state, var) != val)
+            return 0;
+    }
+    return 1;
+}
@@ -27,6 +27,8 @@ struct _plan_search_astar_t {
 
     plan_list_t *list; /*!< Open-list */
     int pathmax;       /*!< Use pathmax correction */
+    plan_state_t *state; /*!< Copy of the expanded state used with
+                              symmetries */
 };
 typedef struct _plan_search_astar_t plan_search_astar_t;
 
@@ -66,6 +68,25 @@ plan_search_t *planSearchAStarNew(const plan_search_astar_params_t *params)
 
     astar->list     = planListTieBreaking(2);
     astar->pathmax  = params->pathmax;
+    astar->state    = NULL;
+
+    // Agents' problems do not contain operators of the other agents, so
+    // the symmetries found in them need not be symmetries of the whole
+    // problem
+    if (params->symmetry && params->search.prob->agent_name == NULL){
+        astar->search.symmetry = BOR_ALLOC(plan_symmetry_t);
+        planSymmetryInit(astar->search.symmetry, params->search.prob);
+        astar->search.stat.symmetry_generators
+                = astar->search.symmetry->gen_size;
+
+        if (astar->search.symmetry->gen_size == 0){
+            planSymmetryFree(astar->search.symmetry);
+            BOR_FREE(astar->search.symmetry);
+            astar->search.symmetry = NULL;
+        }else{
+            astar->state = planStateNew(params->search.prob->var_size);
+        }
+    }
 
     return &astar->search;
 }
@@ -77,6 +98,8 @@ static void planSearchAStarDel(plan_search_t *search)
     _planSearchFree(search);
     if (astar->list)
         planListDel(astar->list);
+    if (astar->state)
+        planStateDel(astar->state);
     BOR_FREE(astar);
 }
 
@@ -150,8 +173,15 @@ static int planSearchAStarInit(plan_search_t *search)
 {
     plan_search_astar_t *astar = SEARCH_FROM_PARENT(search);
     plan_state_space_node_t *node;
+    plan_state_id_t state_id = search->initial_state;
+
+    if (search->symmetry){
+        state_id = planSymmetryCanonicalStateId(search->symmetry,
+                                                search->state_pool,
+                                                state_id, NULL);
+    }
 
-    node = planStateSpaceNode(search->state_space, search->initial_state);
+    node = planStateSpaceNode(search->state_space, state_id);
     return astarInsertState(astar, node, NULL, NULL);
 }
 
@@ -161,7 +191,7 @@ static int planSearchAStarStep(plan_search_t *search)
     plan_cost_t cost[2], g_cost;
     plan_state_id_t cur_state, next_state;
     plan_state_space_node_t *cur_node, *next_node;
-    int i, op_size, res;
+    int i, op_size, res, pruned;
     plan_op_t **op;
 
     // Get next state from open list
@@ -187,12 +217,24 @@ static int planSearchAStarStep(plan_search_t *search)
     planSearchStatIncExpandedStates(&search->stat);
     _planSearchExpandedNode(search, cur_node);
 
+    // Keep own copy of the expanded state, because search->state can be
+    // overwritten during evaluation of the successors
+    if (search->symmetry)
+        planStatePoolGetState(search->state_pool, cur_state, astar->state);
+
     // Add states created by applicable operators
     op      = search->app_ops.op;
     op_size = search->app_ops.op_found;
     for (i = 0; i < op_size; ++i){
         // Create a new state
-        next_state = planOpApply(op[i], search->state_pool, cur_state);
+        if (search->symmetry){
+            next_state = planSymmetryApplyOp(search->symmetry,
+                                             search->state_pool,
+                                             astar->state, op[i], &pruned);
+            search->stat.symmetry_pruned += pruned;
+        }else{
+            next_state = planOpApply(op[i], search->state_pool, cur_state);
+        }
         // Compute its g() value
         g_cost = cur_node->cost + op[i]->cost;
 
@@ -49,6 +49,10 @@ plan_search_t *planSearchLazyNew(const plan_search_lazy_params_t *params)
                     NULL);
     planSearchLazyBaseInit(lazy, params->list, params->list_del,
                            params->use_preferred_ops);
+    // The incremental computation needs the full set of applicable
+    // operators of the parent state
+    if (params->inc_app_ops && !params->search.stubborn_sets)
+        planSearchLazyBaseIncAppOps(lazy, params->search.prob);
 
     return &lazy->search;
 }
@@ -17,6 +17,8 @@
  * See the License for more information.
  */
 
+#include <boruvka/alloc.h>
+
 #include "search_lazy_base.h"
 
 /**
@@ -37,12 +39,26 @@ void planSearchLazyBaseInit(plan_search_lazy_base_t *lb,
     lb->list = list;
     lb->list_del = list_del;
     lb->use_preferred_ops = use_preferred_ops;
+    lb->app_ops_inc = NULL;
+    // Nodes are closed as soon as they are created
+    lb->search.reinsert_closed = 1;
+}
+
+void planSearchLazyBaseIncAppOps(plan_search_lazy_base_t *lb,
+                                 const plan_problem_t *prob)
+{
+    lb->app_ops_inc = BOR_ALLOC(plan_search_applicable_ops_inc_t);
+    planSearchApplicableOpsIncInit(lb->app_ops_inc, prob);
 }
 
 void planSearchLazyBaseFree(plan_search_lazy_base_t *lb)
 {
     if (lb->list_del && lb->list)
         planListLazyDel(lb->list);
+    if (lb->app_ops_inc){
+        planSearchApplicableOpsIncFree(lb->app_ops_inc);
+        BOR_FREE(lb->app_ops_inc);
+    }
 }
 
 int planSearchLazyBaseInitStep(plan_search_t *search)
@@ -151,6 +167,7 @@ static plan_state_space_node_t *createNode(plan_search_lazy_base_t *lb,
 {
     plan_search_t *search = &lb->search;
     plan_state_id_t cur_state_id;
+    const plan_state_t *cur_state;
     plan_state_space_node_t *cur_node, *parent_node;
     plan_cost_t cur_heur;
     plan_search_applicable_ops_t *pref_ops = NULL;
@@ -164,11 +181,31 @@ static plan_state_space_node_t *createNode(plan_search_lazy_base_t *lb,
         return NULL;
     }
 
-    cur_node->parent_state_id = parent_state_id;
-    cur_node->op = parent_op;
+    // get parent node for path cost computation
+    parent_node = planStateSpaceNode(search->state_space, parent_state_id);
+
+    // The cost is set before the heuristic is computed, because in
+    // multi-agent search the evaluation can be finished later (and the
+    // node inserted into open-list) when the other agents respond. If the
+    // state is already waiting for its heuristic value, it was reached
+    // again from another parent and the first path is kept.
+    if (cur_node->cost == -1){
+        cur_node->parent_state_id = parent_state_id;
+        cur_node->op = parent_op;
+        cur_node->cost = parent_node->cost + parent_op->cost;
+    }
 
     // find applicable operators in the current state
-    _planSearchFindApplicableOps(search, cur_state_id);
+    if (lb->app_ops_inc){
+        cur_state = planSearchLoadState(search, cur_state_id);
+        planSearchApplicableOpsFindInc(&search->app_ops, lb->app_ops_inc,
+                                       cur_state, cur_state_id,
+                                       parent_state_id,
+                                       parent_op, search->state_pool,
+                                       search->succ_gen);
+    }else{
+        _planSearchFindApplicableOps(search, cur_state_id);
+    }
 
     // compute heuristic value for the current node
     if (lb->use_preferred_ops)
@@ -187,13 +224,9 @@ static plan_state_space_node_t *createNode(plan_search_lazy_base_t *lb,
         return NULL;
     }
 
-    // get parent node for path cost computation
-    parent_node = planStateSpaceNode(search->state_space, parent_state_id);
-
     // Update current node's data
     planStateSpaceOpen(search->state_space, cur_node);
     planStateSpaceClose(search->state_space, cur_node);
-    cur_node->cost = parent_node->cost + parent_op->cost;
     planSearchStatIncExpandedStates(&lb->search.stat);
 
     return cur_node;
@@ -36,6 +36,9 @@ struct _plan_search_lazy_base_t {
     int list_del;           /*!< True if .list should be deleted */
     int use_preferred_ops;  /*!< True if preferred operators from heuristic
                                  should be used. */
+    plan_search_applicable_ops_inc_t *app_ops_inc; /*!< Incremental
+                                 computation of applicable operators or
+                                 NULL if disabled */
 };
 typedef struct _plan_search_lazy_base_t plan_search_lazy_base_t;
 
@@ -47,6 +50,13 @@ void planSearchLazyBaseInit(plan_search_lazy_base_t *lb,
                             plan_list_lazy_t *list, int list_del,
                             int use_preferred_ops);
 
+/**
+ * Enables incremental computation of applicable operators of generated
+ * states.
+ */
+void planSearchLazyBaseIncAppOps(plan_search_lazy_base_t *lb,
+                                 const plan_problem_t *prob);
+
 /**
  * Frees resources.
  */
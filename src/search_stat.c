@@ -28,6 +28,10 @@ void planSearchStatInit(plan_search_stat_t *stat)
     stat->expanded_states = 0L;
     stat->generated_states = 0L;
     stat->peak_memory = 0L;
+    stat->ma_private_parts = 0L;
+    stat->ma_private_mem = 0L;
+    stat->symmetry_generators = 0L;
+    stat->symmetry_pruned = 0L;
     stat->found = -1;
 }
 
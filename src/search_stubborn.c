@@ -0,0 +1,303 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <limits.h>
+#include <boruvka/alloc.h>
+
+#include "plan/search_stubborn.h"
+#include "fact_op_cross_ref.h"
+
+/** Stores operators of each fact (only real operators, i.e., not the
+ *  artificial ones from the cross reference) in one array. Returns array
+ *  of starts of facts. */
+static int *factOps(const plan_oparr_t *arr, int fact_size, int op_size,
+                    int **op_out);
+/** Returns the fact ID of the first unsatisfied precondition of the
+ *  operator or -1 if the operator is applicable */
+static int unsatisfiedPre(const plan_search_stubborn_t *ss,
+                          const plan_op_t *op, const plan_state_t *state);
+/** Adds operators from op[0..size) to the stubborn set */
+static void addOps(plan_search_stubborn_t *ss, const int *op, int size,
+                   int *queue_size);
+/** Computes interfering operators of the operator */
+static void interfereCompute(plan_search_stubborn_t *ss, int op_id);
+
+void planSearchStubbornInit(plan_search_stubborn_t *ss,
+                            const plan_problem_t *prob)
+{
+    plan_fact_op_cross_ref_t cref;
+    int i;
+
+    bzero(ss, sizeof(*ss));
+    ss->op = prob->op;
+    ss->op_size = prob->op_size;
+    ss->goal = prob->goal;
+
+    // Operators of an agent interfere with operators of other agents
+    // that are not part of the agent's problem
+    ss->enabled = (prob->ma_privacy_var < 0
+                    && prob->agent_name == NULL
+                    && prob->proj_op == NULL);
+    for (i = 0; i < prob->op_size; ++i){
+        if (prob->op[i].cond_eff_size > 0)
+            ss->enabled = 0;
+    }
+    if (!ss->enabled)
+        return;
+
+    planFactOpCrossRefInit(&cref, prob->var, prob->var_size, prob->goal,
+                           prob->op, prob->op_size);
+
+    ss->var_fact = BOR_ALLOC_ARR(int, prob->var_size + 1);
+    for (i = 0; i < prob->var_size; ++i)
+        ss->var_fact[i] = planFactId(&cref.fact_id, i, 0);
+    ss->var_fact[prob->var_size] = cref.fact_id.fact_size;
+
+    ss->fact_pre_begin = factOps(cref.fact_pre, cref.fact_id.fact_size,
+                                 prob->op_size, &ss->fact_pre);
+    ss->fact_eff_begin = factOps(cref.fact_eff, cref.fact_id.fact_size,
+                                 prob->op_size, &ss->fact_eff);
+    planFactOpCrossRefFree(&cref);
+
+    ss->interfere = BOR_CALLOC_ARR(int *, BOR_MAX(prob->op_size, 1));
+    ss->interfere_size = BOR_CALLOC_ARR(int, BOR_MAX(prob->op_size, 1));
+    ss->op_mark = BOR_CALLOC_ARR(int, BOR_MAX(prob->op_size, 1));
+    ss->mark = 0;
+    ss->queue = BOR_ALLOC_ARR(int, BOR_MAX(prob->op_size, 1));
+}
+
+void planSearchStubbornFree(plan_search_stubborn_t *ss)
+{
+    int i;
+
+    if (ss->var_fact)
+        BOR_FREE(ss->var_fact);
+    if (ss->fact_pre)
+        BOR_FREE(ss->fact_pre);
+    if (ss->fact_pre_begin)
+        BOR_FREE(ss->fact_pre_begin);
+    if (ss->fact_eff)
+        BOR_FREE(ss->fact_eff);
+    if (ss->fact_eff_begin)
+        BOR_FREE(ss->fact_eff_begin);
+    if (ss->interfere){
+        for (i = 0; i < ss->op_size; ++i){
+            if (ss->interfere[i])
+                BOR_FREE(ss->interfere[i]);
+        }
+        BOR_FREE(ss->interfere);
+    }
+    if (ss->interfere_size)
+        BOR_FREE(ss->interfere_size);
+    if (ss->op_mark)
+        BOR_FREE(ss->op_mark);
+    if (ss->queue)
+        BOR_FREE(ss->queue);
+}
+
+void planSearchStubbornPrune(plan_search_stubborn_t *ss,
+                             const plan_state_t *state,
+                             plan_search_applicable_ops_t *app)
+{
+    plan_var_id_t var;
+    plan_val_t val;
+    plan_op_t *tmp;
+    int i, op_id, fact, size, found;
+
+    if (!ss->enabled || app->op_found <= 1)
+        return;
+
+    // Start with achievers of an unsatisfied goal
+    fact = -1;
+    PLAN_PART_STATE_FOR_EACH(ss->goal, i, var, val){
+        if (planStateGet(state, var) != val){
+            fact = ss->var_fact[var] + val;
+            break;
+        }
+    }
+    if (fact < 0)
+        return;
+
+    if (ss->mark == INT_MAX){
+        bzero(ss->op_mark, sizeof(int) * ss->op_size);
+        ss->mark = 0;
+    }
+    ++ss->mark;
+
+    size = 0;
+    addOps(ss, ss->fact_eff + ss->fact_eff_begin[fact],
+           ss->fact_eff_begin[fact + 1] - ss->fact_eff_begin[fact], &size);
+
+    // Applicable operators bring in all interfering operators, the other
+    // ones their necessary enabling set
+    for (i = 0; i < size; ++i){
+        op_id = ss->queue[i];
+        fact = unsatisfiedPre(ss, ss->op + op_id, state);
+        if (fact < 0){
+            if (ss->interfere[op_id] == NULL)
+                interfereCompute(ss, op_id);
+            addOps(ss, ss->interfere[op_id], ss->interfere_size[op_id],
+                   &size);
+        }else{
+            addOps(ss, ss->fact_eff + ss->fact_eff_begin[fact],
+                   ss->fact_eff_begin[fact + 1] - ss->fact_eff_begin[fact],
+                   &size);
+        }
+    }
+
+    // Move operators from the stubborn set to the beginning
+    for (found = 0, i = 0; i < app->op_found; ++i){
+        if (ss->op_mark[app->op[i] - ss->op] == ss->mark){
+            tmp = app->op[found];
+            app->op[found++] = app->op[i];
+            app->op[i] = tmp;
+        }
+    }
+
+    ss->ops_before += app->op_found;
+    ss->ops_after += found;
+    app->op_found = found;
+
+    if (++ss->pruned_states == PLAN_SEARCH_STUBBORN_CHECK_AFTER){
+        if (1. - (double)ss->ops_after / ss->ops_before
+                < PLAN_SEARCH_STUBBORN_MIN_RATIO)
+            ss->enabled = 0;
+    }
+}
+
+static int *factOps(const plan_oparr_t *arr, int fact_size, int op_size,
+                    int **op_out)
+{
+    int *begin, *op;
+    int fact, i, size;
+
+    begin = BOR_ALLOC_ARR(int, fact_size + 1);
+    for (size = 0, fact = 0; fact < fact_size; ++fact){
+        begin[fact] = size;
+        for (i = 0; i < arr[fact].size; ++i){
+            if (arr[fact].op[i] < op_size)
+                ++size;
+        }
+    }
+    begin[fact_size] = size;
+
+    op = BOR_ALLOC_ARR(int, BOR_MAX(size, 1));
+    for (size = 0, fact = 0; fact < fact_size; ++fact){
+        for (i = 0; i < arr[fact].size; ++i){
+            if (arr[fact].op[i] < op_size)
+                op[size++] = arr[fact].op[i];
+        }
+    }
+
+    *op_out = op;
+    return begin;
+}
+
+static int unsatisfiedPre(const plan_search_stubborn_t *ss,
+                          const plan_op_t *op, const plan_state_t *state)
+{
+    plan_var_id_t var;
+    plan_val_t val;
+    int i;
+
+    PLAN_PART_STATE_FOR_EACH(op->pre, i, var, val){
+        if (planStateGet(state, var) != val)
+            return ss->var_fact[var] + val;
+    }
+    return -1;
+}
+
+static void addOps(plan_search_stubborn_t *ss, const int *op, int size,
+                   int *queue_size)
+{
+    int i;
+
+    for (i = 0; i < size; ++i){
+        if (ss->op_mark[op[i]] != ss->mark){
+            ss->op_mark[op[i]] = ss->mark;
+            ss->queue[(*queue_size)++] = op[i];
+        }
+    }
+}
+
+static int cmpInt(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+/** Appends operators of all values of the variable except val to
+ *  out[] */
+static void appendOtherVals(const plan_search_stubborn_t *ss,
+                            const int *fact_op, const int *fact_op_begin,
+                            plan_var_id_t var, plan_val_t val,
+                            int **out, int *out_size, int *out_alloc)
+{
+    int fact, i, size;
+
+    for (fact = ss->var_fact[var]; fact < ss->var_fact[var + 1]; ++fact){
+        if (fact == ss->var_fact[var] + val)
+            continue;
+
+        size = fact_op_begin[fact + 1] - fact_op_begin[fact];
+        if (*out_size + size > *out_alloc){
+            *out_alloc = BOR_MAX(2 * *out_alloc, *out_size + size);
+            *out = BOR_REALLOC_ARR(*out, int, *out_alloc);
+        }
+        for (i = 0; i < size; ++i)
+            (*out)[(*out_size)++] = fact_op[fact_op_begin[fact] + i];
+    }
+}
+
+static void interfereCompute(plan_search_stubborn_t *ss, int op_id)
+{
+    const plan_op_t *op = ss->op + op_id;
+    plan_var_id_t var;
+    plan_val_t val;
+    int *out, size, alloc, i, ins;
+
+    alloc = 16;
+    size = 0;
+    out = BOR_ALLOC_ARR(int, alloc);
+
+    PLAN_PART_STATE_FOR_EACH(op->eff, i, var, val){
+        // The operator disables operators requiring other value...
+        appendOtherVals(ss, ss->fact_pre, ss->fact_pre_begin, var, val,
+                        &out, &size, &alloc);
+        // ...and conflicts with operators setting other value
+        appendOtherVals(ss, ss->fact_eff, ss->fact_eff_begin, var, val,
+                        &out, &size, &alloc);
+    }
+
+    // Operators that can disable this operator
+    PLAN_PART_STATE_FOR_EACH(op->pre, i, var, val){
+        appendOtherVals(ss, ss->fact_eff, ss->fact_eff_begin, var, val,
+                        &out, &size, &alloc);
+    }
+
+    // Remove duplicates and the operator itself
+    qsort(out, size, sizeof(int), cmpInt);
+    for (ins = 0, i = 0; i < size; ++i){
+        if (out[i] == op_id || (ins > 0 && out[ins - 1] == out[i]))
+            continue;
+        out[ins++] = out[i];
+    }
+
+    ss->interfere[op_id] = BOR_REALLOC_ARR(out, int, BOR_MAX(ins, 1));
+    ss->interfere_size[op_id] = ins;
+}
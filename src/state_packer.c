@@ -336,6 +336,13 @@ void planStatePackerSetMAPrivacyVar(const plan_state_packer_t *p,
     ((plan_packer_word_t *)buf)[id] = val;
 }
 
+plan_val_t planStatePackerGetVar(const plan_state_packer_t *p,
+                                 plan_var_id_t var,
+                                 const void *buf)
+{
+    return packerGetVar(p->vars + var, buf);
+}
+
 plan_val_t planStatePackerGetMAPrivacyVar(const plan_state_packer_t *p,
                                           const void *buf)
 {
@@ -19,6 +19,15 @@
 
 #include <boruvka/alloc.h>
 #include "plan/succ_gen.h"
+#include "fd_reader.h"
+
+/** Estimated cost of visiting one node of the decision tree relative to
+ *  the cost of testing one word of packed precondition of one operator */
+#define TREE_NODE_COST 16.
+
+/** Minimal number of operators for which testing of packed
+ *  preconditions is considered */
+#define MASK_MIN_OPS 1024
 
 #ifndef _GNU_SOURCE
 /** Declaration of qsort_r() function that should be available in libc */
@@ -27,8 +36,22 @@ void qsort_r(void *base, size_t nmemb, size_t size,
              void *arg);
 #endif
 
+/**
+ * Node of the flattened decision tree.
+ */
+struct _plan_succ_gen_node_t {
+    plan_var_id_t var; /*!< Decision variable */
+    int ops;           /*!< Offset of immediate operators in .ops[] */
+    int ops_size;
+    int val;           /*!< Offset of subtrees in .child[] */
+    int val_size;
+    int def;           /*!< Index of default subtree or -1 */
+};
+typedef struct _plan_succ_gen_node_t plan_succ_gen_node_t;
+
 /**
  * Base building structure for a tree node of successor generator.
+ * The tree is built from these nodes and then flattened.
  */
 struct _plan_succ_gen_tree_t {
     plan_var_id_t var;                  /*!< Decision variable */
@@ -56,7 +79,7 @@ static plan_succ_gen_tree_t *treeNew(plan_op_t **ops, int len,
                                      const plan_var_id_t *var);
 
 /** Creates a new tree from the FD definition */
-static plan_succ_gen_tree_t *treeFromFD(FILE *fin,
+static plan_succ_gen_tree_t *treeFromFD(plan_fd_reader_t *r,
                                         const plan_var_t *vars,
                                         plan_op_t *ops,
                                         int *num_ops);
@@ -64,10 +87,26 @@ static plan_succ_gen_tree_t *treeFromFD(FILE *fin,
 /** Recursively deletes a tree */
 static void treeDel(plan_succ_gen_tree_t *tree);
 
-/** Finds applicable operators to the given state */
-static int treeFind(const plan_succ_gen_tree_t *tree,
-                    plan_val_t *vals,
+/** Stores the tree into the contiguous buffer of the successor
+ *  generator */
+static void flatten(plan_succ_gen_t *sg, const plan_succ_gen_tree_t *tree);
+
+/** Frees arrays of packed preconditions */
+static void maskFree(plan_succ_gen_t *sg);
+/** Finds applicable operators by testing packed preconditions */
+static int maskFind(const plan_succ_gen_t *sg, const void *bufstate,
                     plan_op_t **op, int op_size);
+/** Returns expected number of nodes of the decision tree visited by
+ *  one query */
+static double treeExpectedVisits(const plan_succ_gen_t *sg);
+
+/** Finds applicable operators to the state given either by values or by
+ *  packed buffer */
+_bor_inline int flatFind(const plan_succ_gen_t *sg,
+                         const plan_val_t *vals,
+                         const plan_state_packer_t *packer,
+                         const void *bufstate,
+                         plan_op_t **op, int op_size);
 
 /** Set immediate operators to tree node */
 static void treeBuildSetOps(plan_succ_gen_tree_t *tree,
@@ -95,10 +134,14 @@ plan_succ_gen_t *planSuccGenNew(const plan_op_t *op, int opsize,
                                 const plan_var_id_t *var_order)
 {
     plan_succ_gen_t *sg;
+    plan_succ_gen_tree_t *root;
     plan_op_t **sorted_ops = NULL;
     int i, size;
 
     sg = BOR_ALLOC(plan_succ_gen_t);
+    sg->mask_op = NULL;
+    sg->mask = sg->mask_val = NULL;
+    sg->mask_op_size = sg->mask_words = 0;
 
     // Determine size of the var_order array
     if (var_order != NULL){
@@ -130,7 +173,9 @@ plan_succ_gen_t *planSuccGenNew(const plan_op_t *op, int opsize,
                 opsSortCmp, (void *)sg->var_order);
     }
 
-    sg->root = treeNew(sorted_ops, opsize, sg->var_order);
+    root = treeNew(sorted_ops, opsize, sg->var_order);
+    flatten(sg, root);
+    treeDel(root);
     sg->num_operators = opsize;
 
     if (sorted_ops)
@@ -143,17 +188,284 @@ plan_succ_gen_t *planSuccGenFromFD(FILE *fin,
                                    plan_op_t *op)
 {
     plan_succ_gen_t *sg;
+    char *buf;
+    const char *cur;
+    size_t size, alloc, len;
+
+    // Read the rest of the stream
+    alloc = 1024 * 1024;
+    buf = BOR_ALLOC_ARR(char, alloc);
+    size = 0;
+    while ((len = fread(buf + size, 1, alloc - size, fin)) > 0){
+        size += len;
+        if (size == alloc){
+            alloc *= 2;
+            buf = BOR_REALLOC_ARR(buf, char, alloc);
+        }
+    }
+
+    cur = buf;
+    sg = planSuccGenFromFDBuf(&cur, buf + size, vars, op);
+
+    // Return the unparsed part back to the stream
+    fseek(fin, -(long)(buf + size - cur), SEEK_CUR);
+    BOR_FREE(buf);
+    return sg;
+}
+
+plan_succ_gen_t *planSuccGenFromFDBuf(const char **buf, const char *end,
+                                      const plan_var_t *vars,
+                                      plan_op_t *op)
+{
+    plan_succ_gen_t *sg;
+    plan_succ_gen_tree_t *root;
+    plan_fd_reader_t r;
+
+    planFDReaderInit(&r, *buf, end - *buf);
     sg = BOR_ALLOC(plan_succ_gen_t);
     bzero(sg, sizeof(*sg));
     sg->num_operators = 0;
-    sg->root = treeFromFD(fin, vars, op, &sg->num_operators);
+    root = treeFromFD(&r, vars, op, &sg->num_operators);
+    flatten(sg, root);
+    if (root)
+        treeDel(root);
+    *buf = r.cur;
+    return sg;
+}
+
+/**
+ * Header of serialized successor generator, followed by .var_order
+ * (if any), the nodes, indexes of immediate operators and .child[].
+ */
+struct _bin_header_t {
+    int32_t node_size;
+    int32_t node_struct_size;
+    int32_t ops_size;
+    int32_t child_size;
+    int32_t max_depth;
+    int32_t num_operators;
+    int32_t var_order_size; /*!< Including the terminating
+                                 PLAN_VAR_ID_UNDEFINED or 0 if none */
+    int32_t pad;
+};
+typedef struct _bin_header_t bin_header_t;
+
+/** Size of the arrays of immediate operators and subtrees */
+static void flatSizes(const plan_succ_gen_t *sg, int *ops_size,
+                      int *child_size)
+{
+    const plan_succ_gen_node_t *last;
+
+    // Nodes are stored in pre-order, so the last node also occupies the
+    // end of both arrays.
+    *ops_size = *child_size = 0;
+    if (sg->node_size > 0){
+        last = sg->node + sg->node_size - 1;
+        *ops_size = last->ops + last->ops_size;
+        *child_size = last->val + last->val_size;
+    }
+}
+
+static size_t binVarOrderSize(const plan_succ_gen_t *sg)
+{
+    int size;
+
+    if (sg->var_order == NULL)
+        return 0;
+    for (size = 0; sg->var_order[size] != PLAN_VAR_ID_UNDEFINED; ++size);
+    return size + 1;
+}
+
+/** Rounds size up to 8 bytes */
+static size_t binAlign(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+/** Returns true if the node refers only to existing operators and
+ *  variables and to subtrees stored after it (as they are in pre-order) */
+static int binNodeValid(const plan_succ_gen_t *sg, int id,
+                        int ops_size, int child_size, int var_size)
+{
+    const plan_succ_gen_node_t *node = sg->node + id;
+    int i, c;
+
+    if (node->ops < 0 || node->ops_size < 0
+            || node->ops + node->ops_size > ops_size
+            || node->val < 0 || node->val_size < 0
+            || node->val + node->val_size > child_size
+            || (node->def != -1
+                    && (node->def <= id || node->def >= sg->node_size))
+            || (node->var != PLAN_VAR_ID_UNDEFINED
+                    && (node->var < 0 || node->var >= var_size)))
+        return 0;
+
+    for (i = 0; i < node->val_size; ++i){
+        c = sg->child[node->val + i];
+        if (c != -1 && (c <= id || c >= sg->node_size))
+            return 0;
+    }
+    return 1;
+}
+
+/** Computes depth of the tree from the validated nodes */
+static int binMaxDepth(const plan_succ_gen_t *sg)
+{
+    const plan_succ_gen_node_t *node;
+    int *depth, i, j, c, max_depth = 0;
+
+    if (sg->node_size == 0)
+        return 0;
+
+    // Subtrees are stored after their parents, so the depth of each node
+    // is final before its subtrees are visited
+    depth = BOR_CALLOC_ARR(int, sg->node_size);
+    depth[0] = 1;
+    for (i = 0; i < sg->node_size; ++i){
+        if (depth[i] == 0)
+            continue;
+        max_depth = BOR_MAX(max_depth, depth[i]);
+
+        node = sg->node + i;
+        for (j = 0; j < node->val_size; ++j){
+            c = sg->child[node->val + j];
+            if (c >= 0)
+                depth[c] = BOR_MAX(depth[c], depth[i] + 1);
+        }
+        if (node->def >= 0)
+            depth[node->def] = BOR_MAX(depth[node->def], depth[i] + 1);
+    }
+    BOR_FREE(depth);
+
+    return max_depth;
+}
+
+size_t planSuccGenBinSize(const plan_succ_gen_t *sg)
+{
+    int ops_size, child_size;
+    size_t size;
+
+    flatSizes(sg, &ops_size, &child_size);
+    size  = sizeof(bin_header_t);
+    size += binAlign(sizeof(int32_t) * binVarOrderSize(sg));
+    size += binAlign(sizeof(plan_succ_gen_node_t) * sg->node_size);
+    size += binAlign(sizeof(int32_t) * ops_size);
+    size += binAlign(sizeof(int32_t) * child_size);
+    return size;
+}
+
+void planSuccGenToBin(const plan_succ_gen_t *sg, const plan_op_t *op,
+                      void *buf)
+{
+    bin_header_t *h = buf;
+    char *cur = buf;
+    int32_t *arr;
+    int i, ops_size, child_size;
+
+    flatSizes(sg, &ops_size, &child_size);
+    bzero(buf, planSuccGenBinSize(sg));
+    h->node_size = sg->node_size;
+    h->node_struct_size = sizeof(plan_succ_gen_node_t);
+    h->ops_size = ops_size;
+    h->child_size = child_size;
+    h->max_depth = sg->max_depth;
+    h->num_operators = sg->num_operators;
+    h->var_order_size = binVarOrderSize(sg);
+    cur += sizeof(*h);
+
+    arr = (int32_t *)cur;
+    for (i = 0; i < h->var_order_size; ++i)
+        arr[i] = sg->var_order[i];
+    cur += binAlign(sizeof(int32_t) * h->var_order_size);
+
+    if (sg->node_size > 0)
+        memcpy(cur, sg->node, sizeof(plan_succ_gen_node_t) * sg->node_size);
+    cur += binAlign(sizeof(plan_succ_gen_node_t) * sg->node_size);
+
+    arr = (int32_t *)cur;
+    for (i = 0; i < ops_size; ++i)
+        arr[i] = sg->ops[i] - op;
+    cur += binAlign(sizeof(int32_t) * ops_size);
+
+    arr = (int32_t *)cur;
+    for (i = 0; i < child_size; ++i)
+        arr[i] = sg->child[i];
+}
+
+plan_succ_gen_t *planSuccGenFromBin(const void *buf, size_t size,
+                                    plan_op_t *op, int op_size,
+                                    int var_size)
+{
+    const bin_header_t *h = buf;
+    const char *cur = buf;
+    const int32_t *arr;
+    plan_succ_gen_t *sg;
+    int i;
+
+    if (size < sizeof(*h)
+            || h->node_struct_size != sizeof(plan_succ_gen_node_t)
+            || h->node_size < 0 || h->ops_size < 0 || h->child_size < 0
+            || h->var_order_size < 0)
+        return NULL;
+
+    if (sizeof(*h)
+            + binAlign(sizeof(int32_t) * (size_t)h->var_order_size)
+            + binAlign(sizeof(plan_succ_gen_node_t) * (size_t)h->node_size)
+            + binAlign(sizeof(int32_t) * (size_t)h->ops_size)
+            + binAlign(sizeof(int32_t) * (size_t)h->child_size) > size)
+        return NULL;
+
+    sg = BOR_ALLOC(plan_succ_gen_t);
+    bzero(sg, sizeof(*sg));
+    sg->node_size = h->node_size;
+    sg->num_operators = h->num_operators;
+    cur += sizeof(*h);
+
+    if (h->var_order_size > 0){
+        arr = (const int32_t *)cur;
+        sg->var_order = BOR_ALLOC_ARR(plan_var_id_t, h->var_order_size);
+        for (i = 0; i < h->var_order_size; ++i)
+            sg->var_order[i] = arr[i];
+    }
+    cur += binAlign(sizeof(int32_t) * h->var_order_size);
+
+    sg->node = (plan_succ_gen_node_t *)cur;
+    cur += binAlign(sizeof(plan_succ_gen_node_t) * h->node_size);
+
+    // Only pointers to operators must be resolved
+    arr = (const int32_t *)cur;
+    sg->buf = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(h->ops_size, 1));
+    sg->ops = sg->buf;
+    for (i = 0; i < h->ops_size; ++i){
+        if (arr[i] < 0 || arr[i] >= op_size){
+            planSuccGenDel(sg);
+            return NULL;
+        }
+        sg->ops[i] = op + arr[i];
+    }
+    cur += binAlign(sizeof(int32_t) * h->ops_size);
+
+    sg->child = (int *)cur;
+
+    // Check that nodes do not refer outside of the arrays
+    for (i = 0; i < sg->node_size; ++i){
+        if (!binNodeValid(sg, i, h->ops_size, h->child_size, var_size)){
+            planSuccGenDel(sg);
+            return NULL;
+        }
+    }
+
+    // The stored depth is not trusted because it sizes the stack of
+    // planSuccGenFind()
+    sg->max_depth = binMaxDepth(sg);
     return sg;
 }
 
 void planSuccGenDel(plan_succ_gen_t *sg)
 {
-    if (sg->root)
-        treeDel(sg->root);
+    if (sg->buf)
+        BOR_FREE(sg->buf);
+    maskFree(sg);
     if (sg->var_order)
         BOR_FREE(sg->var_order);
 
@@ -164,11 +476,7 @@ int planSuccGenFind(const plan_succ_gen_t *sg,
                     const plan_state_t *state,
                     plan_op_t **op, int op_size)
 {
-    // Use variable-length array to speed it up.
-    int size = planStateSize(state);
-    plan_val_t vals[size];
-    memcpy(vals, state->val, sizeof(plan_val_t) * size);
-    return treeFind(sg->root, vals, op, op_size);
+    return flatFind(sg, state->val, NULL, NULL, op, op_size);
 }
 
 int planSuccGenFindPart(const plan_succ_gen_t *sg,
@@ -183,7 +491,75 @@ int planSuccGenFindPart(const plan_succ_gen_t *sg,
         vals[i] = PLAN_VAL_UNDEFINED;
     for (i = 0; i < part_state->vals_size; ++i)
         vals[part_state->vals[i].var] = part_state->vals[i].val;
-    return treeFind(sg->root, vals, op, op_size);
+    return flatFind(sg, vals, NULL, NULL, op, op_size);
+}
+
+int planSuccGenFindPacked(const plan_succ_gen_t *sg,
+                          const plan_state_packer_t *packer,
+                          const void *bufstate,
+                          plan_op_t **op, int op_size)
+{
+    if (sg->mask_op != NULL)
+        return maskFind(sg, bufstate, op, op_size);
+    return flatFind(sg, NULL, packer, bufstate, op, op_size);
+}
+
+void planSuccGenPack(plan_succ_gen_t *sg, plan_op_t *op, int op_size,
+                     unsigned flags)
+{
+    const int block = PLAN_SUCC_GEN_MASK_BLOCK;
+    const plan_packer_word_t *pmask, *pval;
+    plan_packer_word_t *mask, *val;
+    double tree_cost, mask_cost;
+    int i, w, words, block_size;
+
+    maskFree(sg);
+
+    if (flags & PLAN_SUCC_GEN_TREE || op_size == 0)
+        return;
+
+    // All operators must be packed
+    words = op[0].pre->bufsize / sizeof(plan_packer_word_t);
+    for (i = 0; i < op_size; ++i){
+        if (op[i].pre->bufsize == 0
+                || op[i].pre->bufsize != words * sizeof(plan_packer_word_t))
+            return;
+    }
+
+    if (!(flags & PLAN_SUCC_GEN_MASK)){
+        if (op_size < MASK_MIN_OPS)
+            return;
+        tree_cost = TREE_NODE_COST * treeExpectedVisits(sg);
+        mask_cost = (double)op_size * words;
+        if (mask_cost >= tree_cost)
+            return;
+    }
+
+    block_size = (op_size + block - 1) / block;
+    sg->mask_op = op;
+    sg->mask_op_size = op_size;
+    sg->mask_words = words;
+    sg->mask = BOR_ALLOC_ARR(plan_packer_word_t, block_size * block * words);
+    sg->mask_val = BOR_ALLOC_ARR(plan_packer_word_t,
+                                 block_size * block * words);
+
+    for (i = 0; i < block_size * block; ++i){
+        mask = sg->mask + (i / block) * block * words + (i % block);
+        val = sg->mask_val + (i / block) * block * words + (i % block);
+
+        for (w = 0; w < words; ++w){
+            if (i < op_size){
+                pmask = op[i].pre->maskbuf;
+                pval = op[i].pre->valbuf;
+                mask[w * block] = pmask[w];
+                val[w * block] = pval[w];
+            }else{
+                // Padding is never applicable
+                mask[w * block] = 0;
+                val[w * block] = 1;
+            }
+        }
+    }
 }
 
 
@@ -342,12 +718,12 @@ static plan_succ_gen_tree_t *treeNew(plan_op_t **ops, int len,
     return tree;
 }
 
-static void treeFromFDOps(plan_succ_gen_tree_t *tree, FILE *fin,
+static void treeFromFDOps(plan_succ_gen_tree_t *tree, plan_fd_reader_t *r,
                           plan_op_t *ops, int *num_ops_out)
 {
     int i, num_ops, op_idx;
 
-    if (fscanf(fin, "%d", &num_ops) != 1){
+    if (planFDReaderInt(r, &num_ops) != 0){
         fprintf(stderr, "Error: Invalid successor generator definition.\n");
         return;
     }
@@ -359,7 +735,7 @@ static void treeFromFDOps(plan_succ_gen_tree_t *tree, FILE *fin,
     tree->ops_size = num_ops;
     tree->ops = BOR_ALLOC_ARR(plan_op_t *, tree->ops_size);
     for (i = 0; i < num_ops; ++i){
-        if (fscanf(fin, "%d", &op_idx) != 1){
+        if (planFDReaderInt(r, &op_idx) != 0){
             fprintf(stderr, "Error: Invalid successor generator definition.\n");
             return;
         }
@@ -367,16 +743,16 @@ static void treeFromFDOps(plan_succ_gen_tree_t *tree, FILE *fin,
     }
 }
 
-static plan_succ_gen_tree_t *treeFromFD(FILE *fin,
+static plan_succ_gen_tree_t *treeFromFD(plan_fd_reader_t *r,
                                         const plan_var_t *vars,
                                         plan_op_t *ops,
                                         int *num_ops_out)
 {
     plan_succ_gen_tree_t *tree;
-    char type[128];
-    int i, var;
+    const char *type;
+    int i, var, len;
 
-    if (fscanf(fin, "%s", type) != 1){
+    if (planFDReaderWord(r, &type, &len) != 0){
         fprintf(stderr, "Error: Could not determine type\n");
         return NULL;
     }
@@ -389,41 +765,37 @@ static plan_succ_gen_tree_t *treeFromFD(FILE *fin,
     tree->val_size = 0;
     tree->def = NULL;
 
-    if (strcmp(type, "switch") == 0){
-        if (fscanf(fin, "%d", &var) != 1){
+    if (len == 6 && strncmp(type, "switch", 6) == 0){
+        if (planFDReaderInt(r, &var) != 0){
             fprintf(stderr, "Error: Invalid successor generator definition.\n");
             return NULL;
         }
         tree->var = var;
 
-        if (fscanf(fin, "%s", type) != 1){
-            fprintf(stderr, "Error: Invalid successor generator definition.\n");
-            return NULL;
-        }
-        if (strcmp(type, "check") != 0){
+        if (planFDReaderAssert(r, "check") != 0){
             fprintf(stderr, "Error: Invalid successor generator definition."
                             " Expecting 'check'\n");
             return NULL;
         }
-        treeFromFDOps(tree, fin, ops, num_ops_out);
+        treeFromFDOps(tree, r, ops, num_ops_out);
 
         tree->val_size = vars[var].range;
         tree->val = BOR_CALLOC_ARR(plan_succ_gen_tree_t *, tree->val_size);
         for (i = 0; i < vars[var].range; ++i){
-            tree->val[i] = treeFromFD(fin, vars, ops, num_ops_out);
+            tree->val[i] = treeFromFD(r, vars, ops, num_ops_out);
         }
 
-        tree->def = treeFromFD(fin, vars, ops, num_ops_out);
+        tree->def = treeFromFD(r, vars, ops, num_ops_out);
 
-    }else if (strcmp(type, "check") == 0){
-        treeFromFDOps(tree, fin, ops, num_ops_out);
+    }else if (len == 5 && strncmp(type, "check", 5) == 0){
+        treeFromFDOps(tree, r, ops, num_ops_out);
         if (tree->ops_size == 0){
             BOR_FREE(tree);
             return NULL;
         }
 
     }else{
-        fprintf(stderr, "Error: Unknown type: `%s'\n", type);
+        fprintf(stderr, "Error: Unknown type: `%.*s'\n", len, type);
         return NULL;
     }
 
@@ -450,39 +822,219 @@ static void treeDel(plan_succ_gen_tree_t *tree)
     BOR_FREE(tree);
 }
 
-static int treeFind(const plan_succ_gen_tree_t *tree,
-                    plan_val_t *vals,
-                    plan_op_t **op, int op_size)
+/** Counts nodes, operators and subtree slots and computes depth of the
+ *  tree */
+static void flattenCount(const plan_succ_gen_tree_t *tree, int depth,
+                         plan_succ_gen_t *sg, int *ops_size, int *child_size)
 {
-    int i, found = 0, size;
+    int i;
+
+    ++sg->node_size;
+    *ops_size += tree->ops_size;
+    *child_size += tree->val_size;
+    sg->max_depth = BOR_MAX(sg->max_depth, depth);
+
+    for (i = 0; i < tree->val_size; ++i){
+        if (tree->val[i])
+            flattenCount(tree->val[i], depth + 1, sg, ops_size, child_size);
+    }
+    if (tree->def)
+        flattenCount(tree->def, depth + 1, sg, ops_size, child_size);
+}
+
+/** Stores the node and all its subtrees in pre-order, returns index of
+ *  the node */
+static int flattenNode(plan_succ_gen_t *sg, const plan_succ_gen_tree_t *tree,
+                       int *node_size, int *ops_size, int *child_size)
+{
+    plan_succ_gen_node_t *node;
+    int id, i;
+
+    id = (*node_size)++;
+    node = sg->node + id;
+    node->var = tree->var;
+    node->ops = *ops_size;
+    node->ops_size = tree->ops_size;
+    node->val = *child_size;
+    node->val_size = tree->val_size;
+    node->def = -1;
+
+    for (i = 0; i < tree->ops_size; ++i)
+        sg->ops[(*ops_size)++] = tree->ops[i];
+    *child_size += tree->val_size;
+
+    for (i = 0; i < tree->val_size; ++i){
+        sg->child[node->val + i] = -1;
+        if (tree->val[i]){
+            sg->child[node->val + i] = flattenNode(sg, tree->val[i],
+                                                   node_size, ops_size,
+                                                   child_size);
+        }
+    }
+
+    if (tree->def)
+        node->def = flattenNode(sg, tree->def, node_size, ops_size, child_size);
+
+    return id;
+}
+
+static void flatten(plan_succ_gen_t *sg, const plan_succ_gen_tree_t *tree)
+{
+    int ops_size, child_size, node_size;
+    size_t size;
+
+    sg->node = NULL;
+    sg->node_size = 0;
+    sg->ops = NULL;
+    sg->child = NULL;
+    sg->max_depth = 0;
+    sg->buf = NULL;
+    if (tree == NULL)
+        return;
+
+    ops_size = child_size = 0;
+    flattenCount(tree, 1, sg, &ops_size, &child_size);
+
+    // Operators go first because of alignment of pointers
+    size  = sizeof(plan_op_t *) * ops_size;
+    size += sizeof(plan_succ_gen_node_t) * sg->node_size;
+    size += sizeof(int) * child_size;
+    sg->buf = BOR_ALLOC_ARR(char, size);
+    sg->ops = (plan_op_t **)sg->buf;
+    sg->node = (plan_succ_gen_node_t *)(sg->ops + ops_size);
+    sg->child = (int *)(sg->node + sg->node_size);
+
+    node_size = ops_size = child_size = 0;
+    flattenNode(sg, tree, &node_size, &ops_size, &child_size);
+}
+
+_bor_inline int flatFind(const plan_succ_gen_t *sg,
+                         const plan_val_t *vals,
+                         const plan_state_packer_t *packer,
+                         const void *bufstate,
+                         plan_op_t **op, int op_size)
+{
+    // Each visited node pushes at most one default subtree that waits
+    // for processing, so the stack is bounded by the depth of the tree.
+    int stack[sg->max_depth + 1];
+    int stack_size, found, i;
+    const plan_succ_gen_node_t *node;
     plan_val_t val;
 
-    // insert all immediate operators
-    if (tree->ops_size > 0){
-        for (i = 0; i < tree->ops_size; ++i){
-            if (op_size > i)
-                op[i] = tree->ops[i];
+    if (sg->node_size == 0)
+        return 0;
+
+    found = 0;
+    stack[0] = 0;
+    stack_size = 1;
+    while (stack_size > 0){
+        node = sg->node + stack[--stack_size];
+
+        // insert all immediate operators
+        for (i = 0; i < node->ops_size; ++i, ++found){
+            if (found < op_size)
+                op[found] = sg->ops[node->ops + i];
+        }
+
+        if (node->var == PLAN_VAR_ID_UNDEFINED)
+            continue;
+
+        // Default subtree is pushed first so that the subtree
+        // corresponding to the value is processed before it
+        if (node->def >= 0)
+            stack[stack_size++] = node->def;
+
+        if (vals != NULL){
+            val = vals[node->var];
+        }else{
+            val = planStatePackerGetVar(packer, node->var, bufstate);
+        }
+
+        if (val != PLAN_VAL_UNDEFINED && val < node->val_size
+                && sg->child[node->val + val] >= 0){
+            stack[stack_size++] = sg->child[node->val + val];
         }
-        found = tree->ops_size;
     }
 
-    // check whether this node should check on any variable value
-    if (tree->var != PLAN_VAR_ID_UNDEFINED){
-        // get corresponding value from state
-        val = vals[tree->var];
+    return found;
+}
+
+static void maskFree(plan_succ_gen_t *sg)
+{
+    if (sg->mask)
+        BOR_FREE(sg->mask);
+    if (sg->mask_val)
+        BOR_FREE(sg->mask_val);
+    sg->mask_op = NULL;
+    sg->mask = sg->mask_val = NULL;
+    sg->mask_op_size = sg->mask_words = 0;
+}
 
-        // and use tree corresponding to the value if present
-        if (val != PLAN_VAL_UNDEFINED && val < tree->val_size && tree->val[val]){
-            size = BOR_MAX(0, (int)op_size - (int)found);
-            found += treeFind(tree->val[val], vals, op + found, size);
+static int maskFind(const plan_succ_gen_t *sg, const void *bufstate,
+                    plan_op_t **op, int op_size)
+{
+    const int block = PLAN_SUCC_GEN_MASK_BLOCK;
+    const plan_packer_word_t *state = bufstate;
+    const plan_packer_word_t *mask, *val;
+    plan_packer_word_t diff[PLAN_SUCC_GEN_MASK_BLOCK], s;
+    int i, l, w, found;
+
+    found = 0;
+    mask = sg->mask;
+    val = sg->mask_val;
+    for (i = 0; i < sg->mask_op_size; i += block){
+        // Operators of the whole block are tested word by word, the
+        // inner loop has no dependencies so it can be vectorized.
+        for (l = 0; l < block; ++l)
+            diff[l] = 0;
+        for (w = 0; w < sg->mask_words; ++w){
+            s = state[w];
+            for (l = 0; l < block; ++l)
+                diff[l] |= (s & mask[l]) ^ val[l];
+            mask += block;
+            val += block;
         }
 
-        // use default tree if present
-        if (tree->def){
-            size = BOR_MAX(0, (int)op_size - (int)found);
-            found += treeFind(tree->def, vals, op + found, size);
+        for (l = 0; l < block; ++l){
+            if (diff[l] == 0){
+                if (found < op_size)
+                    op[found] = sg->mask_op + i + l;
+                ++found;
+            }
         }
     }
 
     return found;
 }
+
+static double treeExpectedVisits(const plan_succ_gen_t *sg)
+{
+    const plan_succ_gen_node_t *node;
+    double *prob, visits;
+    int i, j, child;
+
+    if (sg->node_size == 0)
+        return 0.;
+
+    // Values of variables are assumed to be distributed uniformly over
+    // the values the node branches on. Nodes are stored in pre-order so
+    // parents are always processed before their children.
+    prob = BOR_CALLOC_ARR(double, sg->node_size);
+    prob[0] = 1.;
+    visits = 0.;
+    for (i = 0; i < sg->node_size; ++i){
+        node = sg->node + i;
+        visits += prob[i];
+
+        for (j = 0; j < node->val_size; ++j){
+            child = sg->child[node->val + j];
+            if (child >= 0)
+                prob[child] = prob[i] / node->val_size;
+        }
+        if (node->def >= 0)
+            prob[node->def] = prob[i];
+    }
+
+    BOR_FREE(prob);
+    return visits;
+}
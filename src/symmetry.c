@@ -0,0 +1,910 @@
+/***
+ * maplan
+ * -------
+ * Copyright (c)2016 Daniel Fiser <danfis@danfis.cz>,
+ * Agent Technology Center, Department of Computer Science,
+ * Faculty of Electrical Engineering, Czech Technical University in Prague.
+ * All rights reserved.
+ *
+ * This file is part of maplan.
+ *
+ * Distributed under the OSI-approved BSD License (the "License");
+ * see accompanying file BDS-LICENSE for details or see
+ * <http://www.opensource.org/licenses/bsd-license.php>.
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even the
+ * implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the License for more information.
+ */
+
+#include <stdint.h>
+#include <boruvka/alloc.h>
+
+#include "plan/symmetry.h"
+
+/** Labels of edges of the problem description graph */
+#define EDGE_VAR 0 /*!< variable -- fact */
+#define EDGE_PRE 1 /*!< operator -- precondition */
+#define EDGE_EFF 2 /*!< operator -- effect */
+
+/** Colors of vertices, operators are colored by
+ *  COLOR_OP + rank of their cost */
+#define COLOR_VAR  0
+#define COLOR_GOAL 1
+#define COLOR_FACT 2
+#define COLOR_OP   3
+
+/**
+ * Problem description graph.
+ * Vertices are ordered as variables, facts and operators.
+ */
+struct _graph_t {
+    int vert_size;
+    int *color;
+    int *adj_begin;  /*!< Start of neighbors of each vertex in .adj[] */
+    int *adj;
+    int *adj_label;
+};
+typedef struct _graph_t graph_t;
+
+/**
+ * Ordered partition of vertices. Cells are identified by the position of
+ * their first element.
+ */
+struct _part_t {
+    int *elem;     /*!< Vertices ordered by cells */
+    int *pos;      /*!< Position of each vertex in .elem[] */
+    int *cell;     /*!< Cell of each vertex */
+    int *cell_end; /*!< End of the cell (valid only for cell starts) */
+    int cell_size; /*!< Number of cells */
+};
+typedef struct _part_t part_t;
+
+struct _key_vert_t {
+    uint64_t key;
+    int vert;
+};
+typedef struct _key_vert_t key_vert_t;
+
+/**
+ * Working memory of the refinement of partitions.
+ */
+struct _refiner_t {
+    const graph_t *g;
+    int n;
+    uint64_t *key;       /*!< Weighted number of neighbors in splitter */
+    int *touched;        /*!< Vertices with non-zero key */
+    int touched_size;
+    int *touched_cell;   /*!< Cells containing touched vertices */
+    int touched_cell_size;
+    char *is_touched_cell;
+    int *queue;          /*!< Circular queue of splitters */
+    int queue_head;
+    int queue_size;
+    char *in_queue;
+    key_vert_t *sort;
+};
+typedef struct _refiner_t refiner_t;
+
+/** Builds the problem description graph */
+static void graphInit(graph_t *g, const plan_symmetry_t *sym,
+                      const plan_problem_t *prob);
+static void graphFree(graph_t *g);
+/** Computes generators of the automorphism group of the graph */
+static void findGenerators(plan_symmetry_t *sym, const graph_t *g);
+/** Applies the generator on the state */
+static void applyGen(const plan_symmetry_t *sym,
+                     const plan_symmetry_gen_t *gen,
+                     const plan_state_t *in, plan_state_t *out);
+/** Composes acc[] with the inverse of the last traced canonicalization */
+static void accUpdate(const plan_symmetry_t *sym, int *acc, int *tmp);
+
+void planSymmetryInit(plan_symmetry_t *sym, const plan_problem_t *prob)
+{
+    graph_t g;
+    int i;
+
+    bzero(sym, sizeof(*sym));
+    sym->var_size = prob->var_size;
+    sym->op = prob->op;
+    sym->op_size = prob->op_size;
+    sym->state = planStateNew(prob->var_size);
+    sym->state2 = planStateNew(prob->var_size);
+
+    sym->var_fact = BOR_ALLOC_ARR(int, prob->var_size + 1);
+    for (i = 0; i < prob->var_size; ++i){
+        sym->var_fact[i] = sym->fact_size;
+        sym->fact_size += prob->var[i].range;
+    }
+    sym->var_fact[prob->var_size] = sym->fact_size;
+
+    if (prob->ma_privacy_var >= 0)
+        return;
+    for (i = 0; i < prob->op_size; ++i){
+        if (prob->op[i].cond_eff_size > 0)
+            return;
+    }
+
+    graphInit(&g, sym, prob);
+    findGenerators(sym, &g);
+    graphFree(&g);
+}
+
+void planSymmetryFree(plan_symmetry_t *sym)
+{
+    int i;
+
+    for (i = 0; i < sym->gen_size; ++i){
+        BOR_FREE(sym->gen[i].var);
+        BOR_FREE(sym->gen[i].fact);
+        BOR_FREE(sym->gen[i].op);
+        BOR_FREE(sym->gen[i].op_inv);
+    }
+    if (sym->gen)
+        BOR_FREE(sym->gen);
+    if (sym->var_fact)
+        BOR_FREE(sym->var_fact);
+    if (sym->trace)
+        BOR_FREE(sym->trace);
+    planStateDel(sym->state);
+    planStateDel(sym->state2);
+}
+
+/** Returns true if state a is lexicographically smaller than b */
+static int lexLess(const plan_state_t *a, const plan_state_t *b)
+{
+    int i;
+
+    for (i = 0; i < a->size; ++i){
+        if (a->val[i] != b->val[i])
+            return a->val[i] < b->val[i];
+    }
+    return 0;
+}
+
+int planSymmetryCanonicalize(plan_symmetry_t *sym, plan_state_t *state)
+{
+    int i, improved, changed = 0;
+
+    sym->trace_size = 0;
+    do {
+        improved = 0;
+        for (i = 0; i < sym->gen_size; ++i){
+            applyGen(sym, sym->gen + i, state, sym->state2);
+            if (!lexLess(sym->state2, state))
+                continue;
+
+            planStateCopy(state, sym->state2);
+            improved = changed = 1;
+            if (sym->record_trace){
+                if (sym->trace_size == sym->trace_alloc){
+                    sym->trace_alloc = BOR_MAX(16, 2 * sym->trace_alloc);
+                    sym->trace = BOR_REALLOC_ARR(sym->trace, int,
+                                                 sym->trace_alloc);
+                }
+                sym->trace[sym->trace_size++] = i;
+            }
+        }
+    } while (improved);
+
+    return changed;
+}
+
+plan_state_id_t planSymmetryCanonicalStateId(plan_symmetry_t *sym,
+                                             plan_state_pool_t *pool,
+                                             plan_state_id_t state_id,
+                                             int *pruned)
+{
+    size_t num_states;
+    plan_state_id_t id;
+
+    if (pruned)
+        *pruned = 0;
+
+    planStatePoolGetState(pool, state_id, sym->state);
+    if (!planSymmetryCanonicalize(sym, sym->state))
+        return state_id;
+
+    num_states = pool->num_states;
+    id = planStatePoolInsert(pool, sym->state);
+    if (pruned)
+        *pruned = (pool->num_states == num_states);
+    return id;
+}
+
+plan_state_id_t planSymmetryApplyOp(plan_symmetry_t *sym,
+                                    plan_state_pool_t *pool,
+                                    const plan_state_t *state,
+                                    const plan_op_t *op,
+                                    int *pruned)
+{
+    plan_var_id_t var;
+    plan_val_t val;
+    size_t num_states;
+    plan_state_id_t id;
+    int i, changed;
+
+    planStateCopy(sym->state, state);
+    PLAN_PART_STATE_FOR_EACH(op->eff, i, var, val)
+        planStateSet(sym->state, var, val);
+    changed = planSymmetryCanonicalize(sym, sym->state);
+
+    num_states = pool->num_states;
+    id = planStatePoolInsert(pool, sym->state);
+    if (pruned)
+        *pruned = (changed && pool->num_states == num_states);
+    return id;
+}
+
+void planSymmetryRepairPath(plan_symmetry_t *sym,
+                            plan_state_pool_t *pool,
+                            plan_state_id_t init_state,
+                            plan_op_t **op, int op_size,
+                            plan_state_id_t *state)
+{
+    plan_var_id_t var;
+    plan_val_t val;
+    int *acc, *tmp;
+    int i, j, op_id;
+
+    // acc[] maps operators applicable in the canonical states to the
+    // operators applicable in the corresponding states of the real plan
+    acc = BOR_ALLOC_ARR(int, BOR_MAX(sym->op_size, 1));
+    tmp = BOR_ALLOC_ARR(int, BOR_MAX(sym->op_size, 1));
+    for (i = 0; i < sym->op_size; ++i)
+        acc[i] = i;
+
+    sym->record_trace = 1;
+    planStatePoolGetState(pool, init_state, sym->state);
+    planSymmetryCanonicalize(sym, sym->state);
+    accUpdate(sym, acc, tmp);
+
+    state[0] = init_state;
+    for (i = 0; i < op_size; ++i){
+        op_id = op[i] - sym->op;
+        PLAN_PART_STATE_FOR_EACH(op[i]->eff, j, var, val)
+            planStateSet(sym->state, var, val);
+
+        op[i] = sym->op + acc[op_id];
+        state[i + 1] = planOpApply(op[i], pool, state[i]);
+
+        planSymmetryCanonicalize(sym, sym->state);
+        accUpdate(sym, acc, tmp);
+    }
+    sym->record_trace = 0;
+
+    BOR_FREE(acc);
+    BOR_FREE(tmp);
+}
+
+static void applyGen(const plan_symmetry_t *sym,
+                     const plan_symmetry_gen_t *gen,
+                     const plan_state_t *in, plan_state_t *out)
+{
+    int var, to_var, fact;
+
+    for (var = 0; var < sym->var_size; ++var){
+        fact = gen->fact[sym->var_fact[var] + in->val[var]];
+        to_var = gen->var[var];
+        out->val[to_var] = fact - sym->var_fact[to_var];
+    }
+}
+
+static void accUpdate(const plan_symmetry_t *sym, int *acc, int *tmp)
+{
+    int op_id, i, x;
+
+    if (sym->trace_size == 0)
+        return;
+
+    for (op_id = 0; op_id < sym->op_size; ++op_id){
+        x = op_id;
+        for (i = sym->trace_size - 1; i >= 0; --i)
+            x = sym->gen[sym->trace[i]].op_inv[x];
+        tmp[op_id] = acc[x];
+    }
+    memcpy(acc, tmp, sizeof(int) * sym->op_size);
+}
+
+
+/*** Problem description graph ***/
+static int cmpCost(const void *a, const void *b)
+{
+    plan_cost_t c1 = *(const plan_cost_t *)a;
+    plan_cost_t c2 = *(const plan_cost_t *)b;
+    return (c1 < c2 ? -1 : (c1 > c2 ? 1 : 0));
+}
+
+/** Adds edge between u and v, deg[] holds the number of already added
+ *  neighbors of each vertex */
+static void graphAddEdge(graph_t *g, int *deg, int u, int v, int label)
+{
+    g->adj[g->adj_begin[u] + deg[u]] = v;
+    g->adj_label[g->adj_begin[u] + deg[u]++] = label;
+    g->adj[g->adj_begin[v] + deg[v]] = u;
+    g->adj_label[g->adj_begin[v] + deg[v]++] = label;
+}
+
+static void graphInit(graph_t *g, const plan_symmetry_t *sym,
+                      const plan_problem_t *prob)
+{
+    plan_var_id_t var;
+    plan_val_t val;
+    plan_cost_t *cost;
+    int *deg;
+    int fact_start, op_start, cost_size;
+    int i, j, v, lo, hi, mid;
+
+    fact_start = sym->var_size;
+    op_start = fact_start + sym->fact_size;
+    g->vert_size = op_start + sym->op_size;
+    g->color = BOR_ALLOC_ARR(int, g->vert_size);
+    g->adj_begin = BOR_CALLOC_ARR(int, g->vert_size + 1);
+
+    for (i = 0; i < sym->var_size; ++i)
+        g->color[i] = COLOR_VAR;
+    for (i = 0; i < sym->fact_size; ++i)
+        g->color[fact_start + i] = COLOR_FACT;
+    PLAN_PART_STATE_FOR_EACH(prob->goal, i, var, val)
+        g->color[fact_start + sym->var_fact[var] + val] = COLOR_GOAL;
+
+    // Operators with the same cost share the color
+    cost = BOR_ALLOC_ARR(plan_cost_t, BOR_MAX(sym->op_size, 1));
+    for (i = 0; i < sym->op_size; ++i)
+        cost[i] = prob->op[i].cost;
+    qsort(cost, sym->op_size, sizeof(plan_cost_t), cmpCost);
+    for (cost_size = 0, i = 0; i < sym->op_size; ++i){
+        if (cost_size == 0 || cost[cost_size - 1] != cost[i])
+            cost[cost_size++] = cost[i];
+    }
+    for (i = 0; i < sym->op_size; ++i){
+        lo = 0;
+        hi = cost_size - 1;
+        while (lo < hi){
+            mid = (lo + hi) / 2;
+            if (cost[mid] < prob->op[i].cost){
+                lo = mid + 1;
+            }else{
+                hi = mid;
+            }
+        }
+        g->color[op_start + i] = COLOR_OP + lo;
+    }
+    BOR_FREE(cost);
+
+    // Count degrees
+    for (i = 0; i < sym->var_size; ++i){
+        for (j = sym->var_fact[i]; j < sym->var_fact[i + 1]; ++j){
+            ++g->adj_begin[i];
+            ++g->adj_begin[fact_start + j];
+        }
+    }
+    for (i = 0; i < sym->op_size; ++i){
+        PLAN_PART_STATE_FOR_EACH(prob->op[i].pre, j, var, val){
+            ++g->adj_begin[op_start + i];
+            ++g->adj_begin[fact_start + sym->var_fact[var] + val];
+        }
+        PLAN_PART_STATE_FOR_EACH(prob->op[i].eff, j, var, val){
+            ++g->adj_begin[op_start + i];
+            ++g->adj_begin[fact_start + sym->var_fact[var] + val];
+        }
+    }
+    for (j = 0, i = 0; i <= g->vert_size; ++i){
+        v = g->adj_begin[i];
+        g->adj_begin[i] = j;
+        j += v;
+    }
+
+    g->adj = BOR_ALLOC_ARR(int, BOR_MAX(j, 1));
+    g->adj_label = BOR_ALLOC_ARR(int, BOR_MAX(j, 1));
+    deg = BOR_CALLOC_ARR(int, g->vert_size);
+    for (i = 0; i < sym->var_size; ++i){
+        for (j = sym->var_fact[i]; j < sym->var_fact[i + 1]; ++j)
+            graphAddEdge(g, deg, i, fact_start + j, EDGE_VAR);
+    }
+    for (i = 0; i < sym->op_size; ++i){
+        PLAN_PART_STATE_FOR_EACH(prob->op[i].pre, j, var, val){
+            graphAddEdge(g, deg, op_start + i,
+                         fact_start + sym->var_fact[var] + val, EDGE_PRE);
+        }
+        PLAN_PART_STATE_FOR_EACH(prob->op[i].eff, j, var, val){
+            graphAddEdge(g, deg, op_start + i,
+                         fact_start + sym->var_fact[var] + val, EDGE_EFF);
+        }
+    }
+    BOR_FREE(deg);
+}
+
+static void graphFree(graph_t *g)
+{
+    BOR_FREE(g->color);
+    BOR_FREE(g->adj_begin);
+    BOR_FREE(g->adj);
+    BOR_FREE(g->adj_label);
+}
+
+/** Returns true if perm[] is an automorphism of the graph, mark[] must
+ *  be zeroed array of size g->vert_size */
+static int graphIsAutomorphism(const graph_t *g, const int *perm, int *mark)
+{
+    int v, u, i, ok;
+
+    for (v = 0; v < g->vert_size; ++v){
+        u = perm[v];
+        if (g->color[v] != g->color[u])
+            return 0;
+        if (g->adj_begin[v + 1] - g->adj_begin[v]
+                != g->adj_begin[u + 1] - g->adj_begin[u])
+            return 0;
+
+        for (i = g->adj_begin[u]; i < g->adj_begin[u + 1]; ++i)
+            mark[g->adj[i]] |= (1 << g->adj_label[i]);
+        ok = 1;
+        for (i = g->adj_begin[v]; ok && i < g->adj_begin[v + 1]; ++i){
+            if (!(mark[perm[g->adj[i]]] & (1 << g->adj_label[i])))
+                ok = 0;
+        }
+        for (i = g->adj_begin[u]; i < g->adj_begin[u + 1]; ++i)
+            mark[g->adj[i]] = 0;
+        if (!ok)
+            return 0;
+    }
+    return 1;
+}
+
+
+/*** Partitions ***/
+static void partInit(part_t *p, int n)
+{
+    p->elem = BOR_ALLOC_ARR(int, 4 * BOR_MAX(n, 1));
+    p->pos = p->elem + n;
+    p->cell = p->pos + n;
+    p->cell_end = p->cell + n;
+    p->cell_size = 0;
+}
+
+static void partFree(part_t *p)
+{
+    BOR_FREE(p->elem);
+}
+
+static void partCopy(part_t *dst, const part_t *src, int n)
+{
+    memcpy(dst->elem, src->elem, sizeof(int) * 4 * n);
+    dst->cell_size = src->cell_size;
+}
+
+/** Returns true if both partitions have the same cells */
+static int partShapeEq(const part_t *a, const part_t *b, int n)
+{
+    int i;
+
+    if (a->cell_size != b->cell_size)
+        return 0;
+    for (i = 0; i < n; i = a->cell_end[i]){
+        if (a->cell_end[i] != b->cell_end[i])
+            return 0;
+    }
+    return 1;
+}
+
+/** Returns the first cell with more than one element or -1 */
+static int partFirstNonSingleton(const part_t *p, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i = p->cell_end[i]){
+        if (p->cell_end[i] - i > 1)
+            return i;
+    }
+    return -1;
+}
+
+
+/*** Refinement ***/
+static void refinerInit(refiner_t *r, const graph_t *g)
+{
+    int n = g->vert_size;
+
+    r->g = g;
+    r->n = n;
+    r->key = BOR_CALLOC_ARR(uint64_t, BOR_MAX(n, 1));
+    r->touched = BOR_ALLOC_ARR(int, BOR_MAX(n, 1));
+    r->touched_size = 0;
+    r->touched_cell = BOR_ALLOC_ARR(int, BOR_MAX(n, 1));
+    r->touched_cell_size = 0;
+    r->is_touched_cell = BOR_CALLOC_ARR(char, BOR_MAX(n, 1));
+    r->queue = BOR_ALLOC_ARR(int, BOR_MAX(n, 1));
+    r->queue_head = r->queue_size = 0;
+    r->in_queue = BOR_CALLOC_ARR(char, BOR_MAX(n, 1));
+    r->sort = BOR_ALLOC_ARR(key_vert_t, BOR_MAX(n, 1));
+}
+
+static void refinerFree(refiner_t *r)
+{
+    BOR_FREE(r->key);
+    BOR_FREE(r->touched);
+    BOR_FREE(r->touched_cell);
+    BOR_FREE(r->is_touched_cell);
+    BOR_FREE(r->queue);
+    BOR_FREE(r->in_queue);
+    BOR_FREE(r->sort);
+}
+
+static void refinerPush(refiner_t *r, int cell)
+{
+    if (r->in_queue[cell])
+        return;
+    r->in_queue[cell] = 1;
+    r->queue[(r->queue_head + r->queue_size++) % r->n] = cell;
+}
+
+static int refinerPop(refiner_t *r)
+{
+    int cell;
+
+    cell = r->queue[r->queue_head];
+    r->queue_head = (r->queue_head + 1) % r->n;
+    --r->queue_size;
+    r->in_queue[cell] = 0;
+    return cell;
+}
+
+static int cmpKeyVert(const void *a, const void *b)
+{
+    const key_vert_t *k1 = a, *k2 = b;
+    if (k1->key != k2->key)
+        return (k1->key < k2->key ? -1 : 1);
+    return k1->vert - k2->vert;
+}
+
+static int cmpInt(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+/** Splits the cell according to the keys of its vertices */
+static void refinerSplitCell(refiner_t *r, part_t *p, int start)
+{
+    int end = p->cell_end[start];
+    int size = end - start;
+    int i, j, cur;
+
+    if (size == 1)
+        return;
+
+    for (i = 0; i < size; ++i){
+        r->sort[i].vert = p->elem[start + i];
+        r->sort[i].key = r->key[r->sort[i].vert];
+    }
+    qsort(r->sort, size, sizeof(key_vert_t), cmpKeyVert);
+    if (r->sort[0].key == r->sort[size - 1].key)
+        return;
+
+    for (i = 0; i < size; ++i){
+        p->elem[start + i] = r->sort[i].vert;
+        p->pos[r->sort[i].vert] = start + i;
+    }
+
+    for (cur = start, i = 1; i <= size; ++i){
+        if (i < size && r->sort[i].key == r->sort[i - 1].key)
+            continue;
+
+        p->cell_end[cur] = start + i;
+        for (j = cur; j < start + i; ++j)
+            p->cell[p->elem[j]] = cur;
+        if (cur != start)
+            ++p->cell_size;
+        refinerPush(r, cur);
+        cur = start + i;
+    }
+}
+
+/** Refines the partition until it is equitable */
+static void refinerRun(refiner_t *r, part_t *p)
+{
+    const graph_t *g = r->g;
+    int start, end, i, j, u, w, c;
+
+    while (r->queue_size > 0){
+        start = refinerPop(r);
+        end = p->cell_end[start];
+
+        for (i = start; i < end; ++i){
+            u = p->elem[i];
+            for (j = g->adj_begin[u]; j < g->adj_begin[u + 1]; ++j){
+                w = g->adj[j];
+                if (r->key[w] == 0)
+                    r->touched[r->touched_size++] = w;
+                r->key[w] += 1ull << (21 * g->adj_label[j]);
+            }
+        }
+
+        for (i = 0; i < r->touched_size; ++i){
+            c = p->cell[r->touched[i]];
+            if (!r->is_touched_cell[c]){
+                r->is_touched_cell[c] = 1;
+                r->touched_cell[r->touched_cell_size++] = c;
+            }
+        }
+
+        // Cells are split in their order so that the result does not
+        // depend on the numbering of vertices
+        qsort(r->touched_cell, r->touched_cell_size, sizeof(int), cmpInt);
+        for (i = 0; i < r->touched_cell_size; ++i){
+            refinerSplitCell(r, p, r->touched_cell[i]);
+            r->is_touched_cell[r->touched_cell[i]] = 0;
+        }
+        r->touched_cell_size = 0;
+
+        for (i = 0; i < r->touched_size; ++i)
+            r->key[r->touched[i]] = 0;
+        r->touched_size = 0;
+    }
+}
+
+/** Sets up the partition by colors of vertices and refines it */
+static void refinerInitPart(refiner_t *r, part_t *p)
+{
+    const graph_t *g = r->g;
+    int i;
+
+    for (i = 0; i < r->n; ++i){
+        r->sort[i].key = g->color[i];
+        r->sort[i].vert = i;
+    }
+    qsort(r->sort, r->n, sizeof(key_vert_t), cmpKeyVert);
+    for (i = 0; i < r->n; ++i)
+        r->key[i] = r->sort[i].key;
+
+    p->cell_size = 0;
+    for (i = 0; i < r->n; ++i){
+        p->elem[i] = r->sort[i].vert;
+        p->pos[r->sort[i].vert] = i;
+    }
+    for (i = 0; i < r->n; ++i){
+        if (i == 0 || r->key[i] != r->key[i - 1]){
+            ++p->cell_size;
+            refinerPush(r, i);
+        }
+    }
+    for (i = r->n - 1; i >= 0; --i){
+        if (i == r->n - 1 || r->key[i] != r->key[i + 1]){
+            p->cell_end[i] = i + 1;
+        }else{
+            p->cell_end[i] = p->cell_end[i + 1];
+        }
+    }
+    for (i = 0; i < r->n; ++i){
+        if (i == 0 || r->key[i] != r->key[i - 1]){
+            p->cell[p->elem[i]] = i;
+        }else{
+            p->cell[p->elem[i]] = p->cell[p->elem[i - 1]];
+        }
+    }
+    for (i = 0; i < r->n; ++i)
+        r->key[i] = 0;
+
+    refinerRun(r, p);
+}
+
+/** Makes the vertex a singleton cell and refines the partition */
+static void refinerIndividualize(refiner_t *r, part_t *p, int v)
+{
+    int start = p->cell[v];
+    int end = p->cell_end[start];
+    int u, i;
+
+    if (end - start > 1){
+        u = p->elem[start];
+        p->elem[p->pos[v]] = u;
+        p->pos[u] = p->pos[v];
+        p->elem[start] = v;
+        p->pos[v] = start;
+
+        p->cell_end[start] = start + 1;
+        p->cell_end[start + 1] = end;
+        for (i = start + 1; i < end; ++i)
+            p->cell[p->elem[i]] = start + 1;
+        ++p->cell_size;
+        refinerPush(r, start);
+    }
+    refinerRun(r, p);
+}
+
+
+/*** Search for generators ***/
+struct _gen_search_t {
+    plan_symmetry_t *sym;
+    const graph_t *g;
+    refiner_t ref;
+    int n;
+    part_t *path;     /*!< Partitions along the first path */
+    int *path_vert;   /*!< Individualized vertices along the first path */
+    int *path_cell;   /*!< Target cells along the first path */
+    int depth;
+    part_t *stack;    /*!< Partitions of the currently explored branch */
+    int *perm;
+    int *mark;
+    int *orbit;       /*!< Union-find of orbits */
+    int nodes;
+};
+typedef struct _gen_search_t gen_search_t;
+
+static int orbitFind(int *orbit, int v)
+{
+    int root = v, next;
+
+    while (orbit[root] != root)
+        root = orbit[root];
+    while (orbit[v] != root){
+        next = orbit[v];
+        orbit[v] = root;
+        v = next;
+    }
+    return root;
+}
+
+/** Stores the automorphism .perm[] as a new generator */
+static void addGenerator(gen_search_t *gs)
+{
+    plan_symmetry_t *sym = gs->sym;
+    plan_symmetry_gen_t *gen;
+    int fact_start = sym->var_size;
+    int op_start = fact_start + sym->fact_size;
+    int i, a, b;
+
+    ++sym->gen_size;
+    sym->gen = BOR_REALLOC_ARR(sym->gen, plan_symmetry_gen_t, sym->gen_size);
+    gen = sym->gen + sym->gen_size - 1;
+    gen->var = BOR_ALLOC_ARR(int, BOR_MAX(sym->var_size, 1));
+    gen->fact = BOR_ALLOC_ARR(int, BOR_MAX(sym->fact_size, 1));
+    gen->op = BOR_ALLOC_ARR(int, BOR_MAX(sym->op_size, 1));
+    gen->op_inv = BOR_ALLOC_ARR(int, BOR_MAX(sym->op_size, 1));
+
+    // Colors guarantee that each kind of vertices is mapped on itself
+    for (i = 0; i < sym->var_size; ++i)
+        gen->var[i] = gs->perm[i];
+    for (i = 0; i < sym->fact_size; ++i)
+        gen->fact[i] = gs->perm[fact_start + i] - fact_start;
+    for (i = 0; i < sym->op_size; ++i){
+        gen->op[i] = gs->perm[op_start + i] - op_start;
+        gen->op_inv[gen->op[i]] = i;
+    }
+
+    for (i = 0; i < gs->n; ++i){
+        a = orbitFind(gs->orbit, i);
+        b = orbitFind(gs->orbit, gs->perm[i]);
+        if (a != b)
+            gs->orbit[a] = b;
+    }
+}
+
+/** Explores the branch at the given level looking for a leaf defining an
+ *  automorphism */
+static int searchBranch(gen_search_t *gs, int level)
+{
+    const part_t *cur = gs->stack + level;
+    int i, start, end;
+
+    if (level == gs->depth){
+        for (i = 0; i < gs->n; ++i)
+            gs->perm[gs->path[gs->depth].elem[i]] = cur->elem[i];
+        return graphIsAutomorphism(gs->g, gs->perm, gs->mark);
+    }
+
+    start = gs->path_cell[level];
+    end = cur->cell_end[start];
+    for (i = start; i < end; ++i){
+        if (++gs->nodes > PLAN_SYMMETRY_BRANCH_LIMIT)
+            return 0;
+
+        partCopy(gs->stack + level + 1, cur, gs->n);
+        refinerIndividualize(&gs->ref, gs->stack + level + 1, cur->elem[i]);
+        if (partShapeEq(gs->stack + level + 1, gs->path + level + 1, gs->n)
+                && searchBranch(gs, level + 1))
+            return 1;
+    }
+    return 0;
+}
+
+/** Computes the first path of the search tree, returns -1 if the memory
+ *  limit was reached */
+static int firstPath(gen_search_t *gs)
+{
+    int alloc, cell;
+
+    alloc = 8;
+    gs->path = BOR_ALLOC_ARR(part_t, alloc);
+    gs->path_vert = BOR_ALLOC_ARR(int, alloc);
+    gs->path_cell = BOR_ALLOC_ARR(int, alloc);
+    partInit(gs->path, gs->n);
+    refinerInitPart(&gs->ref, gs->path);
+
+    gs->depth = 0;
+    while ((cell = partFirstNonSingleton(gs->path + gs->depth, gs->n)) >= 0){
+        if (2L * 4L * (gs->depth + 2) * gs->n > PLAN_SYMMETRY_MAX_PART_MEM)
+            return -1;
+
+        if (gs->depth + 1 == alloc){
+            alloc *= 2;
+            gs->path = BOR_REALLOC_ARR(gs->path, part_t, alloc);
+            gs->path_vert = BOR_REALLOC_ARR(gs->path_vert, int, alloc);
+            gs->path_cell = BOR_REALLOC_ARR(gs->path_cell, int, alloc);
+        }
+
+        gs->path_cell[gs->depth] = cell;
+        gs->path_vert[gs->depth] = gs->path[gs->depth].elem[cell];
+        partInit(gs->path + gs->depth + 1, gs->n);
+        partCopy(gs->path + gs->depth + 1, gs->path + gs->depth, gs->n);
+        refinerIndividualize(&gs->ref, gs->path + gs->depth + 1,
+                             gs->path_vert[gs->depth]);
+        ++gs->depth;
+    }
+    return 0;
+}
+
+static void findGenerators(plan_symmetry_t *sym, const graph_t *g)
+{
+    gen_search_t gs;
+    const part_t *p;
+    int level, i, end, v, w;
+
+    if (g->vert_size == 0)
+        return;
+
+    bzero(&gs, sizeof(gs));
+    gs.sym = sym;
+    gs.g = g;
+    gs.n = g->vert_size;
+    refinerInit(&gs.ref, g);
+
+    if (firstPath(&gs) == 0 && gs.depth > 0){
+        gs.stack = BOR_ALLOC_ARR(part_t, gs.depth + 1);
+        for (i = 0; i <= gs.depth; ++i)
+            partInit(gs.stack + i, gs.n);
+        gs.perm = BOR_ALLOC_ARR(int, gs.n);
+        gs.mark = BOR_CALLOC_ARR(int, gs.n);
+        gs.orbit = BOR_ALLOC_ARR(int, gs.n);
+        for (i = 0; i < gs.n; ++i)
+            gs.orbit[i] = i;
+
+        // Going from the bottom of the first path, generators found at
+        // deeper levels fix all vertices individualized above them, so
+        // they can be used for pruning of the candidates at upper levels.
+        for (level = gs.depth - 1; level >= 0; --level){
+            p = gs.path + level;
+            v = gs.path_vert[level];
+            end = p->cell_end[gs.path_cell[level]];
+            for (i = gs.path_cell[level]; i < end; ++i){
+                w = p->elem[i];
+                if (orbitFind(gs.orbit, w) == orbitFind(gs.orbit, v))
+                    continue;
+
+                partCopy(gs.stack + level + 1, p, gs.n);
+                refinerIndividualize(&gs.ref, gs.stack + level + 1, w);
+                if (!partShapeEq(gs.stack + level + 1, gs.path + level + 1,
+                                 gs.n))
+                    continue;
+
+                gs.nodes = 0;
+                if (searchBranch(&gs, level + 1))
+                    addGenerator(&gs);
+            }
+        }
+
+        for (i = 0; i <= gs.depth; ++i)
+            partFree(gs.stack + i);
+        BOR_FREE(gs.stack);
+        BOR_FREE(gs.perm);
+        BOR_FREE(gs.mark);
+        BOR_FREE(gs.orbit);
+    }
+
+    for (i = 0; i <= gs.depth; ++i)
+        partFree(gs.path + i);
+    BOR_FREE(gs.path);
+    BOR_FREE(gs.path_vert);
+    BOR_FREE(gs.path_cell);
+    refinerFree(&gs.ref);
+}
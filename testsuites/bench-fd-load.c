@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <boruvka/timer.h>
+#include "plan/problem.h"
+
+/** Number of variables of the generated problems */
+#define NUM_VARS 500
+/** Number of preconditions and effects of each generated operator */
+#define OP_PRE 4
+#define OP_EFF 3
+
+/**
+ * Writes a random SAS+ problem with the given number of operators. The
+ * successor generator is stored as a single "check" node so that the
+ * benchmark measures parsing and not construction of the generator.
+ */
+static void genSAS(const char *fn, int num_ops)
+{
+    FILE *fout;
+    int range[NUM_VARS];
+    int i, j, k;
+
+    srand(num_ops);
+    fout = fopen(fn, "w");
+    fprintf(fout, "begin_version\n3\nend_version\n");
+    fprintf(fout, "begin_metric\n1\nend_metric\n");
+
+    fprintf(fout, "%d\n", NUM_VARS);
+    for (i = 0; i < NUM_VARS; ++i){
+        range[i] = 2 + rand() % 4;
+        fprintf(fout, "begin_variable\nvar%d\n-1\n%d\n", i, range[i]);
+        for (j = 0; j < range[i]; ++j)
+            fprintf(fout, "Atom fact%d(obj%d)\n", i, j);
+        fprintf(fout, "end_variable\n");
+    }
+
+    fprintf(fout, "0\n");
+    fprintf(fout, "begin_state\n");
+    for (i = 0; i < NUM_VARS; ++i)
+        fprintf(fout, "0\n");
+    fprintf(fout, "end_state\n");
+    fprintf(fout, "begin_goal\n1\n0 1\nend_goal\n");
+
+    fprintf(fout, "%d\n", num_ops);
+    for (i = 0; i < num_ops; ++i){
+        // Variables are taken from disjoint ranges to avoid conflicts
+        k = rand() % (NUM_VARS - OP_PRE - OP_EFF);
+        fprintf(fout, "begin_operator\nop%d obj%d obj%d\n",
+                i, rand() % 100, rand() % 100);
+        fprintf(fout, "%d\n", OP_PRE);
+        for (j = 0; j < OP_PRE; ++j)
+            fprintf(fout, "%d %d\n", k + j, rand() % range[k + j]);
+        fprintf(fout, "%d\n", OP_EFF);
+        for (j = OP_PRE; j < OP_PRE + OP_EFF; ++j){
+            fprintf(fout, "0 %d -1 %d\n", k + j, rand() % range[k + j]);
+        }
+        fprintf(fout, "%d\nend_operator\n", 1 + rand() % 10);
+    }
+    fprintf(fout, "0\n");
+
+    fprintf(fout, "begin_SG\ncheck %d\n", num_ops);
+    for (i = 0; i < num_ops; ++i)
+        fprintf(fout, "%d\n", i);
+    fprintf(fout, "end_SG\n");
+    fclose(fout);
+}
+
+static void bench(const char *fn, int num_ops)
+{
+    plan_problem_t *p;
+    bor_timer_t timer;
+
+    genSAS(fn, num_ops);
+
+    borTimerStart(&timer);
+    p = planProblemFromFD(fn);
+    borTimerStop(&timer);
+    if (p == NULL){
+        fprintf(stderr, "Error: Could not load `%s'\n", fn);
+        return;
+    }
+
+    printf("%d ops: %.3f s, %.0f ops/s\n", p->op_size,
+           borTimerElapsedInSF(&timer),
+           p->op_size / borTimerElapsedInSF(&timer));
+    planProblemDel(p);
+    remove(fn);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *fn = "bench-fd-load.sas";
+
+    if (argc == 2){
+        bench(fn, atoi(argv[1]));
+        return 0;
+    }
+
+    if (argc != 1){
+        fprintf(stderr, "Usage: %s [num_operators]\n", argv[0]);
+        return -1;
+    }
+
+    bench(fn, 10000);
+    bench(fn, 100000);
+    bench(fn, 1000000);
+    return 0;
+}
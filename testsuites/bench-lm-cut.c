@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <boruvka/alloc.h>
+#include <boruvka/timer.h>
+#include "plan/problem.h"
+#include "plan/heur.h"
+
+#include "state_pool.h"
+
+/** Number of passes over all states */
+#define REPEAT 10
+
+static void bench(const char *proto, const char *states)
+{
+    plan_problem_t *p;
+    plan_state_t *state, **st;
+    state_pool_t state_pool;
+    plan_heur_t *heur;
+    plan_heur_res_t res;
+    bor_timer_t timer;
+    long evals, hsum;
+    int i, r, st_size;
+
+    p = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    heur = planHeurLMCutNew(p->var, p->var_size, p->goal,
+                            p->op, p->op_size, 0);
+
+    st = NULL;
+    st_size = 0;
+    statePoolInit(&state_pool, states);
+    state = planStateNew(p->var_size);
+    while (statePoolNext(&state_pool, state) == 0){
+        st = BOR_REALLOC_ARR(st, plan_state_t *, st_size + 1);
+        st[st_size++] = state;
+        state = planStateNew(p->var_size);
+    }
+    planStateDel(state);
+    statePoolFree(&state_pool);
+
+    evals = hsum = 0;
+    borTimerStart(&timer);
+    for (r = 0; r < REPEAT; ++r){
+        for (i = 0; i < st_size; ++i){
+            planHeurResInit(&res);
+            planHeurState(heur, st[i], &res);
+            if (res.heur != PLAN_HEUR_DEAD_END)
+                hsum += res.heur;
+            ++evals;
+        }
+    }
+    borTimerStop(&timer);
+    printf("%s: %ld evaluations, %.0f evaluations/s, heur sum %ld\n",
+           proto, evals, evals / borTimerElapsedInSF(&timer), hsum);
+
+    for (i = 0; i < st_size; ++i)
+        planStateDel(st[i]);
+    if (st)
+        BOR_FREE(st);
+    planHeurDel(heur);
+    planProblemDel(p);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3){
+        bench(argv[1], argv[2]);
+        return 0;
+    }
+
+    if (argc != 1){
+        fprintf(stderr, "Usage: %s [problem.proto states.txt]\n", argv[0]);
+        return -1;
+    }
+
+    // The problems of TSHeurAdmissible with sampled states
+    bench("proto/depot-pfile1.proto", "states/depot-pfile1.txt");
+    bench("proto/driverlog-pfile1.proto", "states/driverlog-pfile1.txt");
+    bench("proto/rovers-p03.proto", "states/rovers-p03.txt");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <boruvka/alloc.h>
+#include <boruvka/timer.h>
+#include "plan/ma_private_state.h"
+
+/** Number of passes over all inserted arrays when looking them up */
+#define REPEAT 10
+
+/** Fills the array of private state IDs for the i-th unique entry */
+static void fillState(int *state, int num_agents, long i)
+{
+    unsigned long x = i * 2654435761ul + 1;
+    int a;
+
+    for (a = 0; a < num_agents; ++a){
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        state[a] = (a == 0 ? (int)i : (int)(x % 1024));
+    }
+}
+
+static void bench(int num_agents, long size)
+{
+    plan_ma_private_state_t aps;
+    bor_timer_t timer;
+    int *state;
+    long i, r, ops, check;
+
+    state = BOR_ALLOC_ARR(int, num_agents);
+    planMAPrivateStateInit(&aps, num_agents, num_agents - 1);
+
+    borTimerStart(&timer);
+    for (i = 0; i < size; ++i){
+        fillState(state, num_agents, i);
+        planMAPrivateStateInsert(&aps, state);
+    }
+    borTimerStop(&timer);
+    printf("agents: %d: insert: %ld states, %.0f inserts/s, %lu bytes\n",
+           num_agents, size, size / borTimerElapsedInSF(&timer),
+           (unsigned long)planMAPrivateStateMemUsage(&aps));
+
+    // Inserting already stored arrays is a lookup
+    ops = check = 0;
+    borTimerStart(&timer);
+    for (r = 0; r < REPEAT; ++r){
+        for (i = 0; i < size; ++i){
+            fillState(state, num_agents, i);
+            check += (planMAPrivateStateInsert(&aps, state) == i);
+            ++ops;
+        }
+    }
+    borTimerStop(&timer);
+    printf("agents: %d: lookup: %ld lookups, %.0f lookups/s, %ld hits\n",
+           num_agents, ops, ops / borTimerElapsedInSF(&timer), check);
+
+    ops = check = 0;
+    borTimerStart(&timer);
+    for (r = 0; r < REPEAT; ++r){
+        for (i = 0; i < size; ++i){
+            planMAPrivateStateGet(&aps, i, state);
+            check += state[0];
+            ++ops;
+        }
+    }
+    borTimerStop(&timer);
+    printf("agents: %d: get: %ld gets, %.0f gets/s, %ld\n",
+           num_agents, ops, ops / borTimerElapsedInSF(&timer), check);
+
+    planMAPrivateStateFree(&aps);
+    BOR_FREE(state);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3){
+        bench(atoi(argv[1]), atol(argv[2]));
+        return 0;
+    }
+
+    if (argc != 1){
+        fprintf(stderr, "Usage: %s [num-agents num-states]\n", argv[0]);
+        return -1;
+    }
+
+    bench(2, 1000000L);
+    bench(5, 1000000L);
+    bench(16, 1000000L);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <boruvka/alloc.h>
+#include <boruvka/timer.h>
+#include "plan/problem.h"
+#include "plan/succ_gen.h"
+
+#include "state_pool.h"
+
+/** Number of passes over all states */
+#define REPEAT 100
+
+/** Returns the number of found operators over all queries */
+static long benchPacked(const char *proto, const char *name,
+                        plan_problem_t *p, const plan_state_id_t *sid,
+                        int sid_size, plan_op_t **op)
+{
+    bor_timer_t timer;
+    const void *buf;
+    long found, queries;
+    int i, r;
+
+    found = queries = 0;
+    borTimerStart(&timer);
+    for (r = 0; r < REPEAT; ++r){
+        for (i = 0; i < sid_size; ++i){
+            buf = planStatePoolGetPackedState(p->state_pool, sid[i]);
+            found += planSuccGenFindPacked(p->succ_gen,
+                                           p->state_pool->packer, buf,
+                                           op, p->op_size);
+            ++queries;
+        }
+    }
+    borTimerStop(&timer);
+    printf("%s: %s: %ld queries, %.0f queries/s, %ld ops\n",
+           proto, name, queries,
+           queries / borTimerElapsedInSF(&timer), found);
+    return found;
+}
+
+/** Returns -1 if the packed variants do not find the same operators as
+ *  the unpacked one */
+static int bench(const char *proto, const char *states)
+{
+    plan_problem_t *p;
+    plan_state_t *state;
+    plan_state_id_t *sid;
+    state_pool_t state_pool;
+    plan_op_t **op;
+    bor_timer_t timer;
+    long found, found_tree, found_mask, queries;
+    int i, r, sid_size;
+
+    p = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    state = planStateNew(p->var_size);
+    op = BOR_ALLOC_ARR(plan_op_t *, p->op_size);
+
+    statePoolInit(&state_pool, states);
+    sid = NULL;
+    for (sid_size = 0; statePoolNext(&state_pool, state) == 0; ++sid_size){
+        sid = BOR_REALLOC_ARR(sid, plan_state_id_t, sid_size + 1);
+        sid[sid_size] = planStatePoolInsert(p->state_pool, state);
+    }
+    statePoolFree(&state_pool);
+
+    found = queries = 0;
+    borTimerStart(&timer);
+    for (r = 0; r < REPEAT; ++r){
+        for (i = 0; i < sid_size; ++i){
+            planStatePoolGetState(p->state_pool, sid[i], state);
+            found += planSuccGenFind(p->succ_gen, state, op, p->op_size);
+            ++queries;
+        }
+    }
+    borTimerStop(&timer);
+    printf("%s: unpacked: %ld queries, %.0f queries/s, %ld ops\n",
+           proto, queries, queries / borTimerElapsedInSF(&timer), found);
+
+    planSuccGenPack(p->succ_gen, p->op, p->op_size, PLAN_SUCC_GEN_TREE);
+    found_tree = benchPacked(proto, "packed tree", p, sid, sid_size, op);
+    planSuccGenPack(p->succ_gen, p->op, p->op_size, PLAN_SUCC_GEN_MASK);
+    found_mask = benchPacked(proto, "packed mask", p, sid, sid_size, op);
+
+    if (sid)
+        BOR_FREE(sid);
+    BOR_FREE(op);
+    planStateDel(state);
+    planProblemDel(p);
+
+    if (found_tree != found || found_mask != found){
+        fprintf(stderr, "Error: %s: packed variants found different number"
+                        " of operators (%ld, %ld instead of %ld)\n",
+                proto, found_tree, found_mask, found);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 0;
+
+    if (argc == 3)
+        return bench(argv[1], argv[2]);
+
+    if (argc != 1){
+        fprintf(stderr, "Usage: %s [problem.proto states.txt]\n", argv[0]);
+        return -1;
+    }
+
+    ret |= bench("proto/depot-pfile1.proto", "states/depot-pfile1.txt");
+    ret |= bench("proto/depot-pfile5.proto", "states/depot-pfile5.txt");
+    ret |= bench("proto/rovers-p03.proto", "states/rovers-p03.txt");
+    ret |= bench("proto/rovers-p15.proto", "states/rovers-p15.txt");
+    return ret;
+}
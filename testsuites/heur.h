@@ -19,6 +19,13 @@ TEST_TS_HEUR(RelaxFF);
 TEST_TS_HEUR(LMCut);
 TEST_TS_HEUR(DTG);
 
+TEST(testHeurDTGTable);
+TEST_SUITE(TSHeurDTGTable) {
+    TEST_ADD(testHeurDTGTable),
+    TEST_ADD(protobufTearDown),
+    TEST_SUITE_CLOSURE
+};
+
 TEST(testHeurLMCutIncLocal);
 TEST(testHeurLMCutIncCache);
 TEST(testHeurLMCutIncCachePrune);
@@ -42,8 +49,10 @@ TEST_SUITE(TSHeurFlow) {
 };
 
 TEST(testHeurPotential);
+TEST(testHeurPotentialEnsemble);
 TEST_SUITE(TSHeurPotential) {
     TEST_ADD(testHeurPotential),
+    TEST_ADD(testHeurPotentialEnsemble),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
@@ -57,6 +66,7 @@ TEST_SUITE(TSHeurPotential) {
     TEST_SUITE_ADD(TSHeurLMCut), \
     TEST_SUITE_ADD(TSHeurLMCutInc), \
     TEST_SUITE_ADD(TSHeurDTG), \
+    TEST_SUITE_ADD(TSHeurDTGTable), \
     TEST_SUITE_ADD(TSHeurFlow), \
     TEST_SUITE_ADD(TSHeurPotential)
 
@@ -28,12 +28,33 @@ static plan_heur_t *heurFlowLandmarks(const plan_problem_t *p)
                            PLAN_HEUR_FLOW_LANDMARKS_LM_CUT);
 }
 
+static plan_heur_t *heurOpCount(const plan_problem_t *p)
+{
+    return planHeurOpCountNew(p->var, p->var_size, p->goal,
+                              p->op, p->op_size,
+                              PLAN_HEUR_OP_COUNT_SEQ
+                                | PLAN_HEUR_OP_COUNT_LM_CUT
+                                | PLAN_HEUR_OP_COUNT_PHO);
+}
+
+static plan_heur_t *heurPDB(const plan_problem_t *p)
+{
+    return planHeurPDBNew(p->var, p->var_size, p->goal,
+                          p->op, p->op_size, 0, 0);
+}
+
+static plan_heur_t *heurMS(const plan_problem_t *p)
+{
+    return planHeurMSNew(p->var, p->var_size, p->goal,
+                         p->op, p->op_size, 0, 0);
+}
+
 static plan_heur_t *heurPotential(const plan_problem_t *p)
 {
     PLAN_STATE_STACK(init_state, p->state_pool->num_vars);
     planStatePoolGetState(p->state_pool, p->initial_state, &init_state);
     return planHeurPotentialNew(p->var, p->var_size, p->goal,
-                                p->op, p->op_size, &init_state, 0);
+                                p->op, p->op_size, &init_state, 0, 0);
 }
 
 static void checkOptimalCost(new_heur_fn new_heur, const char *proto)
@@ -102,6 +123,51 @@ static void checkOptimalCost2(new_heur_fn new_heur, const char *proto,
     fclose(fcosts);
 }
 
+/** Runs A* where the heuristic is evaluated incrementally via node
+ *  callbacks and checks that all evaluated states get the same value from
+ *  a fresh heuristic evaluating states from scratch */
+static void checkNodeEqState(new_heur_fn new_heur, const char *proto)
+{
+    plan_search_astar_params_t params;
+    plan_search_t *search;
+    plan_path_t path;
+    plan_problem_t *p;
+    plan_heur_t *heur;
+    plan_heur_res_t res;
+    plan_state_t *state;
+    plan_state_space_node_t *node;
+    plan_state_id_t sid;
+
+    planSearchAStarParamsInit(&params);
+    p = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    params.search.prob = p;
+    params.search.heur = new_heur(p);
+    params.search.heur_del = 1;
+    search = planSearchAStarNew(&params);
+
+    planPathInit(&path);
+    assertEquals(planSearchRun(search, &path), PLAN_SEARCH_FOUND);
+    planPathFree(&path);
+
+    heur = new_heur(p);
+    state = planStateNew(p->var_size);
+    for (sid = 0; sid < (plan_state_id_t)p->state_pool->num_states; ++sid){
+        node = planStateSpaceNode(search->state_space, sid);
+        if (planStateSpaceNodeIsNew(node))
+            continue;
+
+        planStatePoolGetState(p->state_pool, sid, state);
+        planHeurResInit(&res);
+        planHeurState(heur, state, &res);
+        assertEquals(node->heuristic, res.heur);
+    }
+    planStateDel(state);
+    planHeurDel(heur);
+
+    planSearchDel(search);
+    planProblemDel(p);
+}
+
 TEST(testHeurAdmissibleLMCut)
 {
     checkOptimalCost(heurLMCut, "proto/depot-pfile1.proto");
@@ -190,6 +256,85 @@ TEST(testHeurAdmissibleFlowLandmarks)
                       "states/rovers-p03.cost.txt");
 }
 
+TEST(testHeurAdmissibleFlowWarmStart)
+{
+    // LPs warm-started from the parent's basis must have the same
+    // optimal values as LPs solved from scratch
+    checkNodeEqState(heurFlow, "proto/depot-pfile1.proto");
+    checkNodeEqState(heurFlow, "proto/depot-pfile2.proto");
+    checkNodeEqState(heurFlow, "proto/rovers-p01.proto");
+    checkNodeEqState(heurFlow, "proto/rovers-p02.proto");
+    checkNodeEqState(heurFlow, "proto/rovers-p03.proto");
+    checkNodeEqState(heurFlowLandmarks, "proto/depot-pfile1.proto");
+    checkNodeEqState(heurFlowLandmarks, "proto/rovers-p03.proto");
+}
+
+TEST(testHeurAdmissibleOpCount)
+{
+    checkOptimalCost(heurOpCount, "proto/depot-pfile1.proto");
+    checkOptimalCost(heurOpCount, "proto/depot-pfile2.proto");
+    checkOptimalCost(heurOpCount, "proto/rovers-p01.proto");
+    checkOptimalCost(heurOpCount, "proto/rovers-p02.proto");
+    checkOptimalCost(heurOpCount, "proto/rovers-p03.proto");
+
+    checkOptimalCost2(heurOpCount,
+                      "proto/depot-pfile1.proto",
+                      "states/depot-pfile1.txt",
+                      "states/depot-pfile1.cost.txt");
+    checkOptimalCost2(heurOpCount,
+                      "proto/driverlog-pfile1.proto",
+                      "states/driverlog-pfile1.txt",
+                      "states/driverlog-pfile1.cost.txt");
+    checkOptimalCost2(heurOpCount,
+                      "proto/rovers-p03.proto",
+                      "states/rovers-p03.txt",
+                      "states/rovers-p03.cost.txt");
+}
+
+TEST(testHeurAdmissiblePDB)
+{
+    checkOptimalCost(heurPDB, "proto/depot-pfile1.proto");
+    checkOptimalCost(heurPDB, "proto/depot-pfile2.proto");
+    checkOptimalCost(heurPDB, "proto/rovers-p01.proto");
+    checkOptimalCost(heurPDB, "proto/rovers-p02.proto");
+    checkOptimalCost(heurPDB, "proto/rovers-p03.proto");
+
+    checkOptimalCost2(heurPDB,
+                      "proto/depot-pfile1.proto",
+                      "states/depot-pfile1.txt",
+                      "states/depot-pfile1.cost.txt");
+    checkOptimalCost2(heurPDB,
+                      "proto/driverlog-pfile1.proto",
+                      "states/driverlog-pfile1.txt",
+                      "states/driverlog-pfile1.cost.txt");
+    checkOptimalCost2(heurPDB,
+                      "proto/rovers-p03.proto",
+                      "states/rovers-p03.txt",
+                      "states/rovers-p03.cost.txt");
+}
+
+TEST(testHeurAdmissibleMS)
+{
+    checkOptimalCost(heurMS, "proto/depot-pfile1.proto");
+    checkOptimalCost(heurMS, "proto/depot-pfile2.proto");
+    checkOptimalCost(heurMS, "proto/rovers-p01.proto");
+    checkOptimalCost(heurMS, "proto/rovers-p02.proto");
+    checkOptimalCost(heurMS, "proto/rovers-p03.proto");
+
+    checkOptimalCost2(heurMS,
+                      "proto/depot-pfile1.proto",
+                      "states/depot-pfile1.txt",
+                      "states/depot-pfile1.cost.txt");
+    checkOptimalCost2(heurMS,
+                      "proto/driverlog-pfile1.proto",
+                      "states/driverlog-pfile1.txt",
+                      "states/driverlog-pfile1.cost.txt");
+    checkOptimalCost2(heurMS,
+                      "proto/rovers-p03.proto",
+                      "states/rovers-p03.txt",
+                      "states/rovers-p03.cost.txt");
+}
+
 TEST(testHeurAdmissiblePotential)
 {
     checkOptimalCost(heurPotential, "proto/depot-pfile1.proto");
@@ -5,6 +5,10 @@ TEST(testHeurAdmissibleLMCut);
 TEST(testHeurAdmissibleMax);
 TEST(testHeurAdmissibleFlow);
 TEST(testHeurAdmissibleFlowLandmarks);
+TEST(testHeurAdmissibleFlowWarmStart);
+TEST(testHeurAdmissibleOpCount);
+TEST(testHeurAdmissiblePDB);
+TEST(testHeurAdmissibleMS);
 TEST(testHeurAdmissiblePotential);
 TEST(protobufTearDown);
 
@@ -13,6 +17,10 @@ TEST_SUITE(TSHeurAdmissible){
     TEST_ADD(testHeurAdmissibleMax),
     TEST_ADD(testHeurAdmissibleFlow),
     TEST_ADD(testHeurAdmissibleFlowLandmarks),
+    TEST_ADD(testHeurAdmissibleFlowWarmStart),
+    TEST_ADD(testHeurAdmissibleOpCount),
+    TEST_ADD(testHeurAdmissiblePDB),
+    TEST_ADD(testHeurAdmissibleMS),
     TEST_ADD(testHeurAdmissiblePotential),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
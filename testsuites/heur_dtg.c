@@ -1,11 +1,44 @@
 #include <cu/cu.h>
 #include "plan/heur.h"
 #include "heur_common.h"
+#include "state_pool.h"
 
 static plan_heur_t *dtgNew(plan_problem_t *p)
 {
     return planHeurDTGNew(p->var, p->var_size, p->goal,
-                          p->op, p->op_size);
+                          p->op, p->op_size, 0);
+}
+
+static void cmpTable(const char *proto, const char *states)
+{
+    plan_problem_t *p;
+    state_pool_t state_pool;
+    plan_state_t *state;
+    plan_heur_t *heur, *heur_table;
+    plan_heur_res_t res, res_table;
+
+    p = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    state = planStateNew(p->state_pool->num_vars);
+    statePoolInit(&state_pool, states);
+
+    heur = planHeurDTGNew(p->var, p->var_size, p->goal,
+                          p->op, p->op_size, 0);
+    heur_table = planHeurDTGNew(p->var, p->var_size, p->goal,
+                                p->op, p->op_size, PLAN_HEUR_DTG_TABLE);
+
+    while (statePoolNext(&state_pool, state) == 0){
+        planHeurResInit(&res);
+        planHeurState(heur, state, &res);
+        planHeurResInit(&res_table);
+        planHeurState(heur_table, state, &res_table);
+        assertEquals(res.heur, res_table.heur);
+    }
+
+    planHeurDel(heur);
+    planHeurDel(heur_table);
+    statePoolFree(&state_pool);
+    planStateDel(state);
+    planProblemDel(p);
 }
 
 TEST(testHeurDTG)
@@ -21,3 +54,13 @@ TEST(testHeurDTG)
     runHeurTest("DTG", "proto/CityCar-p3-2-2-0-1.proto",
             "states/citycar-p3-2-2-0-1.txt", dtgNew, 0, 0);
 }
+
+TEST(testHeurDTGTable)
+{
+    cmpTable("proto/depot-pfile1.proto", "states/depot-pfile1.txt");
+    cmpTable("proto/depot-pfile5.proto", "states/depot-pfile5.txt");
+    cmpTable("proto/rovers-p03.proto", "states/rovers-p03.txt");
+    cmpTable("proto/rovers-p15.proto", "states/rovers-p15.txt");
+    cmpTable("proto/CityCar-p3-2-2-0-1.proto",
+             "states/citycar-p3-2-2-0-1.txt");
+}
@@ -21,7 +21,7 @@ static void runAStar(const char *proto, unsigned flags,
     planSearchAStarParamsInit(&params);
     params.search.heur = planHeurPotentialNew(p->var, p->var_size, p->goal,
                                               p->op, p->op_size, state,
-                                              flags);
+                                              flags, 0);
     //params.search.heur = planHeurLMCutNew(p->var, p->var_size, p->goal,
     //                                      p->op, p->op_size, flags);
     planStateDel(state);
@@ -57,3 +57,14 @@ TEST(testHeurPotential)
     runAStar("proto/rovers-p03.proto", 0, 11);
     runAStar("proto/sokoban-p01.proto", 0, 9);
 }
+
+TEST(testHeurPotentialEnsemble)
+{
+    unsigned flags = PLAN_HEUR_POT_ENSEMBLE(8);
+
+    runAStar("proto/simple.proto", flags, 10);
+    runAStar("proto/depot-pfile1.proto", flags, 10);
+    runAStar("proto/driverlog-pfile1.proto", flags, 7);
+    runAStar("proto/rovers-p01.proto", flags, 10);
+    runAStar("proto/sokoban-p01.proto", flags, 9);
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <cu/cu.h>
+#include <boruvka/alloc.h>
 #include <plan/landmark.h>
 
 static int ldm0[] = { 0, 1, 3, 4 };
@@ -82,3 +83,129 @@ TEST(testLandmarkCache)
 
     planLandmarkCacheDel(ldmc);
 }
+
+TEST(testLandmarkCacheBounded)
+{
+    plan_landmark_cache_t *ldmc;
+    plan_landmark_set_t ldms;
+    const plan_landmark_set_t *l;
+    int ops[1000], *big;
+    int i, id;
+    long evictions;
+
+    for (i = 0; i < 1000; ++i)
+        ops[i] = i;
+
+    ldmc = planLandmarkCacheNew(PLAN_LANDMARK_CACHE_MAX_MEM_MB(1));
+    for (id = 0; id < 1000; ++id){
+        planLandmarkSetInit(&ldms);
+        planLandmarkSetAdd(&ldms, 1000, ops);
+        assertEquals(planLandmarkCacheAdd(ldmc, id, &ldms), 0);
+
+        // Keep the first set alive
+        l = planLandmarkCacheGet(ldmc, 0);
+        assertNotEquals(l, NULL);
+        if (l != NULL){
+            assertEquals(l->size, 1);
+            assertEquals(l->landmark[0].size, 1000);
+            assertEquals(l->landmark[0].op_id[999], 999);
+        }
+    }
+
+    assertEquals(planLandmarkCacheGet(ldmc, 1), NULL);
+    assertNotEquals(planLandmarkCacheGet(ldmc, 999), NULL);
+    assertEquals(ldmc->stats.inserts, 1000);
+    assertEquals(ldmc->stats.sets + ldmc->stats.evictions, 1000);
+    assertTrue(ldmc->stats.evictions > 0);
+    assertTrue(ldmc->stats.max_bytes <= 1024L * 1024L);
+    assertEquals(ldmc->stats.misses, 1);
+    assertEquals(ldmc->stats.rejected, 0);
+
+    // A set larger than the whole cache is rejected without evicting
+    // anything
+    evictions = ldmc->stats.evictions;
+    big = BOR_ALLOC_ARR(int, 300000);
+    for (i = 0; i < 300000; ++i)
+        big[i] = i;
+    planLandmarkSetInit(&ldms);
+    planLandmarkSetAdd(&ldms, 300000, big);
+    BOR_FREE(big);
+    assertEquals(planLandmarkCacheAdd(ldmc, 1000, &ldms), 0);
+    assertEquals(ldmc->stats.rejected, 1);
+    assertEquals(ldmc->stats.evictions, evictions);
+    assertEquals(ldmc->stats.inserts, 1000);
+    assertEquals(planLandmarkCacheGet(ldmc, 1000), NULL);
+    assertNotEquals(planLandmarkCacheGet(ldmc, 0), NULL);
+
+    planLandmarkCacheDel(ldmc);
+}
+
+TEST(testLandmarkCacheSparseIDs)
+{
+    plan_landmark_cache_t *ldmc;
+    plan_landmark_set_t ldms;
+    int ops[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    int i, id;
+
+    // IDs are spread over the whole range of int, so the index must not
+    // depend on the largest ID
+    ldmc = planLandmarkCacheNew(PLAN_LANDMARK_CACHE_MAX_MEM_MB(1));
+    for (i = 0; i < 100000; ++i){
+        id = i * 21473;
+        planLandmarkSetInit(&ldms);
+        planLandmarkSetAdd(&ldms, 10, ops);
+        assertEquals(planLandmarkCacheAdd(ldmc, id, &ldms), 0);
+    }
+
+    assertNotEquals(planLandmarkCacheGet(ldmc, 99999 * 21473), NULL);
+    assertEquals(planLandmarkCacheGet(ldmc, 0), NULL);
+    assertEquals(planLandmarkCacheGet(ldmc, 1), NULL);
+    assertEquals(ldmc->stats.sets + ldmc->stats.evictions, 100000);
+    assertTrue(ldmc->stats.evictions > 0);
+    assertTrue(ldmc->stats.max_bytes <= 1024L * 1024L);
+    assertTrue(ldmc->buf_size * (long)sizeof(int)
+                + ldmc->idx_size * (long)(sizeof(int) + sizeof(long))
+                    <= 1024L * 1024L);
+
+    planLandmarkCacheDel(ldmc);
+}
+
+TEST(testLandmarkCachePruneDuplicate)
+{
+    plan_landmark_cache_t *ldmc;
+    plan_landmark_set_t ldms;
+    int ops[1000];
+    int i;
+
+    for (i = 0; i < 1000; ++i)
+        ops[i] = i;
+
+    ldmc = planLandmarkCacheNew(PLAN_LANDMARK_CACHE_PRUNE
+                                    | PLAN_LANDMARK_CACHE_MAX_MEM_MB(1));
+    planLandmarkSetInit(&ldms);
+    planLandmarkSetAdd(&ldms, 4, ldm0);
+    assertEquals(planLandmarkCacheAdd(ldmc, 0, &ldms), 0);
+    assertNotEquals(planLandmarkCacheGet(ldmc, 0), NULL);
+
+    // Set 0 stays in the list of prune-ready sets as the last one, but it
+    // is evicted from the cache
+    for (i = 1; i < 1000; ++i){
+        planLandmarkSetInit(&ldms);
+        planLandmarkSetAdd(&ldms, 1000, ops);
+        assertEquals(planLandmarkCacheAdd(ldmc, i, &ldms), 0);
+    }
+    assertEquals(planLandmarkCacheGet(ldmc, 0), NULL);
+
+    // Now the set is stored again and it gets into the list second time
+    planLandmarkSetInit(&ldms);
+    planLandmarkSetAdd(&ldms, 4, ldm0);
+    assertEquals(planLandmarkCacheAdd(ldmc, 0, &ldms), 0);
+    assertNotEquals(planLandmarkCacheGet(ldmc, 0), NULL);
+
+    // The last used set must survive pruning
+    assertEquals(planLandmarkPrune(ldmc), 0);
+    assertNotEquals(planLandmarkCacheGet(ldmc, 0), NULL);
+    assertEquals(ldmc->stats.pruned, 0);
+
+    planLandmarkCacheDel(ldmc);
+}
@@ -1,10 +1,16 @@
 #ifndef TEST_LANDMARK
 
 TEST(testLandmarkCache);
+TEST(testLandmarkCacheBounded);
+TEST(testLandmarkCacheSparseIDs);
+TEST(testLandmarkCachePruneDuplicate);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSLandmark) {
     TEST_ADD(testLandmarkCache),
+    TEST_ADD(testLandmarkCacheBounded),
+    TEST_ADD(testLandmarkCacheSparseIDs),
+    TEST_ADD(testLandmarkCachePruneDuplicate),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
@@ -1,4 +1,7 @@
+#include <unistd.h>
+#include <string.h>
 #include <cu/cu.h>
+#include <boruvka/alloc.h>
 #include "plan/problem.h"
 
 static void pVar(const plan_var_t *var, int var_size, FILE *fout)
@@ -261,6 +264,68 @@ TEST(testLoadFromProtoClone)
 }
 
 
+static void binFromProto(const char *proto, int flags, FILE *f1, FILE *f2)
+{
+    plan_problem_t *p1, *p2, *p3;
+    const char *fn = "regressions/tmp.load-from-file.bin";
+
+    p1 = planProblemFromProto(proto, flags);
+    assertEquals(planProblemToBin(p1, fn), 0);
+    p2 = planProblemFromBin(fn);
+    assertNotEquals(p2, NULL);
+    if (p2 == NULL){
+        planProblemDel(p1);
+        return;
+    }
+    assertNotEquals(p2->bin_map, NULL);
+    assertEquals(p1->op_size, p2->op_size);
+    assertEquals(p2->state_pool->num_states, 1);
+
+    fprintf(f1, "---- %s %x ----\n", proto, flags);
+    pProblem(p1, f1);
+    fprintf(f1, "---- %s %x END ----\n", proto, flags);
+
+    fprintf(f2, "---- %s %x ----\n", proto, flags);
+    pProblem(p2, f2);
+    fprintf(f2, "---- %s %x END ----\n", proto, flags);
+
+    // Cloned problem must not depend on the mapped file
+    p3 = planProblemClone(p2);
+    assertEquals(p3->bin_map, NULL);
+    planProblemDel(p2);
+    assertEquals(p1->op_size, p3->op_size);
+
+    planProblemDel(p1);
+    planProblemDel(p3);
+}
+
+TEST(testLoadFromBin)
+{
+    int flags;
+    FILE *f1, *f2;
+
+    f1 = fopen("regressions/temp.load-from-file-cmp-from-bin.out", "w");
+    f2 = fopen("regressions/tmp.temp.load-from-file-cmp-from-bin.out", "w");
+    if (f1 == NULL || f2 == NULL){
+        fprintf(stderr, "Could not open files for comparison!!\n");
+        return;
+    }
+
+    flags = PLAN_PROBLEM_USE_CG | PLAN_PROBLEM_PRUNE_DUPLICATES;
+    binFromProto("proto/rovers-p03.proto", flags, f1, f2);
+    binFromProto("proto/depot-pfile5.proto", flags, f1, f2);
+    binFromProto("proto/CityCar-p3-2-2-0-1.proto", flags, f1, f2);
+
+    flags = 0;
+    binFromProto("proto/rovers-p03.proto", flags, f1, f2);
+    binFromProto("proto/depot-pfile5.proto", flags, f1, f2);
+    binFromProto("proto/CityCar-p3-2-2-0-1.proto", flags, f1, f2);
+
+    fclose(f1);
+    fclose(f2);
+}
+
+
 static void cloneAgentFromProto(const char *proto, int flags, FILE *f1, FILE *f2)
 {
     plan_problem_agents_t *p1, *p2;
@@ -352,3 +417,176 @@ TEST(testLoadFromFactoredProto)
     loadFactoredProto("proto/rovers-p03-rover0.proto", flags);
     loadFactoredProto("proto/rovers-p03-rover1.proto", flags);
 }
+
+
+/** Number of operators of the generated problem, large enough to sort and
+ *  pack the operators in several threads */
+#define LARGE_OP_SIZE 16384
+/** Field number of PlanProblem.operator */
+#define PROTO_OPERATOR_FIELD 6
+
+static int readVarint(const unsigned char *buf, size_t size,
+                      size_t *pos, uint64_t *val)
+{
+    int shift = 0;
+
+    *val = 0;
+    for (; *pos < size && shift < 64; ++*pos, shift += 7){
+        *val |= (uint64_t)(buf[*pos] & 0x7f) << shift;
+        if ((buf[*pos] & 0x80) == 0){
+            ++*pos;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/** Skips a top-level field of the message starting at *pos and returns
+ *  its field number or -1 on a malformed input. Top-level fields of
+ *  PlanProblem are either varints or length-delimited. */
+static int skipField(const unsigned char *buf, size_t size, size_t *pos)
+{
+    uint64_t tag, val;
+
+    if (readVarint(buf, size, pos, &tag) != 0
+            || readVarint(buf, size, pos, &val) != 0)
+        return -1;
+    if ((tag & 0x7) == 2){
+        if (val > size - *pos)
+            return -1;
+        *pos += val;
+    }else if ((tag & 0x7) != 0){
+        return -1;
+    }
+    return tag >> 3;
+}
+
+/** Writes the problem from the proto file to the out file with its
+ *  operators repeated so that there are at least LARGE_OP_SIZE of them.
+ *  Repeated fields of concatenated protobuf messages are merged, so it is
+ *  enough to append the operator fields again. Returns the number of
+ *  operators in the output file or -1 on failure. */
+static int writeLargeProto(const char *proto, const char *out)
+{
+    FILE *fin, *fout;
+    unsigned char *buf;
+    size_t size, pos, start;
+    int field, op_size, copies, i;
+
+    fin = fopen(proto, "rb");
+    if (fin == NULL)
+        return -1;
+    fseek(fin, 0, SEEK_END);
+    size = ftell(fin);
+    fseek(fin, 0, SEEK_SET);
+    buf = BOR_ALLOC_ARR(unsigned char, size);
+    if (fread(buf, 1, size, fin) != size)
+        size = 0;
+    fclose(fin);
+
+    op_size = 0;
+    for (pos = 0; pos < size;){
+        if ((field = skipField(buf, size, &pos)) < 0)
+            break;
+        if (field == PROTO_OPERATOR_FIELD)
+            ++op_size;
+    }
+
+    fout = NULL;
+    if (pos == size && op_size > 0)
+        fout = fopen(out, "wb");
+    if (fout == NULL){
+        BOR_FREE(buf);
+        return -1;
+    }
+
+    fwrite(buf, 1, size, fout);
+    copies = (LARGE_OP_SIZE + op_size - 1) / op_size;
+    for (i = 1; i < copies; ++i){
+        for (pos = 0; pos < size;){
+            start = pos;
+            if (skipField(buf, size, &pos) == PROTO_OPERATOR_FIELD)
+                fwrite(buf + start, 1, pos - start, fout);
+        }
+    }
+
+    fclose(fout);
+    BOR_FREE(buf);
+    return op_size * copies;
+}
+
+static int partStateEq(const plan_part_state_t *ps1,
+                       const plan_part_state_t *ps2)
+{
+    if (!planPartStateEq(ps1, ps2) || ps1->bufsize != ps2->bufsize)
+        return 0;
+    if (ps1->bufsize == 0)
+        return 1;
+    return memcmp(ps1->valbuf, ps2->valbuf, ps1->bufsize) == 0
+            && memcmp(ps1->maskbuf, ps2->maskbuf, ps1->bufsize) == 0;
+}
+
+/** Compares operators including their packed part-states */
+static int opEq(const plan_op_t *op1, const plan_op_t *op2)
+{
+    int i;
+
+    if (strcmp(op1->name, op2->name) != 0
+            || op1->cost != op2->cost
+            || op1->cond_eff_size != op2->cond_eff_size
+            || !partStateEq(op1->pre, op2->pre)
+            || !partStateEq(op1->eff, op2->eff))
+        return 0;
+
+    for (i = 0; i < op1->cond_eff_size; ++i){
+        if (!partStateEq(op1->cond_eff[i].pre, op2->cond_eff[i].pre)
+                || !partStateEq(op1->cond_eff[i].eff, op2->cond_eff[i].eff))
+            return 0;
+    }
+    return 1;
+}
+
+static void loadLargeProto(const char *proto)
+{
+    const char *large = "regressions/tmp.load-from-file-large.proto";
+    plan_problem_t *p, *lp;
+    int i, op_size;
+
+    op_size = writeLargeProto(proto, large);
+    assertTrue(op_size >= LARGE_OP_SIZE);
+    if (op_size < LARGE_OP_SIZE)
+        return;
+
+    // Without pruning, all copies are packed the same way as the
+    // operators of the original problem
+    p = planProblemFromProto(proto, 0);
+    lp = planProblemFromProto(large, 0);
+    assertEquals(lp->op_size, op_size);
+    assertEquals(lp->op_size % p->op_size, 0);
+    for (i = 0; i < lp->op_size; ++i)
+        assertTrue(opEq(lp->op + i, p->op + (i % p->op_size)));
+    planProblemDel(p);
+    planProblemDel(lp);
+
+    // With pruning, all copies are removed and the same operators survive
+    // in the same order
+    p = planProblemFromProto(proto, PLAN_PROBLEM_PRUNE_DUPLICATES);
+    lp = planProblemFromProto(large, PLAN_PROBLEM_PRUNE_DUPLICATES);
+    assertEquals(lp->op_size, p->op_size);
+    assertEquals(lp->duplicate_ops_removed, op_size - p->op_size);
+    for (i = 0; i < lp->op_size && i < p->op_size; ++i){
+        assertTrue(opEq(lp->op + i, p->op + i));
+        assertEquals(lp->op[i].global_id, p->op[i].global_id);
+    }
+    planProblemDel(p);
+    planProblemDel(lp);
+
+    unlink(large);
+}
+
+TEST(testLoadFromProtoLarge)
+{
+    loadLargeProto("proto/CityCar-p3-2-2-0-1.proto");
+    loadLargeProto("proto/depot-pfile5.proto");
+    loadLargeProto("proto/rovers-p15.proto");
+}
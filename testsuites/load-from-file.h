@@ -5,8 +5,10 @@ TEST(testLoadFromProto);
 TEST(testLoadFromProtoCondEff);
 TEST(testLoadAgentFromProto);
 TEST(testLoadFromProtoClone);
+TEST(testLoadFromBin);
 TEST(testLoadAgentFromProtoClone);
 TEST(testLoadFromFactoredProto);
+TEST(testLoadFromProtoLarge);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSLoadFromFile) {
@@ -14,8 +16,10 @@ TEST_SUITE(TSLoadFromFile) {
     TEST_ADD(testLoadFromProtoCondEff),
     TEST_ADD(testLoadAgentFromProto),
     TEST_ADD(testLoadFromProtoClone),
+    TEST_ADD(testLoadFromBin),
     TEST_ADD(testLoadAgentFromProtoClone),
     TEST_ADD(testLoadFromFactoredProto),
+    TEST_ADD(testLoadFromProtoLarge),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
@@ -0,0 +1,581 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <cu/cu.h>
+#include <plan/lp.h>
+#include "../src/lp_simplex.h"
+
+#define MAX_ROWS 8
+#define MAX_COLS 6
+#define EPS 1E-6
+
+#ifndef PLAN_LP
+# define PLAN_LP_OPTIMAL    0
+# define PLAN_LP_INFEASIBLE 1
+# define PLAN_LP_UNBOUNDED  2
+# define PLAN_LP_FAILED     3
+#endif /* PLAN_LP */
+
+/** Dense description of a small problem that can be loaded into both
+ *  solvers */
+struct _prob_t {
+    int rows;
+    int cols;
+    int maximize;
+    double obj[MAX_COLS];
+    double lb[MAX_COLS];
+    double ub[MAX_COLS];
+    int bounded[MAX_COLS]; /*!< True if .ub is set */
+    int is_int[MAX_COLS];
+    double coef[MAX_ROWS][MAX_COLS];
+    double rhs[MAX_ROWS];
+    char sense[MAX_ROWS];
+};
+typedef struct _prob_t prob_t;
+
+static void probInit(prob_t *p, int rows, int cols, int maximize)
+{
+    bzero(p, sizeof(*p));
+    p->rows = rows;
+    p->cols = cols;
+    p->maximize = maximize;
+}
+
+static void probSetUB(prob_t *p, int col, double ub)
+{
+    p->ub[col] = ub;
+    p->bounded[col] = 1;
+}
+
+static int randInt(int from, int to)
+{
+    return from + rand() % (to - from + 1);
+}
+
+static void probRand(prob_t *p, int ilp)
+{
+    static const char sense[4] = { 'L', 'L', 'G', 'E' };
+    int row, col;
+
+    probInit(p, randInt(1, MAX_ROWS), randInt(1, MAX_COLS), rand() % 2);
+    for (col = 0; col < p->cols; ++col){
+        p->obj[col] = randInt(-5, 5);
+        if (ilp){
+            probSetUB(p, col, randInt(1, 3));
+            p->is_int[col] = 1;
+        }else if (rand() % 3 != 0){
+            probSetUB(p, col, randInt(1, 10));
+        }
+    }
+
+    for (row = 0; row < p->rows; ++row){
+        for (col = 0; col < p->cols; ++col){
+            if (rand() % 3 != 0)
+                p->coef[row][col] = randInt(-4, 6);
+        }
+        p->rhs[row] = randInt(-5, 15);
+        p->sense[row] = sense[rand() % 4];
+    }
+}
+
+/** Random problem with many constraints active in the same vertex */
+static void probRandDegenerate(prob_t *p)
+{
+    int row, col;
+
+    probRand(p, 0);
+    p->rows = MAX_ROWS;
+    for (row = 0; row < p->rows; ++row){
+        if (row % 2 == 1){
+            // Scaled copy of the previous row
+            for (col = 0; col < p->cols; ++col)
+                p->coef[row][col] = 2. * p->coef[row - 1][col];
+            p->rhs[row] = 2. * p->rhs[row - 1];
+            p->sense[row] = p->sense[row - 1];
+        }else{
+            for (col = 0; col < p->cols; ++col)
+                p->coef[row][col] = randInt(-4, 6);
+            p->rhs[row] = 0.;
+            p->sense[row] = 'L';
+        }
+    }
+}
+
+static int simplexStatus(int status)
+{
+    switch (status){
+        case PLAN_LP_SIMPLEX_OPTIMAL:
+            return PLAN_LP_OPTIMAL;
+        case PLAN_LP_SIMPLEX_INFEASIBLE:
+            return PLAN_LP_INFEASIBLE;
+        case PLAN_LP_SIMPLEX_UNBOUNDED:
+            return PLAN_LP_UNBOUNDED;
+        default:
+            return PLAN_LP_FAILED;
+    }
+}
+
+static int solveSimplex(const prob_t *p, int ilp, double *z)
+{
+    plan_lp_simplex_t lp;
+    int row, col, status;
+
+    planLPSimplexInit(&lp, p->rows, p->cols, p->maximize);
+    for (col = 0; col < p->cols; ++col){
+        planLPSimplexSetObj(&lp, col, p->obj[col]);
+        planLPSimplexSetVarRange(&lp, col, p->lb[col],
+                                 p->bounded[col] ? p->ub[col]
+                                                 : PLAN_LP_SIMPLEX_INF);
+        if (p->is_int[col])
+            planLPSimplexSetVarInt(&lp, col);
+    }
+    for (row = 0; row < p->rows; ++row){
+        for (col = 0; col < p->cols; ++col){
+            if (p->coef[row][col] != 0.)
+                planLPSimplexSetCoef(&lp, row, col, p->coef[row][col]);
+        }
+        planLPSimplexSetRHS(&lp, row, p->rhs[row], p->sense[row]);
+    }
+
+    if (ilp){
+        status = planLPSimplexSolveILP(&lp, z);
+    }else{
+        status = planLPSimplexSolve(&lp, z);
+    }
+    planLPSimplexFree(&lp);
+    return simplexStatus(status);
+}
+
+#ifdef PLAN_LP
+static int solveBackend(const prob_t *p, int ilp, double *z)
+{
+    plan_lp_t *lp;
+    int row, col, status;
+
+    lp = planLPNew(p->rows, p->cols,
+                   (p->maximize ? PLAN_LP_MAX : PLAN_LP_MIN));
+    for (col = 0; col < p->cols; ++col){
+        planLPSetObj(lp, col, p->obj[col]);
+        if (p->bounded[col])
+            planLPSetVarRange(lp, col, p->lb[col], p->ub[col]);
+        if (ilp && p->is_int[col])
+            planLPSetVarInt(lp, col);
+    }
+    for (row = 0; row < p->rows; ++row){
+        for (col = 0; col < p->cols; ++col){
+            if (p->coef[row][col] != 0.)
+                planLPSetCoef(lp, row, col, p->coef[row][col]);
+        }
+        planLPSetRHS(lp, row, p->rhs[row], p->sense[row]);
+    }
+
+    if (ilp){
+        *z = planLPSolveILPObjVal(lp);
+    }else{
+        *z = planLPSolveObjVal(lp);
+    }
+    status = planLPStatus(lp);
+    planLPDel(lp);
+    return status;
+}
+#endif /* PLAN_LP */
+
+static int isBounded(const prob_t *p)
+{
+    int col;
+
+    for (col = 0; col < p->cols; ++col){
+        if (!p->bounded[col])
+            return 0;
+    }
+    return 1;
+}
+
+/** Enumerates all points of a bounded pure integer problem */
+static int solveBruteForce(const prob_t *p, double *z)
+{
+    int x[MAX_COLS];
+    int row, col, found = 0;
+    double val, act;
+
+    for (col = 0; col < p->cols; ++col)
+        x[col] = p->lb[col];
+
+    while (1){
+        for (row = 0; row < p->rows; ++row){
+            act = 0.;
+            for (col = 0; col < p->cols; ++col)
+                act += p->coef[row][col] * x[col];
+            if ((p->sense[row] == 'L' && act > p->rhs[row] + EPS)
+                    || (p->sense[row] == 'G' && act < p->rhs[row] - EPS)
+                    || (p->sense[row] == 'E'
+                            && fabs(act - p->rhs[row]) > EPS))
+                break;
+        }
+
+        if (row == p->rows){
+            val = 0.;
+            for (col = 0; col < p->cols; ++col)
+                val += p->obj[col] * x[col];
+            if (!found || (p->maximize && val > *z)
+                    || (!p->maximize && val < *z)){
+                *z = val;
+                found = 1;
+            }
+        }
+
+        for (col = 0; col < p->cols && x[col] == p->ub[col]; ++col)
+            x[col] = p->lb[col];
+        if (col == p->cols)
+            break;
+        ++x[col];
+    }
+
+    return (found ? PLAN_LP_OPTIMAL : PLAN_LP_INFEASIBLE);
+}
+
+/** Bound substituted for missing upper bounds by solveVertices() */
+#define VERTEX_BIG_UB 1E6
+#define MAX_BOUNDS (MAX_ROWS + 2 * MAX_COLS)
+
+/** Solves the square system a x = b in place by the Gaussian elimination
+ *  with partial pivoting. Returns 0 if the system is singular. */
+static int solveSquare(int n, double a[MAX_COLS][MAX_COLS + 1],
+                       double *x)
+{
+    int i, j, k, piv;
+    double tmp, f;
+
+    for (i = 0; i < n; ++i){
+        piv = i;
+        for (j = i + 1; j < n; ++j){
+            if (fabs(a[j][i]) > fabs(a[piv][i]))
+                piv = j;
+        }
+        if (fabs(a[piv][i]) < 1E-9)
+            return 0;
+        for (k = 0; k <= n; ++k){
+            tmp = a[i][k];
+            a[i][k] = a[piv][k];
+            a[piv][k] = tmp;
+        }
+        for (j = i + 1; j < n; ++j){
+            f = a[j][i] / a[i][i];
+            for (k = i; k <= n; ++k)
+                a[j][k] -= f * a[i][k];
+        }
+    }
+
+    for (i = n - 1; i >= 0; --i){
+        x[i] = a[i][n];
+        for (k = i + 1; k < n; ++k)
+            x[i] -= a[i][k] * x[k];
+        x[i] /= a[i][i];
+    }
+    return 1;
+}
+
+/** Finds the best vertex of the problem with all missing upper bounds
+ *  set to big_ub by trying all combinations of .cols constraints and
+ *  bounds as the active set. */
+static int solveVerticesBox(const prob_t *p, double big_ub, double *z)
+{
+    double ca[MAX_BOUNDS][MAX_COLS], cb[MAX_BOUNDS];
+    double a[MAX_COLS][MAX_COLS + 1], x[MAX_COLS];
+    double ub[MAX_COLS], act, val;
+    int sel[MAX_COLS];
+    int num, row, col, i, found = 0, feasible;
+
+    bzero(ca, sizeof(ca));
+    num = 0;
+    for (row = 0; row < p->rows; ++row){
+        for (col = 0; col < p->cols; ++col)
+            ca[num][col] = p->coef[row][col];
+        cb[num++] = p->rhs[row];
+    }
+    for (col = 0; col < p->cols; ++col){
+        ub[col] = (p->bounded[col] ? p->ub[col] : big_ub);
+        ca[num][col] = 1.;
+        cb[num++] = p->lb[col];
+        ca[num][col] = 1.;
+        cb[num++] = ub[col];
+    }
+
+    for (i = 0; i < p->cols; ++i)
+        sel[i] = i;
+    while (1){
+        for (i = 0; i < p->cols; ++i){
+            for (col = 0; col < p->cols; ++col)
+                a[i][col] = ca[sel[i]][col];
+            a[i][p->cols] = cb[sel[i]];
+        }
+
+        if (solveSquare(p->cols, a, x)){
+            feasible = 1;
+            for (col = 0; col < p->cols && feasible; ++col){
+                if (x[col] < p->lb[col] - EPS
+                        || x[col] > ub[col] + EPS * (1. + ub[col]))
+                    feasible = 0;
+            }
+            for (row = 0; row < p->rows && feasible; ++row){
+                act = 0.;
+                for (col = 0; col < p->cols; ++col)
+                    act += p->coef[row][col] * x[col];
+                val = EPS * (1. + fabs(p->rhs[row]));
+                if ((p->sense[row] == 'L' && act > p->rhs[row] + val)
+                        || (p->sense[row] == 'G' && act < p->rhs[row] - val)
+                        || (p->sense[row] == 'E'
+                                && fabs(act - p->rhs[row]) > val))
+                    feasible = 0;
+            }
+
+            if (feasible){
+                val = 0.;
+                for (col = 0; col < p->cols; ++col)
+                    val += p->obj[col] * x[col];
+                if (!found || (p->maximize && val > *z)
+                        || (!p->maximize && val < *z)){
+                    *z = val;
+                    found = 1;
+                }
+            }
+        }
+
+        // Next combination in the lexicographic order
+        for (i = p->cols - 1; i >= 0 && sel[i] == num - p->cols + i; --i);
+        if (i < 0)
+            break;
+        ++sel[i];
+        for (++i; i < p->cols; ++i)
+            sel[i] = sel[i - 1] + 1;
+    }
+
+    return found;
+}
+
+/** Enumerates all vertices of a continuous problem. Missing upper bounds
+ *  are replaced by a big constant; the problem is unbounded if doubling
+ *  the constant changes the optimum. */
+static int solveVertices(const prob_t *p, double *z)
+{
+    double z2;
+
+    if (!solveVerticesBox(p, VERTEX_BIG_UB, z))
+        return PLAN_LP_INFEASIBLE;
+    if (isBounded(p))
+        return PLAN_LP_OPTIMAL;
+    solveVerticesBox(p, 2. * VERTEX_BIG_UB, &z2);
+    if (fabs(*z - z2) > EPS * (1. + fabs(*z)))
+        return PLAN_LP_UNBOUNDED;
+    return PLAN_LP_OPTIMAL;
+}
+
+static int sameObjVal(double z1, double z2)
+{
+    return fabs(z1 - z2) <= EPS * (1. + fabs(z1));
+}
+
+static void printProb(const prob_t *p, int ilp, const char *solver,
+                      int st1, double z1, int st2, double z2)
+{
+    int row, col;
+
+    fprintf(stderr, "Mismatch (%s, %s): %d %f vs. %d %f\n",
+            (ilp ? "ILP" : "LP"), solver, st1, z1, st2, z2);
+    fprintf(stderr, "%s:", (p->maximize ? "max" : "min"));
+    for (col = 0; col < p->cols; ++col)
+        fprintf(stderr, " %+g x%d", p->obj[col], col);
+    fprintf(stderr, "\n");
+    for (row = 0; row < p->rows; ++row){
+        for (col = 0; col < p->cols; ++col)
+            fprintf(stderr, " %+g x%d", p->coef[row][col], col);
+        fprintf(stderr, " %c %g\n", p->sense[row], p->rhs[row]);
+    }
+    for (col = 0; col < p->cols; ++col){
+        fprintf(stderr, " %g <= x%d", p->lb[col], col);
+        if (p->bounded[col])
+            fprintf(stderr, " <= %g", p->ub[col]);
+        fprintf(stderr, "\n");
+    }
+}
+
+/** Solves the problem with the built-in simplex and compares the result
+ *  with the enumeration of vertices (LP) or integer points (bounded ILP)
+ *  and, if configured, with the LP backend. Returns the status of the
+ *  built-in simplex. */
+static int check(const prob_t *p, int ilp)
+{
+    double z, zcmp;
+    int status, cmp;
+
+    status = solveSimplex(p, ilp, &z);
+    assertNotEquals(status, PLAN_LP_FAILED);
+
+#ifdef PLAN_LP
+    cmp = solveBackend(p, ilp, &zcmp);
+    if (cmp != PLAN_LP_FAILED){
+        if (cmp != status
+                || (status == PLAN_LP_OPTIMAL && !sameObjVal(z, zcmp)))
+            printProb(p, ilp, "backend", status, z, cmp, zcmp);
+        assertEquals(status, cmp);
+        if (status == PLAN_LP_OPTIMAL)
+            assertTrue(sameObjVal(z, zcmp));
+    }
+#endif /* PLAN_LP */
+
+    if (!ilp || isBounded(p)){
+        if (ilp){
+            cmp = solveBruteForce(p, &zcmp);
+        }else{
+            cmp = solveVertices(p, &zcmp);
+        }
+        if (cmp != status
+                || (status == PLAN_LP_OPTIMAL && !sameObjVal(z, zcmp)))
+            printProb(p, ilp, "enumeration", status, z, cmp, zcmp);
+        assertEquals(status, cmp);
+        if (status == PLAN_LP_OPTIMAL)
+            assertTrue(sameObjVal(z, zcmp));
+    }
+
+    return status;
+}
+
+TEST(testLPSimplexRandom)
+{
+    prob_t p;
+    int i, st, cnt[4] = { 0, 0, 0, 0 };
+
+    srand(1234);
+    for (i = 0; i < 500; ++i){
+        probRand(&p, 0);
+        st = check(&p, 0);
+        ++cnt[st];
+    }
+
+    // All outcomes must be covered by the random problems
+    assertTrue(cnt[PLAN_LP_OPTIMAL] > 0);
+    assertTrue(cnt[PLAN_LP_INFEASIBLE] > 0);
+    assertTrue(cnt[PLAN_LP_UNBOUNDED] > 0);
+}
+
+TEST(testLPSimplexDegenerate)
+{
+    prob_t p;
+    int i, col;
+    double z;
+
+    // Beale's example on which the simplex with the textbook pivoting
+    // rule cycles
+    probInit(&p, 3, 4, 0);
+    p.obj[0] = -0.75;
+    p.obj[1] = 20.;
+    p.obj[2] = -0.5;
+    p.obj[3] = 6.;
+    p.coef[0][0] = 0.25;
+    p.coef[0][1] = -8.;
+    p.coef[0][2] = -1.;
+    p.coef[0][3] = 9.;
+    p.sense[0] = 'L';
+    p.coef[1][0] = 0.5;
+    p.coef[1][1] = -12.;
+    p.coef[1][2] = -0.5;
+    p.coef[1][3] = 3.;
+    p.sense[1] = 'L';
+    p.coef[2][2] = 1.;
+    p.rhs[2] = 1.;
+    p.sense[2] = 'L';
+    assertEquals(check(&p, 0), PLAN_LP_OPTIMAL);
+    assertEquals(solveSimplex(&p, 0, &z), PLAN_LP_OPTIMAL);
+    assertTrue(sameObjVal(z, -1.25));
+
+    // Many times duplicated constraint x0 + x1 <= 1 with all variables
+    // fixed to zero but two
+    probInit(&p, MAX_ROWS, MAX_COLS, 1);
+    for (col = 0; col < p.cols; ++col){
+        p.obj[col] = 1.;
+        if (col >= 2)
+            probSetUB(&p, col, 0.);
+    }
+    for (i = 0; i < p.rows; ++i){
+        p.coef[i][0] = p.coef[i][1] = i + 1;
+        p.rhs[i] = i + 1;
+        p.sense[i] = (i % 3 == 2 ? 'E' : 'L');
+    }
+    assertEquals(check(&p, 0), PLAN_LP_OPTIMAL);
+    assertEquals(solveSimplex(&p, 0, &z), PLAN_LP_OPTIMAL);
+    assertTrue(sameObjVal(z, 1.));
+
+    srand(4321);
+    for (i = 0; i < 300; ++i){
+        probRandDegenerate(&p);
+        check(&p, 0);
+    }
+}
+
+TEST(testLPSimplexILP)
+{
+    prob_t p;
+    int i, st, cnt[4] = { 0, 0, 0, 0 };
+
+    srand(2468);
+    for (i = 0; i < 300; ++i){
+        probRand(&p, 1);
+        st = check(&p, 1);
+        ++cnt[st];
+    }
+    assertTrue(cnt[PLAN_LP_OPTIMAL] > 0);
+    assertTrue(cnt[PLAN_LP_INFEASIBLE] > 0);
+}
+
+TEST(testLPSimplexInfeasible)
+{
+    prob_t p;
+    double z;
+
+    // x0 + x1 <= 1, x0 + x1 >= 3
+    probInit(&p, 2, 2, 0);
+    p.obj[0] = p.obj[1] = 1.;
+    p.coef[0][0] = p.coef[0][1] = 1.;
+    p.rhs[0] = 1.;
+    p.sense[0] = 'L';
+    p.coef[1][0] = p.coef[1][1] = 1.;
+    p.rhs[1] = 3.;
+    p.sense[1] = 'G';
+    assertEquals(check(&p, 0), PLAN_LP_INFEASIBLE);
+
+    // 2 x0 = 1 has a fractional solution only
+    probInit(&p, 1, 1, 0);
+    p.obj[0] = 1.;
+    p.coef[0][0] = 2.;
+    p.rhs[0] = 1.;
+    p.sense[0] = 'E';
+    probSetUB(&p, 0, 3.);
+    p.is_int[0] = 1;
+    assertEquals(check(&p, 0), PLAN_LP_OPTIMAL);
+    assertEquals(solveSimplex(&p, 0, &z), PLAN_LP_OPTIMAL);
+    assertTrue(sameObjVal(z, 0.5));
+    assertEquals(check(&p, 1), PLAN_LP_INFEASIBLE);
+}
+
+TEST(testLPSimplexUnbounded)
+{
+    prob_t p;
+
+    // max x0 + x1 s.t. x0 - x1 <= 1
+    probInit(&p, 1, 2, 1);
+    p.obj[0] = p.obj[1] = 1.;
+    p.coef[0][0] = 1.;
+    p.coef[0][1] = -1.;
+    p.rhs[0] = 1.;
+    p.sense[0] = 'L';
+    assertEquals(check(&p, 0), PLAN_LP_UNBOUNDED);
+
+    // The same with integer variables
+    p.is_int[0] = p.is_int[1] = 1;
+    assertEquals(check(&p, 1), PLAN_LP_UNBOUNDED);
+
+    // The minimization is bounded by the lower bounds
+    p.maximize = 0;
+    assertEquals(check(&p, 0), PLAN_LP_OPTIMAL);
+    assertEquals(check(&p, 1), PLAN_LP_OPTIMAL);
+}
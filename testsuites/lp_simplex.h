@@ -0,0 +1,17 @@
+#ifndef TEST_LP_SIMPLEX
+
+TEST(testLPSimplexRandom);
+TEST(testLPSimplexDegenerate);
+TEST(testLPSimplexILP);
+TEST(testLPSimplexInfeasible);
+TEST(testLPSimplexUnbounded);
+
+TEST_SUITE(TSLPSimplex) {
+    TEST_ADD(testLPSimplexRandom),
+    TEST_ADD(testLPSimplexDegenerate),
+    TEST_ADD(testLPSimplexILP),
+    TEST_ADD(testLPSimplexInfeasible),
+    TEST_ADD(testLPSimplexUnbounded),
+    TEST_SUITE_CLOSURE
+};
+#endif
@@ -1,5 +1,6 @@
 #include <cu/cu.h>
 #include <plan/ma_private_state.h>
+#include <plan/intern_table.h>
 
 TEST(testMAPrivateState)
 {
@@ -45,3 +46,44 @@ TEST(testMAPrivateState)
 
     planMAPrivateStateFree(&aps);
 }
+
+TEST(testInternTable)
+{
+    plan_intern_table_t t;
+    int el[3];
+    const int *stored;
+    int i;
+
+    planInternTableInit(&t, sizeof(int) * 3);
+    assertEquals(planInternTableFind(&t, el), -1);
+
+    // Enough elements to force several resizes
+    for (i = 0; i < 1000; ++i){
+        el[0] = i;
+        el[1] = i % 7;
+        el[2] = -i;
+        assertEquals(planInternTableInsert(&t, el), i);
+    }
+    assertEquals(planInternTableSize(&t), 1000);
+
+    for (i = 999; i >= 0; --i){
+        el[0] = i;
+        el[1] = i % 7;
+        el[2] = -i;
+        assertEquals(planInternTableInsert(&t, el), i);
+        assertEquals(planInternTableFind(&t, el), i);
+
+        stored = planInternTableGet(&t, i);
+        assertEquals(stored[0], i);
+        assertEquals(stored[1], i % 7);
+        assertEquals(stored[2], -i);
+    }
+    assertEquals(planInternTableSize(&t), 1000);
+
+    el[0] = 1000;
+    assertEquals(planInternTableFind(&t, el), -1);
+    assertTrue(planInternTableGet(&t, 1000) == NULL);
+    assertTrue(planInternTableMemUsage(&t) >= 1000 * 4 * sizeof(int));
+
+    planInternTableFree(&t);
+}
@@ -2,10 +2,12 @@
 #define TEST_MA_PRIVATE_STATE_H
 
 TEST(testMAPrivateState);
+TEST(testInternTable);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSMAPrivateState) {
     TEST_ADD(testMAPrivateState),
+    TEST_ADD(testInternTable),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
@@ -1,8 +1,10 @@
+#include <unistd.h>
 #include <cu/cu.h>
 #include <boruvka/tasks.h>
 #include <plan/ma_search.h>
 
 struct _th_t {
+    plan_ma_search_params_t params;
     plan_search_t *search;
     plan_ma_comm_t *comm;
     plan_path_t path;
@@ -10,13 +12,21 @@ struct _th_t {
 };
 typedef struct _th_t th_t;
 
-static void maLMCutTask(int id, void *data, const bor_tasks_thinfo_t *_)
+typedef plan_heur_t *(*heur_new_fn)(const plan_problem_t *prob);
+
+static plan_heur_t *lmCutProjNew(const plan_problem_t *prob)
+{
+    return planHeurLMCutNew(prob->var, prob->var_size, prob->goal,
+                            prob->proj_op, prob->proj_op_size, 0);
+}
+
+static void maTask(int id, void *data, const bor_tasks_thinfo_t *_)
 {
     th_t *th = data;
     plan_ma_search_params_t params;
     plan_ma_search_t *ma_search;
 
-    planMASearchParamsInit(&params);
+    params = th->params;
     params.comm = th->comm;
     params.search = th->search;
     params.verify_solution = 1;
@@ -26,45 +36,48 @@ static void maLMCutTask(int id, void *data, const bor_tasks_thinfo_t *_)
     planMASearchDel(ma_search);
 }
 
-static void runMALMCut(int agent_size, plan_problem_t **prob,
-                       int optimal_cost)
+/** Runs A* in all agents and checks that all of them ended with the
+ *  expected result. Returns cost of the found plan or -1. */
+static int runMA(int agent_size, plan_problem_t **prob, heur_new_fn heur_new,
+                 const plan_ma_search_params_t *ma_params, int exp_res)
 {
     plan_search_astar_params_t params;
     plan_search_t *search;
-    plan_heur_t *heur;
     bor_tasks_t *tasks;
     th_t th[agent_size];
-    int i;
-    int found = 0;
-
+    int i, cost = -1;
 
     tasks = borTasksNew(agent_size);
     for (i = 0; i < agent_size; ++i){
-        heur = planHeurLMCutNew(prob[i]->var, prob[i]->var_size,
-                                prob[i]->goal,
-                                prob[i]->proj_op, prob[i]->proj_op_size, 0);
-
         planSearchAStarParamsInit(&params);
-        params.search.heur = heur;
+        params.search.heur = heur_new(prob[i]);
         params.search.heur_del = 1;
         params.search.prob = prob[i];
         search = planSearchAStarNew(&params);
 
+        planMASearchParamsInit(&th[i].params);
+        if (ma_params != NULL)
+            th[i].params = *ma_params;
+        th[i].params.prob = prob[i];
         th[i].search = search;
         th[i].comm = planMACommInprocNew(i, agent_size);
         planPathInit(&th[i].path);
-        borTasksAdd(tasks, maLMCutTask, i, th + i);
+        borTasksAdd(tasks, maTask, i, th + i);
     }
 
     borTasksRun(tasks);
     borTasksDel(tasks);
 
     for (i = 0; i < agent_size; ++i){
+        if (exp_res == PLAN_SEARCH_NOT_FOUND)
+            assertEquals(th[i].res, PLAN_SEARCH_NOT_FOUND);
+
         if (th[i].res == PLAN_SEARCH_FOUND){
-            assertEquals(planPathCost(&th[i].path), optimal_cost);
+            if (cost >= 0)
+                assertEquals(planPathCost(&th[i].path), cost);
+            cost = planPathCost(&th[i].path);
             //fprintf(stdout, "cost: %d\n", planPathCost(&th[i].path));
             //planPathPrint(&th[i].path, stdout);
-            found = 1;
         }
 
         planSearchDel(th[i].search);
@@ -72,7 +85,18 @@ static void runMALMCut(int agent_size, plan_problem_t **prob,
         planMACommDel(th[i].comm);
     }
 
-    assertTrue(found);
+    if (exp_res == PLAN_SEARCH_FOUND)
+        assertTrue(cost >= 0);
+    return cost;
+}
+
+static void runMALMCut(int agent_size, plan_problem_t **prob,
+                       int optimal_cost)
+{
+    int cost;
+
+    cost = runMA(agent_size, prob, lmCutProjNew, NULL, PLAN_SEARCH_FOUND);
+    assertEquals(cost, optimal_cost);
 }
 
 static void maSearch(const char *proto, int optimal_cost)
@@ -131,3 +155,106 @@ TEST(testMASearchFactored)
                      "proto/depot-pfile1-truck0.proto",
                      "proto/depot-pfile1-truck1.proto");
 }
+
+
+/** Runs the search with and without pipelining of the heuristic and
+ *  checks that the found plans have the same cost */
+static void maSearchPipeline(const char *proto, heur_new_fn heur_new)
+{
+    plan_problem_agents_t *p;
+    plan_problem_t **prob;
+    plan_ma_search_params_t params;
+    int i, cost, cost_pipeline;
+
+    p = planProblemAgentsFromProto(proto, PLAN_PROBLEM_USE_CG);
+    prob = alloca(sizeof(plan_problem_t *) * p->agent_size);
+    for (i = 0; i < p->agent_size; ++i)
+        prob[i] = p->agent + i;
+    cost = runMA(p->agent_size, prob, heur_new, NULL, PLAN_SEARCH_FOUND);
+    planProblemAgentsDel(p);
+
+    p = planProblemAgentsFromProto(proto, PLAN_PROBLEM_USE_CG);
+    for (i = 0; i < p->agent_size; ++i)
+        prob[i] = p->agent + i;
+    planMASearchParamsInit(&params);
+    params.heur_pipeline = 8;
+    cost_pipeline = runMA(p->agent_size, prob, heur_new, &params,
+                          PLAN_SEARCH_FOUND);
+    planProblemAgentsDel(p);
+
+    assertEquals(cost, cost_pipeline);
+}
+
+TEST(testMASearchPipeline)
+{
+    maSearchPipeline("proto/depot-pfile1.proto", planHeurMARelaxFFNew);
+    maSearchPipeline("proto/driverlog-pfile1.proto", planHeurMARelaxFFNew);
+    maSearchPipeline("proto/depot-pfile1.proto", planHeurMADTGNew);
+    maSearchPipeline("proto/driverlog-pfile1.proto", planHeurMADTGNew);
+}
+
+TEST(testMASearchUnsolvable)
+{
+    plan_problem_agents_t *p;
+    plan_problem_t **prob;
+    int i;
+
+    // The termination detection must finish the search when all agents
+    // are idle; a hang is turned into a failure by the alarm.
+    alarm(60);
+    p = planProblemAgentsFromProto("proto/key-unsolvable-ma.proto",
+                                   PLAN_PROBLEM_USE_CG);
+    prob = alloca(sizeof(plan_problem_t *) * p->agent_size);
+    for (i = 0; i < p->agent_size; ++i)
+        prob[i] = p->agent + i;
+    assertEquals(runMA(p->agent_size, prob, lmCutProjNew, NULL,
+                       PLAN_SEARCH_NOT_FOUND), -1);
+    planProblemAgentsDel(p);
+    alarm(0);
+}
+
+/** Runs the search writing checkpoints as often as possible, then resumes
+ *  fresh agents from the last committed checkpoint */
+static void maSearchCheckpoint(const char *proto, int optimal_cost)
+{
+    const char *prefix = "regressions/tmp.ma-checkpoint";
+    plan_problem_agents_t *p;
+    plan_problem_t **prob;
+    plan_ma_search_params_t params;
+    FILE *fin;
+    int i;
+
+    remove("regressions/tmp.ma-checkpoint.manifest");
+
+    p = planProblemAgentsFromProto(proto, PLAN_PROBLEM_USE_CG);
+    prob = alloca(sizeof(plan_problem_t *) * p->agent_size);
+    for (i = 0; i < p->agent_size; ++i)
+        prob[i] = p->agent + i;
+    planMASearchParamsInit(&params);
+    params.checkpoint = prefix;
+    params.checkpoint_interval = 1E-6;
+    assertEquals(runMA(p->agent_size, prob, lmCutProjNew, &params,
+                       PLAN_SEARCH_FOUND), optimal_cost);
+    planProblemAgentsDel(p);
+
+    fin = fopen("regressions/tmp.ma-checkpoint.manifest", "rb");
+    assertNotEquals(fin, NULL);
+    if (fin == NULL)
+        return;
+    fclose(fin);
+
+    p = planProblemAgentsFromProto(proto, PLAN_PROBLEM_USE_CG);
+    for (i = 0; i < p->agent_size; ++i)
+        prob[i] = p->agent + i;
+    planMASearchParamsInit(&params);
+    params.restore = prefix;
+    assertEquals(runMA(p->agent_size, prob, lmCutProjNew, &params,
+                       PLAN_SEARCH_FOUND), optimal_cost);
+    planProblemAgentsDel(p);
+}
+
+TEST(testMASearchCheckpoint)
+{
+    maSearchCheckpoint("proto/depot-pfile1.proto", 10);
+    maSearchCheckpoint("proto/driverlog-pfile1.proto", 7);
+}
@@ -3,11 +3,17 @@
 
 TEST(testMASearch);
 TEST(testMASearchFactored);
+TEST(testMASearchPipeline);
+TEST(testMASearchUnsolvable);
+TEST(testMASearchCheckpoint);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSMASearch) {
     TEST_ADD(testMASearch),
     TEST_ADD(testMASearchFactored),
+    TEST_ADD(testMASearchPipeline),
+    TEST_ADD(testMASearchUnsolvable),
+    TEST_ADD(testMASearchCheckpoint),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
@@ -5,7 +5,7 @@
 #include "succ_gen.h"
 #include "state_space.h"
 //#include "search_ehc.h"
-//#include "search_lazy.h"
+#include "search_lazy.h"
 #include "search_astar.h"
 #include "heur.h"
 #include "heur_ma.h"
@@ -20,6 +20,7 @@
 #include "ma_private_state.h"
 #include "landmark.h"
 #include "msg_schema.h"
+#include "lp_simplex.h"
 
 TEST(protobufTearDown)
 {
@@ -33,6 +34,7 @@ TEST_SUITES {
     TEST_SUITE_ADD(TSStateSpace),
     //TEST_SUITE_ADD(TSSearchEHC),
     //TEST_SUITE_ADD(TSSearchLazy),
+    TEST_SUITE_ADD(TSSearchLazyIncAppOps),
     TEST_SUITE_ADD(TSSearchAStar),
     TEST_SUITE_ADD_HEUR,
     TEST_SUITE_ADD(TSHeurMA),
@@ -47,6 +49,7 @@ TEST_SUITES {
     TEST_SUITE_ADD(TSMAPrivateState),
     TEST_SUITE_ADD(TSLandmark),
     TEST_SUITE_ADD(TSMsgSchema),
+    TEST_SUITE_ADD(TSLPSimplex),
     TEST_SUITES_CLOSURE
 };
 
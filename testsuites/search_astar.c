@@ -47,3 +47,135 @@ TEST(testSearchAStar)
     planSearchDel(search);
     planProblemDel(p);
 }
+
+/** Applies the path from the initial state and checks it reaches a goal */
+static void checkPath(plan_problem_t *p, plan_path_t *path)
+{
+    plan_path_op_t *pop;
+    plan_op_t *op;
+    plan_state_id_t state_id;
+    int i;
+
+    state_id = p->initial_state;
+    BOR_LIST_FOR_EACH_ENTRY(path, plan_path_op_t, pop, path){
+        op = NULL;
+        for (i = 0; i < p->op_size; ++i){
+            if (p->op[i].global_id == pop->global_id)
+                op = p->op + i;
+        }
+        assertNotEquals(op, NULL);
+        if (op == NULL)
+            return;
+
+        assertTrue(planStatePoolPartStateIsSubset(p->state_pool, op->pre,
+                                                  state_id));
+        state_id = planOpApply(op, p->state_pool, state_id);
+    }
+    assertTrue(planProblemCheckGoal(p, state_id));
+}
+
+#define RUN_STUBBORN   0x1 /*!< Use stubborn sets */
+#define RUN_SYMMETRY   0x2 /*!< Use symmetry pruning */
+#define RUN_LM_CUT_INC 0x4 /*!< Use incremental LM-Cut */
+
+/** Runs A* with LM-Cut on the problem and checks the result, the path
+ *  must be a valid plan of the expected cost. The search and the problem
+ *  are returned for further checks and must be deleted by the caller. */
+static plan_search_t *runLMCut(const char *proto, int load_flags,
+                               int run_flags, int exp_res,
+                               plan_cost_t exp_cost, plan_problem_t **p_out)
+{
+    plan_search_astar_params_t params;
+    plan_search_t *search;
+    plan_path_t path;
+    plan_problem_t *p;
+    int res;
+
+    planSearchAStarParamsInit(&params);
+    p = planProblemFromProto(proto, load_flags);
+    params.search.prob = p;
+    if (run_flags & RUN_LM_CUT_INC){
+        params.search.heur = planHeurLMCutIncLocalNew(p->var, p->var_size,
+                                                      p->goal, p->op,
+                                                      p->op_size, 0);
+    }else{
+        params.search.heur = planHeurLMCutNew(p->var, p->var_size, p->goal,
+                                              p->op, p->op_size, 0);
+    }
+    params.search.heur_del = 1;
+    params.search.stubborn_sets = ((run_flags & RUN_STUBBORN) != 0);
+    params.symmetry = ((run_flags & RUN_SYMMETRY) != 0);
+    search = planSearchAStarNew(&params);
+
+    planPathInit(&path);
+    res = planSearchRun(search, &path);
+    assertEquals(res, exp_res);
+    if (res == PLAN_SEARCH_FOUND){
+        assertEquals(planPathCost(&path), exp_cost);
+        checkPath(p, &path);
+    }
+    planPathFree(&path);
+
+    *p_out = p;
+    return search;
+}
+
+TEST(testSearchAStarStubborn)
+{
+    plan_search_t *search;
+    plan_problem_t *p;
+
+    // Stubborn sets must preserve optimality
+    search = runLMCut("proto/driverlog-pfile3.proto", PLAN_PROBLEM_USE_CG,
+                      RUN_STUBBORN, PLAN_SEARCH_FOUND, 12, &p);
+    assertNotEquals(search->stubborn, NULL);
+    assertTrue(search->stubborn->ops_after < search->stubborn->ops_before);
+    planSearchDel(search);
+    planProblemDel(p);
+}
+
+TEST(testSearchAStarSymmetry)
+{
+    plan_search_t *search;
+    plan_problem_t *p;
+
+    // Symmetry pruning must preserve optimality
+    search = runLMCut("proto/driverlog-pfile3.proto", PLAN_PROBLEM_USE_CG,
+                      RUN_SYMMETRY, PLAN_SEARCH_FOUND, 12, &p);
+    // package1 and package2 are interchangeable
+    assertTrue(search->stat.symmetry_generators > 0);
+    assertTrue(search->stat.symmetry_pruned > 0);
+    planSearchDel(search);
+    planProblemDel(p);
+
+    // Incremental heuristics must be evaluated on the canonical states
+    search = runLMCut("proto/driverlog-pfile3.proto", PLAN_PROBLEM_USE_CG,
+                      RUN_SYMMETRY | RUN_LM_CUT_INC, PLAN_SEARCH_FOUND, 12,
+                      &p);
+    planSearchDel(search);
+    planProblemDel(p);
+}
+
+TEST(testSearchAStarH2)
+{
+    plan_search_t *search;
+    plan_problem_t *p;
+
+    // Pruning of the problem by h^2 must preserve optimality
+    search = runLMCut("proto/depot-pfile2.proto",
+                      PLAN_PROBLEM_USE_CG | PLAN_PROBLEM_PRUNE_H2,
+                      0, PLAN_SEARCH_FOUND, 15, &p);
+    assertTrue(p->h2_ops_removed > 0 || p->h2_facts_removed > 0);
+    planSearchDel(search);
+    planProblemDel(p);
+
+    // The goal is mutex with itself under h^2 although it is reachable in
+    // the relaxed problem, so all operators are removed
+    search = runLMCut("proto/key-unsolvable.proto",
+                      PLAN_PROBLEM_USE_CG | PLAN_PROBLEM_PRUNE_H2,
+                      0, PLAN_SEARCH_NOT_FOUND, 0, &p);
+    assertEquals(p->h2_ops_removed, 2);
+    assertEquals(p->op_size, 0);
+    planSearchDel(search);
+    planProblemDel(p);
+}
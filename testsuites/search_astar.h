@@ -2,10 +2,16 @@
 #define TEST_SEARCH_ASTAR_H
 
 TEST(testSearchAStar);
+TEST(testSearchAStarStubborn);
+TEST(testSearchAStarSymmetry);
+TEST(testSearchAStarH2);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSSearchAStar) {
     TEST_ADD(testSearchAStar),
+    TEST_ADD(testSearchAStarStubborn),
+    TEST_ADD(testSearchAStarSymmetry),
+    TEST_ADD(testSearchAStarH2),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
@@ -1,4 +1,5 @@
 #include <cu/cu.h>
+#include <boruvka/alloc.h>
 #include "plan/search.h"
 
 #define DEF_JSON "../data/ma-benchmarks/depot/pfile1.sas"
@@ -28,3 +29,177 @@ TEST(testSearchLazy)
     planSearchDel(lazy);
     planProblemDel(params.search.prob);
 }
+
+static int opCmp(const void *a, const void *b)
+{
+    const plan_op_t *o1 = *(const plan_op_t **)a;
+    const plan_op_t *o2 = *(const plan_op_t **)b;
+    return (o1 < o2 ? -1 : (o1 > o2 ? 1 : 0));
+}
+
+static void checkIncAppOps(const char *proto)
+{
+    plan_problem_t *p;
+    plan_search_applicable_ops_t app;
+    plan_search_applicable_ops_inc_t inc;
+    plan_state_t *state;
+    plan_state_id_t state_id, parent_id;
+    plan_op_t **op, *parent_op;
+    int i, step, found;
+
+    p = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    planSearchApplicableOpsInit(&app, p->op_size);
+    planSearchApplicableOpsIncInit(&inc, p);
+    state = planStateNew(p->var_size);
+    op = BOR_ALLOC_ARR(plan_op_t *, p->op_size);
+
+    srand(1000);
+    state_id = p->initial_state;
+    planStatePoolGetState(p->state_pool, state_id, state);
+    found = planSuccGenFind(p->succ_gen, state, app.op, app.op_size);
+    app.op_found = found;
+    app.state = state_id;
+
+    for (step = 0; step < 1000 && app.op_found > 0; ++step){
+        // Random walk, sometimes going back to a sibling
+        parent_id = state_id;
+        if (step % 3 == 2 && inc.base_state != PLAN_NO_STATE)
+            parent_id = inc.base_state;
+        if (parent_id != app.state){
+            planStatePoolGetState(p->state_pool, parent_id, state);
+            found = planSuccGenFind(p->succ_gen, state, op, p->op_size);
+        }else{
+            found = app.op_found;
+            memcpy(op, app.op, sizeof(plan_op_t *) * found);
+        }
+        if (found == 0)
+            break;
+
+        parent_op = op[rand() % found];
+        state_id = planOpApply(parent_op, p->state_pool, parent_id);
+        planStatePoolGetState(p->state_pool, state_id, state);
+        planSearchApplicableOpsFindInc(&app, &inc, state, state_id,
+                                       parent_id, parent_op,
+                                       p->state_pool, p->succ_gen);
+
+        found = planSuccGenFind(p->succ_gen, state, op, p->op_size);
+        assertEquals(found, app.op_found);
+        if (found != app.op_found)
+            break;
+        qsort(op, found, sizeof(plan_op_t *), opCmp);
+        qsort(app.op, found, sizeof(plan_op_t *), opCmp);
+        for (i = 0; i < found; ++i)
+            assertEquals(op[i], app.op[i]);
+    }
+
+    BOR_FREE(op);
+    planStateDel(state);
+    planSearchApplicableOpsIncFree(&inc);
+    planSearchApplicableOpsFree(&app);
+    planProblemDel(p);
+}
+
+/** Heuristic that checks applicable operators the search derived
+ *  incrementally for the evaluated state against the ones found from
+ *  scratch, the value is computed by the goal-count heuristic */
+struct _check_heur_t {
+    plan_heur_t heur;
+    plan_heur_t *goalcount;
+    plan_op_t **op;
+    plan_op_t **inc_op;
+    int op_size;
+    long checked; /*!< Number of checked states */
+};
+typedef struct _check_heur_t check_heur_t;
+
+static void checkHeurDel(plan_heur_t *_heur)
+{
+    check_heur_t *h = bor_container_of(_heur, check_heur_t, heur);
+
+    planHeurDel(h->goalcount);
+    BOR_FREE(h->op);
+    BOR_FREE(h->inc_op);
+    _planHeurFree(&h->heur);
+    BOR_FREE(h);
+}
+
+static void checkHeurNode(plan_heur_t *_heur, plan_state_id_t state_id,
+                          plan_search_t *search, plan_heur_res_t *res)
+{
+    check_heur_t *h = bor_container_of(_heur, check_heur_t, heur);
+    const plan_search_applicable_ops_t *app = &search->app_ops;
+    const plan_state_t *state;
+    int i, found;
+
+    state = planSearchLoadState(search, state_id);
+    found = planSuccGenFind(search->succ_gen, state, h->op, h->op_size);
+    assertEquals(app->state, state_id);
+    assertEquals(found, app->op_found);
+    if (found == app->op_found){
+        // The search's array is sorted in a copy to keep its order
+        memcpy(h->inc_op, app->op, sizeof(plan_op_t *) * found);
+        qsort(h->op, found, sizeof(plan_op_t *), opCmp);
+        qsort(h->inc_op, found, sizeof(plan_op_t *), opCmp);
+        for (i = 0; i < found; ++i)
+            assertEquals(h->op[i], h->inc_op[i]);
+    }
+    ++h->checked;
+
+    planHeurState(h->goalcount, state, res);
+}
+
+static check_heur_t *checkHeurNew(const plan_problem_t *p)
+{
+    check_heur_t *h;
+
+    h = BOR_ALLOC(check_heur_t);
+    _planHeurInit(&h->heur, checkHeurDel, NULL, checkHeurNode);
+    h->goalcount = planHeurGoalCountNew(p->goal);
+    h->op_size = p->op_size;
+    h->op = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(p->op_size, 1));
+    h->inc_op = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(p->op_size, 1));
+    h->checked = 0;
+    return h;
+}
+
+/** Runs lazy search with incremental applicable operators and checks them
+ *  in every expanded state */
+static void checkIncAppOpsSearch(const char *proto)
+{
+    plan_search_lazy_params_t params;
+    plan_search_t *lazy;
+    plan_path_t path;
+    check_heur_t *heur;
+
+    planSearchLazyParamsInit(&params);
+    params.search.prob = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    heur = checkHeurNew(params.search.prob);
+    params.search.heur = &heur->heur;
+    params.list = planListLazyHeapNew();
+    params.inc_app_ops = 1;
+    lazy = planSearchLazyNew(&params);
+
+    planPathInit(&path);
+    assertEquals(planSearchRun(lazy, &path), PLAN_SEARCH_FOUND);
+    assertTrue(heur->checked > 0);
+
+    planPathFree(&path);
+    planSearchDel(lazy);
+    planListLazyDel(params.list);
+    planHeurDel(&heur->heur);
+    planProblemDel(params.search.prob);
+}
+
+TEST(testSearchLazyIncAppOpsSearch)
+{
+    checkIncAppOpsSearch("proto/depot-pfile1.proto");
+    checkIncAppOpsSearch("proto/rovers-p03.proto");
+    checkIncAppOpsSearch("proto/CityCar-p3-2-2-0-1.proto");
+}
+
+TEST(testSearchLazyIncAppOps)
+{
+    checkIncAppOps("proto/depot-pfile1.proto");
+    checkIncAppOps("proto/rovers-p03.proto");
+    checkIncAppOps("proto/CityCar-p3-2-2-0-1.proto");
+}
@@ -2,10 +2,20 @@
 #define TEST_SEARCH_LAZY_H
 
 TEST(testSearchLazy);
+TEST(testSearchLazyIncAppOps);
+TEST(testSearchLazyIncAppOpsSearch);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSSearchLazy) {
     TEST_ADD(testSearchLazy),
+    TEST_SUITE_CLOSURE
+};
+
+/** Tests of incremental applicable operators use only proto problems, so
+ *  they do not depend on data needed by TSSearchLazy */
+TEST_SUITE(TSSearchLazyIncAppOps) {
+    TEST_ADD(testSearchLazyIncAppOps),
+    TEST_ADD(testSearchLazyIncAppOpsSearch),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };
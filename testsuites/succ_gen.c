@@ -1,3 +1,5 @@
+#include <stdio.h>
+#include <string.h>
 #include <cu/cu.h>
 #include <boruvka/alloc.h>
 #include "plan/problem.h"
@@ -89,6 +91,196 @@ static void test(const char *proto, const char *states)
     statePoolFree(&state_pool);
 }
 
+/** Returns true if the operator has a precondition on some of the
+ *  variables var, var + 1, ... */
+static int hasPreFrom(const plan_op_t *op, int var)
+{
+    int i;
+
+    for (i = 0; i < op->pre->vals_size; ++i){
+        if (op->pre->vals[i].var >= var)
+            return 1;
+    }
+    return 0;
+}
+
+/** Writes decision tree over the operators in the format of Fast
+ *  Downward, the variables are switched in the order 0, 1, ... */
+static void writeFDTree(FILE *fout, const plan_problem_t *prob,
+                        plan_op_t **op, int op_size, int var)
+{
+    plan_op_t **sub;
+    int i, val, imm, sub_size;
+
+    for (imm = 0, i = 0; i < op_size; ++i){
+        if (!hasPreFrom(op[i], var))
+            ++imm;
+    }
+
+    if (var == prob->var_size || imm == op_size){
+        fprintf(fout, "check %d\n", op_size);
+        for (i = 0; i < op_size; ++i)
+            fprintf(fout, "%d\n", (int)(op[i] - prob->op));
+        return;
+    }
+
+    fprintf(fout, "switch %d\ncheck %d\n", var, imm);
+    for (i = 0; i < op_size; ++i){
+        if (!hasPreFrom(op[i], var))
+            fprintf(fout, "%d\n", (int)(op[i] - prob->op));
+    }
+
+    sub = BOR_ALLOC_ARR(plan_op_t *, op_size);
+    for (val = 0; val <= prob->var[var].range; ++val){
+        // The last subtree is the default one
+        for (sub_size = 0, i = 0; i < op_size; ++i){
+            if (!hasPreFrom(op[i], var))
+                continue;
+            if (val == prob->var[var].range){
+                if (!planPartStateIsSet(op[i]->pre, var))
+                    sub[sub_size++] = op[i];
+            }else if (planPartStateGet(op[i]->pre, var) == val){
+                sub[sub_size++] = op[i];
+            }
+        }
+        writeFDTree(fout, prob, sub, sub_size, var + 1);
+    }
+    BOR_FREE(sub);
+}
+
+/** Creates successor generator by parsing its FD definition */
+static plan_succ_gen_t *succGenFromFD(const plan_problem_t *prob)
+{
+    plan_succ_gen_t *sg;
+    plan_op_t **op;
+    FILE *fout;
+    char *buf;
+    const char *cur;
+    size_t size;
+    int i;
+
+    op = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(prob->op_size, 1));
+    for (i = 0; i < prob->op_size; ++i)
+        op[i] = prob->op + i;
+
+    fout = open_memstream(&buf, &size);
+    writeFDTree(fout, prob, op, prob->op_size, 0);
+    fprintf(fout, "end_SG\n");
+    fclose(fout);
+    BOR_FREE(op);
+
+    cur = buf;
+    sg = planSuccGenFromFDBuf(&cur, buf + size, prob->var, prob->op);
+    assertEquals(sg->num_operators, prob->op_size);
+
+    // Only the end marker is left unparsed
+    assertEquals(strncmp(cur, "\nend_SG", 7), 0);
+    free(buf);
+    return sg;
+}
+
+/** Checks that the operators found by the given method are the same as
+ *  the ones found by the linear scan */
+static void checkOps(const char *proto, const char *method,
+                     plan_op_t **ref, int ref_size,
+                     plan_op_t **ops, int ops_size)
+{
+    int i;
+
+    qsort(ops, ops_size, sizeof(plan_op_t *), sortOpsCmp);
+    if (ref_size != ops_size){
+        fprintf(stderr, "%s: %s: found %d operators instead of %d\n",
+                proto, method, ops_size, ref_size);
+    }
+    assertEquals(ref_size, ops_size);
+    for (i = 0; i < ref_size && i < ops_size; ++i)
+        assertEquals(ref[i], ops[i]);
+}
+
+/** Packs the successor generator of the problem with the given flags and
+ *  compares planSuccGenFindPacked() with the linear scan */
+static void testEquivPacked(const char *proto, plan_problem_t *prob,
+                            const plan_state_id_t *sid, int sid_size,
+                            unsigned flags, const char *method)
+{
+    plan_op_t **ref, **ops;
+    const void *buf;
+    int i, ref_size, found;
+
+    planSuccGenPack(prob->succ_gen, prob->op, prob->op_size, flags);
+    if (flags & PLAN_SUCC_GEN_TREE)
+        assertEquals(prob->succ_gen->mask_op, NULL);
+    if (flags & PLAN_SUCC_GEN_MASK)
+        assertNotEquals(prob->succ_gen->mask_op, NULL);
+
+    ref = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(prob->op_size, 1));
+    ops = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(prob->op_size, 1));
+    for (i = 0; i < sid_size; ++i){
+        ref_size = findOpsLinear(prob->state_pool, prob->op, prob->op_size,
+                                 sid[i], ref);
+        buf = planStatePoolGetPackedState(prob->state_pool, sid[i]);
+        found = planSuccGenFindPacked(prob->succ_gen,
+                                      prob->state_pool->packer, buf,
+                                      ops, prob->op_size);
+        checkOps(proto, method, ref, ref_size, ops, found);
+    }
+    BOR_FREE(ref);
+    BOR_FREE(ops);
+}
+
+/** Compares all ways of creating the successor generator and of finding
+ *  applicable operators with the linear scan */
+static void testEquiv(const char *proto, const char *states)
+{
+    plan_problem_t *prob;
+    plan_succ_gen_t *sg_fd;
+    plan_op_t **ref, **ops;
+    plan_state_id_t *sid;
+    plan_state_t *state;
+    state_pool_t state_pool;
+    int i, sid_size, ref_size, found;
+
+    prob = planProblemFromProto(proto, PLAN_PROBLEM_USE_CG);
+    sg_fd = succGenFromFD(prob);
+    ref = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(prob->op_size, 1));
+    ops = BOR_ALLOC_ARR(plan_op_t *, BOR_MAX(prob->op_size, 1));
+    state = planStateNew(prob->state_pool->num_vars);
+
+    statePoolInit(&state_pool, states);
+    sid = NULL;
+    for (sid_size = 0; statePoolNext(&state_pool, state) == 0; ++sid_size){
+        sid = BOR_REALLOC_ARR(sid, plan_state_id_t, sid_size + 1);
+        sid[sid_size] = planStatePoolInsert(prob->state_pool, state);
+    }
+    statePoolFree(&state_pool);
+    assertTrue(sid_size > 0);
+
+    for (i = 0; i < sid_size; ++i){
+        ref_size = findOpsLinear(prob->state_pool, prob->op, prob->op_size,
+                                 sid[i], ref);
+        planStatePoolGetState(prob->state_pool, sid[i], state);
+
+        found = planSuccGenFind(prob->succ_gen, state, ops, prob->op_size);
+        checkOps(proto, "flattened tree", ref, ref_size, ops, found);
+
+        found = planSuccGenFind(sg_fd, state, ops, prob->op_size);
+        checkOps(proto, "tree from FD", ref, ref_size, ops, found);
+    }
+
+    testEquivPacked(proto, prob, sid, sid_size, PLAN_SUCC_GEN_TREE,
+                    "packed tree");
+    testEquivPacked(proto, prob, sid, sid_size, PLAN_SUCC_GEN_MASK,
+                    "packed mask");
+    testEquivPacked(proto, prob, sid, sid_size, 0, "packed default");
+
+    if (sid)
+        BOR_FREE(sid);
+    planStateDel(state);
+    BOR_FREE(ref);
+    BOR_FREE(ops);
+    planSuccGenDel(sg_fd);
+    planProblemDel(prob);
+}
 
 TEST(testSuccGen)
 {
@@ -97,3 +289,15 @@ TEST(testSuccGen)
     test("proto/rovers-p03.proto", "states/rovers-p03.txt");
     test("proto/rovers-p15.proto", "states/rovers-p15.txt");
 }
+
+TEST(testSuccGenEquiv)
+{
+    // All problems but the last one have fewer operators than the
+    // threshold for the packed masks, so the mask is used only if forced
+    testEquiv("proto/depot-pfile1.proto", "states/depot-pfile1.txt");
+    testEquiv("proto/depot-pfile5.proto", "states/depot-pfile5.txt");
+    testEquiv("proto/rovers-p03.proto", "states/rovers-p03.txt");
+    testEquiv("proto/rovers-p15.proto", "states/rovers-p15.txt");
+    testEquiv("proto/CityCar-p3-2-2-0-1.proto",
+              "states/citycar-p3-2-2-0-1.txt");
+}
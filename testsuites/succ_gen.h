@@ -2,10 +2,12 @@
 #define TEST_SUCCGEN_H
 
 TEST(testSuccGen);
+TEST(testSuccGenEquiv);
 TEST(protobufTearDown);
 
 TEST_SUITE(TSSuccGen){
     TEST_ADD(testSuccGen),
+    TEST_ADD(testSuccGenEquiv),
     TEST_ADD(protobufTearDown),
     TEST_SUITE_CLOSURE
 };